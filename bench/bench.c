@@ -0,0 +1,493 @@
+/*************************************************************************
+ * GLFW 2to3 - www.glfw.org
+ * A library easing porting from GLFW 2 to GLFW 3.x
+ *------------------------------------------------------------------------
+ * Copyright © 2020 Emmanuel Gil Peyrot <linkmauve@linkmauve.fr>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would
+ *    be appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not
+ *    be misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source
+ *    distribution.
+ *
+ *************************************************************************/
+
+
+// Nanoseconds per call of the GLFW 2 functions, printed as JSON so that
+// builds can be compared.  Run through `meson test --benchmark`, which loads
+// the mock GLFW 3 and OpenGL libraries and feeds them bench/events.txt.
+
+#include <GL/glfw.h>
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define DEFAULT_RUNS 5
+#define MAX_RUNS 64
+#define MAX_THREADS 64
+
+typedef struct benchmark
+{
+    const char* name;
+    // Calls per run and thread
+    long iterations;
+    // Whether GLFW 2 allows calling it from several threads at once
+    int threadsafe;
+    void* (*setup)(void);
+    void (*run)(void* context, long iterations);
+    void (*teardown)(void* context);
+} benchmark;
+
+// Shared by the threads of contended runs
+static GLFWmutex shared_mutex;
+
+static uint64_t getNanoseconds(void)
+{
+    struct timespec tp;
+    clock_gettime(CLOCK_MONOTONIC, &tp);
+    return (uint64_t)tp.tv_sec * 1000000000 + (uint64_t)tp.tv_nsec;
+}
+
+/* Benchmarked calls */
+
+static void runGetKey(void* context, long iterations)
+{
+    (void)context;
+    for (long i = 0; i < iterations; i++)
+    {
+        glfwGetKey('A');
+    }
+}
+
+static void runGetMousePos(void* context, long iterations)
+{
+    (void)context;
+    int x, y;
+    for (long i = 0; i < iterations; i++)
+    {
+        glfwGetMousePos(&x, &y);
+    }
+}
+
+static void runGetMouseButton(void* context, long iterations)
+{
+    (void)context;
+    for (long i = 0; i < iterations; i++)
+    {
+        glfwGetMouseButton(GLFW_MOUSE_BUTTON_LEFT);
+    }
+}
+
+static void runGetTime(void* context, long iterations)
+{
+    (void)context;
+    for (long i = 0; i < iterations; i++)
+    {
+        glfwGetTime();
+    }
+}
+
+static void runGetJoystickPos(void* context, long iterations)
+{
+    (void)context;
+    float pos[4];
+    for (long i = 0; i < iterations; i++)
+    {
+        glfwGetJoystickPos(GLFW_JOYSTICK_1, pos, 4);
+    }
+}
+
+static void runGetWindowParam(void* context, long iterations)
+{
+    (void)context;
+    for (long i = 0; i < iterations; i++)
+    {
+        glfwGetWindowParam(GLFW_OPENED);
+    }
+}
+
+static void runPollEvents(void* context, long iterations)
+{
+    (void)context;
+    for (long i = 0; i < iterations; i++)
+    {
+        glfwPollEvents();
+    }
+}
+
+static void runSwapBuffers(void* context, long iterations)
+{
+    (void)context;
+    for (long i = 0; i < iterations; i++)
+    {
+        glfwSwapBuffers();
+    }
+}
+
+static void runGetProcAddress(void* context, long iterations)
+{
+    (void)context;
+    for (long i = 0; i < iterations; i++)
+    {
+        glfwGetProcAddress("glBindTexture");
+    }
+}
+
+static void* setupMutex(void)
+{
+    return shared_mutex;
+}
+
+static void runMutex(void* context, long iterations)
+{
+    GLFWmutex mutex = context;
+    for (long i = 0; i < iterations; i++)
+    {
+        glfwLockMutex(mutex);
+        glfwUnlockMutex(mutex);
+    }
+}
+
+// Two threads waking each other up in turn, their mutex being the one shared
+// by all the pairs of a contended run
+typedef struct ping_pong
+{
+    GLFWmutex mutex;
+    GLFWcond ping;
+    GLFWcond pong;
+    GLFWthread partner;
+    int turn;
+    int done;
+} ping_pong;
+
+static void GLFWCALL runPong(void* arg)
+{
+    ping_pong* pair = arg;
+    glfwLockMutex(pair->mutex);
+    for (;;)
+    {
+        while (pair->turn != 1 && !pair->done)
+        {
+            glfwWaitCond(pair->ping, pair->mutex, GLFW_INFINITY);
+        }
+        if (pair->done)
+        {
+            break;
+        }
+        pair->turn = 0;
+        glfwSignalCond(pair->pong);
+    }
+    glfwUnlockMutex(pair->mutex);
+}
+
+static void* setupPingPong(void)
+{
+    ping_pong* pair = calloc(1, sizeof(ping_pong));
+    if (!pair)
+    {
+        return NULL;
+    }
+    pair->mutex = shared_mutex;
+    pair->ping = glfwCreateCond();
+    pair->pong = glfwCreateCond();
+    pair->partner = glfwCreateThread(runPong, pair);
+    return pair;
+}
+
+static void runPingPong(void* context, long iterations)
+{
+    ping_pong* pair = context;
+    glfwLockMutex(pair->mutex);
+    for (long i = 0; i < iterations; i++)
+    {
+        pair->turn = 1;
+        glfwSignalCond(pair->ping);
+        while (pair->turn != 0)
+        {
+            glfwWaitCond(pair->pong, pair->mutex, GLFW_INFINITY);
+        }
+    }
+    glfwUnlockMutex(pair->mutex);
+}
+
+static void teardownPingPong(void* context)
+{
+    ping_pong* pair = context;
+    glfwLockMutex(pair->mutex);
+    pair->done = GL_TRUE;
+    glfwSignalCond(pair->ping);
+    glfwUnlockMutex(pair->mutex);
+    glfwWaitThread(pair->partner, GLFW_WAIT);
+    glfwDestroyCond(pair->ping);
+    glfwDestroyCond(pair->pong);
+    free(pair);
+}
+
+static void GLFWCALL runNothing(void* arg)
+{
+    (void)arg;
+}
+
+static void runCreateThread(void* context, long iterations)
+{
+    (void)context;
+    for (long i = 0; i < iterations; i++)
+    {
+        GLFWthread thread = glfwCreateThread(runNothing, NULL);
+        if (thread >= 0)
+        {
+            glfwWaitThread(thread, GLFW_WAIT);
+        }
+    }
+}
+
+static const benchmark benchmarks[] = {
+    { "glfwGetKey", 1000000, GL_FALSE, NULL, runGetKey, NULL },
+    { "glfwGetMousePos", 1000000, GL_FALSE, NULL, runGetMousePos, NULL },
+    { "glfwGetMouseButton", 1000000, GL_FALSE, NULL, runGetMouseButton, NULL },
+    { "glfwGetTime", 1000000, GL_TRUE, NULL, runGetTime, NULL },
+    { "glfwGetJoystickPos", 1000000, GL_FALSE, NULL, runGetJoystickPos, NULL },
+    { "glfwGetWindowParam", 1000000, GL_FALSE, NULL, runGetWindowParam, NULL },
+    { "glfwPollEvents", 100000, GL_FALSE, NULL, runPollEvents, NULL },
+    { "glfwSwapBuffers", 100000, GL_FALSE, NULL, runSwapBuffers, NULL },
+    { "glfwGetProcAddress", 1000000, GL_FALSE, NULL, runGetProcAddress, NULL },
+    { "glfwLockMutex+glfwUnlockMutex", 1000000, GL_TRUE, setupMutex, runMutex, NULL },
+    { "glfwSignalCond+glfwWaitCond", 20000, GL_TRUE, setupPingPong, runPingPong, teardownPingPong },
+    { "glfwCreateThread+glfwWaitThread", 2000, GL_TRUE, NULL, runCreateThread, NULL },
+};
+
+#define BENCHMARK_COUNT (int)(sizeof(benchmarks) / sizeof(benchmarks[0]))
+
+/* Runs */
+
+// One of the threads of a contended run, started together by the gate
+typedef struct worker
+{
+    const benchmark* bench;
+    GLFWmutex mutex;
+    GLFWcond gate;
+    int* ready;
+    int* open;
+    uint64_t ns;
+} worker;
+
+static double runOnce(const benchmark* bench)
+{
+    void* context = bench->setup ? bench->setup() : NULL;
+    uint64_t start = getNanoseconds();
+    bench->run(context, bench->iterations);
+    uint64_t ns = getNanoseconds() - start;
+    if (bench->teardown)
+    {
+        bench->teardown(context);
+    }
+    return (double)ns / (double)bench->iterations;
+}
+
+static void GLFWCALL runWorker(void* arg)
+{
+    worker* w = arg;
+    void* context = w->bench->setup ? w->bench->setup() : NULL;
+
+    glfwLockMutex(w->mutex);
+    (*w->ready)++;
+    glfwBroadcastCond(w->gate);
+    while (!*w->open)
+    {
+        glfwWaitCond(w->gate, w->mutex, GLFW_INFINITY);
+    }
+    glfwUnlockMutex(w->mutex);
+
+    uint64_t start = getNanoseconds();
+    w->bench->run(context, w->bench->iterations);
+    w->ns = getNanoseconds() - start;
+
+    if (w->bench->teardown)
+    {
+        w->bench->teardown(context);
+    }
+}
+
+// Average time per call seen by each thread, when they all run at once
+static double runContended(const benchmark* bench, int count)
+{
+    worker workers[MAX_THREADS];
+    GLFWthread threads[MAX_THREADS];
+    GLFWmutex mutex = glfwCreateMutex();
+    GLFWcond gate = glfwCreateCond();
+    int ready = 0, open = GL_FALSE;
+
+    for (int i = 0; i < count; i++)
+    {
+        workers[i] = (worker){ bench, mutex, gate, &ready, &open, 0 };
+        threads[i] = glfwCreateThread(runWorker, &workers[i]);
+    }
+
+    glfwLockMutex(mutex);
+    while (ready < count)
+    {
+        glfwWaitCond(gate, mutex, GLFW_INFINITY);
+    }
+    open = GL_TRUE;
+    glfwBroadcastCond(gate);
+    glfwUnlockMutex(mutex);
+
+    uint64_t ns = 0;
+    for (int i = 0; i < count; i++)
+    {
+        glfwWaitThread(threads[i], GLFW_WAIT);
+        ns += workers[i].ns;
+    }
+
+    glfwDestroyCond(gate);
+    glfwDestroyMutex(mutex);
+    return (double)ns / (double)count / (double)bench->iterations;
+}
+
+static int compareDoubles(const void* a, const void* b)
+{
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+static void printResult(const benchmark* bench, int threads, int runs, int first)
+{
+    double results[MAX_RUNS];
+    for (int i = 0; i < runs; i++)
+    {
+        results[i] = threads > 1 ? runContended(bench, threads) : runOnce(bench);
+    }
+    qsort(results, runs, sizeof(double), compareDoubles);
+
+    printf("%s    {\"name\": \"%s\", \"threads\": %d, \"iterations\": %ld, \"runs\": %d, "
+           "\"ns_per_call\": {\"min\": %.2f, \"median\": %.2f, \"max\": %.2f}}",
+           first ? "" : ",\n", bench->name, threads, bench->iterations, runs,
+           results[0], results[runs / 2], results[runs - 1]);
+    fflush(stdout);
+}
+
+static void usage(const char* program)
+{
+    fprintf(stderr, "Usage: %s [-t threads] [-r runs] [benchmark...]\n", program);
+    fprintf(stderr, "Benchmarks:\n");
+    for (int i = 0; i < BENCHMARK_COUNT; i++)
+    {
+        fprintf(stderr, "  %s\n", benchmarks[i].name);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    int threads = 0;
+    int runs = DEFAULT_RUNS;
+    int selected[BENCHMARK_COUNT];
+    int selectedcount = 0;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-t") == 0 && i + 1 < argc)
+        {
+            threads = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc)
+        {
+            runs = atoi(argv[++i]);
+        }
+        else
+        {
+            int found = GL_FALSE;
+            for (int j = 0; j < BENCHMARK_COUNT; j++)
+            {
+                if (strcmp(argv[i], benchmarks[j].name) == 0 && selectedcount < BENCHMARK_COUNT)
+                {
+                    selected[selectedcount++] = j;
+                    found = GL_TRUE;
+                    break;
+                }
+            }
+            if (!found)
+            {
+                usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+        }
+    }
+    if (!selectedcount)
+    {
+        for (int j = 0; j < BENCHMARK_COUNT; j++)
+        {
+            selected[selectedcount++] = j;
+        }
+    }
+    if (runs < 1 || runs > MAX_RUNS)
+    {
+        runs = DEFAULT_RUNS;
+    }
+
+    if (!glfwInit())
+    {
+        fprintf(stderr, "glfwInit() failed\n");
+        return EXIT_FAILURE;
+    }
+    if (!glfwOpenWindow(640, 480, 8, 8, 8, 8, 24, 0, GLFW_WINDOW))
+    {
+        fprintf(stderr, "glfwOpenWindow() failed\n");
+        glfwTerminate();
+        return EXIT_FAILURE;
+    }
+    // Delivers the events making keys, buttons and joysticks look in use
+    glfwPollEvents();
+
+    // Contended runs use as many threads as there are processors, up to 4
+    if (threads <= 0)
+    {
+        threads = glfwGetNumberOfProcessors();
+        if (threads > 4)
+        {
+            threads = 4;
+        }
+    }
+    if (threads > MAX_THREADS)
+    {
+        threads = MAX_THREADS;
+    }
+    shared_mutex = glfwCreateMutex();
+
+    int major, minor, rev;
+    glfwGetVersion(&major, &minor, &rev);
+    printf("{\n  \"version\": \"%d.%d.%d\",\n  \"processors\": %d,\n  \"benchmarks\": [\n",
+           major, minor, rev, glfwGetNumberOfProcessors());
+
+    int first = GL_TRUE;
+    for (int i = 0; i < selectedcount; i++)
+    {
+        const benchmark* bench = &benchmarks[selected[i]];
+        printResult(bench, 1, runs, first);
+        first = GL_FALSE;
+        if (bench->threadsafe && threads > 1)
+        {
+            printResult(bench, threads, runs, first);
+        }
+    }
+    printf("\n  ]\n}\n");
+
+    glfwDestroyMutex(shared_mutex);
+    glfwTerminate();
+    return EXIT_SUCCESS;
+}
@@ -142,6 +142,13 @@ extern "C" {
  #define GLFWAPIENTRY __stdcall
  #define GLFWCALL     __stdcall
 
+#elif defined(GLFW_BUILD_DLL) && defined(__GNUC__)
+
+ /* We are building a shared library, exporting only the GLFW functions */
+ #define GLFWAPI      __attribute__((visibility("default")))
+ #define GLFWAPIENTRY
+ #define GLFWCALL
+
 #else
 
  /* We are either building/calling a static lib or we are non-win32 */
@@ -362,6 +369,8 @@ extern "C" {
 #define GLFW_SYSTEM_KEYS          0x00030004
 #define GLFW_KEY_REPEAT           0x00030005
 #define GLFW_AUTO_POLL_EVENTS     0x00030006
+#define GLFW_IMAGE_STATS          0x00030007
+#define GLFW_PACKED_TEXTURES      0x00030008
 
 /* glfwWaitThread wait modes */
 #define GLFW_WAIT                 0x00040001
@@ -377,6 +386,32 @@ extern "C" {
 #define GLFW_ORIGIN_UL_BIT        0x00000002
 #define GLFW_BUILD_MIPMAPS_BIT    0x00000004 /* Only for glfwLoadTexture2D */
 #define GLFW_ALPHA_MAP_BIT        0x00000008
+#define GLFW_RLE_BIT              0x00000010 /* Only for glfwWriteImage */
+#define GLFW_PACKED_PIXELS_BIT    0x00000020 /* Keep 16-bit images packed, as
+                                                GL_RGB5_A1 or GL_RGB5 */
+
+/* glfwGetImageStats stages */
+#define GLFW_STAGE_READ           0
+#define GLFW_STAGE_DECODE         1
+#define GLFW_STAGE_RESCALE        2
+#define GLFW_STAGE_CONVERT        3
+#define GLFW_STAGE_MIPMAP         4
+#define GLFW_STAGE_UPLOAD         5
+#define GLFW_STAGE_COUNT          6
+
+/* glfwGetMemoryStats categories */
+#define GLFW_MEMORY_IMAGE         0
+#define GLFW_MEMORY_COLORMAP      1
+#define GLFW_MEMORY_RESCALE       2
+#define GLFW_MEMORY_CONVERT       3
+#define GLFW_MEMORY_SYNC          4
+#define GLFW_MEMORY_THREADS       5
+#define GLFW_MEMORY_OTHER         6
+#define GLFW_MEMORY_TOTAL         7
+#define GLFW_MEMORY_COUNT         8
+
+/* Number of (log2 of microseconds) buckets in GLFWstagestats histograms */
+#define GLFW_STATS_BUCKETS        32
 
 /* Time spans longer than this (seconds) are considered to be infinity */
 #define GLFW_INFINITY 100000.0
@@ -400,6 +435,22 @@ typedef struct {
     unsigned char *Data;
 } GLFWimage;
 
+/* Image pipeline stage statistics, times exclude reading from streams */
+typedef struct {
+    unsigned long long Calls;
+    unsigned long long Nanoseconds;
+    unsigned long long Bytes;
+    unsigned long long Histogram[GLFW_STATS_BUCKETS];
+} GLFWstagestats;
+
+/* Memory allocated by the library, in usable bytes of the allocator */
+typedef struct {
+    unsigned long long Bytes;
+    unsigned long long PeakBytes;
+    unsigned long long Blocks;
+    unsigned long long TotalBlocks;
+} GLFWmemorystats;
+
 /* Thread ID */
 typedef int GLFWthread;
 
@@ -504,10 +555,30 @@ GLFWAPI void GLFWAPIENTRY glfwDisable( int token );
 /* Image/texture I/O support */
 GLFWAPI int  GLFWAPIENTRY glfwReadImage( const char *name, GLFWimage *img, int flags );
 GLFWAPI int  GLFWAPIENTRY glfwReadMemoryImage( const void *data, long size, GLFWimage *img, int flags );
+/* The buffer given to glfwRead*ImageInto stays owned by the caller:
+ * glfwFreeImage only clears the fields of such images, and the buffer must
+ * outlive every use of img->Data */
+GLFWAPI long GLFWAPIENTRY glfwReadImageInto( const char *name, GLFWimage *img, void *buffer, long size, int stride, int flags );
+GLFWAPI long GLFWAPIENTRY glfwReadMemoryImageInto( const void *data, long datasize, GLFWimage *img, void *buffer, long size, int stride, int flags );
+GLFWAPI int  GLFWAPIENTRY glfwReadImages( const char **names, GLFWimage *imgs, int *results, int count, int flags );
+GLFWAPI int  GLFWAPIENTRY glfwReadMemoryImages( const void **data, const long *sizes, GLFWimage *imgs, int *results, int count, int flags );
 GLFWAPI void GLFWAPIENTRY glfwFreeImage( GLFWimage *img );
+GLFWAPI int  GLFWAPIENTRY glfwWriteImage( const char *name, const GLFWimage *img, int flags );
+GLFWAPI long GLFWAPIENTRY glfwWriteMemoryImage( const GLFWimage *img, void *data, long size, int flags );
 GLFWAPI int  GLFWAPIENTRY glfwLoadTexture2D( const char *name, int flags );
 GLFWAPI int  GLFWAPIENTRY glfwLoadMemoryTexture2D( const void *data, long size, int flags );
 GLFWAPI int  GLFWAPIENTRY glfwLoadTextureImage2D( GLFWimage *img, int flags );
+GLFWAPI int  GLFWAPIENTRY glfwUpdateTextureImage2D( const GLFWimage *img, int x, int y, int width, int height, int flags );
+GLFWAPI void GLFWAPIENTRY glfwSetTextureLodBias( int levels );
+GLFWAPI void GLFWAPIENTRY glfwSyncPixelStore( void );
+GLFWAPI void GLFWAPIENTRY glfwSetTextureStreamBudget( long bytes );
+GLFWAPI int  GLFWAPIENTRY glfwGetImageStats( int stage, GLFWstagestats *stats );
+GLFWAPI void GLFWAPIENTRY glfwResetImageStats( void );
+GLFWAPI int  GLFWAPIENTRY glfwGetMemoryStats( int category, GLFWmemorystats *stats );
+GLFWAPI void GLFWAPIENTRY glfwGetProcAddressStats( long *hits, long *misses );
+GLFWAPI void GLFWAPIENTRY glfwSyncGLState( void );
+GLFWAPI void GLFWAPIENTRY glfwTraceBegin( const char *name );
+GLFWAPI void GLFWAPIENTRY glfwTraceEnd( void );
 
 
 #ifdef __cplusplus
@@ -0,0 +1,1304 @@
+/*************************************************************************
+ * GLFW 2to3 - www.glfw.org
+ * A library easing porting from GLFW 2 to GLFW 3.x
+ *------------------------------------------------------------------------
+ * Copyright © 2020 Emmanuel Gil Peyrot <linkmauve@linkmauve.fr>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would
+ *    be appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not
+ *    be misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source
+ *    distribution.
+ *
+ *************************************************************************/
+
+
+// Fake OpenGL library, recording the calls made to it instead of rendering
+
+#define GL_GLEXT_PROTOTYPES
+#include <GL/gl.h>
+#include <GL/glext.h>
+
+#include "mock.h"
+
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MOCK_TEXTURE_UNITS 2
+#define MOCK_CLIENT_STACK_DEPTH 16
+
+#define MOCK_GL_FUNCTIONS(F) \
+    F(glGetString) \
+    F(glGetIntegerv) \
+    F(glPixelStorei) \
+    F(glTexParameteri) \
+    F(glGetTexParameteriv) \
+    F(glIsTexture) \
+    F(glTexImage2D) \
+    F(glTexSubImage2D) \
+    F(glCompressedTexImage2D) \
+    F(glCopyTexImage2D) \
+    F(glGetInternalformativ) \
+    F(glIsEnabled) \
+    F(glEnable) \
+    F(glDisable) \
+    F(glGenTextures) \
+    F(glDeleteTextures) \
+    F(glBindTexture) \
+    F(glActiveTexture) \
+    F(glGenFramebuffers) \
+    F(glDeleteFramebuffers) \
+    F(glBindFramebuffer) \
+    F(glFramebufferTexture2D) \
+    F(glFramebufferRenderbuffer) \
+    F(glCheckFramebufferStatus) \
+    F(glGenRenderbuffers) \
+    F(glDeleteRenderbuffers) \
+    F(glBindRenderbuffer) \
+    F(glRenderbufferStorage) \
+    F(glBlitFramebuffer) \
+    F(glGenerateMipmap) \
+    F(glBegin) \
+    F(glEnd) \
+    F(glVertex2f) \
+    F(glVertex2i) \
+    F(glVertex2sv) \
+    F(glVertex3f) \
+    F(glVertex3fv) \
+    F(glVertex3d) \
+    F(glVertex4f) \
+    F(glColor3f) \
+    F(glColor4f) \
+    F(glColor4fv) \
+    F(glColor4ub) \
+    F(glColor3us) \
+    F(glColor4dv) \
+    F(glColor3b) \
+    F(glTexCoord1f) \
+    F(glTexCoord2f) \
+    F(glTexCoord2i) \
+    F(glTexCoord3fv) \
+    F(glTexCoord4f) \
+    F(glTexCoord4fv) \
+    F(glMultiTexCoord2f) \
+    F(glNormal3f) \
+    F(glNormal3fv) \
+    F(glNormal3b) \
+    F(glEdgeFlag) \
+    F(glEvalCoord1f) \
+    F(glArrayElement) \
+    F(glDrawArrays) \
+    F(glEnableClientState) \
+    F(glDisableClientState) \
+    F(glClientActiveTexture) \
+    F(glPushClientAttrib) \
+    F(glPopClientAttrib) \
+    F(glVertexPointer) \
+    F(glColorPointer) \
+    F(glTexCoordPointer) \
+    F(glNormalPointer) \
+    F(glGenBuffers) \
+    F(glDeleteBuffers) \
+    F(glBindBuffer) \
+    F(glBufferData)
+
+enum {
+#define F(name) MOCK_GL_##name,
+    MOCK_GL_FUNCTIONS(F)
+#undef F
+    MOCK_GL_COUNT
+};
+
+static const struct {
+    const char* name;
+    void* proc;
+} functions[MOCK_GL_COUNT] = {
+#define F(name) { #name, (void*)name },
+    MOCK_GL_FUNCTIONS(F)
+#undef F
+};
+
+typedef struct mockTexture {
+    int exists;
+    GLint baselevel;
+    GLint maxlevel;
+    GLint generatemipmap;
+} mockTexture;
+
+typedef struct mockBuffer {
+    int exists;
+    void* data;
+} mockBuffer;
+
+// Attributes of a vertex, and the current ones
+typedef struct mockVertex {
+    GLfloat position[4];
+    GLfloat color[4];
+    GLfloat texcoord[MOCK_TEXTURE_UNITS][4];
+    GLfloat normal[3];
+    GLboolean edgeflag;
+} mockVertex;
+
+// Only float arrays are read
+typedef struct mockArray {
+    int enabled;
+    GLint size;
+    GLsizei stride;
+    const GLvoid* pointer;
+    GLuint buffer;
+} mockArray;
+
+// State saved by glPushClientAttrib(GL_CLIENT_VERTEX_ARRAY_BIT)
+typedef struct mockArrays {
+    mockArray vertex;
+    mockArray color;
+    mockArray texcoord[MOCK_TEXTURE_UNITS];
+    mockArray normal;
+    int clientunit;
+    GLuint arraybuffer;
+} mockArrays;
+
+static struct {
+    long calls[MOCK_GL_COUNT];
+    long frame;
+    FILE* log;
+
+    const char* version;
+    const char* extensions;
+
+    GLint unpack[5];
+    GLenum enabled[16];
+    int enabledcount;
+
+    GLuint nextname;
+    mockTexture* textures;
+    GLuint texturecount;
+    GLuint texture2d;
+    GLuint rectangle;
+    GLuint readfbo;
+    GLuint drawfbo;
+    GLuint renderbuffer;
+
+    mockBuffer* buffers;
+    GLuint buffercount;
+    mockArrays arrays;
+    mockArrays clientstack[MOCK_CLIENT_STACK_DEPTH];
+    int clientdepth;
+
+    // Primitive between glBegin() and glEnd(), drawn on the latter
+    GLenum mode;
+    int open;
+    mockVertex* vertices;
+    int vertexcount;
+    int vertexcapacity;
+    mockVertex current;
+} mock = {
+    .unpack = { 4 },
+    .nextname = 1,
+    .current = {
+        .color = { 1.f, 1.f, 1.f, 1.f },
+        .texcoord = { { 0.f, 0.f, 0.f, 1.f }, { 0.f, 0.f, 0.f, 1.f } },
+        .normal = { 0.f, 0.f, 1.f },
+        .edgeflag = GL_TRUE,
+    },
+};
+
+__attribute__((constructor)) static void openLog(void)
+{
+    const char* path = getenv("GLFW2TO3_MOCK_GL_LOG");
+    if (path)
+    {
+        mock.log = fopen(path, "w");
+        if (!mock.log)
+        {
+            perror(path);
+        }
+    }
+
+    mock.version = getenv("GLFW2TO3_MOCK_GL_VERSION");
+    if (!mock.version)
+    {
+        mock.version = "2.1 glfw2to3 mock";
+    }
+    mock.extensions = getenv("GLFW2TO3_MOCK_GL_EXTENSIONS");
+    if (!mock.extensions)
+    {
+        mock.extensions = "GL_ARB_framebuffer_object "
+                          "GL_ARB_texture_non_power_of_two "
+                          "GL_ARB_texture_rectangle "
+                          "GL_SGIS_generate_mipmap";
+    }
+}
+
+__attribute__((destructor)) static void closeLog(void)
+{
+    if (mock.log)
+    {
+        fclose(mock.log);
+        mock.log = NULL;
+    }
+}
+
+// Counts a call, and writes it to the log with the frame it was made in
+__attribute__((format(printf, 2, 3)))
+static void record(int function, const char* format, ...)
+{
+    mock.calls[function]++;
+    if (!mock.log)
+    {
+        return;
+    }
+
+    va_list args;
+    va_start(args, format);
+    fprintf(mock.log, "%ld %s(", mock.frame, functions[function].name);
+    vfprintf(mock.log, format, args);
+    fputs(")\n", mock.log);
+    va_end(args);
+}
+
+static void genNames(GLsizei n, GLuint* names)
+{
+    for (GLsizei i = 0; i < n; i++)
+    {
+        names[i] = mock.nextname++;
+    }
+}
+
+static mockTexture* getTexture(GLuint name)
+{
+    if (!name || name >= mock.texturecount)
+    {
+        return NULL;
+    }
+    return mock.textures[name].exists ? &mock.textures[name] : NULL;
+}
+
+static GLint* getUnpackParameter(GLenum pname)
+{
+    switch (pname)
+    {
+    case GL_UNPACK_ALIGNMENT:
+        return &mock.unpack[0];
+    case GL_UNPACK_ROW_LENGTH:
+        return &mock.unpack[1];
+    case GL_UNPACK_SKIP_ROWS:
+        return &mock.unpack[2];
+    case GL_UNPACK_SKIP_PIXELS:
+        return &mock.unpack[3];
+    case GL_UNPACK_SWAP_BYTES:
+        return &mock.unpack[4];
+    default:
+        return NULL;
+    }
+}
+
+const GLubyte* glGetString(GLenum name)
+{
+    record(MOCK_GL_glGetString, "0x%04x", name);
+    switch (name)
+    {
+    case GL_VENDOR:
+        return (const GLubyte*)"glfw2to3";
+    case GL_RENDERER:
+        return (const GLubyte*)"mock";
+    case GL_VERSION:
+        return (const GLubyte*)mock.version;
+    case GL_EXTENSIONS:
+        return (const GLubyte*)mock.extensions;
+    default:
+        return NULL;
+    }
+}
+
+void glGetIntegerv(GLenum pname, GLint* data)
+{
+    record(MOCK_GL_glGetIntegerv, "0x%04x", pname);
+    GLint* unpack = getUnpackParameter(pname);
+    if (unpack)
+    {
+        *data = *unpack;
+        return;
+    }
+
+    switch (pname)
+    {
+    case GL_TEXTURE_BINDING_2D:
+        *data = mock.texture2d;
+        break;
+    case GL_TEXTURE_BINDING_RECTANGLE:
+        *data = mock.rectangle;
+        break;
+    case GL_READ_FRAMEBUFFER_BINDING:
+        *data = mock.readfbo;
+        break;
+    case GL_DRAW_FRAMEBUFFER_BINDING:
+        *data = mock.drawfbo;
+        break;
+    case GL_RENDERBUFFER_BINDING:
+        *data = mock.renderbuffer;
+        break;
+    case GL_ARRAY_BUFFER_BINDING:
+        *data = mock.arrays.arraybuffer;
+        break;
+    case GL_MAX_TEXTURE_SIZE:
+    case GL_MAX_RECTANGLE_TEXTURE_SIZE:
+    case GL_MAX_RENDERBUFFER_SIZE:
+        *data = 16384;
+        break;
+    default:
+        *data = 0;
+        break;
+    }
+}
+
+void glPixelStorei(GLenum pname, GLint param)
+{
+    record(MOCK_GL_glPixelStorei, "0x%04x, %d", pname, param);
+    GLint* unpack = getUnpackParameter(pname);
+    if (unpack)
+    {
+        *unpack = param;
+    }
+}
+
+void glTexParameteri(GLenum target, GLenum pname, GLint param)
+{
+    record(MOCK_GL_glTexParameteri, "0x%04x, 0x%04x, %d", target, pname, param);
+    mockTexture* texture = getTexture(mock.texture2d);
+    if (target != GL_TEXTURE_2D || !texture)
+    {
+        return;
+    }
+
+    if (pname == GL_TEXTURE_BASE_LEVEL)
+    {
+        texture->baselevel = param;
+    }
+    else if (pname == GL_TEXTURE_MAX_LEVEL)
+    {
+        texture->maxlevel = param;
+    }
+    else if (pname == GL_GENERATE_MIPMAP_SGIS)
+    {
+        texture->generatemipmap = param;
+    }
+}
+
+void glGetTexParameteriv(GLenum target, GLenum pname, GLint* params)
+{
+    record(MOCK_GL_glGetTexParameteriv, "0x%04x, 0x%04x", target, pname);
+    mockTexture* texture = getTexture(mock.texture2d);
+    *params = 0;
+    if (target != GL_TEXTURE_2D || !texture)
+    {
+        return;
+    }
+
+    if (pname == GL_TEXTURE_BASE_LEVEL)
+    {
+        *params = texture->baselevel;
+    }
+    else if (pname == GL_TEXTURE_MAX_LEVEL)
+    {
+        *params = texture->maxlevel;
+    }
+    else if (pname == GL_GENERATE_MIPMAP_SGIS)
+    {
+        *params = texture->generatemipmap;
+    }
+}
+
+GLboolean glIsTexture(GLuint texture)
+{
+    record(MOCK_GL_glIsTexture, "%u", texture);
+    return getTexture(texture) != NULL;
+}
+
+void glTexImage2D(GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type, const void* pixels)
+{
+    (void)pixels;
+    record(MOCK_GL_glTexImage2D, "0x%04x, %d, 0x%04x, %d, %d, %d, 0x%04x, 0x%04x",
+           target, level, internalformat, width, height, border, format, type);
+}
+
+void glTexSubImage2D(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height, GLenum format, GLenum type, const void* pixels)
+{
+    (void)pixels;
+    record(MOCK_GL_glTexSubImage2D, "0x%04x, %d, %d, %d, %d, %d, 0x%04x, 0x%04x",
+           target, level, xoffset, yoffset, width, height, format, type);
+}
+
+void glCompressedTexImage2D(GLenum target, GLint level, GLenum internalformat, GLsizei width, GLsizei height, GLint border, GLsizei imageSize, const void* data)
+{
+    (void)data;
+    record(MOCK_GL_glCompressedTexImage2D, "0x%04x, %d, 0x%04x, %d, %d, %d, %d",
+           target, level, internalformat, width, height, border, imageSize);
+}
+
+void glCopyTexImage2D(GLenum target, GLint level, GLenum internalformat, GLint x, GLint y, GLsizei width, GLsizei height, GLint border)
+{
+    record(MOCK_GL_glCopyTexImage2D, "0x%04x, %d, 0x%04x, %d, %d, %d, %d, %d",
+           target, level, internalformat, x, y, width, height, border);
+}
+
+void glGetInternalformativ(GLenum target, GLenum internalformat, GLenum pname, GLsizei count, GLint* params)
+{
+    record(MOCK_GL_glGetInternalformativ, "0x%04x, 0x%04x, 0x%04x, %d",
+           target, internalformat, pname, count);
+    if (count < 1)
+    {
+        return;
+    }
+
+    // Every format is uploaded as is
+    if (pname == GL_TEXTURE_IMAGE_FORMAT)
+    {
+        params[0] = internalformat;
+    }
+    else if (pname == GL_TEXTURE_IMAGE_TYPE)
+    {
+        params[0] = GL_UNSIGNED_BYTE;
+    }
+    else
+    {
+        params[0] = 0;
+    }
+}
+
+GLboolean glIsEnabled(GLenum cap)
+{
+    record(MOCK_GL_glIsEnabled, "0x%04x", cap);
+    for (int i = 0; i < mock.enabledcount; i++)
+    {
+        if (mock.enabled[i] == cap)
+        {
+            return GL_TRUE;
+        }
+    }
+    return GL_FALSE;
+}
+
+void glEnable(GLenum cap)
+{
+    record(MOCK_GL_glEnable, "0x%04x", cap);
+    for (int i = 0; i < mock.enabledcount; i++)
+    {
+        if (mock.enabled[i] == cap)
+        {
+            return;
+        }
+    }
+    if (mock.enabledcount < (int)(sizeof(mock.enabled) / sizeof(mock.enabled[0])))
+    {
+        mock.enabled[mock.enabledcount++] = cap;
+    }
+}
+
+void glDisable(GLenum cap)
+{
+    record(MOCK_GL_glDisable, "0x%04x", cap);
+    for (int i = 0; i < mock.enabledcount; i++)
+    {
+        if (mock.enabled[i] == cap)
+        {
+            mock.enabled[i] = mock.enabled[--mock.enabledcount];
+            return;
+        }
+    }
+}
+
+void glGenTextures(GLsizei n, GLuint* textures)
+{
+    record(MOCK_GL_glGenTextures, "%d", n);
+    genNames(n, textures);
+
+    if (mock.nextname > mock.texturecount)
+    {
+        GLuint count = mock.nextname * 2;
+        mockTexture* grown = realloc(mock.textures, count * sizeof(mockTexture));
+        if (!grown)
+        {
+            abort();
+        }
+        memset(grown + mock.texturecount, 0,
+               (count - mock.texturecount) * sizeof(mockTexture));
+        mock.textures = grown;
+        mock.texturecount = count;
+    }
+
+    for (GLsizei i = 0; i < n; i++)
+    {
+        mock.textures[textures[i]] = (mockTexture){ 1, 0, 1000 };
+    }
+}
+
+void glDeleteTextures(GLsizei n, const GLuint* textures)
+{
+    record(MOCK_GL_glDeleteTextures, "%d", n);
+    for (GLsizei i = 0; i < n; i++)
+    {
+        mockTexture* texture = getTexture(textures[i]);
+        if (texture)
+        {
+            texture->exists = 0;
+        }
+        if (textures[i] == mock.texture2d)
+        {
+            mock.texture2d = 0;
+        }
+        if (textures[i] == mock.rectangle)
+        {
+            mock.rectangle = 0;
+        }
+    }
+}
+
+void glBindTexture(GLenum target, GLuint texture)
+{
+    record(MOCK_GL_glBindTexture, "0x%04x, %u", target, texture);
+    if (target == GL_TEXTURE_2D)
+    {
+        mock.texture2d = texture;
+    }
+    else if (target == GL_TEXTURE_RECTANGLE)
+    {
+        mock.rectangle = texture;
+    }
+}
+
+// Only the bindings of the first texture unit are kept
+void glActiveTexture(GLenum texture)
+{
+    record(MOCK_GL_glActiveTexture, "0x%04x", texture);
+}
+
+void glGenFramebuffers(GLsizei n, GLuint* framebuffers)
+{
+    record(MOCK_GL_glGenFramebuffers, "%d", n);
+    genNames(n, framebuffers);
+}
+
+void glDeleteFramebuffers(GLsizei n, const GLuint* framebuffers)
+{
+    record(MOCK_GL_glDeleteFramebuffers, "%d", n);
+    for (GLsizei i = 0; i < n; i++)
+    {
+        if (framebuffers[i] == mock.readfbo)
+        {
+            mock.readfbo = 0;
+        }
+        if (framebuffers[i] == mock.drawfbo)
+        {
+            mock.drawfbo = 0;
+        }
+    }
+}
+
+void glBindFramebuffer(GLenum target, GLuint framebuffer)
+{
+    record(MOCK_GL_glBindFramebuffer, "0x%04x, %u", target, framebuffer);
+    if (target == GL_FRAMEBUFFER || target == GL_READ_FRAMEBUFFER)
+    {
+        mock.readfbo = framebuffer;
+    }
+    if (target == GL_FRAMEBUFFER || target == GL_DRAW_FRAMEBUFFER)
+    {
+        mock.drawfbo = framebuffer;
+    }
+}
+
+void glFramebufferTexture2D(GLenum target, GLenum attachment, GLenum textarget, GLuint texture, GLint level)
+{
+    record(MOCK_GL_glFramebufferTexture2D, "0x%04x, 0x%04x, 0x%04x, %u, %d",
+           target, attachment, textarget, texture, level);
+}
+
+void glFramebufferRenderbuffer(GLenum target, GLenum attachment, GLenum renderbuffertarget, GLuint renderbuffer)
+{
+    record(MOCK_GL_glFramebufferRenderbuffer, "0x%04x, 0x%04x, 0x%04x, %u",
+           target, attachment, renderbuffertarget, renderbuffer);
+}
+
+GLenum glCheckFramebufferStatus(GLenum target)
+{
+    record(MOCK_GL_glCheckFramebufferStatus, "0x%04x", target);
+    return GL_FRAMEBUFFER_COMPLETE;
+}
+
+void glGenRenderbuffers(GLsizei n, GLuint* renderbuffers)
+{
+    record(MOCK_GL_glGenRenderbuffers, "%d", n);
+    genNames(n, renderbuffers);
+}
+
+void glDeleteRenderbuffers(GLsizei n, const GLuint* renderbuffers)
+{
+    record(MOCK_GL_glDeleteRenderbuffers, "%d", n);
+    for (GLsizei i = 0; i < n; i++)
+    {
+        if (renderbuffers[i] == mock.renderbuffer)
+        {
+            mock.renderbuffer = 0;
+        }
+    }
+}
+
+void glBindRenderbuffer(GLenum target, GLuint renderbuffer)
+{
+    record(MOCK_GL_glBindRenderbuffer, "0x%04x, %u", target, renderbuffer);
+    mock.renderbuffer = renderbuffer;
+}
+
+void glRenderbufferStorage(GLenum target, GLenum internalformat, GLsizei width, GLsizei height)
+{
+    record(MOCK_GL_glRenderbufferStorage, "0x%04x, 0x%04x, %d, %d",
+           target, internalformat, width, height);
+}
+
+void glBlitFramebuffer(GLint srcX0, GLint srcY0, GLint srcX1, GLint srcY1, GLint dstX0, GLint dstY0, GLint dstX1, GLint dstY1, GLbitfield mask, GLenum filter)
+{
+    record(MOCK_GL_glBlitFramebuffer, "%d, %d, %d, %d, %d, %d, %d, %d, 0x%x, 0x%04x",
+           srcX0, srcY0, srcX1, srcY1, dstX0, dstY0, dstX1, dstY1, mask, filter);
+}
+
+void glGenerateMipmap(GLenum target)
+{
+    record(MOCK_GL_glGenerateMipmap, "0x%04x", target);
+}
+
+/* Drawing, written to the log as the vertices drawn */
+
+// Writes what gets rendered to the log, so that runs drawing the same things
+// through different calls can be compared
+__attribute__((format(printf, 1, 2)))
+static void recordState(const char* format, ...)
+{
+    if (!mock.log)
+    {
+        return;
+    }
+
+    va_list args;
+    va_start(args, format);
+    fprintf(mock.log, "%ld ", mock.frame);
+    vfprintf(mock.log, format, args);
+    fputc('\n', mock.log);
+    va_end(args);
+}
+
+static void recordVertex(GLenum mode, const mockVertex* v)
+{
+    recordState("Vertex(0x%04x, %u, position %.9g %.9g %.9g %.9g, "
+                "color %.9g %.9g %.9g %.9g, texcoord %.9g %.9g %.9g %.9g, "
+                "texcoord1 %.9g %.9g %.9g %.9g, normal %.9g %.9g %.9g, edge %d)",
+                mode, mock.texture2d,
+                v->position[0], v->position[1], v->position[2], v->position[3],
+                v->color[0], v->color[1], v->color[2], v->color[3],
+                v->texcoord[0][0], v->texcoord[0][1], v->texcoord[0][2], v->texcoord[0][3],
+                v->texcoord[1][0], v->texcoord[1][1], v->texcoord[1][2], v->texcoord[1][3],
+                v->normal[0], v->normal[1], v->normal[2], v->edgeflag);
+}
+
+static int getPrimitiveSize(GLenum mode)
+{
+    switch (mode)
+    {
+    case GL_POINTS:
+        return 1;
+    case GL_LINES:
+        return 2;
+    case GL_TRIANGLES:
+        return 3;
+    case GL_QUADS:
+        return 4;
+    default:
+        return 0;
+    }
+}
+
+static void beginPrimitive(GLenum mode)
+{
+    mock.mode = mode;
+    mock.open = 1;
+    mock.vertexcount = 0;
+}
+
+// Incomplete independent primitives are dropped as OpenGL does, so that
+// appending them to each other draws the same, while the start of every
+// strip, loop, fan or polygon is written to the log
+static void endPrimitive(void)
+{
+    int count = mock.vertexcount;
+    int size = getPrimitiveSize(mock.mode);
+    if (size)
+    {
+        count -= count % size;
+    }
+    else if (count)
+    {
+        recordState("Primitive(0x%04x)", mock.mode);
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        recordVertex(mock.mode, &mock.vertices[i]);
+    }
+    mock.open = 0;
+}
+
+// Emits a vertex with the current attributes, outside of a primitive it does
+// nothing
+static void addVertex(GLfloat x, GLfloat y, GLfloat z, GLfloat w)
+{
+    if (!mock.open)
+    {
+        return;
+    }
+
+    if (mock.vertexcount == mock.vertexcapacity)
+    {
+        int capacity = mock.vertexcapacity ? mock.vertexcapacity * 2 : 64;
+        mockVertex* vertices = realloc(mock.vertices, capacity * sizeof(mockVertex));
+        if (!vertices)
+        {
+            abort();
+        }
+        mock.vertices = vertices;
+        mock.vertexcapacity = capacity;
+    }
+
+    mockVertex* vertex = &mock.vertices[mock.vertexcount++];
+    *vertex = mock.current;
+    vertex->position[0] = x;
+    vertex->position[1] = y;
+    vertex->position[2] = z;
+    vertex->position[3] = w;
+}
+
+static void setColor(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha)
+{
+    mock.current.color[0] = red;
+    mock.current.color[1] = green;
+    mock.current.color[2] = blue;
+    mock.current.color[3] = alpha;
+}
+
+static void setTexCoord(GLenum texture, GLfloat s, GLfloat t, GLfloat r, GLfloat q)
+{
+    unsigned unit = texture - GL_TEXTURE0;
+    if (unit >= MOCK_TEXTURE_UNITS)
+    {
+        return;
+    }
+    mock.current.texcoord[unit][0] = s;
+    mock.current.texcoord[unit][1] = t;
+    mock.current.texcoord[unit][2] = r;
+    mock.current.texcoord[unit][3] = q;
+}
+
+static void setNormal(GLfloat nx, GLfloat ny, GLfloat nz)
+{
+    mock.current.normal[0] = nx;
+    mock.current.normal[1] = ny;
+    mock.current.normal[2] = nz;
+}
+
+void glBegin(GLenum mode)
+{
+    record(MOCK_GL_glBegin, "0x%04x", mode);
+    beginPrimitive(mode);
+}
+
+void glEnd(void)
+{
+    record(MOCK_GL_glEnd, "%s", "");
+    if (mock.open)
+    {
+        endPrimitive();
+    }
+}
+
+void glVertex2f(GLfloat x, GLfloat y)
+{
+    record(MOCK_GL_glVertex2f, "%g, %g", x, y);
+    addVertex(x, y, 0.f, 1.f);
+}
+
+void glVertex2i(GLint x, GLint y)
+{
+    record(MOCK_GL_glVertex2i, "%d, %d", x, y);
+    addVertex((GLfloat)x, (GLfloat)y, 0.f, 1.f);
+}
+
+void glVertex2sv(const GLshort* v)
+{
+    record(MOCK_GL_glVertex2sv, "%d, %d", v[0], v[1]);
+    addVertex((GLfloat)v[0], (GLfloat)v[1], 0.f, 1.f);
+}
+
+void glVertex3f(GLfloat x, GLfloat y, GLfloat z)
+{
+    record(MOCK_GL_glVertex3f, "%g, %g, %g", x, y, z);
+    addVertex(x, y, z, 1.f);
+}
+
+void glVertex3fv(const GLfloat* v)
+{
+    record(MOCK_GL_glVertex3fv, "%g, %g, %g", v[0], v[1], v[2]);
+    addVertex(v[0], v[1], v[2], 1.f);
+}
+
+void glVertex3d(GLdouble x, GLdouble y, GLdouble z)
+{
+    record(MOCK_GL_glVertex3d, "%g, %g, %g", x, y, z);
+    addVertex((GLfloat)x, (GLfloat)y, (GLfloat)z, 1.f);
+}
+
+void glVertex4f(GLfloat x, GLfloat y, GLfloat z, GLfloat w)
+{
+    record(MOCK_GL_glVertex4f, "%g, %g, %g, %g", x, y, z, w);
+    addVertex(x, y, z, w);
+}
+
+void glColor3f(GLfloat red, GLfloat green, GLfloat blue)
+{
+    record(MOCK_GL_glColor3f, "%g, %g, %g", red, green, blue);
+    setColor(red, green, blue, 1.f);
+}
+
+void glColor4f(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha)
+{
+    record(MOCK_GL_glColor4f, "%g, %g, %g, %g", red, green, blue, alpha);
+    setColor(red, green, blue, alpha);
+}
+
+void glColor4fv(const GLfloat* v)
+{
+    record(MOCK_GL_glColor4fv, "%g, %g, %g, %g", v[0], v[1], v[2], v[3]);
+    setColor(v[0], v[1], v[2], v[3]);
+}
+
+void glColor4ub(GLubyte red, GLubyte green, GLubyte blue, GLubyte alpha)
+{
+    record(MOCK_GL_glColor4ub, "%u, %u, %u, %u", red, green, blue, alpha);
+    setColor(red / 255.f, green / 255.f, blue / 255.f, alpha / 255.f);
+}
+
+void glColor3us(GLushort red, GLushort green, GLushort blue)
+{
+    record(MOCK_GL_glColor3us, "%u, %u, %u", red, green, blue);
+    setColor(red / 65535.f, green / 65535.f, blue / 65535.f, 1.f);
+}
+
+void glColor4dv(const GLdouble* v)
+{
+    record(MOCK_GL_glColor4dv, "%g, %g, %g, %g", v[0], v[1], v[2], v[3]);
+    setColor((GLfloat)v[0], (GLfloat)v[1], (GLfloat)v[2], (GLfloat)v[3]);
+}
+
+void glColor3b(GLbyte red, GLbyte green, GLbyte blue)
+{
+    record(MOCK_GL_glColor3b, "%d, %d, %d", red, green, blue);
+    setColor((2 * red + 1) / 255.f, (2 * green + 1) / 255.f, (2 * blue + 1) / 255.f, 1.f);
+}
+
+void glTexCoord1f(GLfloat s)
+{
+    record(MOCK_GL_glTexCoord1f, "%g", s);
+    setTexCoord(GL_TEXTURE0, s, 0.f, 0.f, 1.f);
+}
+
+void glTexCoord2f(GLfloat s, GLfloat t)
+{
+    record(MOCK_GL_glTexCoord2f, "%g, %g", s, t);
+    setTexCoord(GL_TEXTURE0, s, t, 0.f, 1.f);
+}
+
+void glTexCoord2i(GLint s, GLint t)
+{
+    record(MOCK_GL_glTexCoord2i, "%d, %d", s, t);
+    setTexCoord(GL_TEXTURE0, (GLfloat)s, (GLfloat)t, 0.f, 1.f);
+}
+
+void glTexCoord3fv(const GLfloat* v)
+{
+    record(MOCK_GL_glTexCoord3fv, "%g, %g, %g", v[0], v[1], v[2]);
+    setTexCoord(GL_TEXTURE0, v[0], v[1], v[2], 1.f);
+}
+
+void glTexCoord4f(GLfloat s, GLfloat t, GLfloat r, GLfloat q)
+{
+    record(MOCK_GL_glTexCoord4f, "%g, %g, %g, %g", s, t, r, q);
+    setTexCoord(GL_TEXTURE0, s, t, r, q);
+}
+
+void glTexCoord4fv(const GLfloat* v)
+{
+    record(MOCK_GL_glTexCoord4fv, "%g, %g, %g, %g", v[0], v[1], v[2], v[3]);
+    setTexCoord(GL_TEXTURE0, v[0], v[1], v[2], v[3]);
+}
+
+void glMultiTexCoord2f(GLenum target, GLfloat s, GLfloat t)
+{
+    record(MOCK_GL_glMultiTexCoord2f, "0x%04x, %g, %g", target, s, t);
+    setTexCoord(target, s, t, 0.f, 1.f);
+}
+
+void glNormal3f(GLfloat nx, GLfloat ny, GLfloat nz)
+{
+    record(MOCK_GL_glNormal3f, "%g, %g, %g", nx, ny, nz);
+    setNormal(nx, ny, nz);
+}
+
+void glNormal3fv(const GLfloat* v)
+{
+    record(MOCK_GL_glNormal3fv, "%g, %g, %g", v[0], v[1], v[2]);
+    setNormal(v[0], v[1], v[2]);
+}
+
+void glNormal3b(GLbyte nx, GLbyte ny, GLbyte nz)
+{
+    record(MOCK_GL_glNormal3b, "%d, %d, %d", nx, ny, nz);
+    setNormal((2 * nx + 1) / 255.f, (2 * ny + 1) / 255.f, (2 * nz + 1) / 255.f);
+}
+
+void glEdgeFlag(GLboolean flag)
+{
+    record(MOCK_GL_glEdgeFlag, "%d", flag);
+    mock.current.edgeflag = flag;
+}
+
+// As if a one-dimensional map along x was enabled
+void glEvalCoord1f(GLfloat u)
+{
+    record(MOCK_GL_glEvalCoord1f, "%g", u);
+    addVertex(u, 0.f, 0.f, 1.f);
+}
+
+/* Vertex arrays and buffers */
+
+static mockBuffer* getBuffer(GLuint name)
+{
+    if (!name || name >= mock.buffercount)
+    {
+        return NULL;
+    }
+    return mock.buffers[name].exists ? &mock.buffers[name] : NULL;
+}
+
+static mockArray* getArray(GLenum cap)
+{
+    switch (cap)
+    {
+    case GL_VERTEX_ARRAY:
+        return &mock.arrays.vertex;
+    case GL_COLOR_ARRAY:
+        return &mock.arrays.color;
+    case GL_TEXTURE_COORD_ARRAY:
+        return &mock.arrays.texcoord[mock.arrays.clientunit];
+    case GL_NORMAL_ARRAY:
+        return &mock.arrays.normal;
+    default:
+        return NULL;
+    }
+}
+
+static void setArray(mockArray* array, GLint size, GLenum type, GLsizei stride, const GLvoid* pointer)
+{
+    // Arrays of other types are left disabled when drawing
+    array->size = type == GL_FLOAT ? size : 0;
+    array->stride = stride ? stride : (GLsizei)(size * sizeof(GLfloat));
+    array->pointer = pointer;
+    array->buffer = mock.arrays.arraybuffer;
+}
+
+// Reads the components of an element the array has, leaving the others
+static void readArray(const mockArray* array, GLint index, GLfloat* value)
+{
+    if (!array->enabled || !array->size)
+    {
+        return;
+    }
+
+    const char* base = NULL;
+    if (array->buffer)
+    {
+        mockBuffer* buffer = getBuffer(array->buffer);
+        if (!buffer || !buffer->data)
+        {
+            return;
+        }
+        base = buffer->data;
+    }
+    const char* element = base + (uintptr_t)array->pointer + (size_t)index * array->stride;
+    memcpy(value, element, array->size * sizeof(GLfloat));
+}
+
+// Sets the current attributes from the enabled arrays, and emits a vertex if
+// the vertex array is
+static void arrayElement(GLint index)
+{
+    if (mock.arrays.color.enabled)
+    {
+        mock.current.color[3] = 1.f;
+        readArray(&mock.arrays.color, index, mock.current.color);
+    }
+    for (int i = 0; i < MOCK_TEXTURE_UNITS; i++)
+    {
+        if (mock.arrays.texcoord[i].enabled)
+        {
+            GLfloat texcoord[4] = { 0.f, 0.f, 0.f, 1.f };
+            readArray(&mock.arrays.texcoord[i], index, texcoord);
+            memcpy(mock.current.texcoord[i], texcoord, sizeof(texcoord));
+        }
+    }
+    readArray(&mock.arrays.normal, index, mock.current.normal);
+
+    if (mock.arrays.vertex.enabled)
+    {
+        GLfloat position[4] = { 0.f, 0.f, 0.f, 1.f };
+        readArray(&mock.arrays.vertex, index, position);
+        addVertex(position[0], position[1], position[2], position[3]);
+    }
+}
+
+void glArrayElement(GLint i)
+{
+    record(MOCK_GL_glArrayElement, "%d", i);
+    arrayElement(i);
+}
+
+void glDrawArrays(GLenum mode, GLint first, GLsizei count)
+{
+    record(MOCK_GL_glDrawArrays, "0x%04x, %d, %d", mode, first, count);
+    if (mock.open)
+    {
+        return;
+    }
+
+    beginPrimitive(mode);
+    for (GLsizei i = 0; i < count; i++)
+    {
+        arrayElement(first + i);
+    }
+    endPrimitive();
+}
+
+void glEnableClientState(GLenum cap)
+{
+    record(MOCK_GL_glEnableClientState, "0x%04x", cap);
+    mockArray* array = getArray(cap);
+    if (array)
+    {
+        array->enabled = 1;
+    }
+}
+
+void glDisableClientState(GLenum cap)
+{
+    record(MOCK_GL_glDisableClientState, "0x%04x", cap);
+    mockArray* array = getArray(cap);
+    if (array)
+    {
+        array->enabled = 0;
+    }
+}
+
+void glClientActiveTexture(GLenum texture)
+{
+    record(MOCK_GL_glClientActiveTexture, "0x%04x", texture);
+    unsigned unit = texture - GL_TEXTURE0;
+    if (unit < MOCK_TEXTURE_UNITS)
+    {
+        mock.arrays.clientunit = unit;
+    }
+}
+
+// The vertex arrays are saved whatever the mask
+void glPushClientAttrib(GLbitfield mask)
+{
+    record(MOCK_GL_glPushClientAttrib, "0x%x", mask);
+    if (mock.clientdepth < MOCK_CLIENT_STACK_DEPTH)
+    {
+        mock.clientstack[mock.clientdepth] = mock.arrays;
+    }
+    mock.clientdepth++;
+}
+
+void glPopClientAttrib(void)
+{
+    record(MOCK_GL_glPopClientAttrib, "%s", "");
+    if (!mock.clientdepth)
+    {
+        return;
+    }
+    mock.clientdepth--;
+    if (mock.clientdepth < MOCK_CLIENT_STACK_DEPTH)
+    {
+        mock.arrays = mock.clientstack[mock.clientdepth];
+    }
+}
+
+void glVertexPointer(GLint size, GLenum type, GLsizei stride, const GLvoid* pointer)
+{
+    record(MOCK_GL_glVertexPointer, "%d, 0x%04x, %d, %p", size, type, stride, pointer);
+    setArray(&mock.arrays.vertex, size, type, stride, pointer);
+}
+
+void glColorPointer(GLint size, GLenum type, GLsizei stride, const GLvoid* pointer)
+{
+    record(MOCK_GL_glColorPointer, "%d, 0x%04x, %d, %p", size, type, stride, pointer);
+    setArray(&mock.arrays.color, size, type, stride, pointer);
+}
+
+void glTexCoordPointer(GLint size, GLenum type, GLsizei stride, const GLvoid* pointer)
+{
+    record(MOCK_GL_glTexCoordPointer, "%d, 0x%04x, %d, %p", size, type, stride, pointer);
+    setArray(&mock.arrays.texcoord[mock.arrays.clientunit], size, type, stride, pointer);
+}
+
+void glNormalPointer(GLenum type, GLsizei stride, const GLvoid* pointer)
+{
+    record(MOCK_GL_glNormalPointer, "0x%04x, %d, %p", type, stride, pointer);
+    setArray(&mock.arrays.normal, 3, type, stride, pointer);
+}
+
+void glGenBuffers(GLsizei n, GLuint* buffers)
+{
+    record(MOCK_GL_glGenBuffers, "%d", n);
+    genNames(n, buffers);
+
+    if (mock.nextname > mock.buffercount)
+    {
+        GLuint count = mock.nextname * 2;
+        mockBuffer* grown = realloc(mock.buffers, count * sizeof(mockBuffer));
+        if (!grown)
+        {
+            abort();
+        }
+        memset(grown + mock.buffercount, 0,
+               (count - mock.buffercount) * sizeof(mockBuffer));
+        mock.buffers = grown;
+        mock.buffercount = count;
+    }
+
+    for (GLsizei i = 0; i < n; i++)
+    {
+        mock.buffers[buffers[i]] = (mockBuffer){ 1, NULL };
+    }
+}
+
+void glDeleteBuffers(GLsizei n, const GLuint* buffers)
+{
+    record(MOCK_GL_glDeleteBuffers, "%d", n);
+    for (GLsizei i = 0; i < n; i++)
+    {
+        mockBuffer* buffer = getBuffer(buffers[i]);
+        if (buffer)
+        {
+            free(buffer->data);
+            *buffer = (mockBuffer){ 0, NULL };
+        }
+        if (buffers[i] == mock.arrays.arraybuffer)
+        {
+            mock.arrays.arraybuffer = 0;
+        }
+    }
+}
+
+void glBindBuffer(GLenum target, GLuint buffer)
+{
+    record(MOCK_GL_glBindBuffer, "0x%04x, %u", target, buffer);
+    if (target == GL_ARRAY_BUFFER)
+    {
+        mock.arrays.arraybuffer = buffer;
+    }
+}
+
+void glBufferData(GLenum target, GLsizeiptr size, const void* data, GLenum usage)
+{
+    record(MOCK_GL_glBufferData, "0x%04x, %ld, 0x%04x", target, (long)size, usage);
+    mockBuffer* buffer = getBuffer(mock.arrays.arraybuffer);
+    if (target != GL_ARRAY_BUFFER || !buffer)
+    {
+        return;
+    }
+
+    void* storage = realloc(buffer->data, size ? size : 1);
+    if (!storage)
+    {
+        abort();
+    }
+    if (data)
+    {
+        memcpy(storage, data, size);
+    }
+    buffer->data = storage;
+}
+
+long glfw2to3MockGetGLCalls(const char* name)
+{
+    long calls = 0;
+    for (int i = 0; i < MOCK_GL_COUNT; i++)
+    {
+        if (!name || strcmp(functions[i].name, name) == 0)
+        {
+            calls += mock.calls[i];
+        }
+    }
+    return calls;
+}
+
+void glfw2to3MockResetGLCalls(void)
+{
+    memset(mock.calls, 0, sizeof(mock.calls));
+}
+
+long glfw2to3MockGetFrame(void)
+{
+    return mock.frame;
+}
+
+// Used by the mock GLFW 3
+
+void* _glfw2to3MockGetProcAddress(const char* name)
+{
+    for (int i = 0; i < MOCK_GL_COUNT; i++)
+    {
+        if (strcmp(functions[i].name, name) == 0)
+        {
+            return functions[i].proc;
+        }
+    }
+    return NULL;
+}
+
+void _glfw2to3MockSwapBuffers(void)
+{
+    const mockVertex* v = &mock.current;
+    recordState("Current(color %.9g %.9g %.9g %.9g, texcoord %.9g %.9g %.9g %.9g, "
+                "texcoord1 %.9g %.9g %.9g %.9g, normal %.9g %.9g %.9g, edge %d)",
+                v->color[0], v->color[1], v->color[2], v->color[3],
+                v->texcoord[0][0], v->texcoord[0][1], v->texcoord[0][2], v->texcoord[0][3],
+                v->texcoord[1][0], v->texcoord[1][1], v->texcoord[1][2], v->texcoord[1][3],
+                v->normal[0], v->normal[1], v->normal[2], v->edgeflag);
+    recordState("SwapBuffers");
+    mock.frame++;
+}
@@ -0,0 +1,831 @@
+/*************************************************************************
+ * GLFW 2to3 - www.glfw.org
+ * A library easing porting from GLFW 2 to GLFW 3.x
+ *------------------------------------------------------------------------
+ * Copyright © 2020 Emmanuel Gil Peyrot <linkmauve@linkmauve.fr>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would
+ *    be appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not
+ *    be misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source
+ *    distribution.
+ *
+ *************************************************************************/
+
+
+// Fake GLFW 3 library, with a single window whose events come from a script
+// or from the harness
+
+#include "mock.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define GLFW_RELEASE 0
+#define GLFW_PRESS 1
+#define GLFW_REPEAT 2
+
+#define GLFW_FOCUSED 0x00020001
+#define GLFW_ICONIFIED 0x00020002
+#define GLFW_RESIZABLE 0x00020003
+
+#define MOCK_MAX_KEYS 349
+#define MOCK_MAX_BUTTONS 8
+#define MOCK_MAX_JOYSTICKS 16
+#define MOCK_MAX_JOYSTICK_INPUTS 32
+
+typedef struct GLFWwindow GLFWwindow;
+typedef struct GLFWmonitor GLFWmonitor;
+
+typedef void (* GLFWwindowsizefun)(GLFWwindow*, int, int);
+typedef void (* GLFWwindowclosefun)(GLFWwindow*);
+typedef void (* GLFWwindowrefreshfun)(GLFWwindow*);
+typedef void (* GLFWkeyfun)(GLFWwindow*, int, int, int, int);
+typedef void (* GLFWcharfun)(GLFWwindow*, unsigned int);
+typedef void (* GLFWmousebuttonfun)(GLFWwindow*, int, int, int);
+typedef void (* GLFWcursorposfun)(GLFWwindow*, double, double);
+typedef void (* GLFWscrollfun)(GLFWwindow*, double, double);
+
+typedef struct GLFWvidmode {
+    int width;
+    int height;
+    int redBits;
+    int greenBits;
+    int blueBits;
+    int refreshRate;
+} GLFWvidmode;
+
+struct GLFWwindow {
+    int width, height;
+    int x, y;
+    int focused;
+    int iconified;
+    int resizable;
+    double cursorx, cursory;
+    unsigned char keys[MOCK_MAX_KEYS];
+    unsigned char buttons[MOCK_MAX_BUTTONS];
+
+    GLFWwindowsizefun sizefun;
+    GLFWwindowclosefun closefun;
+    GLFWwindowrefreshfun refreshfun;
+    GLFWkeyfun keyfun;
+    GLFWcharfun charfun;
+    GLFWmousebuttonfun mousebuttonfun;
+    GLFWcursorposfun cursorposfun;
+    GLFWscrollfun scrollfun;
+};
+
+struct GLFWmonitor {
+    int unused;
+};
+
+typedef enum mockEventType {
+    MOCK_KEY,
+    MOCK_CHAR,
+    MOCK_BUTTON,
+    MOCK_CURSOR,
+    MOCK_SCROLL,
+    MOCK_RESIZE,
+    MOCK_FOCUS,
+    MOCK_CLOSE,
+    MOCK_AXES,
+    MOCK_JOYSTICK_BUTTONS,
+    MOCK_DISCONNECT,
+    MOCK_FRAME,
+} mockEventType;
+
+typedef struct mockEvent {
+    mockEventType type;
+    int code;
+    int action;
+    double x, y;
+    int count;
+    float values[MOCK_MAX_JOYSTICK_INPUTS];
+} mockEvent;
+
+typedef struct mockJoystick {
+    int present;
+    int axiscount;
+    int buttoncount;
+    float axes[MOCK_MAX_JOYSTICK_INPUTS];
+    unsigned char buttons[MOCK_MAX_JOYSTICK_INPUTS];
+} mockJoystick;
+
+// Provided by the mock OpenGL library
+void* _glfw2to3MockGetProcAddress(const char* name);
+void _glfw2to3MockSwapBuffers(void);
+const unsigned char* glGetString(unsigned int name);
+
+static struct {
+    int initialized;
+    GLFWwindow window;
+    int windowused;
+    int resizablehint;
+    GLFWwindow* current;
+    int interval;
+    GLFWmonitor monitor;
+    mockJoystick joysticks[MOCK_MAX_JOYSTICKS];
+
+    mockEvent* events;
+    int eventcount;
+    int eventsize;
+    int nextevent;
+} mock;
+
+static const GLFWvidmode vidmodes[] = {
+    { 640, 480, 8, 8, 8, 60 },
+    { 800, 600, 8, 8, 8, 60 },
+    { 1024, 768, 8, 8, 8, 60 },
+    { 1280, 720, 8, 8, 8, 60 },
+    { 1920, 1080, 8, 8, 8, 60 },
+};
+
+static void pushEvent(const mockEvent* event)
+{
+    if (mock.eventcount == mock.eventsize)
+    {
+        int size = mock.eventsize ? mock.eventsize * 2 : 64;
+        mockEvent* grown = realloc(mock.events, size * sizeof(mockEvent));
+        if (!grown)
+        {
+            abort();
+        }
+        mock.events = grown;
+        mock.eventsize = size;
+    }
+    mock.events[mock.eventcount++] = *event;
+}
+
+static int parseAction(const char* action)
+{
+    if (strcmp(action, "press") == 0)
+    {
+        return GLFW_PRESS;
+    }
+    if (strcmp(action, "release") == 0)
+    {
+        return GLFW_RELEASE;
+    }
+    if (strcmp(action, "repeat") == 0)
+    {
+        return GLFW_REPEAT;
+    }
+    return atoi(action);
+}
+
+// Reads the values following a joystick event into it
+static void parseValues(mockEvent* event, char* values)
+{
+    event->count = 0;
+    char* end;
+    for (;;)
+    {
+        float value = strtof(values, &end);
+        if (end == values || event->count == MOCK_MAX_JOYSTICK_INPUTS)
+        {
+            break;
+        }
+        event->values[event->count++] = value;
+        values = end;
+    }
+}
+
+static int parseEvent(mockEvent* event, char* line)
+{
+    char name[16], action[16];
+    int offset;
+
+    memset(event, 0, sizeof(*event));
+    if (sscanf(line, "key %d %15s", &event->code, action) == 2)
+    {
+        event->type = MOCK_KEY;
+        event->action = parseAction(action);
+    }
+    else if (sscanf(line, "char %d", &event->code) == 1)
+    {
+        event->type = MOCK_CHAR;
+    }
+    else if (sscanf(line, "button %d %15s", &event->code, action) == 2)
+    {
+        event->type = MOCK_BUTTON;
+        event->action = parseAction(action);
+    }
+    else if (sscanf(line, "cursor %lf %lf", &event->x, &event->y) == 2)
+    {
+        event->type = MOCK_CURSOR;
+    }
+    else if (sscanf(line, "scroll %lf %lf", &event->x, &event->y) == 2)
+    {
+        event->type = MOCK_SCROLL;
+    }
+    else if (sscanf(line, "resize %d %d", &event->code, &event->action) == 2)
+    {
+        event->type = MOCK_RESIZE;
+    }
+    else if (sscanf(line, "focus %d", &event->code) == 1)
+    {
+        event->type = MOCK_FOCUS;
+    }
+    else if (sscanf(line, "joystick %d %15s %n", &event->code, name, &offset) == 2)
+    {
+        if (strcmp(name, "axes") == 0)
+        {
+            event->type = MOCK_AXES;
+            parseValues(event, line + offset);
+        }
+        else if (strcmp(name, "buttons") == 0)
+        {
+            event->type = MOCK_JOYSTICK_BUTTONS;
+            parseValues(event, line + offset);
+        }
+        else if (strcmp(name, "disconnect") == 0)
+        {
+            event->type = MOCK_DISCONNECT;
+        }
+        else
+        {
+            return 0;
+        }
+    }
+    else if (sscanf(line, "%15s", name) == 1 && strcmp(name, "close") == 0)
+    {
+        event->type = MOCK_CLOSE;
+    }
+    else if (sscanf(line, "%15s", name) == 1 && strcmp(name, "frame") == 0)
+    {
+        event->type = MOCK_FRAME;
+    }
+    else
+    {
+        return 0;
+    }
+    return 1;
+}
+
+static void loadScript(const char* path)
+{
+    FILE* file = fopen(path, "r");
+    if (!file)
+    {
+        perror(path);
+        return;
+    }
+
+    char line[1024];
+    int number = 0;
+    while (fgets(line, sizeof(line), file))
+    {
+        number++;
+        char* start = line + strspn(line, " \t");
+        if (*start == '#' || *start == '\n' || *start == '\0')
+        {
+            continue;
+        }
+
+        mockEvent event;
+        if (parseEvent(&event, start))
+        {
+            pushEvent(&event);
+        }
+        else
+        {
+            fprintf(stderr, "%s:%d: unknown mock event\n", path, number);
+        }
+    }
+    fclose(file);
+}
+
+static void setJoystick(const mockEvent* event)
+{
+    if (event->code < 0 || event->code >= MOCK_MAX_JOYSTICKS)
+    {
+        return;
+    }
+
+    mockJoystick* joystick = &mock.joysticks[event->code];
+    if (event->type == MOCK_DISCONNECT)
+    {
+        memset(joystick, 0, sizeof(*joystick));
+        return;
+    }
+
+    joystick->present = 1;
+    if (event->type == MOCK_AXES)
+    {
+        joystick->axiscount = event->count;
+        memcpy(joystick->axes, event->values, event->count * sizeof(float));
+    }
+    else
+    {
+        joystick->buttoncount = event->count;
+        for (int i = 0; i < event->count; i++)
+        {
+            joystick->buttons[i] = event->values[i] != 0.f;
+        }
+    }
+}
+
+static void deliverEvent(const mockEvent* event)
+{
+    GLFWwindow* window = mock.windowused ? &mock.window : NULL;
+
+    switch (event->type)
+    {
+    case MOCK_AXES:
+    case MOCK_JOYSTICK_BUTTONS:
+    case MOCK_DISCONNECT:
+        setJoystick(event);
+        return;
+    default:
+        break;
+    }
+
+    if (!window)
+    {
+        return;
+    }
+
+    switch (event->type)
+    {
+    case MOCK_KEY:
+        if (event->code >= 0 && event->code < MOCK_MAX_KEYS)
+        {
+            window->keys[event->code] = event->action != GLFW_RELEASE;
+        }
+        if (window->keyfun)
+        {
+            window->keyfun(window, event->code, 0, event->action, 0);
+        }
+        break;
+    case MOCK_CHAR:
+        if (window->charfun)
+        {
+            window->charfun(window, (unsigned int)event->code);
+        }
+        break;
+    case MOCK_BUTTON:
+        if (event->code >= 0 && event->code < MOCK_MAX_BUTTONS)
+        {
+            window->buttons[event->code] = event->action != GLFW_RELEASE;
+        }
+        if (window->mousebuttonfun)
+        {
+            window->mousebuttonfun(window, event->code, event->action, 0);
+        }
+        break;
+    case MOCK_CURSOR:
+        window->cursorx = event->x;
+        window->cursory = event->y;
+        if (window->cursorposfun)
+        {
+            window->cursorposfun(window, event->x, event->y);
+        }
+        break;
+    case MOCK_SCROLL:
+        if (window->scrollfun)
+        {
+            window->scrollfun(window, event->x, event->y);
+        }
+        break;
+    case MOCK_RESIZE:
+        window->width = event->code;
+        window->height = event->action;
+        if (window->sizefun)
+        {
+            window->sizefun(window, window->width, window->height);
+        }
+        if (window->refreshfun)
+        {
+            window->refreshfun(window);
+        }
+        break;
+    case MOCK_FOCUS:
+        window->focused = event->code;
+        break;
+    case MOCK_CLOSE:
+        if (window->closefun)
+        {
+            window->closefun(window);
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+// Delivers the queued events up to the end of the next scripted frame
+static void processEvents(void)
+{
+    while (mock.nextevent < mock.eventcount)
+    {
+        mockEvent event = mock.events[mock.nextevent++];
+        if (event.type == MOCK_FRAME)
+        {
+            break;
+        }
+        deliverEvent(&event);
+    }
+
+    if (mock.nextevent == mock.eventcount)
+    {
+        mock.nextevent = mock.eventcount = 0;
+    }
+}
+
+/* GLFW 3 API */
+
+int glfwInit(void)
+{
+    free(mock.events);
+    memset(&mock, 0, sizeof(mock));
+    mock.resizablehint = 1;
+    mock.initialized = 1;
+
+    const char* script = getenv("GLFW2TO3_MOCK_EVENTS");
+    if (script)
+    {
+        loadScript(script);
+    }
+    return 1;
+}
+
+void glfwTerminate(void)
+{
+    free(mock.events);
+    memset(&mock, 0, sizeof(mock));
+}
+
+void glfwWindowHint(int hint, int value)
+{
+    if (hint == GLFW_RESIZABLE)
+    {
+        mock.resizablehint = value;
+    }
+}
+
+GLFWwindow* glfwCreateWindow(int width, int height, const char* title, GLFWmonitor* monitor, GLFWwindow* share)
+{
+    (void)title;
+    (void)monitor;
+    (void)share;
+    if (!mock.initialized || mock.windowused || width <= 0 || height <= 0)
+    {
+        return NULL;
+    }
+
+    memset(&mock.window, 0, sizeof(mock.window));
+    mock.window.width = width;
+    mock.window.height = height;
+    mock.window.focused = 1;
+    mock.window.resizable = mock.resizablehint;
+    mock.windowused = 1;
+    return &mock.window;
+}
+
+void glfwDestroyWindow(GLFWwindow* window)
+{
+    if (window == &mock.window)
+    {
+        mock.windowused = 0;
+        if (mock.current == window)
+        {
+            mock.current = NULL;
+        }
+    }
+}
+
+void glfwIconifyWindow(GLFWwindow* window)
+{
+    window->iconified = 1;
+}
+
+void glfwRestoreWindow(GLFWwindow* window)
+{
+    window->iconified = 0;
+}
+
+void glfwMakeContextCurrent(GLFWwindow* window)
+{
+    mock.current = window;
+}
+
+void glfwSetWindowTitle(GLFWwindow* window, const char* title)
+{
+    (void)window;
+    (void)title;
+}
+
+void glfwSetWindowPos(GLFWwindow* window, int x, int y)
+{
+    window->x = x;
+    window->y = y;
+}
+
+void glfwGetFramebufferSize(GLFWwindow* window, int* width, int* height)
+{
+    if (width)
+    {
+        *width = window->width;
+    }
+    if (height)
+    {
+        *height = window->height;
+    }
+}
+
+void glfwGetWindowContentScale(GLFWwindow* window, float* xscale, float* yscale)
+{
+    (void)window;
+    if (xscale)
+    {
+        *xscale = 1.f;
+    }
+    if (yscale)
+    {
+        *yscale = 1.f;
+    }
+}
+
+// The window manager takes its time, the size changes on the next events
+void glfwSetWindowSize(GLFWwindow* window, int width, int height)
+{
+    (void)window;
+    glfw2to3MockResize(width, height);
+}
+
+int glfwGetWindowAttrib(GLFWwindow* window, int attrib)
+{
+    switch (attrib)
+    {
+    case GLFW_FOCUSED:
+        return window->focused;
+    case GLFW_ICONIFIED:
+        return window->iconified;
+    case GLFW_RESIZABLE:
+        return window->resizable;
+    default:
+        return 0;
+    }
+}
+
+GLFWwindowsizefun glfwSetWindowSizeCallback(GLFWwindow* window, GLFWwindowsizefun cbfun)
+{
+    GLFWwindowsizefun previous = window->sizefun;
+    window->sizefun = cbfun;
+    return previous;
+}
+
+GLFWwindowclosefun glfwSetWindowCloseCallback(GLFWwindow* window, GLFWwindowclosefun cbfun)
+{
+    GLFWwindowclosefun previous = window->closefun;
+    window->closefun = cbfun;
+    return previous;
+}
+
+GLFWwindowrefreshfun glfwSetWindowRefreshCallback(GLFWwindow* window, GLFWwindowrefreshfun cbfun)
+{
+    GLFWwindowrefreshfun previous = window->refreshfun;
+    window->refreshfun = cbfun;
+    return previous;
+}
+
+GLFWkeyfun glfwSetKeyCallback(GLFWwindow* window, GLFWkeyfun cbfun)
+{
+    GLFWkeyfun previous = window->keyfun;
+    window->keyfun = cbfun;
+    return previous;
+}
+
+GLFWcharfun glfwSetCharCallback(GLFWwindow* window, GLFWcharfun cbfun)
+{
+    GLFWcharfun previous = window->charfun;
+    window->charfun = cbfun;
+    return previous;
+}
+
+GLFWmousebuttonfun glfwSetMouseButtonCallback(GLFWwindow* window, GLFWmousebuttonfun cbfun)
+{
+    GLFWmousebuttonfun previous = window->mousebuttonfun;
+    window->mousebuttonfun = cbfun;
+    return previous;
+}
+
+GLFWcursorposfun glfwSetCursorPosCallback(GLFWwindow* window, GLFWcursorposfun cbfun)
+{
+    GLFWcursorposfun previous = window->cursorposfun;
+    window->cursorposfun = cbfun;
+    return previous;
+}
+
+GLFWscrollfun glfwSetScrollCallback(GLFWwindow* window, GLFWscrollfun cbfun)
+{
+    GLFWscrollfun previous = window->scrollfun;
+    window->scrollfun = cbfun;
+    return previous;
+}
+
+int glfwGetKey(GLFWwindow* window, int key)
+{
+    if (key < 0 || key >= MOCK_MAX_KEYS)
+    {
+        return GLFW_RELEASE;
+    }
+    return window->keys[key];
+}
+
+int glfwGetMouseButton(GLFWwindow* window, int button)
+{
+    if (button < 0 || button >= MOCK_MAX_BUTTONS)
+    {
+        return GLFW_RELEASE;
+    }
+    return window->buttons[button];
+}
+
+void glfwGetCursorPos(GLFWwindow* window, double* xpos, double* ypos)
+{
+    if (xpos)
+    {
+        *xpos = window->cursorx;
+    }
+    if (ypos)
+    {
+        *ypos = window->cursory;
+    }
+}
+
+void glfwSetCursorPos(GLFWwindow* window, double xpos, double ypos)
+{
+    window->cursorx = xpos;
+    window->cursory = ypos;
+}
+
+void glfwSwapBuffers(GLFWwindow* window)
+{
+    (void)window;
+    _glfw2to3MockSwapBuffers();
+}
+
+void glfwSwapInterval(int interval)
+{
+    mock.interval = interval;
+}
+
+int glfwExtensionSupported(const char* extension)
+{
+    if (!mock.current)
+    {
+        return 0;
+    }
+
+    const char* extensions = (const char*)glGetString(0x1F03);
+    size_t length = strlen(extension);
+    for (const char* start = extensions; (start = strstr(start, extension)); start += length)
+    {
+        if ((start == extensions || start[-1] == ' ') &&
+            (start[length] == ' ' || start[length] == '\0'))
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+void* glfwGetProcAddress(const char* procname)
+{
+    if (!mock.current)
+    {
+        return NULL;
+    }
+    return _glfw2to3MockGetProcAddress(procname);
+}
+
+GLFWmonitor* glfwGetPrimaryMonitor(void)
+{
+    return &mock.monitor;
+}
+
+const GLFWvidmode* glfwGetVideoModes(GLFWmonitor* monitor, int* count)
+{
+    (void)monitor;
+    *count = sizeof(vidmodes) / sizeof(vidmodes[0]);
+    return vidmodes;
+}
+
+const GLFWvidmode* glfwGetVideoMode(GLFWmonitor* monitor)
+{
+    (void)monitor;
+    return &vidmodes[sizeof(vidmodes) / sizeof(vidmodes[0]) - 1];
+}
+
+void glfwPollEvents(void)
+{
+    processEvents();
+}
+
+// Never blocks, a game waiting for events which will never come would hang
+void glfwWaitEvents(void)
+{
+    processEvents();
+}
+
+int glfwJoystickPresent(int jid)
+{
+    if (jid < 0 || jid >= MOCK_MAX_JOYSTICKS)
+    {
+        return 0;
+    }
+    return mock.joysticks[jid].present;
+}
+
+const float* glfwGetJoystickAxes(int jid, int* count)
+{
+    *count = 0;
+    if (!glfwJoystickPresent(jid))
+    {
+        return NULL;
+    }
+    *count = mock.joysticks[jid].axiscount;
+    return mock.joysticks[jid].axes;
+}
+
+const unsigned char* glfwGetJoystickButtons(int jid, int* count)
+{
+    *count = 0;
+    if (!glfwJoystickPresent(jid))
+    {
+        return NULL;
+    }
+    *count = mock.joysticks[jid].buttoncount;
+    return mock.joysticks[jid].buttons;
+}
+
+/* Harness API */
+
+void glfw2to3MockKey(int key, int action)
+{
+    pushEvent(&(mockEvent){ .type = MOCK_KEY, .code = key, .action = action });
+}
+
+void glfw2to3MockChar(unsigned int codepoint)
+{
+    pushEvent(&(mockEvent){ .type = MOCK_CHAR, .code = (int)codepoint });
+}
+
+void glfw2to3MockMouseButton(int button, int action)
+{
+    pushEvent(&(mockEvent){ .type = MOCK_BUTTON, .code = button, .action = action });
+}
+
+void glfw2to3MockCursorPos(double xpos, double ypos)
+{
+    pushEvent(&(mockEvent){ .type = MOCK_CURSOR, .x = xpos, .y = ypos });
+}
+
+void glfw2to3MockScroll(double xoffset, double yoffset)
+{
+    pushEvent(&(mockEvent){ .type = MOCK_SCROLL, .x = xoffset, .y = yoffset });
+}
+
+void glfw2to3MockResize(int width, int height)
+{
+    pushEvent(&(mockEvent){ .type = MOCK_RESIZE, .code = width, .action = height });
+}
+
+void glfw2to3MockClose(void)
+{
+    pushEvent(&(mockEvent){ .type = MOCK_CLOSE });
+}
+
+void glfw2to3MockJoystickAxes(int joy, const float* axes, int count)
+{
+    mockEvent event = { .type = MOCK_AXES, .code = joy };
+    event.count = count < MOCK_MAX_JOYSTICK_INPUTS ? count : MOCK_MAX_JOYSTICK_INPUTS;
+    memcpy(event.values, axes, event.count * sizeof(float));
+    pushEvent(&event);
+}
+
+void glfw2to3MockJoystickButtons(int joy, const unsigned char* buttons, int count)
+{
+    mockEvent event = { .type = MOCK_JOYSTICK_BUTTONS, .code = joy };
+    event.count = count < MOCK_MAX_JOYSTICK_INPUTS ? count : MOCK_MAX_JOYSTICK_INPUTS;
+    for (int i = 0; i < event.count; i++)
+    {
+        event.values[i] = buttons[i];
+    }
+    pushEvent(&event);
+}
@@ -0,0 +1,67 @@
+/*************************************************************************
+ * GLFW 2to3 - www.glfw.org
+ * A library easing porting from GLFW 2 to GLFW 3.x
+ *------------------------------------------------------------------------
+ * Copyright © 2020 Emmanuel Gil Peyrot <linkmauve@linkmauve.fr>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would
+ *    be appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not
+ *    be misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source
+ *    distribution.
+ *
+ *************************************************************************/
+
+
+#ifndef _glfw2to3_mock_h_
+#define _glfw2to3_mock_h_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Control of the mock GLFW 3 and OpenGL libraries, for harnesses running in
+ * the same process as the game.
+ *
+ * Injected events are queued after those of the GLFW2TO3_MOCK_EVENTS script,
+ * and delivered by the next glfwPollEvents() or glfwWaitEvents() of GLFW 3.
+ * Keys and buttons use the GLFW 3 codes and actions.
+ */
+
+void glfw2to3MockKey(int key, int action);
+void glfw2to3MockChar(unsigned int codepoint);
+void glfw2to3MockMouseButton(int button, int action);
+void glfw2to3MockCursorPos(double xpos, double ypos);
+void glfw2to3MockScroll(double xoffset, double yoffset);
+void glfw2to3MockResize(int width, int height);
+void glfw2to3MockClose(void);
+void glfw2to3MockJoystickAxes(int joy, const float* axes, int count);
+void glfw2to3MockJoystickButtons(int joy, const unsigned char* buttons, int count);
+
+/* Number of calls made to an OpenGL function of the mock since the last
+ * reset, or to all of them when name is NULL.
+ */
+long glfw2to3MockGetGLCalls(const char* name);
+void glfw2to3MockResetGLCalls(void);
+
+/* Number of buffer swaps so far */
+long glfw2to3MockGetFrame(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _glfw2to3_mock_h_ */
@@ -0,0 +1,383 @@
+/*************************************************************************
+ * GLFW 2to3 - www.glfw.org
+ * A library easing porting from GLFW 2 to GLFW 3.x
+ *------------------------------------------------------------------------
+ * Copyright © 2020 Emmanuel Gil Peyrot <linkmauve@linkmauve.fr>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would
+ *    be appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not
+ *    be misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source
+ *    distribution.
+ *
+ *************************************************************************/
+
+#include "internal.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// Each codec is enabled by the build system when its library is found
+#ifndef _GLFW_HAVE_ZLIB
+#define _GLFW_HAVE_ZLIB 0
+#endif
+#ifndef _GLFW_HAVE_ZSTD
+#define _GLFW_HAVE_ZSTD 0
+#endif
+#ifndef _GLFW_HAVE_LZ4
+#define _GLFW_HAVE_LZ4 0
+#endif
+
+#if _GLFW_HAVE_ZLIB
+#include <zlib.h>
+#endif
+#if _GLFW_HAVE_ZSTD
+#include <zstd.h>
+#endif
+#if _GLFW_HAVE_LZ4
+#include <lz4frame.h>
+#endif
+
+/* Transparent decompression of image streams */
+
+// Size of both the compressed input window and the decoded output window
+#define _GLFW_DECODER_WINDOW 65536
+
+struct _GLFWdecoder
+{
+    int codec;
+    int eof;
+
+    // Compressed bytes not yet consumed by the codec
+    unsigned char in[_GLFW_DECODER_WINDOW];
+    size_t inpos, insize;
+
+    // Decoded bytes not yet returned, used to batch small reads
+    unsigned char out[_GLFW_DECODER_WINDOW];
+    size_t outpos, outsize;
+
+    union
+    {
+#if _GLFW_HAVE_ZLIB
+        z_stream zlib;
+#endif
+#if _GLFW_HAVE_ZSTD
+        ZSTD_DStream* zstd;
+#endif
+#if _GLFW_HAVE_LZ4
+        LZ4F_dctx* lz4;
+#endif
+        int unused;
+    };
+};
+
+static const struct
+{
+    const char* suffix;
+    unsigned char magic[4];
+    int magicsize;
+    int available;
+} codecs[_GLFW_CODEC_COUNT] =
+{
+    [_GLFW_CODEC_GZIP] = { ".gz",  { 0x1f, 0x8b }, 2, _GLFW_HAVE_ZLIB },
+    [_GLFW_CODEC_ZSTD] = { ".zst", { 0x28, 0xb5, 0x2f, 0xfd }, 4, _GLFW_HAVE_ZSTD },
+    [_GLFW_CODEC_LZ4]  = { ".lz4", { 0x04, 0x22, 0x4d, 0x18 }, 4, _GLFW_HAVE_LZ4 },
+};
+
+// Runs the codec over the input window, returns the number of bytes decoded
+// into data or -1 on corrupt input
+static long decode(_GLFWdecoder* decoder, unsigned char* data, size_t size)
+{
+    const unsigned char* in = decoder->in + decoder->inpos;
+    size_t insize = decoder->insize - decoder->inpos;
+
+    switch (decoder->codec)
+    {
+#if _GLFW_HAVE_ZLIB
+        case _GLFW_CODEC_GZIP:
+        {
+            z_stream* z = &decoder->zlib;
+            z->next_in = (unsigned char*)in;
+            z->avail_in = (uInt)insize;
+            z->next_out = data;
+            z->avail_out = (uInt)(size < UINT32_MAX ? size : UINT32_MAX);
+            uInt avail = z->avail_out;
+
+            int result = inflate(z, Z_NO_FLUSH);
+            decoder->inpos += insize - z->avail_in;
+            if (result == Z_STREAM_END)
+            {
+                // Concatenated gzip members form a single stream
+                inflateReset(z);
+            }
+            else if (result != Z_OK && result != Z_BUF_ERROR)
+            {
+                return -1;
+            }
+            return avail - z->avail_out;
+        }
+#endif
+#if _GLFW_HAVE_ZSTD
+        case _GLFW_CODEC_ZSTD:
+        {
+            ZSTD_inBuffer input = { in, insize, 0 };
+            ZSTD_outBuffer output = { data, size, 0 };
+
+            size_t result = ZSTD_decompressStream(decoder->zstd, &output, &input);
+            if (ZSTD_isError(result))
+            {
+                return -1;
+            }
+            decoder->inpos += input.pos;
+            return output.pos;
+        }
+#endif
+#if _GLFW_HAVE_LZ4
+        case _GLFW_CODEC_LZ4:
+        {
+            size_t outsize = size;
+
+            size_t result = LZ4F_decompress(decoder->lz4, data, &outsize,
+                                            in, &insize, NULL);
+            if (LZ4F_isError(result))
+            {
+                return -1;
+            }
+            decoder->inpos += insize;
+            return outsize;
+        }
+#endif
+        default:
+            (void)in;
+            (void)insize;
+            (void)data;
+            (void)size;
+            return -1;
+    }
+}
+
+// Decodes at least one byte into data unless the end of the stream is
+// reached, refilling the input window as needed
+static long fill(_GLFWdecoder* decoder, unsigned char* data, size_t size,
+                 _GLFWrawreadfun read, void* user)
+{
+    for (;;)
+    {
+        if (decoder->inpos == decoder->insize && !decoder->eof)
+        {
+            long count = read(user, decoder->in, sizeof(decoder->in));
+            if (count <= 0)
+            {
+                decoder->eof = GL_TRUE;
+            }
+            decoder->inpos = 0;
+            decoder->insize = count > 0 ? count : 0;
+        }
+
+        size_t inpos = decoder->inpos;
+        long count = decode(decoder, data, size);
+        if (count != 0)
+        {
+            return count;
+        }
+
+        // Stop once the codec can't make progress with the input it has
+        if (decoder->inpos == inpos &&
+            (decoder->eof || decoder->inpos < decoder->insize))
+        {
+            return 0;
+        }
+    }
+}
+
+int _glfwDetectCompression(const unsigned char* magic, long size)
+{
+    for (int codec = 1; codec < _GLFW_CODEC_COUNT; ++codec)
+    {
+        if (codecs[codec].available && size >= codecs[codec].magicsize &&
+            !memcmp(magic, codecs[codec].magic, codecs[codec].magicsize))
+        {
+            return codec;
+        }
+    }
+
+    return _GLFW_CODEC_NONE;
+}
+
+const char* _glfwGetCompressionSuffix(int codec)
+{
+    if (codec <= _GLFW_CODEC_NONE || codec >= _GLFW_CODEC_COUNT ||
+        !codecs[codec].available)
+    {
+        return NULL;
+    }
+
+    return codecs[codec].suffix;
+}
+
+_GLFWdecoder* _glfwCreateDecoder(int codec)
+{
+    _GLFWdecoder* decoder = _glfwCalloc(1, sizeof(_GLFWdecoder), GLFW_MEMORY_OTHER);
+    if (!decoder)
+    {
+        return NULL;
+    }
+
+    decoder->codec = codec;
+
+    switch (codec)
+    {
+#if _GLFW_HAVE_ZLIB
+        case _GLFW_CODEC_GZIP:
+            // The extra 16 of windowBits selects the gzip wrapper
+            if (inflateInit2(&decoder->zlib, 15 + 16) == Z_OK)
+            {
+                return decoder;
+            }
+            break;
+#endif
+#if _GLFW_HAVE_ZSTD
+        case _GLFW_CODEC_ZSTD:
+            decoder->zstd = ZSTD_createDStream();
+            if (decoder->zstd)
+            {
+                ZSTD_initDStream(decoder->zstd);
+                return decoder;
+            }
+            break;
+#endif
+#if _GLFW_HAVE_LZ4
+        case _GLFW_CODEC_LZ4:
+            if (!LZ4F_isError(LZ4F_createDecompressionContext(&decoder->lz4,
+                                                              LZ4F_VERSION)))
+            {
+                return decoder;
+            }
+            break;
+#endif
+        default:
+            break;
+    }
+
+    _glfwFree(decoder, GLFW_MEMORY_OTHER);
+    return NULL;
+}
+
+long _glfwDecoderRead(_GLFWdecoder* decoder, void* data, long size,
+                      _GLFWrawreadfun read, void* user)
+{
+    unsigned char* dst = data;
+    long done = 0;
+
+    while (done < size)
+    {
+        if (decoder->outpos < decoder->outsize)
+        {
+            size_t count = decoder->outsize - decoder->outpos;
+            if (count > (size_t)(size - done))
+            {
+                count = size - done;
+            }
+            memcpy(dst + done, decoder->out + decoder->outpos, count);
+            decoder->outpos += count;
+            done += count;
+            continue;
+        }
+
+        // Large reads are decoded in place, small ones through the window
+        long count;
+        if (size - done >= _GLFW_DECODER_WINDOW)
+        {
+            count = fill(decoder, dst + done, size - done, read, user);
+            if (count > 0)
+            {
+                done += count;
+            }
+        }
+        else
+        {
+            count = fill(decoder, decoder->out, sizeof(decoder->out), read, user);
+            decoder->outpos = 0;
+            decoder->outsize = count > 0 ? count : 0;
+        }
+
+        if (count <= 0)
+        {
+            break;
+        }
+    }
+
+    return done;
+}
+
+void _glfwResetDecoder(_GLFWdecoder* decoder)
+{
+    decoder->eof = GL_FALSE;
+    decoder->inpos = decoder->insize = 0;
+    decoder->outpos = decoder->outsize = 0;
+
+    switch (decoder->codec)
+    {
+#if _GLFW_HAVE_ZLIB
+        case _GLFW_CODEC_GZIP:
+            inflateReset(&decoder->zlib);
+            break;
+#endif
+#if _GLFW_HAVE_ZSTD
+        case _GLFW_CODEC_ZSTD:
+            ZSTD_initDStream(decoder->zstd);
+            break;
+#endif
+#if _GLFW_HAVE_LZ4
+        case _GLFW_CODEC_LZ4:
+            LZ4F_resetDecompressionContext(decoder->lz4);
+            break;
+#endif
+        default:
+            break;
+    }
+}
+
+void _glfwDestroyDecoder(_GLFWdecoder* decoder)
+{
+    if (!decoder)
+    {
+        return;
+    }
+
+    switch (decoder->codec)
+    {
+#if _GLFW_HAVE_ZLIB
+        case _GLFW_CODEC_GZIP:
+            inflateEnd(&decoder->zlib);
+            break;
+#endif
+#if _GLFW_HAVE_ZSTD
+        case _GLFW_CODEC_ZSTD:
+            ZSTD_freeDStream(decoder->zstd);
+            break;
+#endif
+#if _GLFW_HAVE_LZ4
+        case _GLFW_CODEC_LZ4:
+            LZ4F_freeDecompressionContext(decoder->lz4);
+            break;
+#endif
+        default:
+            break;
+    }
+
+    _glfwFree(decoder, GLFW_MEMORY_OTHER);
+}
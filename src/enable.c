@@ -38,6 +38,12 @@ GLFWAPI void GLFWAPIENTRY glfwEnable(int token)
     case GLFW_KEY_REPEAT:
         // Nothing to do, already enabled in GLFW 3.
         break;
+    case GLFW_IMAGE_STATS:
+        _glfw.imagestats = GL_TRUE;
+        break;
+    case GLFW_PACKED_TEXTURES:
+        _glfw.packedtextures = GL_TRUE;
+        break;
     default:
         fprintf(stderr, "Unsupported glfwEnable(0x%x)\n", token);
     }
@@ -50,6 +56,12 @@ GLFWAPI void GLFWAPIENTRY glfwDisable(int token)
     case GLFW_AUTO_POLL_EVENTS:
         // Nothing to do, already disabled in GLFW 3.
         break;
+    case GLFW_IMAGE_STATS:
+        _glfw.imagestats = GL_FALSE;
+        break;
+    case GLFW_PACKED_TEXTURES:
+        _glfw.packedtextures = GL_FALSE;
+        break;
     default:
         fprintf(stderr, "Unsupported glfwDisable(0x%x)\n", token);
     }
@@ -27,20 +27,143 @@
 
 #include "internal.h"
 
+#include <string.h>
+
+struct _GLFWprocentry {
+    char* name;
+    uint32_t hash;
+    void* proc;
+};
+
+// FNV-1a
+static uint32_t hashName(const char* name)
+{
+    uint32_t hash = 2166136261u;
+    while (*name)
+    {
+        hash = (hash ^ (unsigned char)*name++) * 16777619u;
+    }
+    return hash;
+}
+
+// Returns the entry holding name, or the empty one where it would go
+static _GLFWprocentry* findProc(_GLFWprocentry* procs, int size, const char* name, uint32_t hash)
+{
+    int i = hash & (size - 1);
+    while (procs[i].name &&
+           (procs[i].hash != hash || strcmp(procs[i].name, name) != 0))
+    {
+        i = (i + 1) & (size - 1);
+    }
+    return &procs[i];
+}
+
+static int growProcCache(void)
+{
+    int size = _glfw.procsize ? _glfw.procsize * 2 : 256;
+    _GLFWprocentry* procs = _glfwCalloc(size, sizeof(_GLFWprocentry), GLFW_MEMORY_OTHER);
+    if (!procs)
+    {
+        return GL_FALSE;
+    }
+
+    for (int i = 0; i < _glfw.procsize; i++)
+    {
+        const _GLFWprocentry* entry = &_glfw.procs[i];
+        if (entry->name)
+        {
+            *findProc(procs, size, entry->name, entry->hash) = *entry;
+        }
+    }
+
+    _glfwFree(_glfw.procs, GLFW_MEMORY_OTHER);
+    _glfw.procs = procs;
+    _glfw.procsize = size;
+    return GL_TRUE;
+}
+
+void _glfwFlushProcCache(void)
+{
+    for (int i = 0; i < _glfw.procsize; i++)
+    {
+        _glfwFree(_glfw.procs[i].name, GLFW_MEMORY_OTHER);
+    }
+    _glfwFree(_glfw.procs, GLFW_MEMORY_OTHER);
+    _glfw.procs = NULL;
+    _glfw.procsize = 0;
+    _glfw.proccount = 0;
+
+    _glfwFlushGLProcs();
+}
+
 /* Extension support */
 
-GLFWAPI int   GLFWAPIENTRY glfwExtensionSupported(const char *extension)
+static int extensionSupported(const char *extension)
 {
-    return _glfw.glfwExtensionSupported(extension);
+    _GLFW_COUNT_CALL(glfwExtensionSupported);
+    return _GLFW3(glfwExtensionSupported)(extension);
 }
 
+_GLFW_FORWARD(glfwExtensionSupported, extensionSupported);
+
 GLFWAPI void* GLFWAPIENTRY glfwGetProcAddress(const char *procname)
 {
-    return _glfw.glfwGetProcAddress(procname);
+    _GLFW_COUNT_CALL(glfwGetProcAddress);
+    if (!_glfw.window || !procname)
+    {
+        return _GLFW3(glfwGetProcAddress)(procname);
+    }
+
+    // Entry points don't change for the lifetime of a context, and games
+    // tend to look the same ones up again and again
+    uint32_t hash = hashName(procname);
+    if (_glfw.procs)
+    {
+        const _GLFWprocentry* entry = findProc(_glfw.procs, _glfw.procsize, procname, hash);
+        if (entry->name)
+        {
+            _glfw.prochits++;
+            return entry->proc;
+        }
+    }
+
+    _glfw.procmisses++;
+    void* proc = _glfwInterposeGLProc(procname, _GLFW3(glfwGetProcAddress)(procname), GL_TRUE);
+
+    // Keep at most half of the table used, so that probes stay short
+    if ((_glfw.proccount + 1) * 2 > _glfw.procsize && !growProcCache())
+    {
+        return proc;
+    }
+
+    size_t length = strlen(procname) + 1;
+    char* name = _glfwMalloc(length, GLFW_MEMORY_OTHER);
+    if (name)
+    {
+        memcpy(name, procname, length);
+        *findProc(_glfw.procs, _glfw.procsize, name, hash) =
+            (_GLFWprocentry){ .name = name, .hash = hash, .proc = proc };
+        _glfw.proccount++;
+    }
+    return proc;
+}
+
+GLFWAPI void  GLFWAPIENTRY glfwGetProcAddressStats(long *hits, long *misses)
+{
+    _GLFW_COUNT_CALL(glfwGetProcAddressStats);
+    if (hits)
+    {
+        *hits = _glfw.prochits;
+    }
+    if (misses)
+    {
+        *misses = _glfw.procmisses;
+    }
 }
 
 GLFWAPI void  GLFWAPIENTRY glfwGetGLVersion(int *major, int *minor, int *rev)
 {
+    _GLFW_COUNT_CALL(glfwGetGLVersion);
     if (!_glfw.window)
     {
         return;
@@ -0,0 +1,2862 @@
+/*************************************************************************
+ * GLFW 2to3 - www.glfw.org
+ * A library easing porting from GLFW 2 to GLFW 3.x
+ *------------------------------------------------------------------------
+ * Copyright © 2020 Emmanuel Gil Peyrot <linkmauve@linkmauve.fr>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would
+ *    be appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not
+ *    be misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source
+ *    distribution.
+ *
+ *************************************************************************/
+
+
+// All the OpenGL prototypes are needed to wrap the functions with them
+#define GL_GLEXT_PROTOTYPES
+#include "internal.h"
+
+#include <dlfcn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* OpenGL call interposition */
+
+enum {
+    CATEGORY_DRAW,
+    CATEGORY_BIND,
+    CATEGORY_UPLOAD,
+    CATEGORY_STATE,
+    CATEGORY_GET,
+    CATEGORY_VERTEX,
+    CATEGORY_OTHER,
+    CATEGORY_COUNT
+};
+
+static const char* category_names[CATEGORY_COUNT] = {
+    "draws",
+    "binds",
+    "uploads",
+    "state",
+    "glGet",
+    "vertices",
+    "other",
+};
+
+// Wrapped functions, V(category, hook, name, params, args, bytes uploaded)
+// for those returning void, and R(category, type, name, params, args) for
+// the others.  With GLFW2TO3_GL_FILTER, SKIP functions are dropped when they
+// change nothing, SYNC ones update the shadowed state they change without
+// being shadowed themselves, and FORGET ones make the filter forget it.  Any
+// function changing shadowed state must be one of these, or the filter
+// would drop calls which do change it.  With GLFW2TO3_GL_BATCH, BATCH ones are
+// recorded between glBegin() and glEnd(), and all the others draw the
+// primitives recorded so far first.  Every function allowed between glBegin()
+// and glEnd() must be listed, or it would reach the driver before the
+// primitive it belongs to
+#define GL_FUNCTIONS(V, R) \
+    V(DRAW, BATCH, glBegin, (GLenum mode), (mode), 0) \
+    V(DRAW, FORGET, glDrawArrays, (GLenum mode, GLint first, GLsizei count), (mode, first, count), 0) \
+    V(DRAW, FORGET, glDrawElements, (GLenum mode, GLsizei count, GLenum type, const GLvoid* indices), (mode, count, type, indices), 0) \
+    V(DRAW, FORGET, glDrawRangeElements, (GLenum mode, GLuint start, GLuint end, GLsizei count, GLenum type, const GLvoid* indices), (mode, start, end, count, type, indices), 0) \
+    V(DRAW, FORGET, glCallList, (GLuint list), (list), 0) \
+    V(DRAW, FORGET, glCallLists, (GLsizei n, GLenum type, const GLvoid* lists), (n, type, lists), 0) \
+    V(DRAW, FORGET, glMultiDrawArrays, (GLenum mode, const GLint* first, const GLsizei* count, GLsizei drawcount), (mode, first, count, drawcount), 0) \
+    V(DRAW, FORGET, glMultiDrawElements, (GLenum mode, const GLsizei* count, GLenum type, const void* const* indices, GLsizei drawcount), (mode, count, type, indices, drawcount), 0) \
+    V(DRAW, FORGET, glDrawArraysInstanced, (GLenum mode, GLint first, GLsizei count, GLsizei instancecount), (mode, first, count, instancecount), 0) \
+    V(DRAW, FORGET, glDrawElementsInstanced, (GLenum mode, GLsizei count, GLenum type, const void* indices, GLsizei instancecount), (mode, count, type, indices, instancecount), 0) \
+    V(DRAW, FORGET, glDrawElementsBaseVertex, (GLenum mode, GLsizei count, GLenum type, const void* indices, GLint basevertex), (mode, count, type, indices, basevertex), 0) \
+    V(DRAW, NONE, glDrawPixels, (GLsizei width, GLsizei height, GLenum format, GLenum type, const GLvoid* pixels), (width, height, format, type, pixels), 0) \
+    V(BIND, SKIP, glBindTexture, (GLenum target, GLuint texture), (target, texture), 0) \
+    V(BIND, SKIP, glBindBuffer, (GLenum target, GLuint buffer), (target, buffer), 0) \
+    V(BIND, SYNC, glBindBufferBase, (GLenum target, GLuint index, GLuint buffer), (target, index, buffer), 0) \
+    V(BIND, SYNC, glBindBufferRange, (GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size), (target, index, buffer, offset, size), 0) \
+    V(BIND, SYNC, glBindTextures, (GLuint first, GLsizei count, const GLuint* textures), (first, count, textures), 0) \
+    V(BIND, SYNC, glBindTextureUnit, (GLuint unit, GLuint texture), (unit, texture), 0) \
+    V(BIND, SYNC, glBindMultiTextureEXT, (GLenum texunit, GLenum target, GLuint texture), (texunit, target, texture), 0) \
+    V(BIND, SKIP, glBindFramebuffer, (GLenum target, GLuint framebuffer), (target, framebuffer), 0) \
+    V(BIND, SKIP, glBindRenderbuffer, (GLenum target, GLuint renderbuffer), (target, renderbuffer), 0) \
+    V(BIND, FORGET, glBindFramebufferEXT, (GLenum target, GLuint framebuffer), (target, framebuffer), 0) \
+    V(BIND, FORGET, glBindRenderbufferEXT, (GLenum target, GLuint renderbuffer), (target, renderbuffer), 0) \
+    V(BIND, SYNC, glBindVertexArray, (GLuint array), (array), 0) \
+    V(BIND, SKIP, glUseProgram, (GLuint program), (program), 0) \
+    V(BIND, SKIP, glActiveTexture, (GLenum texture), (texture), 0) \
+    V(BIND, SKIP, glClientActiveTexture, (GLenum texture), (texture), 0) \
+    V(UPLOAD, SYNC, glTexImage2D, (GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type, const GLvoid* pixels), (target, level, internalformat, width, height, border, format, type, pixels), pixels ? getImageSize(width, height, format, type) : 0) \
+    V(UPLOAD, NONE, glTexSubImage2D, (GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height, GLenum format, GLenum type, const GLvoid* pixels), (target, level, xoffset, yoffset, width, height, format, type, pixels), getImageSize(width, height, format, type)) \
+    V(UPLOAD, SYNC, glCompressedTexImage2D, (GLenum target, GLint level, GLenum internalformat, GLsizei width, GLsizei height, GLint border, GLsizei imageSize, const void* data), (target, level, internalformat, width, height, border, imageSize, data), data ? imageSize : 0) \
+    V(UPLOAD, NONE, glCompressedTexSubImage2D, (GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height, GLenum format, GLsizei imageSize, const void* data), (target, level, xoffset, yoffset, width, height, format, imageSize, data), imageSize) \
+    V(UPLOAD, NONE, glBufferData, (GLenum target, GLsizeiptr size, const void* data, GLenum usage), (target, size, data, usage), data ? size : 0) \
+    V(UPLOAD, NONE, glBufferSubData, (GLenum target, GLintptr offset, GLsizeiptr size, const void* data), (target, offset, size, data), size) \
+    V(STATE, SKIP, glEnable, (GLenum cap), (cap), 0) \
+    V(STATE, SKIP, glDisable, (GLenum cap), (cap), 0) \
+    V(STATE, SKIP, glEnableClientState, (GLenum cap), (cap), 0) \
+    V(STATE, SKIP, glDisableClientState, (GLenum cap), (cap), 0) \
+    V(STATE, SYNC, glEnablei, (GLenum target, GLuint index), (target, index), 0) \
+    V(STATE, SYNC, glDisablei, (GLenum target, GLuint index), (target, index), 0) \
+    V(STATE, FORGET, glInterleavedArrays, (GLenum format, GLsizei stride, const GLvoid* pointer), (format, stride, pointer), 0) \
+    V(STATE, SKIP, glBlendFunc, (GLenum sfactor, GLenum dfactor), (sfactor, dfactor), 0) \
+    V(STATE, SKIP, glAlphaFunc, (GLenum func, GLclampf ref), (func, ref), 0) \
+    V(STATE, SKIP, glDepthFunc, (GLenum func), (func), 0) \
+    V(STATE, SKIP, glDepthMask, (GLboolean flag), (flag), 0) \
+    V(STATE, SKIP, glColorMask, (GLboolean red, GLboolean green, GLboolean blue, GLboolean alpha), (red, green, blue, alpha), 0) \
+    V(STATE, FORGET, glColorMaski, (GLuint index, GLboolean r, GLboolean g, GLboolean b, GLboolean a), (index, r, g, b, a), 0) \
+    V(STATE, SKIP, glCullFace, (GLenum mode), (mode), 0) \
+    V(STATE, SKIP, glShadeModel, (GLenum mode), (mode), 0) \
+    V(STATE, NONE, glPolygonMode, (GLenum face, GLenum mode), (face, mode), 0) \
+    V(STATE, NONE, glTexParameteri, (GLenum target, GLenum pname, GLint param), (target, pname, param), 0) \
+    V(STATE, NONE, glTexParameterf, (GLenum target, GLenum pname, GLfloat param), (target, pname, param), 0) \
+    V(STATE, NONE, glTexEnvi, (GLenum target, GLenum pname, GLint param), (target, pname, param), 0) \
+    V(STATE, NONE, glTexEnvf, (GLenum target, GLenum pname, GLfloat param), (target, pname, param), 0) \
+    V(STATE, BATCH_SKIP, glColor3f, (GLfloat red, GLfloat green, GLfloat blue), (red, green, blue), 0) \
+    V(STATE, BATCH_SKIP, glColor4f, (GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha), (red, green, blue, alpha), 0) \
+    V(STATE, BATCH_SKIP, glColor3ub, (GLubyte red, GLubyte green, GLubyte blue), (red, green, blue), 0) \
+    V(STATE, BATCH_SKIP, glColor4ub, (GLubyte red, GLubyte green, GLubyte blue, GLubyte alpha), (red, green, blue, alpha), 0) \
+    V(STATE, SKIP, glViewport, (GLint x, GLint y, GLsizei width, GLsizei height), (x, y, width, height), 0) \
+    V(STATE, SKIP, glScissor, (GLint x, GLint y, GLsizei width, GLsizei height), (x, y, width, height), 0) \
+    V(STATE, FORGET, glViewportIndexedf, (GLuint index, GLfloat x, GLfloat y, GLfloat w, GLfloat h), (index, x, y, w, h), 0) \
+    V(STATE, FORGET, glViewportIndexedfv, (GLuint index, const GLfloat* v), (index, v), 0) \
+    V(STATE, FORGET, glViewportArrayv, (GLuint first, GLsizei count, const GLfloat* v), (first, count, v), 0) \
+    V(STATE, FORGET, glScissorIndexed, (GLuint index, GLint left, GLint bottom, GLsizei width, GLsizei height), (index, left, bottom, width, height), 0) \
+    V(STATE, FORGET, glScissorIndexedv, (GLuint index, const GLint* v), (index, v), 0) \
+    V(STATE, FORGET, glScissorArrayv, (GLuint first, GLsizei count, const GLint* v), (first, count, v), 0) \
+    V(STATE, SKIP, glMatrixMode, (GLenum mode), (mode), 0) \
+    V(STATE, NONE, glLoadIdentity, (void), (), 0) \
+    V(STATE, NONE, glLoadMatrixf, (const GLfloat* m), (m), 0) \
+    V(STATE, NONE, glMultMatrixf, (const GLfloat* m), (m), 0) \
+    V(STATE, NONE, glPushMatrix, (void), (), 0) \
+    V(STATE, NONE, glPopMatrix, (void), (), 0) \
+    V(STATE, NONE, glTranslatef, (GLfloat x, GLfloat y, GLfloat z), (x, y, z), 0) \
+    V(STATE, NONE, glRotatef, (GLfloat angle, GLfloat x, GLfloat y, GLfloat z), (angle, x, y, z), 0) \
+    V(STATE, NONE, glScalef, (GLfloat x, GLfloat y, GLfloat z), (x, y, z), 0) \
+    V(STATE, NONE, glOrtho, (GLdouble left, GLdouble right, GLdouble bottom, GLdouble top, GLdouble near_val, GLdouble far_val), (left, right, bottom, top, near_val, far_val), 0) \
+    V(STATE, NONE, glVertexPointer, (GLint size, GLenum type, GLsizei stride, const GLvoid* ptr), (size, type, stride, ptr), 0) \
+    V(STATE, NONE, glTexCoordPointer, (GLint size, GLenum type, GLsizei stride, const GLvoid* ptr), (size, type, stride, ptr), 0) \
+    V(STATE, NONE, glColorPointer, (GLint size, GLenum type, GLsizei stride, const GLvoid* ptr), (size, type, stride, ptr), 0) \
+    V(STATE, SYNC, glPixelStorei, (GLenum pname, GLint param), (pname, param), 0) \
+    V(STATE, SYNC, glPixelStoref, (GLenum pname, GLfloat param), (pname, param), 0) \
+    V(STATE, SKIP, glClearColor, (GLclampf red, GLclampf green, GLclampf blue, GLclampf alpha), (red, green, blue, alpha), 0) \
+    V(STATE, NONE, glLineWidth, (GLfloat width), (width), 0) \
+    V(STATE, NONE, glPointSize, (GLfloat size), (size), 0) \
+    V(STATE, NONE, glLineStipple, (GLint factor, GLushort pattern), (factor, pattern), 0) \
+    V(STATE, NONE, glPolygonOffset, (GLfloat factor, GLfloat units), (factor, units), 0) \
+    V(STATE, NONE, glFrontFace, (GLenum mode), (mode), 0) \
+    V(STATE, NONE, glDepthRange, (GLclampd near_val, GLclampd far_val), (near_val, far_val), 0) \
+    V(STATE, NONE, glBlendEquation, (GLenum mode), (mode), 0) \
+    V(STATE, NONE, glStencilFunc, (GLenum func, GLint ref, GLuint mask), (func, ref, mask), 0) \
+    V(STATE, NONE, glStencilOp, (GLenum fail, GLenum zfail, GLenum zpass), (fail, zfail, zpass), 0) \
+    V(STATE, NONE, glStencilMask, (GLuint mask), (mask), 0) \
+    V(STATE, NONE, glTexEnvfv, (GLenum target, GLenum pname, const GLfloat* params), (target, pname, params), 0) \
+    V(STATE, NONE, glTexGeni, (GLenum coord, GLenum pname, GLint param), (coord, pname, param), 0) \
+    V(STATE, NONE, glTexGenfv, (GLenum coord, GLenum pname, const GLfloat* params), (coord, pname, params), 0) \
+    V(STATE, NONE, glFogf, (GLenum pname, GLfloat param), (pname, param), 0) \
+    V(STATE, NONE, glFogi, (GLenum pname, GLint param), (pname, param), 0) \
+    V(STATE, NONE, glFogfv, (GLenum pname, const GLfloat* params), (pname, params), 0) \
+    V(STATE, NONE, glLightf, (GLenum light, GLenum pname, GLfloat param), (light, pname, param), 0) \
+    V(STATE, NONE, glLightfv, (GLenum light, GLenum pname, const GLfloat* params), (light, pname, params), 0) \
+    V(STATE, NONE, glLightModelfv, (GLenum pname, const GLfloat* params), (pname, params), 0) \
+    V(STATE, NONE, glMaterialf, (GLenum face, GLenum pname, GLfloat param), (face, pname, param), 0) \
+    V(STATE, NONE, glMaterialfv, (GLenum face, GLenum pname, const GLfloat* params), (face, pname, params), 0) \
+    V(STATE, NONE, glMateriali, (GLenum face, GLenum pname, GLint param), (face, pname, param), 0) \
+    V(STATE, NONE, glMaterialiv, (GLenum face, GLenum pname, const GLint* params), (face, pname, params), 0) \
+    V(STATE, NONE, glColorMaterial, (GLenum face, GLenum mode), (face, mode), 0) \
+    V(STATE, NONE, glNormalPointer, (GLenum type, GLsizei stride, const GLvoid* ptr), (type, stride, ptr), 0) \
+    V(STATE, NONE, glLoadMatrixd, (const GLdouble* m), (m), 0) \
+    V(STATE, NONE, glMultMatrixd, (const GLdouble* m), (m), 0) \
+    V(STATE, NONE, glTranslated, (GLdouble x, GLdouble y, GLdouble z), (x, y, z), 0) \
+    V(STATE, NONE, glRotated, (GLdouble angle, GLdouble x, GLdouble y, GLdouble z), (angle, x, y, z), 0) \
+    V(STATE, NONE, glScaled, (GLdouble x, GLdouble y, GLdouble z), (x, y, z), 0) \
+    V(STATE, NONE, glFrustum, (GLdouble left, GLdouble right, GLdouble bottom, GLdouble top, GLdouble near_val, GLdouble far_val), (left, right, bottom, top, near_val, far_val), 0) \
+    V(STATE, NONE, glUniform1i, (GLint location, GLint v0), (location, v0), 0) \
+    V(STATE, NONE, glUniform1f, (GLint location, GLfloat v0), (location, v0), 0) \
+    V(STATE, NONE, glUniform2f, (GLint location, GLfloat v0, GLfloat v1), (location, v0, v1), 0) \
+    V(STATE, NONE, glUniform4f, (GLint location, GLfloat v0, GLfloat v1, GLfloat v2, GLfloat v3), (location, v0, v1, v2, v3), 0) \
+    V(STATE, NONE, glUniform4fv, (GLint location, GLsizei count, const GLfloat* value), (location, count, value), 0) \
+    V(STATE, NONE, glUniformMatrix4fv, (GLint location, GLsizei count, GLboolean transpose, const GLfloat* value), (location, count, transpose, value), 0) \
+    V(STATE, BATCH_FORGET, glColor3d, (GLdouble red, GLdouble green, GLdouble blue), (red, green, blue), 0) \
+    V(STATE, BATCH_FORGET, glColor4d, (GLdouble red, GLdouble green, GLdouble blue, GLdouble alpha), (red, green, blue, alpha), 0) \
+    V(STATE, BATCH_FORGET, glColor3fv, (const GLfloat* v), (v), 0) \
+    V(STATE, BATCH_FORGET, glColor4fv, (const GLfloat* v), (v), 0) \
+    V(STATE, BATCH_FORGET, glColor3ubv, (const GLubyte* v), (v), 0) \
+    V(STATE, BATCH_FORGET, glColor4ubv, (const GLubyte* v), (v), 0) \
+    V(STATE, FORGET, glColor3b, (GLbyte red, GLbyte green, GLbyte blue), (red, green, blue), 0) \
+    V(STATE, FORGET, glColor3bv, (const GLbyte* v), (v), 0) \
+    V(STATE, FORGET, glColor3s, (GLshort red, GLshort green, GLshort blue), (red, green, blue), 0) \
+    V(STATE, FORGET, glColor3sv, (const GLshort* v), (v), 0) \
+    V(STATE, FORGET, glColor3i, (GLint red, GLint green, GLint blue), (red, green, blue), 0) \
+    V(STATE, FORGET, glColor3iv, (const GLint* v), (v), 0) \
+    V(STATE, BATCH_FORGET, glColor3dv, (const GLdouble* v), (v), 0) \
+    V(STATE, BATCH_FORGET, glColor3us, (GLushort red, GLushort green, GLushort blue), (red, green, blue), 0) \
+    V(STATE, BATCH_FORGET, glColor3usv, (const GLushort* v), (v), 0) \
+    V(STATE, BATCH_FORGET, glColor3ui, (GLuint red, GLuint green, GLuint blue), (red, green, blue), 0) \
+    V(STATE, BATCH_FORGET, glColor3uiv, (const GLuint* v), (v), 0) \
+    V(STATE, FORGET, glColor4b, (GLbyte red, GLbyte green, GLbyte blue, GLbyte alpha), (red, green, blue, alpha), 0) \
+    V(STATE, FORGET, glColor4bv, (const GLbyte* v), (v), 0) \
+    V(STATE, FORGET, glColor4s, (GLshort red, GLshort green, GLshort blue, GLshort alpha), (red, green, blue, alpha), 0) \
+    V(STATE, FORGET, glColor4sv, (const GLshort* v), (v), 0) \
+    V(STATE, FORGET, glColor4i, (GLint red, GLint green, GLint blue, GLint alpha), (red, green, blue, alpha), 0) \
+    V(STATE, FORGET, glColor4iv, (const GLint* v), (v), 0) \
+    V(STATE, BATCH_FORGET, glColor4dv, (const GLdouble* v), (v), 0) \
+    V(STATE, BATCH_FORGET, glColor4us, (GLushort red, GLushort green, GLushort blue, GLushort alpha), (red, green, blue, alpha), 0) \
+    V(STATE, BATCH_FORGET, glColor4usv, (const GLushort* v), (v), 0) \
+    V(STATE, BATCH_FORGET, glColor4ui, (GLuint red, GLuint green, GLuint blue, GLuint alpha), (red, green, blue, alpha), 0) \
+    V(STATE, BATCH_FORGET, glColor4uiv, (const GLuint* v), (v), 0) \
+    V(STATE, NONE, glSecondaryColor3b, (GLbyte red, GLbyte green, GLbyte blue), (red, green, blue), 0) \
+    V(STATE, NONE, glSecondaryColor3bv, (const GLbyte* v), (v), 0) \
+    V(STATE, NONE, glSecondaryColor3s, (GLshort red, GLshort green, GLshort blue), (red, green, blue), 0) \
+    V(STATE, NONE, glSecondaryColor3sv, (const GLshort* v), (v), 0) \
+    V(STATE, NONE, glSecondaryColor3i, (GLint red, GLint green, GLint blue), (red, green, blue), 0) \
+    V(STATE, NONE, glSecondaryColor3iv, (const GLint* v), (v), 0) \
+    V(STATE, NONE, glSecondaryColor3f, (GLfloat red, GLfloat green, GLfloat blue), (red, green, blue), 0) \
+    V(STATE, NONE, glSecondaryColor3fv, (const GLfloat* v), (v), 0) \
+    V(STATE, NONE, glSecondaryColor3d, (GLdouble red, GLdouble green, GLdouble blue), (red, green, blue), 0) \
+    V(STATE, NONE, glSecondaryColor3dv, (const GLdouble* v), (v), 0) \
+    V(STATE, NONE, glSecondaryColor3ub, (GLubyte red, GLubyte green, GLubyte blue), (red, green, blue), 0) \
+    V(STATE, NONE, glSecondaryColor3ubv, (const GLubyte* v), (v), 0) \
+    V(STATE, NONE, glSecondaryColor3us, (GLushort red, GLushort green, GLushort blue), (red, green, blue), 0) \
+    V(STATE, NONE, glSecondaryColor3usv, (const GLushort* v), (v), 0) \
+    V(STATE, NONE, glSecondaryColor3ui, (GLuint red, GLuint green, GLuint blue), (red, green, blue), 0) \
+    V(STATE, NONE, glSecondaryColor3uiv, (const GLuint* v), (v), 0) \
+    V(STATE, NONE, glFogCoordf, (GLfloat coord), (coord), 0) \
+    V(STATE, NONE, glFogCoordfv, (const GLfloat* coord), (coord), 0) \
+    V(STATE, NONE, glFogCoordd, (GLdouble coord), (coord), 0) \
+    V(STATE, NONE, glFogCoorddv, (const GLdouble* coord), (coord), 0) \
+    V(STATE, NONE, glIndexs, (GLshort c), (c), 0) \
+    V(STATE, NONE, glIndexsv, (const GLshort* c), (c), 0) \
+    V(STATE, NONE, glIndexi, (GLint c), (c), 0) \
+    V(STATE, NONE, glIndexiv, (const GLint* c), (c), 0) \
+    V(STATE, NONE, glIndexf, (GLfloat c), (c), 0) \
+    V(STATE, NONE, glIndexfv, (const GLfloat* c), (c), 0) \
+    V(STATE, NONE, glIndexd, (GLdouble c), (c), 0) \
+    V(STATE, NONE, glIndexdv, (const GLdouble* c), (c), 0) \
+    V(STATE, NONE, glIndexub, (GLubyte c), (c), 0) \
+    V(STATE, NONE, glIndexubv, (const GLubyte* c), (c), 0) \
+    V(STATE, FORGET, glBlendFuncSeparate, (GLenum sfactorRGB, GLenum dfactorRGB, GLenum sfactorAlpha, GLenum dfactorAlpha), (sfactorRGB, dfactorRGB, sfactorAlpha, dfactorAlpha), 0) \
+    V(STATE, NONE, glPushAttrib, (GLbitfield mask), (mask), 0) \
+    V(STATE, FORGET, glBlendFunci, (GLuint buf, GLenum src, GLenum dst), (buf, src, dst), 0) \
+    V(STATE, FORGET, glBlendFuncSeparatei, (GLuint buf, GLenum srcRGB, GLenum dstRGB, GLenum srcAlpha, GLenum dstAlpha), (buf, srcRGB, dstRGB, srcAlpha, dstAlpha), 0) \
+    V(STATE, FORGET, glPopAttrib, (void), (), 0) \
+    V(STATE, NONE, glPushClientAttrib, (GLbitfield mask), (mask), 0) \
+    V(STATE, FORGET, glPopClientAttrib, (void), (), 0) \
+    R(GET, GLenum, glGetError, (void), ()) \
+    R(GET, const GLubyte*, glGetString, (GLenum name), (name)) \
+    R(GET, GLboolean, glIsEnabled, (GLenum cap), (cap)) \
+    V(GET, NONE, glGetBooleanv, (GLenum pname, GLboolean* params), (pname, params), 0) \
+    V(GET, NONE, glGetIntegerv, (GLenum pname, GLint* params), (pname, params), 0) \
+    V(GET, NONE, glGetFloatv, (GLenum pname, GLfloat* params), (pname, params), 0) \
+    V(GET, NONE, glGetDoublev, (GLenum pname, GLdouble* params), (pname, params), 0) \
+    V(GET, NONE, glGetTexParameteriv, (GLenum target, GLenum pname, GLint* params), (target, pname, params), 0) \
+    V(GET, NONE, glGetTexLevelParameteriv, (GLenum target, GLint level, GLenum pname, GLint* params), (target, level, pname, params), 0) \
+    V(GET, NONE, glGetTexImage, (GLenum target, GLint level, GLenum format, GLenum type, GLvoid* pixels), (target, level, format, type, pixels), 0) \
+    V(GET, NONE, glReadPixels, (GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, GLvoid* pixels), (x, y, width, height, format, type, pixels), 0) \
+    V(GET, NONE, glFinish, (void), (), 0) \
+    V(VERTEX, BATCH, glVertex2s, (GLshort x, GLshort y), (x, y), 0) \
+    V(VERTEX, BATCH, glVertex2sv, (const GLshort* v), (v), 0) \
+    V(VERTEX, BATCH, glVertex2i, (GLint x, GLint y), (x, y), 0) \
+    V(VERTEX, BATCH, glVertex2iv, (const GLint* v), (v), 0) \
+    V(VERTEX, BATCH, glVertex2f, (GLfloat x, GLfloat y), (x, y), 0) \
+    V(VERTEX, BATCH, glVertex2fv, (const GLfloat* v), (v), 0) \
+    V(VERTEX, BATCH, glVertex2d, (GLdouble x, GLdouble y), (x, y), 0) \
+    V(VERTEX, BATCH, glVertex2dv, (const GLdouble* v), (v), 0) \
+    V(VERTEX, BATCH, glVertex3s, (GLshort x, GLshort y, GLshort z), (x, y, z), 0) \
+    V(VERTEX, BATCH, glVertex3sv, (const GLshort* v), (v), 0) \
+    V(VERTEX, BATCH, glVertex3i, (GLint x, GLint y, GLint z), (x, y, z), 0) \
+    V(VERTEX, BATCH, glVertex3iv, (const GLint* v), (v), 0) \
+    V(VERTEX, BATCH, glVertex3f, (GLfloat x, GLfloat y, GLfloat z), (x, y, z), 0) \
+    V(VERTEX, BATCH, glVertex3fv, (const GLfloat* v), (v), 0) \
+    V(VERTEX, BATCH, glVertex3d, (GLdouble x, GLdouble y, GLdouble z), (x, y, z), 0) \
+    V(VERTEX, BATCH, glVertex3dv, (const GLdouble* v), (v), 0) \
+    V(VERTEX, NONE, glVertex4s, (GLshort x, GLshort y, GLshort z, GLshort w), (x, y, z, w), 0) \
+    V(VERTEX, NONE, glVertex4sv, (const GLshort* v), (v), 0) \
+    V(VERTEX, NONE, glVertex4i, (GLint x, GLint y, GLint z, GLint w), (x, y, z, w), 0) \
+    V(VERTEX, NONE, glVertex4iv, (const GLint* v), (v), 0) \
+    V(VERTEX, NONE, glVertex4f, (GLfloat x, GLfloat y, GLfloat z, GLfloat w), (x, y, z, w), 0) \
+    V(VERTEX, NONE, glVertex4fv, (const GLfloat* v), (v), 0) \
+    V(VERTEX, NONE, glVertex4d, (GLdouble x, GLdouble y, GLdouble z, GLdouble w), (x, y, z, w), 0) \
+    V(VERTEX, NONE, glVertex4dv, (const GLdouble* v), (v), 0) \
+    V(VERTEX, BATCH, glTexCoord1s, (GLshort s), (s), 0) \
+    V(VERTEX, BATCH, glTexCoord1sv, (const GLshort* v), (v), 0) \
+    V(VERTEX, BATCH, glTexCoord1i, (GLint s), (s), 0) \
+    V(VERTEX, BATCH, glTexCoord1iv, (const GLint* v), (v), 0) \
+    V(VERTEX, BATCH, glTexCoord1f, (GLfloat s), (s), 0) \
+    V(VERTEX, BATCH, glTexCoord1fv, (const GLfloat* v), (v), 0) \
+    V(VERTEX, BATCH, glTexCoord1d, (GLdouble s), (s), 0) \
+    V(VERTEX, BATCH, glTexCoord1dv, (const GLdouble* v), (v), 0) \
+    V(VERTEX, BATCH, glTexCoord2s, (GLshort s, GLshort t), (s, t), 0) \
+    V(VERTEX, BATCH, glTexCoord2sv, (const GLshort* v), (v), 0) \
+    V(VERTEX, BATCH, glTexCoord2i, (GLint s, GLint t), (s, t), 0) \
+    V(VERTEX, BATCH, glTexCoord2iv, (const GLint* v), (v), 0) \
+    V(VERTEX, BATCH, glTexCoord2f, (GLfloat s, GLfloat t), (s, t), 0) \
+    V(VERTEX, BATCH, glTexCoord2fv, (const GLfloat* v), (v), 0) \
+    V(VERTEX, BATCH, glTexCoord2d, (GLdouble s, GLdouble t), (s, t), 0) \
+    V(VERTEX, BATCH, glTexCoord2dv, (const GLdouble* v), (v), 0) \
+    V(VERTEX, BATCH, glTexCoord3s, (GLshort s, GLshort t, GLshort r), (s, t, r), 0) \
+    V(VERTEX, BATCH, glTexCoord3sv, (const GLshort* v), (v), 0) \
+    V(VERTEX, BATCH, glTexCoord3i, (GLint s, GLint t, GLint r), (s, t, r), 0) \
+    V(VERTEX, BATCH, glTexCoord3iv, (const GLint* v), (v), 0) \
+    V(VERTEX, BATCH, glTexCoord3f, (GLfloat s, GLfloat t, GLfloat r), (s, t, r), 0) \
+    V(VERTEX, BATCH, glTexCoord3fv, (const GLfloat* v), (v), 0) \
+    V(VERTEX, BATCH, glTexCoord3d, (GLdouble s, GLdouble t, GLdouble r), (s, t, r), 0) \
+    V(VERTEX, BATCH, glTexCoord3dv, (const GLdouble* v), (v), 0) \
+    V(VERTEX, BATCH, glTexCoord4s, (GLshort s, GLshort t, GLshort r, GLshort q), (s, t, r, q), 0) \
+    V(VERTEX, BATCH, glTexCoord4sv, (const GLshort* v), (v), 0) \
+    V(VERTEX, BATCH, glTexCoord4i, (GLint s, GLint t, GLint r, GLint q), (s, t, r, q), 0) \
+    V(VERTEX, BATCH, glTexCoord4iv, (const GLint* v), (v), 0) \
+    V(VERTEX, BATCH, glTexCoord4f, (GLfloat s, GLfloat t, GLfloat r, GLfloat q), (s, t, r, q), 0) \
+    V(VERTEX, BATCH, glTexCoord4fv, (const GLfloat* v), (v), 0) \
+    V(VERTEX, BATCH, glTexCoord4d, (GLdouble s, GLdouble t, GLdouble r, GLdouble q), (s, t, r, q), 0) \
+    V(VERTEX, BATCH, glTexCoord4dv, (const GLdouble* v), (v), 0) \
+    V(VERTEX, NONE, glNormal3b, (GLbyte nx, GLbyte ny, GLbyte nz), (nx, ny, nz), 0) \
+    V(VERTEX, NONE, glNormal3bv, (const GLbyte* v), (v), 0) \
+    V(VERTEX, NONE, glNormal3s, (GLshort nx, GLshort ny, GLshort nz), (nx, ny, nz), 0) \
+    V(VERTEX, NONE, glNormal3sv, (const GLshort* v), (v), 0) \
+    V(VERTEX, NONE, glNormal3i, (GLint nx, GLint ny, GLint nz), (nx, ny, nz), 0) \
+    V(VERTEX, NONE, glNormal3iv, (const GLint* v), (v), 0) \
+    V(VERTEX, BATCH, glNormal3f, (GLfloat nx, GLfloat ny, GLfloat nz), (nx, ny, nz), 0) \
+    V(VERTEX, BATCH, glNormal3fv, (const GLfloat* v), (v), 0) \
+    V(VERTEX, BATCH, glNormal3d, (GLdouble nx, GLdouble ny, GLdouble nz), (nx, ny, nz), 0) \
+    V(VERTEX, BATCH, glNormal3dv, (const GLdouble* v), (v), 0) \
+    V(VERTEX, NONE, glMultiTexCoord1s, (GLenum target, GLshort s), (target, s), 0) \
+    V(VERTEX, NONE, glMultiTexCoord1sv, (GLenum target, const GLshort* v), (target, v), 0) \
+    V(VERTEX, NONE, glMultiTexCoord1i, (GLenum target, GLint s), (target, s), 0) \
+    V(VERTEX, NONE, glMultiTexCoord1iv, (GLenum target, const GLint* v), (target, v), 0) \
+    V(VERTEX, NONE, glMultiTexCoord1f, (GLenum target, GLfloat s), (target, s), 0) \
+    V(VERTEX, NONE, glMultiTexCoord1fv, (GLenum target, const GLfloat* v), (target, v), 0) \
+    V(VERTEX, NONE, glMultiTexCoord1d, (GLenum target, GLdouble s), (target, s), 0) \
+    V(VERTEX, NONE, glMultiTexCoord1dv, (GLenum target, const GLdouble* v), (target, v), 0) \
+    V(VERTEX, NONE, glMultiTexCoord2s, (GLenum target, GLshort s, GLshort t), (target, s, t), 0) \
+    V(VERTEX, NONE, glMultiTexCoord2sv, (GLenum target, const GLshort* v), (target, v), 0) \
+    V(VERTEX, NONE, glMultiTexCoord2i, (GLenum target, GLint s, GLint t), (target, s, t), 0) \
+    V(VERTEX, NONE, glMultiTexCoord2iv, (GLenum target, const GLint* v), (target, v), 0) \
+    V(VERTEX, NONE, glMultiTexCoord2f, (GLenum target, GLfloat s, GLfloat t), (target, s, t), 0) \
+    V(VERTEX, NONE, glMultiTexCoord2fv, (GLenum target, const GLfloat* v), (target, v), 0) \
+    V(VERTEX, NONE, glMultiTexCoord2d, (GLenum target, GLdouble s, GLdouble t), (target, s, t), 0) \
+    V(VERTEX, NONE, glMultiTexCoord2dv, (GLenum target, const GLdouble* v), (target, v), 0) \
+    V(VERTEX, NONE, glMultiTexCoord3s, (GLenum target, GLshort s, GLshort t, GLshort r), (target, s, t, r), 0) \
+    V(VERTEX, NONE, glMultiTexCoord3sv, (GLenum target, const GLshort* v), (target, v), 0) \
+    V(VERTEX, NONE, glMultiTexCoord3i, (GLenum target, GLint s, GLint t, GLint r), (target, s, t, r), 0) \
+    V(VERTEX, NONE, glMultiTexCoord3iv, (GLenum target, const GLint* v), (target, v), 0) \
+    V(VERTEX, NONE, glMultiTexCoord3f, (GLenum target, GLfloat s, GLfloat t, GLfloat r), (target, s, t, r), 0) \
+    V(VERTEX, NONE, glMultiTexCoord3fv, (GLenum target, const GLfloat* v), (target, v), 0) \
+    V(VERTEX, NONE, glMultiTexCoord3d, (GLenum target, GLdouble s, GLdouble t, GLdouble r), (target, s, t, r), 0) \
+    V(VERTEX, NONE, glMultiTexCoord3dv, (GLenum target, const GLdouble* v), (target, v), 0) \
+    V(VERTEX, NONE, glMultiTexCoord4s, (GLenum target, GLshort s, GLshort t, GLshort r, GLshort q), (target, s, t, r, q), 0) \
+    V(VERTEX, NONE, glMultiTexCoord4sv, (GLenum target, const GLshort* v), (target, v), 0) \
+    V(VERTEX, NONE, glMultiTexCoord4i, (GLenum target, GLint s, GLint t, GLint r, GLint q), (target, s, t, r, q), 0) \
+    V(VERTEX, NONE, glMultiTexCoord4iv, (GLenum target, const GLint* v), (target, v), 0) \
+    V(VERTEX, NONE, glMultiTexCoord4f, (GLenum target, GLfloat s, GLfloat t, GLfloat r, GLfloat q), (target, s, t, r, q), 0) \
+    V(VERTEX, NONE, glMultiTexCoord4fv, (GLenum target, const GLfloat* v), (target, v), 0) \
+    V(VERTEX, NONE, glMultiTexCoord4d, (GLenum target, GLdouble s, GLdouble t, GLdouble r, GLdouble q), (target, s, t, r, q), 0) \
+    V(VERTEX, NONE, glMultiTexCoord4dv, (GLenum target, const GLdouble* v), (target, v), 0) \
+    V(VERTEX, NONE, glEdgeFlag, (GLboolean flag), (flag), 0) \
+    V(VERTEX, NONE, glEdgeFlagv, (const GLboolean* flag), (flag), 0) \
+    V(VERTEX, NONE, glEvalCoord1f, (GLfloat u), (u), 0) \
+    V(VERTEX, NONE, glEvalCoord1fv, (const GLfloat* v), (v), 0) \
+    V(VERTEX, NONE, glEvalCoord1d, (GLdouble u), (u), 0) \
+    V(VERTEX, NONE, glEvalCoord1dv, (const GLdouble* v), (v), 0) \
+    V(VERTEX, NONE, glEvalCoord2f, (GLfloat u, GLfloat v), (u, v), 0) \
+    V(VERTEX, NONE, glEvalCoord2fv, (const GLfloat* v), (v), 0) \
+    V(VERTEX, NONE, glEvalCoord2d, (GLdouble u, GLdouble v), (u, v), 0) \
+    V(VERTEX, NONE, glEvalCoord2dv, (const GLdouble* v), (v), 0) \
+    V(VERTEX, NONE, glEvalPoint1, (GLint i), (i), 0) \
+    V(VERTEX, NONE, glEvalPoint2, (GLint i, GLint j), (i, j), 0) \
+    V(VERTEX, FORGET, glArrayElement, (GLint i), (i), 0) \
+    V(OTHER, BATCH, glEnd, (void), (), 0) \
+    V(OTHER, NONE, glClear, (GLbitfield mask), (mask), 0) \
+    V(OTHER, NONE, glFlush, (void), (), 0) \
+    V(OTHER, NONE, glGenTextures, (GLsizei n, GLuint* textures), (n, textures), 0) \
+    V(OTHER, NONE, glGenBuffers, (GLsizei n, GLuint* buffers), (n, buffers), 0) \
+    V(OTHER, NONE, glCopyTexSubImage2D, (GLenum target, GLint level, GLint xoffset, GLint yoffset, GLint x, GLint y, GLsizei width, GLsizei height), (target, level, xoffset, yoffset, x, y, width, height), 0) \
+    V(OTHER, SYNC, glDeleteTextures, (GLsizei n, const GLuint* textures), (n, textures), 0) \
+    V(OTHER, SYNC, glDeleteBuffers, (GLsizei n, const GLuint* buffers), (n, buffers), 0) \
+    V(OTHER, SYNC, glDeleteFramebuffers, (GLsizei n, const GLuint* framebuffers), (n, framebuffers), 0) \
+    V(OTHER, SYNC, glDeleteRenderbuffers, (GLsizei n, const GLuint* renderbuffers), (n, renderbuffers), 0) \
+    V(OTHER, FORGET, glDeleteFramebuffersEXT, (GLsizei n, const GLuint* framebuffers), (n, framebuffers), 0) \
+    V(OTHER, FORGET, glDeleteRenderbuffersEXT, (GLsizei n, const GLuint* renderbuffers), (n, renderbuffers), 0) \
+    V(OTHER, FORGET, glDeleteVertexArrays, (GLsizei n, const GLuint* arrays), (n, arrays), 0) \
+    V(OTHER, SYNC, glNewList, (GLuint list, GLenum mode), (list, mode), 0) \
+    V(OTHER, SYNC, glEndList, (void), (), 0)
+
+// Extension functions promoted to core, A(alias, name), which older games
+// use the names of.  Only those taking the same parameters as the core ones
+// can be wrapped along with them: the EXT_vertex_array pointer functions for
+// instance take a count too
+#define GL_ALIASES(A) \
+    A(glDrawArraysEXT, glDrawArrays) \
+    A(glDrawRangeElementsEXT, glDrawRangeElements) \
+    A(glMultiDrawArraysEXT, glMultiDrawArrays) \
+    A(glMultiDrawElementsEXT, glMultiDrawElements) \
+    A(glDrawArraysInstancedARB, glDrawArraysInstanced) \
+    A(glDrawArraysInstancedEXT, glDrawArraysInstanced) \
+    A(glDrawElementsInstancedARB, glDrawElementsInstanced) \
+    A(glDrawElementsInstancedEXT, glDrawElementsInstanced) \
+    A(glArrayElementEXT, glArrayElement) \
+    A(glMultiTexCoord1sARB, glMultiTexCoord1s) \
+    A(glMultiTexCoord1svARB, glMultiTexCoord1sv) \
+    A(glMultiTexCoord1iARB, glMultiTexCoord1i) \
+    A(glMultiTexCoord1ivARB, glMultiTexCoord1iv) \
+    A(glMultiTexCoord1fARB, glMultiTexCoord1f) \
+    A(glMultiTexCoord1fvARB, glMultiTexCoord1fv) \
+    A(glMultiTexCoord1dARB, glMultiTexCoord1d) \
+    A(glMultiTexCoord1dvARB, glMultiTexCoord1dv) \
+    A(glMultiTexCoord2sARB, glMultiTexCoord2s) \
+    A(glMultiTexCoord2svARB, glMultiTexCoord2sv) \
+    A(glMultiTexCoord2iARB, glMultiTexCoord2i) \
+    A(glMultiTexCoord2ivARB, glMultiTexCoord2iv) \
+    A(glMultiTexCoord2fARB, glMultiTexCoord2f) \
+    A(glMultiTexCoord2fvARB, glMultiTexCoord2fv) \
+    A(glMultiTexCoord2dARB, glMultiTexCoord2d) \
+    A(glMultiTexCoord2dvARB, glMultiTexCoord2dv) \
+    A(glMultiTexCoord3sARB, glMultiTexCoord3s) \
+    A(glMultiTexCoord3svARB, glMultiTexCoord3sv) \
+    A(glMultiTexCoord3iARB, glMultiTexCoord3i) \
+    A(glMultiTexCoord3ivARB, glMultiTexCoord3iv) \
+    A(glMultiTexCoord3fARB, glMultiTexCoord3f) \
+    A(glMultiTexCoord3fvARB, glMultiTexCoord3fv) \
+    A(glMultiTexCoord3dARB, glMultiTexCoord3d) \
+    A(glMultiTexCoord3dvARB, glMultiTexCoord3dv) \
+    A(glMultiTexCoord4sARB, glMultiTexCoord4s) \
+    A(glMultiTexCoord4svARB, glMultiTexCoord4sv) \
+    A(glMultiTexCoord4iARB, glMultiTexCoord4i) \
+    A(glMultiTexCoord4ivARB, glMultiTexCoord4iv) \
+    A(glMultiTexCoord4fARB, glMultiTexCoord4f) \
+    A(glMultiTexCoord4fvARB, glMultiTexCoord4fv) \
+    A(glMultiTexCoord4dARB, glMultiTexCoord4d) \
+    A(glMultiTexCoord4dvARB, glMultiTexCoord4dv) \
+    A(glSecondaryColor3bEXT, glSecondaryColor3b) \
+    A(glSecondaryColor3bvEXT, glSecondaryColor3bv) \
+    A(glSecondaryColor3sEXT, glSecondaryColor3s) \
+    A(glSecondaryColor3svEXT, glSecondaryColor3sv) \
+    A(glSecondaryColor3iEXT, glSecondaryColor3i) \
+    A(glSecondaryColor3ivEXT, glSecondaryColor3iv) \
+    A(glSecondaryColor3fEXT, glSecondaryColor3f) \
+    A(glSecondaryColor3fvEXT, glSecondaryColor3fv) \
+    A(glSecondaryColor3dEXT, glSecondaryColor3d) \
+    A(glSecondaryColor3dvEXT, glSecondaryColor3dv) \
+    A(glSecondaryColor3ubEXT, glSecondaryColor3ub) \
+    A(glSecondaryColor3ubvEXT, glSecondaryColor3ubv) \
+    A(glSecondaryColor3usEXT, glSecondaryColor3us) \
+    A(glSecondaryColor3usvEXT, glSecondaryColor3usv) \
+    A(glSecondaryColor3uiEXT, glSecondaryColor3ui) \
+    A(glSecondaryColor3uivEXT, glSecondaryColor3uiv) \
+    A(glFogCoordfEXT, glFogCoordf) \
+    A(glFogCoordfvEXT, glFogCoordfv) \
+    A(glFogCoorddEXT, glFogCoordd) \
+    A(glFogCoorddvEXT, glFogCoorddv) \
+    A(glBindTextureEXT, glBindTexture) \
+    A(glBindBufferARB, glBindBuffer) \
+    A(glBindBufferBaseEXT, glBindBufferBase) \
+    A(glBindBufferRangeEXT, glBindBufferRange) \
+    A(glUseProgramObjectARB, glUseProgram) \
+    A(glActiveTextureARB, glActiveTexture) \
+    A(glClientActiveTextureARB, glClientActiveTexture) \
+    A(glCompressedTexImage2DARB, glCompressedTexImage2D) \
+    A(glCompressedTexSubImage2DARB, glCompressedTexSubImage2D) \
+    A(glBufferDataARB, glBufferData) \
+    A(glBufferSubDataARB, glBufferSubData) \
+    A(glBlendEquationEXT, glBlendEquation) \
+    A(glUniform1iARB, glUniform1i) \
+    A(glUniform1fARB, glUniform1f) \
+    A(glUniform2fARB, glUniform2f) \
+    A(glUniform4fARB, glUniform4f) \
+    A(glUniform4fvARB, glUniform4fv) \
+    A(glUniformMatrix4fvARB, glUniformMatrix4fv) \
+    A(glBlendFuncSeparateEXT, glBlendFuncSeparate) \
+    A(glBlendFuncSeparateINGR, glBlendFuncSeparate) \
+    A(glBlendFunciARB, glBlendFunci) \
+    A(glBlendFuncSeparateiARB, glBlendFuncSeparatei) \
+    A(glEnableIndexedEXT, glEnablei) \
+    A(glDisableIndexedEXT, glDisablei) \
+    A(glColorMaskIndexedEXT, glColorMaski) \
+    A(glGenTexturesEXT, glGenTextures) \
+    A(glGenBuffersARB, glGenBuffers) \
+    A(glDeleteTexturesEXT, glDeleteTextures) \
+    A(glDeleteBuffersARB, glDeleteBuffers)
+
+// Extension functions taking the parameters of core ones, which are wrapped
+// on their own as they can't be aliased to them: EXT_framebuffer_object
+// objects aren't interchangeable with those of ARB_framebuffer_object
+#define GL_UNALIASED(A) \
+    A(glBindFramebufferEXT, glBindFramebuffer) \
+    A(glBindRenderbufferEXT, glBindRenderbuffer) \
+    A(glDeleteFramebuffersEXT, glDeleteFramebuffers) \
+    A(glDeleteRenderbuffersEXT, glDeleteRenderbuffers)
+
+#define GL_CHECK_ALIAS(alias, name) \
+    _Static_assert(__builtin_types_compatible_p(__typeof__(alias), __typeof__(name)), \
+                   #alias " doesn't take the parameters of " #name);
+GL_ALIASES(GL_CHECK_ALIAS)
+GL_UNALIASED(GL_CHECK_ALIAS)
+#undef GL_CHECK_ALIAS
+
+#define GL_ENUM_V(category, hook, name, params, args, bytes) GL_##name,
+#define GL_ENUM_R(category, type, name, params, args) GL_##name,
+enum {
+    GL_FUNCTIONS(GL_ENUM_V, GL_ENUM_R)
+    GL_COUNT
+};
+#undef GL_ENUM_V
+#undef GL_ENUM_R
+
+#if defined(_GLFW_GL_INTERPOSE)
+// Exported under the names of the functions they wrap, so that the calls of
+// games linked to libGL go through them too
+#define GL_THUNK(name) name
+#define GL_THUNK_LINKAGE GLFWAPI
+#else
+#define GL_THUNK(name) name##Thunk
+#define GL_THUNK_LINKAGE static
+#endif
+
+// Counts of the context thread, which is the only one calling OpenGL
+typedef struct gl_stats
+{
+    uint64_t calls[GL_COUNT];
+    uint64_t bytes[GL_COUNT];
+    uint64_t maxcalls[GL_COUNT];
+    uint64_t categorycalls[CATEGORY_COUNT];
+    uint64_t categorymax[CATEGORY_COUNT];
+    uint64_t uploadmax;
+    uint64_t frames;
+
+    // Counts of the frame being drawn, added up on the next buffer swap
+    uint64_t framecalls[GL_COUNT];
+    uint64_t framebytes;
+} gl_stats;
+
+static gl_stats stats;
+
+// Functions shown in the report, from GLFW2TO3_GL_STATS
+static int top_functions = 20;
+
+// Entry points of the driver, resolved on their first call
+static void* procs[GL_COUNT];
+
+// Wrappers which the game looked up through glfwGetProcAddress()
+static unsigned char resolved[GL_COUNT];
+
+static void* getProc(int function);
+
+// Calls the driver, bypassing our own wrappers
+#define GL_CALL(name) ((__typeof__(&name)) getProc(GL_##name))
+
+static uint64_t getImageSize(GLsizei width, GLsizei height, GLenum format, GLenum type)
+{
+    int components;
+    switch (format)
+    {
+    case GL_LUMINANCE_ALPHA:
+    case GL_RG:
+        components = 2;
+        break;
+    case GL_RGB:
+    case GL_BGR:
+        components = 3;
+        break;
+    case GL_RGBA:
+    case GL_BGRA:
+        components = 4;
+        break;
+    default:
+        components = 1;
+        break;
+    }
+
+    int size;
+    switch (type)
+    {
+    case GL_UNSIGNED_SHORT_5_6_5:
+    case GL_UNSIGNED_SHORT_4_4_4_4:
+    case GL_UNSIGNED_SHORT_5_5_5_1:
+    case GL_UNSIGNED_SHORT_1_5_5_5_REV:
+        size = 2;
+        break;
+    case GL_UNSIGNED_INT_8_8_8_8:
+    case GL_UNSIGNED_INT_8_8_8_8_REV:
+    case GL_UNSIGNED_INT_2_10_10_10_REV:
+        size = 4;
+        break;
+    case GL_SHORT:
+    case GL_UNSIGNED_SHORT:
+    case GL_HALF_FLOAT:
+        size = 2 * components;
+        break;
+    case GL_INT:
+    case GL_UNSIGNED_INT:
+    case GL_FLOAT:
+        size = 4 * components;
+        break;
+    default:
+        size = components;
+        break;
+    }
+
+    if (width <= 0 || height <= 0)
+    {
+        return 0;
+    }
+    return (uint64_t)width * (uint64_t)height * (uint64_t)size;
+}
+
+static void countCall(int function, uint64_t bytes)
+{
+    stats.framecalls[function]++;
+    stats.bytes[function] += bytes;
+    stats.framebytes += bytes;
+}
+
+/* Redundant state filter */
+
+// Shadowed values which are known to match the context
+#define KNOWN_ACTIVE_TEXTURE        0x0001
+#define KNOWN_CLIENT_ACTIVE_TEXTURE 0x0002
+#define KNOWN_PROGRAM               0x0004
+#define KNOWN_BLEND_FUNC            0x0008
+#define KNOWN_ALPHA_FUNC            0x0010
+#define KNOWN_DEPTH_FUNC            0x0020
+#define KNOWN_DEPTH_MASK            0x0040
+#define KNOWN_COLOR_MASK            0x0080
+#define KNOWN_CULL_FACE             0x0100
+#define KNOWN_SHADE_MODEL           0x0200
+#define KNOWN_COLOR                 0x0400
+#define KNOWN_VIEWPORT              0x0800
+#define KNOWN_SCISSOR               0x1000
+#define KNOWN_MATRIX_MODE           0x2000
+#define KNOWN_CLEAR_COLOR           0x4000
+#define KNOWN_UNPACK                0x8000
+
+// Bindings and capabilities past these many aren't shadowed
+#define SHADOW_BINDINGS 32
+#define SHADOW_CAPS 64
+
+typedef struct gl_binding
+{
+    GLenum unit;
+    GLenum target;
+    GLuint name;
+} gl_binding;
+
+typedef struct gl_cap
+{
+    GLenum unit;
+    GLenum cap;
+    GLboolean client;
+    GLboolean enabled;
+} gl_cap;
+
+// State of the current context, as far as the calls we saw tell
+typedef struct gl_shadow
+{
+    unsigned known;
+    GLenum activetexture;
+    GLenum clientactivetexture;
+    GLuint program;
+    GLenum blendfunc[2];
+    GLenum alphafunc;
+    GLclampf alpharef;
+    GLenum depthfunc;
+    GLboolean depthmask;
+    GLboolean colormask[4];
+    GLenum cullface;
+    GLenum shademodel;
+    GLfloat color[4];
+    GLint viewport[4];
+    GLint scissor[4];
+    GLenum matrixmode;
+    GLfloat clearcolor[4];
+
+    gl_binding bindings[SHADOW_BINDINGS];
+    int bindingcount;
+    gl_cap caps[SHADOW_CAPS];
+    int capcount;
+
+    // Calls compiled in a display list aren't executed, or not only
+    int compiling;
+    GLenum listmode;
+
+    // Whether other texture units than the first were ever selected, as
+    // otherwise forgetting the state can't have changed the active ones
+    int multitexture;
+    int clientmultitexture;
+} gl_shadow;
+
+static gl_shadow shadow;
+
+// Calls to the SKIP functions, and how many of them were dropped
+static uint64_t filter_calls[GL_COUNT];
+static uint64_t filter_dropped[GL_COUNT];
+
+// Forgets everything but what a new context starts with, which includes the
+// default unpack state _glfw.unpack is reset to
+static void resetShadow(void)
+{
+    memset(&shadow, 0, sizeof(shadow));
+    shadow.known = KNOWN_ACTIVE_TEXTURE | KNOWN_CLIENT_ACTIVE_TEXTURE | KNOWN_UNPACK;
+    shadow.activetexture = GL_TEXTURE0;
+    shadow.clientactivetexture = GL_TEXTURE0;
+}
+
+// Forgets all the shadowed state, after a call which may have changed any
+static void invalidateShadow(void)
+{
+    const gl_shadow previous = shadow;
+    memset(&shadow, 0, sizeof(shadow));
+    shadow.compiling = previous.compiling;
+    shadow.listmode = previous.listmode;
+    shadow.multitexture = previous.multitexture;
+    shadow.clientmultitexture = previous.clientmultitexture;
+    if (!shadow.multitexture)
+    {
+        shadow.activetexture = GL_TEXTURE0;
+        shadow.known |= KNOWN_ACTIVE_TEXTURE;
+    }
+    if (!shadow.clientmultitexture)
+    {
+        shadow.clientactivetexture = GL_TEXTURE0;
+        shadow.known |= KNOWN_CLIENT_ACTIVE_TEXTURE;
+    }
+}
+
+// Returns whether value is already set, and shadows it otherwise
+static int skipValue(unsigned known, void* current, const void* value, size_t size)
+{
+    if (shadow.compiling)
+    {
+        return GL_FALSE;
+    }
+    if ((shadow.known & known) && memcmp(current, value, size) == 0)
+    {
+        return GL_TRUE;
+    }
+    memcpy(current, value, size);
+    shadow.known |= known;
+    return GL_FALSE;
+}
+
+static int isTextureUnitCap(GLenum cap)
+{
+    switch (cap)
+    {
+    case GL_TEXTURE_1D:
+    case GL_TEXTURE_2D:
+    case GL_TEXTURE_3D:
+    case GL_TEXTURE_CUBE_MAP:
+    case GL_TEXTURE_RECTANGLE:
+    case GL_TEXTURE_GEN_S:
+    case GL_TEXTURE_GEN_T:
+    case GL_TEXTURE_GEN_R:
+    case GL_TEXTURE_GEN_Q:
+        return GL_TRUE;
+    default:
+        return GL_FALSE;
+    }
+}
+
+// Texture units forgotten along with the rest of the state aren't queried
+// back, as that would stall the pipeline: what is bound or enabled on them
+// isn't filtered until the game selects a unit again.  Games which only use
+// the first unit never forget it
+static int getTextureUnit(unsigned known, GLenum* unit)
+{
+    if (!(shadow.known & known))
+    {
+        return GL_FALSE;
+    }
+    *unit = known == KNOWN_CLIENT_ACTIVE_TEXTURE ? shadow.clientactivetexture :
+                                                   shadow.activetexture;
+    return GL_TRUE;
+}
+
+static int isTextureTarget(GLenum target)
+{
+    switch (target)
+    {
+    case GL_TEXTURE_1D:
+    case GL_TEXTURE_2D:
+    case GL_TEXTURE_3D:
+    case GL_TEXTURE_CUBE_MAP:
+    case GL_TEXTURE_RECTANGLE:
+        return GL_TRUE;
+    default:
+        return GL_FALSE;
+    }
+}
+
+static int isFramebufferTarget(GLenum target)
+{
+    return target == GL_READ_FRAMEBUFFER || target == GL_DRAW_FRAMEBUFFER;
+}
+
+static int isRenderbufferTarget(GLenum target)
+{
+    return target == GL_RENDERBUFFER;
+}
+
+static int isBufferTarget(GLenum target)
+{
+    return !isTextureTarget(target) && !isFramebufferTarget(target) &&
+           !isRenderbufferTarget(target);
+}
+
+static void forgetTextureBindings(GLenum unit)
+{
+    for (int i = 0; i < shadow.bindingcount; i++)
+    {
+        if (shadow.bindings[i].unit == unit && isTextureTarget(shadow.bindings[i].target))
+        {
+            shadow.bindings[i--] = shadow.bindings[--shadow.bindingcount];
+        }
+    }
+}
+
+static void forgetTargetBindings(GLenum target)
+{
+    for (int i = 0; i < shadow.bindingcount; i++)
+    {
+        if (shadow.bindings[i].target == target)
+        {
+            shadow.bindings[i--] = shadow.bindings[--shadow.bindingcount];
+        }
+    }
+}
+
+static void forgetCap(GLboolean client, GLenum cap)
+{
+    for (int i = 0; i < shadow.capcount; i++)
+    {
+        if (shadow.caps[i].client == client && shadow.caps[i].cap == cap)
+        {
+            shadow.caps[i--] = shadow.caps[--shadow.capcount];
+        }
+    }
+}
+
+static void forgetClientCaps(void)
+{
+    for (int i = 0; i < shadow.capcount; i++)
+    {
+        if (shadow.caps[i].client)
+        {
+            shadow.caps[i--] = shadow.caps[--shadow.capcount];
+        }
+    }
+}
+
+static int skipBinding(GLenum unit, GLenum target, GLuint name)
+{
+    for (int i = 0; i < shadow.bindingcount; i++)
+    {
+        gl_binding* binding = &shadow.bindings[i];
+        if (binding->unit == unit && binding->target == target)
+        {
+            if (binding->name == name)
+            {
+                return GL_TRUE;
+            }
+            binding->name = name;
+            return GL_FALSE;
+        }
+    }
+
+    if (shadow.bindingcount < SHADOW_BINDINGS)
+    {
+        shadow.bindings[shadow.bindingcount++] = (gl_binding){ unit, target, name };
+    }
+    return GL_FALSE;
+}
+
+static int skipCap(GLboolean client, GLenum cap, GLboolean enabled)
+{
+    if (shadow.compiling)
+    {
+        return GL_FALSE;
+    }
+
+    GLenum unit = 0;
+    unsigned known = 0;
+    if (client && cap == GL_TEXTURE_COORD_ARRAY)
+    {
+        known = KNOWN_CLIENT_ACTIVE_TEXTURE;
+    }
+    else if (!client && isTextureUnitCap(cap))
+    {
+        known = KNOWN_ACTIVE_TEXTURE;
+    }
+    if (known && !getTextureUnit(known, &unit))
+    {
+        // Any unit may have been changed
+        forgetCap(client, cap);
+        return GL_FALSE;
+    }
+
+    for (int i = 0; i < shadow.capcount; i++)
+    {
+        gl_cap* entry = &shadow.caps[i];
+        if (entry->cap == cap && entry->client == client && entry->unit == unit)
+        {
+            if (entry->enabled == enabled)
+            {
+                return GL_TRUE;
+            }
+            entry->enabled = enabled;
+            return GL_FALSE;
+        }
+    }
+
+    if (shadow.capcount < SHADOW_CAPS)
+    {
+        shadow.caps[shadow.capcount++] = (gl_cap){ unit, cap, client, enabled };
+    }
+    return GL_FALSE;
+}
+
+// Drawing with the color array enabled leaves the current color undefined
+static void syncDraw(void)
+{
+    for (int i = 0; i < shadow.capcount; i++)
+    {
+        if (shadow.caps[i].client && shadow.caps[i].cap == GL_COLOR_ARRAY)
+        {
+            if (shadow.caps[i].enabled)
+            {
+                shadow.known &= ~KNOWN_COLOR;
+            }
+            return;
+        }
+    }
+    shadow.known &= ~KNOWN_COLOR;
+}
+
+// Names of different kinds of objects may be the same
+static void syncDeletedNames(GLsizei n, const GLuint* names, int (*isTarget)(GLenum))
+{
+    for (int i = 0; i < shadow.bindingcount; i++)
+    {
+        gl_binding* binding = &shadow.bindings[i];
+        if (!isTarget(binding->target))
+        {
+            continue;
+        }
+        for (GLsizei j = 0; j < n; j++)
+        {
+            // Deleting a bound object binds 0 in its place
+            if (names[j] && binding->name == names[j])
+            {
+                binding->name = 0;
+            }
+        }
+    }
+}
+
+static int skip_glBindTexture(GLenum target, GLuint texture)
+{
+    if (shadow.compiling)
+    {
+        return GL_FALSE;
+    }
+
+    GLenum unit;
+    if (!getTextureUnit(KNOWN_ACTIVE_TEXTURE, &unit))
+    {
+        // Any unit may have been changed
+        forgetTargetBindings(target);
+        return GL_FALSE;
+    }
+    return skipBinding(unit, target, texture);
+}
+
+static int skip_glBindBuffer(GLenum target, GLuint buffer)
+{
+    if (shadow.compiling)
+    {
+        return GL_FALSE;
+    }
+    return skipBinding(0, target, buffer);
+}
+
+// GL_FRAMEBUFFER binds both the read and the draw framebuffers
+static int skip_glBindFramebuffer(GLenum target, GLuint framebuffer)
+{
+    if (shadow.compiling)
+    {
+        return GL_FALSE;
+    }
+    if (target == GL_FRAMEBUFFER)
+    {
+        const int read = skipBinding(0, GL_READ_FRAMEBUFFER, framebuffer);
+        const int draw = skipBinding(0, GL_DRAW_FRAMEBUFFER, framebuffer);
+        return read && draw;
+    }
+    return skipBinding(0, target, framebuffer);
+}
+
+static int skip_glBindRenderbuffer(GLenum target, GLuint renderbuffer)
+{
+    if (shadow.compiling)
+    {
+        return GL_FALSE;
+    }
+    return skipBinding(0, target, renderbuffer);
+}
+
+static int skip_glUseProgram(GLuint program)
+{
+    return skipValue(KNOWN_PROGRAM, &shadow.program, &program, sizeof(program));
+}
+
+static int skip_glActiveTexture(GLenum texture)
+{
+    if (texture != GL_TEXTURE0)
+    {
+        shadow.multitexture = GL_TRUE;
+    }
+    return skipValue(KNOWN_ACTIVE_TEXTURE, &shadow.activetexture, &texture, sizeof(texture));
+}
+
+static int skip_glClientActiveTexture(GLenum texture)
+{
+    if (texture != GL_TEXTURE0)
+    {
+        shadow.clientmultitexture = GL_TRUE;
+    }
+    return skipValue(KNOWN_CLIENT_ACTIVE_TEXTURE, &shadow.clientactivetexture, &texture, sizeof(texture));
+}
+
+static int skip_glEnable(GLenum cap)
+{
+    return skipCap(GL_FALSE, cap, GL_TRUE);
+}
+
+static int skip_glDisable(GLenum cap)
+{
+    return skipCap(GL_FALSE, cap, GL_FALSE);
+}
+
+static int skip_glEnableClientState(GLenum cap)
+{
+    return skipCap(GL_TRUE, cap, GL_TRUE);
+}
+
+static int skip_glDisableClientState(GLenum cap)
+{
+    return skipCap(GL_TRUE, cap, GL_FALSE);
+}
+
+static int skip_glBlendFunc(GLenum sfactor, GLenum dfactor)
+{
+    GLenum value[2] = { sfactor, dfactor };
+    return skipValue(KNOWN_BLEND_FUNC, shadow.blendfunc, value, sizeof(value));
+}
+
+static int skip_glAlphaFunc(GLenum func, GLclampf ref)
+{
+    if (shadow.compiling)
+    {
+        return GL_FALSE;
+    }
+    if ((shadow.known & KNOWN_ALPHA_FUNC) &&
+        shadow.alphafunc == func && shadow.alpharef == ref)
+    {
+        return GL_TRUE;
+    }
+    shadow.alphafunc = func;
+    shadow.alpharef = ref;
+    shadow.known |= KNOWN_ALPHA_FUNC;
+    return GL_FALSE;
+}
+
+static int skip_glDepthFunc(GLenum func)
+{
+    return skipValue(KNOWN_DEPTH_FUNC, &shadow.depthfunc, &func, sizeof(func));
+}
+
+static int skip_glDepthMask(GLboolean flag)
+{
+    return skipValue(KNOWN_DEPTH_MASK, &shadow.depthmask, &flag, sizeof(flag));
+}
+
+static int skip_glColorMask(GLboolean red, GLboolean green, GLboolean blue, GLboolean alpha)
+{
+    GLboolean value[4] = { red, green, blue, alpha };
+    return skipValue(KNOWN_COLOR_MASK, shadow.colormask, value, sizeof(value));
+}
+
+static int skip_glCullFace(GLenum mode)
+{
+    return skipValue(KNOWN_CULL_FACE, &shadow.cullface, &mode, sizeof(mode));
+}
+
+static int skip_glShadeModel(GLenum mode)
+{
+    return skipValue(KNOWN_SHADE_MODEL, &shadow.shademodel, &mode, sizeof(mode));
+}
+
+static int skip_glColor4f(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha)
+{
+    GLfloat value[4] = { red, green, blue, alpha };
+    return skipValue(KNOWN_COLOR, shadow.color, value, sizeof(value));
+}
+
+static int skip_glColor3f(GLfloat red, GLfloat green, GLfloat blue)
+{
+    return skip_glColor4f(red, green, blue, 1.f);
+}
+
+static int skip_glColor4ub(GLubyte red, GLubyte green, GLubyte blue, GLubyte alpha)
+{
+    return skip_glColor4f(red / 255.f, green / 255.f, blue / 255.f, alpha / 255.f);
+}
+
+static int skip_glColor3ub(GLubyte red, GLubyte green, GLubyte blue)
+{
+    return skip_glColor4f(red / 255.f, green / 255.f, blue / 255.f, 1.f);
+}
+
+static int skip_glViewport(GLint x, GLint y, GLsizei width, GLsizei height)
+{
+    GLint value[4] = { x, y, width, height };
+    return skipValue(KNOWN_VIEWPORT, shadow.viewport, value, sizeof(value));
+}
+
+static int skip_glScissor(GLint x, GLint y, GLsizei width, GLsizei height)
+{
+    GLint value[4] = { x, y, width, height };
+    return skipValue(KNOWN_SCISSOR, shadow.scissor, value, sizeof(value));
+}
+
+static int skip_glMatrixMode(GLenum mode)
+{
+    return skipValue(KNOWN_MATRIX_MODE, &shadow.matrixmode, &mode, sizeof(mode));
+}
+
+static int skip_glClearColor(GLclampf red, GLclampf green, GLclampf blue, GLclampf alpha)
+{
+    GLfloat value[4] = { red, green, blue, alpha };
+    return skipValue(KNOWN_CLEAR_COLOR, shadow.clearcolor, value, sizeof(value));
+}
+
+// Vertex array objects hold the element array binding and the array states
+static void sync_glBindVertexArray(GLuint array)
+{
+    (void)array;
+    for (int i = 0; i < shadow.bindingcount; i++)
+    {
+        if (shadow.bindings[i].target == GL_ELEMENT_ARRAY_BUFFER)
+        {
+            shadow.bindings[i--] = shadow.bindings[--shadow.bindingcount];
+        }
+    }
+    forgetClientCaps();
+}
+
+// Indexed binds also bind the buffer to the generic binding point
+static void sync_glBindBufferBase(GLenum target, GLuint index, GLuint buffer)
+{
+    (void)index;
+    skip_glBindBuffer(target, buffer);
+}
+
+static void sync_glBindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size)
+{
+    (void)index;
+    (void)offset;
+    (void)size;
+    skip_glBindBuffer(target, buffer);
+}
+
+// The targets these are bound to aren't known without asking the context
+static void sync_glBindTextures(GLuint first, GLsizei count, const GLuint* textures)
+{
+    (void)textures;
+    for (GLsizei i = 0; i < count; i++)
+    {
+        forgetTextureBindings(GL_TEXTURE0 + first + i);
+    }
+}
+
+static void sync_glBindTextureUnit(GLuint unit, GLuint texture)
+{
+    (void)texture;
+    forgetTextureBindings(GL_TEXTURE0 + unit);
+}
+
+static void sync_glBindMultiTextureEXT(GLenum texunit, GLenum target, GLuint texture)
+{
+    if (!shadow.compiling)
+    {
+        skipBinding(texunit, target, texture);
+    }
+}
+
+// glEnable() and glDisable() change all the indices at once
+static void sync_glEnablei(GLenum target, GLuint index)
+{
+    (void)index;
+    forgetCap(GL_FALSE, target);
+}
+
+static void sync_glDisablei(GLenum target, GLuint index)
+{
+    (void)index;
+    forgetCap(GL_FALSE, target);
+}
+
+static void sync_glDeleteTextures(GLsizei n, const GLuint* textures)
+{
+    syncDeletedNames(n, textures, isTextureTarget);
+    if (_glfw.texturestreams)
+    {
+        _glfwDeleteTextureStreams(n, textures);
+    }
+}
+
+// A streamed texture which the game loads again keeps none of its levels
+static void syncTextureImage(GLenum target)
+{
+    if (target == GL_TEXTURE_2D && _glfw.texturestreams &&
+        !_glfw.texturestreamupload && !shadow.compiling)
+    {
+        _glfwForgetTextureStream(_glfwGetGLBinding(GL_TEXTURE_2D));
+    }
+}
+
+static void sync_glTexImage2D(GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type, const GLvoid* pixels)
+{
+    (void)level;
+    (void)internalformat;
+    (void)width;
+    (void)height;
+    (void)border;
+    (void)format;
+    (void)type;
+    (void)pixels;
+    syncTextureImage(target);
+}
+
+static void sync_glCompressedTexImage2D(GLenum target, GLint level, GLenum internalformat, GLsizei width, GLsizei height, GLint border, GLsizei imageSize, const void* data)
+{
+    (void)level;
+    (void)internalformat;
+    (void)width;
+    (void)height;
+    (void)border;
+    (void)imageSize;
+    (void)data;
+    syncTextureImage(target);
+}
+
+static void sync_glDeleteBuffers(GLsizei n, const GLuint* buffers)
+{
+    syncDeletedNames(n, buffers, isBufferTarget);
+}
+
+static void sync_glDeleteFramebuffers(GLsizei n, const GLuint* framebuffers)
+{
+    syncDeletedNames(n, framebuffers, isFramebufferTarget);
+}
+
+static void sync_glDeleteRenderbuffers(GLsizei n, const GLuint* renderbuffers)
+{
+    syncDeletedNames(n, renderbuffers, isRenderbufferTarget);
+}
+
+// The unpack state is shadowed in _glfw.unpack, for the texture uploads.
+// Pixel-store calls aren't compiled in display lists, they always execute
+static void sync_glPixelStorei(GLenum pname, GLint param)
+{
+    switch (pname)
+    {
+    case GL_UNPACK_ALIGNMENT:
+        _glfw.unpack.alignment = param;
+        break;
+    case GL_UNPACK_ROW_LENGTH:
+        _glfw.unpack.rowlength = param;
+        break;
+    case GL_UNPACK_SKIP_ROWS:
+        _glfw.unpack.skiprows = param;
+        break;
+    case GL_UNPACK_SKIP_PIXELS:
+        _glfw.unpack.skippixels = param;
+        break;
+    case GL_UNPACK_SWAP_BYTES:
+        _glfw.unpack.swapbytes = param;
+        break;
+    }
+}
+
+static void sync_glPixelStoref(GLenum pname, GLfloat param)
+{
+    sync_glPixelStorei(pname, (GLint)param);
+}
+
+// Forgets what the FORGET functions change, whatever their parameters
+static void forgetState(int function)
+{
+    switch (function)
+    {
+    case GL_glDrawArrays:
+    case GL_glDrawElements:
+    case GL_glDrawRangeElements:
+    case GL_glMultiDrawArrays:
+    case GL_glMultiDrawElements:
+    case GL_glDrawArraysInstanced:
+    case GL_glDrawElementsInstanced:
+    case GL_glDrawElementsBaseVertex:
+    case GL_glArrayElement:
+        syncDraw();
+        break;
+
+    // Display lists may hold any state change
+    case GL_glCallList:
+    case GL_glCallLists:
+    case GL_glPopAttrib:
+    case GL_glPopClientAttrib:
+        invalidateShadow();
+        break;
+
+    // Bindings of EXT_framebuffer_object objects aren't filtered, only
+    // queried again when we need them
+    case GL_glBindFramebufferEXT:
+    case GL_glDeleteFramebuffersEXT:
+        forgetTargetBindings(GL_READ_FRAMEBUFFER);
+        forgetTargetBindings(GL_DRAW_FRAMEBUFFER);
+        break;
+
+    case GL_glBindRenderbufferEXT:
+    case GL_glDeleteRenderbuffersEXT:
+        forgetTargetBindings(GL_RENDERBUFFER);
+        break;
+
+    // A deleted vertex array object which was bound reverts to the default
+    case GL_glDeleteVertexArrays:
+        sync_glBindVertexArray(0);
+        break;
+
+    case GL_glInterleavedArrays:
+        forgetClientCaps();
+        break;
+
+    case GL_glBlendFuncSeparate:
+    case GL_glBlendFunci:
+    case GL_glBlendFuncSeparatei:
+        shadow.known &= ~KNOWN_BLEND_FUNC;
+        break;
+
+    case GL_glColorMaski:
+        shadow.known &= ~KNOWN_COLOR_MASK;
+        break;
+
+    case GL_glViewportIndexedf:
+    case GL_glViewportIndexedfv:
+    case GL_glViewportArrayv:
+        shadow.known &= ~KNOWN_VIEWPORT;
+        break;
+
+    case GL_glScissorIndexed:
+    case GL_glScissorIndexedv:
+    case GL_glScissorArrayv:
+        shadow.known &= ~KNOWN_SCISSOR;
+        break;
+
+    // The glColor*() functions which aren't filtered
+    default:
+        shadow.known &= ~KNOWN_COLOR;
+        break;
+    }
+}
+
+static void sync_glNewList(GLuint list, GLenum mode)
+{
+    (void)list;
+    shadow.compiling = GL_TRUE;
+    shadow.listmode = mode;
+}
+
+static void sync_glEndList(void)
+{
+    if (shadow.listmode == GL_COMPILE_AND_EXECUTE)
+    {
+        invalidateShadow();
+    }
+    shadow.compiling = GL_FALSE;
+}
+
+/* Immediate mode batching */
+
+// Attributes of the batched vertices, as far as they were set
+#define ATTRIB_COLOR    0x1
+#define ATTRIB_TEXCOORD 0x2
+#define ATTRIB_NORMAL   0x4
+
+// Batches are drawn once they reach this many vertices
+#define BATCH_VERTICES 65536
+
+typedef struct gl_vertex
+{
+    GLfloat position[3];
+    GLfloat color[4];
+    GLfloat texcoord[4];
+    GLfloat normal[3];
+} gl_vertex;
+
+// Primitives drawn between glBegin() and glEnd(), kept to be drawn together
+// from a streaming vertex buffer
+typedef struct gl_batch
+{
+    gl_vertex* vertices;
+    int count;
+    int capacity;
+    GLenum mode;
+    // Attributes drawn from the vertices, as they vary within the batch,
+    // and those which were known for all of them
+    unsigned attribs;
+    unsigned recorded;
+    // Attributes recorded since they were last sent to the context
+    unsigned unsent;
+    // Whether some vertices have z, or texture coordinates r or q set, as
+    // they are otherwise left out of the vertex buffer
+    int depth;
+    int projective;
+    // Vertices with only the attributes drawn, as uploaded
+    GLfloat* packed;
+    size_t packedsize;
+
+    // Primitive between glBegin() and glEnd(), from its first vertex on, and
+    // whether it is forwarded as is since something else was called in it
+    int open;
+    int first;
+    int direct;
+
+    // Current attributes as last set, when known
+    gl_vertex current;
+    unsigned known;
+
+    int compiling;
+    GLuint buffer;
+
+    uint64_t primitives;
+    uint64_t draws;
+    uint64_t drawnvertices;
+    uint64_t replays;
+} gl_batch;
+
+static gl_batch batch;
+
+// Forgets the batch and what it knows of the context, but not the totals
+static void resetBatch(void)
+{
+    batch.count = 0;
+    batch.open = GL_FALSE;
+    batch.first = 0;
+    batch.direct = GL_FALSE;
+    batch.known = 0;
+    batch.compiling = GL_FALSE;
+    batch.buffer = 0;
+}
+
+// Only independent primitives can be appended to each other
+static int getPrimitiveSize(GLenum mode)
+{
+    switch (mode)
+    {
+    case GL_POINTS:
+        return 1;
+    case GL_LINES:
+        return 2;
+    case GL_TRIANGLES:
+        return 3;
+    case GL_QUADS:
+        return 4;
+    default:
+        return 0;
+    }
+}
+
+// Sends the current attributes which drawing from arrays left undefined, or
+// which were only recorded
+static void restoreAttribs(unsigned attribs)
+{
+    if (attribs & ATTRIB_COLOR)
+    {
+        GL_CALL(glColor4fv)(batch.current.color);
+
+        // Nor were the recorded colors seen by the filter
+        shadow.known &= ~KNOWN_COLOR;
+    }
+    if (attribs & ATTRIB_TEXCOORD)
+    {
+        GL_CALL(glTexCoord4fv)(batch.current.texcoord);
+    }
+    if (attribs & ATTRIB_NORMAL)
+    {
+        GL_CALL(glNormal3fv)(batch.current.normal);
+    }
+    batch.unsent = 0;
+}
+
+static void drawBatch(void)
+{
+    if (!batch.count)
+    {
+        if (batch.unsent)
+        {
+            restoreAttribs(batch.unsent);
+        }
+        batch.first = 0;
+        return;
+    }
+
+    // Only the attributes which vary are uploaded, unless there is no memory
+    // left to pack them
+    const int colorsize = (batch.attribs & ATTRIB_COLOR) ? 4 : 0;
+    const int texcoordsize = (batch.attribs & ATTRIB_TEXCOORD) ? (batch.projective ? 4 : 2) : 0;
+    const int normalsize = (batch.attribs & ATTRIB_NORMAL) ? 3 : 0;
+    int positionsize = batch.depth ? 3 : 2;
+    GLsizei stride = (positionsize + colorsize + texcoordsize + normalsize) * sizeof(GLfloat);
+    size_t size = (size_t)batch.count * stride;
+    const GLvoid* data = batch.packed;
+    uintptr_t position = 0;
+    uintptr_t color = position + positionsize * sizeof(GLfloat);
+    uintptr_t texcoord = color + colorsize * sizeof(GLfloat);
+    uintptr_t normal = texcoord + texcoordsize * sizeof(GLfloat);
+
+    if (size > batch.packedsize)
+    {
+        GLfloat* packed = _glfwRealloc(batch.packed, size, GLFW_MEMORY_OTHER);
+        if (packed)
+        {
+            batch.packed = packed;
+            batch.packedsize = size;
+            data = packed;
+        }
+    }
+    if (size <= batch.packedsize)
+    {
+        GLfloat* dst = batch.packed;
+        for (int i = 0; i < batch.count; i++)
+        {
+            const gl_vertex* vertex = &batch.vertices[i];
+            memcpy(dst, vertex->position, positionsize * sizeof(GLfloat));
+            dst += positionsize;
+            memcpy(dst, vertex->color, colorsize * sizeof(GLfloat));
+            dst += colorsize;
+            memcpy(dst, vertex->texcoord, texcoordsize * sizeof(GLfloat));
+            dst += texcoordsize;
+            memcpy(dst, vertex->normal, normalsize * sizeof(GLfloat));
+            dst += normalsize;
+        }
+    }
+    else
+    {
+        positionsize = 3;
+        stride = sizeof(gl_vertex);
+        size = (size_t)batch.count * stride;
+        data = batch.vertices;
+        position = offsetof(gl_vertex, position);
+        color = offsetof(gl_vertex, color);
+        texcoord = offsetof(gl_vertex, texcoord);
+        normal = offsetof(gl_vertex, normal);
+    }
+
+    GL_CALL(glPushClientAttrib)(GL_CLIENT_VERTEX_ARRAY_BIT);
+    if (_glfw.glmajor > 1 || _glfw.glminor >= 3)
+    {
+        GL_CALL(glClientActiveTexture)(GL_TEXTURE0);
+    }
+
+    // Arrays are read from the streaming buffer, or from memory before
+    // OpenGL 1.5
+    uintptr_t base = (uintptr_t)data;
+    if (_glfw.glmajor > 1 || _glfw.glminor >= 5)
+    {
+        if (!batch.buffer)
+        {
+            GL_CALL(glGenBuffers)(1, &batch.buffer);
+        }
+        GL_CALL(glBindBuffer)(GL_ARRAY_BUFFER, batch.buffer);
+        GL_CALL(glBufferData)(GL_ARRAY_BUFFER, (GLsizeiptr)size, data, GL_STREAM_DRAW);
+        base = 0;
+    }
+
+    GL_CALL(glEnableClientState)(GL_VERTEX_ARRAY);
+    GL_CALL(glVertexPointer)(positionsize, GL_FLOAT, stride, (const GLvoid*)(base + position));
+    if (colorsize)
+    {
+        GL_CALL(glEnableClientState)(GL_COLOR_ARRAY);
+        GL_CALL(glColorPointer)(4, GL_FLOAT, stride, (const GLvoid*)(base + color));
+    }
+    else
+    {
+        GL_CALL(glDisableClientState)(GL_COLOR_ARRAY);
+    }
+    if (texcoordsize)
+    {
+        GL_CALL(glEnableClientState)(GL_TEXTURE_COORD_ARRAY);
+        GL_CALL(glTexCoordPointer)(texcoordsize, GL_FLOAT, stride, (const GLvoid*)(base + texcoord));
+    }
+    else
+    {
+        GL_CALL(glDisableClientState)(GL_TEXTURE_COORD_ARRAY);
+    }
+    if (normalsize)
+    {
+        GL_CALL(glEnableClientState)(GL_NORMAL_ARRAY);
+        GL_CALL(glNormalPointer)(GL_FLOAT, stride, (const GLvoid*)(base + normal));
+    }
+    else
+    {
+        GL_CALL(glDisableClientState)(GL_NORMAL_ARRAY);
+    }
+
+    // Arrays the game left enabled would be drawn from too, unlike with
+    // glBegin(); texture coordinates of other units and generic attributes
+    // aren't looked after though
+    GL_CALL(glDisableClientState)(GL_EDGE_FLAG_ARRAY);
+    if (_glfw.glmajor > 1 || _glfw.glminor >= 4)
+    {
+        GL_CALL(glDisableClientState)(GL_SECONDARY_COLOR_ARRAY);
+        GL_CALL(glDisableClientState)(GL_FOG_COORD_ARRAY);
+    }
+
+    GL_CALL(glDrawArrays)(batch.mode, 0, batch.count);
+    GL_CALL(glPopClientAttrib)();
+    restoreAttribs(batch.attribs | batch.unsent);
+
+    batch.draws++;
+    batch.drawnvertices += batch.count;
+    batch.count = 0;
+    batch.first = 0;
+    batch.depth = GL_FALSE;
+    batch.projective = batch.current.texcoord[2] != 0.f || batch.current.texcoord[3] != 1.f;
+}
+
+// Draws the primitives before the open one, and forwards the latter as it
+// was recorded so far, so that something else may be called in it
+static void replayPrimitive(void)
+{
+    int first = batch.first;
+    int count = batch.count;
+
+    batch.count = first;
+    drawBatch();
+
+    GL_CALL(glBegin)(batch.mode);
+    for (int i = first; i < count; i++)
+    {
+        const gl_vertex* vertex = &batch.vertices[i];
+        if (batch.attribs & ATTRIB_COLOR)
+        {
+            GL_CALL(glColor4fv)(vertex->color);
+        }
+        if (batch.attribs & ATTRIB_TEXCOORD)
+        {
+            GL_CALL(glTexCoord4fv)(vertex->texcoord);
+        }
+        if (batch.attribs & ATTRIB_NORMAL)
+        {
+            GL_CALL(glNormal3fv)(vertex->normal);
+        }
+        GL_CALL(glVertex3fv)(vertex->position);
+    }
+    restoreAttribs(batch.attribs | batch.unsent);
+
+    batch.direct = GL_TRUE;
+    batch.replays++;
+}
+
+static void flushBatch(void)
+{
+    if (batch.open && !batch.direct)
+    {
+        replayPrimitive();
+    }
+    else
+    {
+        drawBatch();
+    }
+}
+
+// Called before any other wrapped function, which may change the state the
+// batch is to be drawn with
+static void syncBatch(int function)
+{
+    flushBatch();
+
+    switch (function)
+    {
+    case GL_glNewList:
+        batch.compiling = GL_TRUE;
+        break;
+    case GL_glEndList:
+        // Lists compiled with GL_COMPILE_AND_EXECUTE were executed too
+        batch.compiling = GL_FALSE;
+        batch.known = 0;
+        break;
+    case GL_glDrawArrays:
+    case GL_glDrawElements:
+    case GL_glDrawRangeElements:
+    case GL_glMultiDrawArrays:
+    case GL_glMultiDrawElements:
+    case GL_glDrawArraysInstanced:
+    case GL_glDrawElementsInstanced:
+    case GL_glDrawElementsBaseVertex:
+    case GL_glArrayElement:
+    case GL_glCallList:
+    case GL_glCallLists:
+    case GL_glPopAttrib:
+    case GL_glEvalCoord1f:
+    case GL_glEvalCoord1fv:
+    case GL_glEvalCoord1d:
+    case GL_glEvalCoord1dv:
+    case GL_glEvalCoord2f:
+    case GL_glEvalCoord2fv:
+    case GL_glEvalCoord2d:
+    case GL_glEvalCoord2dv:
+    case GL_glEvalPoint1:
+    case GL_glEvalPoint2:
+        batch.known = 0;
+        break;
+
+    // Attributes set without being recorded
+    case GL_glColor3b:
+    case GL_glColor3bv:
+    case GL_glColor3s:
+    case GL_glColor3sv:
+    case GL_glColor3i:
+    case GL_glColor3iv:
+    case GL_glColor4b:
+    case GL_glColor4bv:
+    case GL_glColor4s:
+    case GL_glColor4sv:
+    case GL_glColor4i:
+    case GL_glColor4iv:
+        batch.known &= ~ATTRIB_COLOR;
+        break;
+    case GL_glNormal3b:
+    case GL_glNormal3bv:
+    case GL_glNormal3s:
+    case GL_glNormal3sv:
+    case GL_glNormal3i:
+    case GL_glNormal3iv:
+        batch.known &= ~ATTRIB_NORMAL;
+        break;
+
+    default:
+        // The glMultiTexCoord*() functions follow each other in the table,
+        // and may set the coordinates of the first unit
+        if (function >= GL_glMultiTexCoord1s && function <= GL_glMultiTexCoord4dv)
+        {
+            batch.known &= ~ATTRIB_TEXCOORD;
+        }
+        break;
+    }
+}
+
+// Returns whether the attribute was recorded, rather than to be forwarded
+static int batchAttrib(unsigned attrib, GLfloat* current, const GLfloat* value, size_t count)
+{
+    if (batch.compiling)
+    {
+        return GL_FALSE;
+    }
+
+    // Attributes which don't vary are left to the context
+    const int changed = !(batch.known & attrib) ||
+                        memcmp(current, value, count * sizeof(GLfloat)) != 0;
+    const int recording = batch.open && !batch.direct;
+    memcpy(current, value, count * sizeof(GLfloat));
+    batch.known |= attrib;
+
+    if (changed && !(batch.attribs & attrib) && batch.count)
+    {
+        if (batch.recorded & attrib)
+        {
+            // The batched vertices hold the previous value
+            batch.attribs |= attrib;
+        }
+        else if (recording && batch.count > batch.first)
+        {
+            // Nor do the previous vertices of this primitive know it
+            replayPrimitive();
+            return GL_FALSE;
+        }
+        else
+        {
+            drawBatch();
+        }
+    }
+
+    if (!recording)
+    {
+        return GL_FALSE;
+    }
+    if (changed)
+    {
+        batch.attribs |= attrib;
+        batch.unsent |= attrib;
+    }
+    return GL_TRUE;
+}
+
+static int batchColor(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha)
+{
+    const GLfloat value[4] = { red, green, blue, alpha };
+    return batchAttrib(ATTRIB_COLOR, batch.current.color, value, 4);
+}
+
+static int batchTexCoord(GLfloat s, GLfloat t, GLfloat r, GLfloat q)
+{
+    const GLfloat value[4] = { s, t, r, q };
+    if (!batch.compiling && (r != 0.f || q != 1.f))
+    {
+        batch.projective = GL_TRUE;
+    }
+    return batchAttrib(ATTRIB_TEXCOORD, batch.current.texcoord, value, 4);
+}
+
+static int batchNormal(GLfloat nx, GLfloat ny, GLfloat nz)
+{
+    const GLfloat value[3] = { nx, ny, nz };
+    return batchAttrib(ATTRIB_NORMAL, batch.current.normal, value, 3);
+}
+
+static int batchVertex(GLfloat x, GLfloat y, GLfloat z)
+{
+    if (batch.compiling || !batch.open || batch.direct)
+    {
+        return GL_FALSE;
+    }
+
+    if (batch.count == batch.capacity)
+    {
+        int capacity = batch.capacity ? batch.capacity * 2 : 1024;
+        gl_vertex* vertices = _glfwRealloc(batch.vertices, capacity * sizeof(gl_vertex), GLFW_MEMORY_OTHER);
+        if (!vertices)
+        {
+            replayPrimitive();
+            return GL_FALSE;
+        }
+        batch.vertices = vertices;
+        batch.capacity = capacity;
+    }
+
+    if (!batch.count)
+    {
+        batch.recorded = batch.known;
+    }
+
+    gl_vertex* vertex = &batch.vertices[batch.count++];
+    *vertex = batch.current;
+    vertex->position[0] = x;
+    vertex->position[1] = y;
+    vertex->position[2] = z;
+    if (z != 0.f)
+    {
+        batch.depth = GL_TRUE;
+    }
+    return GL_TRUE;
+}
+
+static int batch_glBegin(GLenum mode)
+{
+    if (batch.compiling)
+    {
+        return GL_FALSE;
+    }
+    if (batch.open)
+    {
+        flushBatch();
+        return GL_FALSE;
+    }
+
+    if (batch.count && (mode != batch.mode || !getPrimitiveSize(mode)))
+    {
+        drawBatch();
+    }
+    if (!batch.count)
+    {
+        batch.mode = mode;
+        batch.attribs = 0;
+    }
+
+    batch.open = GL_TRUE;
+    batch.first = batch.count;
+    return GL_TRUE;
+}
+
+static int batch_glEnd(void)
+{
+    if (batch.compiling || !batch.open)
+    {
+        return GL_FALSE;
+    }
+    batch.open = GL_FALSE;
+    if (batch.direct)
+    {
+        batch.direct = GL_FALSE;
+        return GL_FALSE;
+    }
+
+    // Incomplete primitives are ignored, they would shift the next ones
+    int size = getPrimitiveSize(batch.mode);
+    if (size)
+    {
+        batch.count -= (batch.count - batch.first) % size;
+    }
+    if (batch.count > batch.first)
+    {
+        batch.primitives++;
+    }
+
+    if (batch.count >= BATCH_VERTICES || !size)
+    {
+        drawBatch();
+    }
+    return GL_TRUE;
+}
+
+static int batch_glVertex2s(GLshort x, GLshort y)
+{
+    return batchVertex((GLfloat)x, (GLfloat)y, 0.f);
+}
+
+static int batch_glVertex2sv(const GLshort* v)
+{
+    return batchVertex((GLfloat)v[0], (GLfloat)v[1], 0.f);
+}
+
+static int batch_glVertex2i(GLint x, GLint y)
+{
+    return batchVertex((GLfloat)x, (GLfloat)y, 0.f);
+}
+
+static int batch_glVertex2iv(const GLint* v)
+{
+    return batchVertex((GLfloat)v[0], (GLfloat)v[1], 0.f);
+}
+
+static int batch_glVertex2f(GLfloat x, GLfloat y)
+{
+    return batchVertex(x, y, 0.f);
+}
+
+static int batch_glVertex2fv(const GLfloat* v)
+{
+    return batchVertex(v[0], v[1], 0.f);
+}
+
+static int batch_glVertex2d(GLdouble x, GLdouble y)
+{
+    return batchVertex((GLfloat)x, (GLfloat)y, 0.f);
+}
+
+static int batch_glVertex2dv(const GLdouble* v)
+{
+    return batchVertex((GLfloat)v[0], (GLfloat)v[1], 0.f);
+}
+
+static int batch_glVertex3s(GLshort x, GLshort y, GLshort z)
+{
+    return batchVertex((GLfloat)x, (GLfloat)y, (GLfloat)z);
+}
+
+static int batch_glVertex3sv(const GLshort* v)
+{
+    return batchVertex((GLfloat)v[0], (GLfloat)v[1], (GLfloat)v[2]);
+}
+
+static int batch_glVertex3i(GLint x, GLint y, GLint z)
+{
+    return batchVertex((GLfloat)x, (GLfloat)y, (GLfloat)z);
+}
+
+static int batch_glVertex3iv(const GLint* v)
+{
+    return batchVertex((GLfloat)v[0], (GLfloat)v[1], (GLfloat)v[2]);
+}
+
+static int batch_glVertex3f(GLfloat x, GLfloat y, GLfloat z)
+{
+    return batchVertex(x, y, z);
+}
+
+static int batch_glVertex3fv(const GLfloat* v)
+{
+    return batchVertex(v[0], v[1], v[2]);
+}
+
+static int batch_glVertex3d(GLdouble x, GLdouble y, GLdouble z)
+{
+    return batchVertex((GLfloat)x, (GLfloat)y, (GLfloat)z);
+}
+
+static int batch_glVertex3dv(const GLdouble* v)
+{
+    return batchVertex((GLfloat)v[0], (GLfloat)v[1], (GLfloat)v[2]);
+}
+
+static int batch_glTexCoord1s(GLshort s)
+{
+    return batchTexCoord((GLfloat)s, 0.f, 0.f, 1.f);
+}
+
+static int batch_glTexCoord1sv(const GLshort* v)
+{
+    return batchTexCoord((GLfloat)v[0], 0.f, 0.f, 1.f);
+}
+
+static int batch_glTexCoord1i(GLint s)
+{
+    return batchTexCoord((GLfloat)s, 0.f, 0.f, 1.f);
+}
+
+static int batch_glTexCoord1iv(const GLint* v)
+{
+    return batchTexCoord((GLfloat)v[0], 0.f, 0.f, 1.f);
+}
+
+static int batch_glTexCoord1f(GLfloat s)
+{
+    return batchTexCoord(s, 0.f, 0.f, 1.f);
+}
+
+static int batch_glTexCoord1fv(const GLfloat* v)
+{
+    return batchTexCoord(v[0], 0.f, 0.f, 1.f);
+}
+
+static int batch_glTexCoord1d(GLdouble s)
+{
+    return batchTexCoord((GLfloat)s, 0.f, 0.f, 1.f);
+}
+
+static int batch_glTexCoord1dv(const GLdouble* v)
+{
+    return batchTexCoord((GLfloat)v[0], 0.f, 0.f, 1.f);
+}
+
+static int batch_glTexCoord2s(GLshort s, GLshort t)
+{
+    return batchTexCoord((GLfloat)s, (GLfloat)t, 0.f, 1.f);
+}
+
+static int batch_glTexCoord2sv(const GLshort* v)
+{
+    return batchTexCoord((GLfloat)v[0], (GLfloat)v[1], 0.f, 1.f);
+}
+
+static int batch_glTexCoord2i(GLint s, GLint t)
+{
+    return batchTexCoord((GLfloat)s, (GLfloat)t, 0.f, 1.f);
+}
+
+static int batch_glTexCoord2iv(const GLint* v)
+{
+    return batchTexCoord((GLfloat)v[0], (GLfloat)v[1], 0.f, 1.f);
+}
+
+static int batch_glTexCoord2f(GLfloat s, GLfloat t)
+{
+    return batchTexCoord(s, t, 0.f, 1.f);
+}
+
+static int batch_glTexCoord2fv(const GLfloat* v)
+{
+    return batchTexCoord(v[0], v[1], 0.f, 1.f);
+}
+
+static int batch_glTexCoord2d(GLdouble s, GLdouble t)
+{
+    return batchTexCoord((GLfloat)s, (GLfloat)t, 0.f, 1.f);
+}
+
+static int batch_glTexCoord2dv(const GLdouble* v)
+{
+    return batchTexCoord((GLfloat)v[0], (GLfloat)v[1], 0.f, 1.f);
+}
+
+static int batch_glTexCoord3s(GLshort s, GLshort t, GLshort r)
+{
+    return batchTexCoord((GLfloat)s, (GLfloat)t, (GLfloat)r, 1.f);
+}
+
+static int batch_glTexCoord3sv(const GLshort* v)
+{
+    return batchTexCoord((GLfloat)v[0], (GLfloat)v[1], (GLfloat)v[2], 1.f);
+}
+
+static int batch_glTexCoord3i(GLint s, GLint t, GLint r)
+{
+    return batchTexCoord((GLfloat)s, (GLfloat)t, (GLfloat)r, 1.f);
+}
+
+static int batch_glTexCoord3iv(const GLint* v)
+{
+    return batchTexCoord((GLfloat)v[0], (GLfloat)v[1], (GLfloat)v[2], 1.f);
+}
+
+static int batch_glTexCoord3f(GLfloat s, GLfloat t, GLfloat r)
+{
+    return batchTexCoord(s, t, r, 1.f);
+}
+
+static int batch_glTexCoord3fv(const GLfloat* v)
+{
+    return batchTexCoord(v[0], v[1], v[2], 1.f);
+}
+
+static int batch_glTexCoord3d(GLdouble s, GLdouble t, GLdouble r)
+{
+    return batchTexCoord((GLfloat)s, (GLfloat)t, (GLfloat)r, 1.f);
+}
+
+static int batch_glTexCoord3dv(const GLdouble* v)
+{
+    return batchTexCoord((GLfloat)v[0], (GLfloat)v[1], (GLfloat)v[2], 1.f);
+}
+
+static int batch_glTexCoord4s(GLshort s, GLshort t, GLshort r, GLshort q)
+{
+    return batchTexCoord((GLfloat)s, (GLfloat)t, (GLfloat)r, (GLfloat)q);
+}
+
+static int batch_glTexCoord4sv(const GLshort* v)
+{
+    return batchTexCoord((GLfloat)v[0], (GLfloat)v[1], (GLfloat)v[2], (GLfloat)v[3]);
+}
+
+static int batch_glTexCoord4i(GLint s, GLint t, GLint r, GLint q)
+{
+    return batchTexCoord((GLfloat)s, (GLfloat)t, (GLfloat)r, (GLfloat)q);
+}
+
+static int batch_glTexCoord4iv(const GLint* v)
+{
+    return batchTexCoord((GLfloat)v[0], (GLfloat)v[1], (GLfloat)v[2], (GLfloat)v[3]);
+}
+
+static int batch_glTexCoord4f(GLfloat s, GLfloat t, GLfloat r, GLfloat q)
+{
+    return batchTexCoord(s, t, r, q);
+}
+
+static int batch_glTexCoord4fv(const GLfloat* v)
+{
+    return batchTexCoord(v[0], v[1], v[2], v[3]);
+}
+
+static int batch_glTexCoord4d(GLdouble s, GLdouble t, GLdouble r, GLdouble q)
+{
+    return batchTexCoord((GLfloat)s, (GLfloat)t, (GLfloat)r, (GLfloat)q);
+}
+
+static int batch_glTexCoord4dv(const GLdouble* v)
+{
+    return batchTexCoord((GLfloat)v[0], (GLfloat)v[1], (GLfloat)v[2], (GLfloat)v[3]);
+}
+
+static int batch_glNormal3f(GLfloat nx, GLfloat ny, GLfloat nz)
+{
+    return batchNormal(nx, ny, nz);
+}
+
+static int batch_glNormal3fv(const GLfloat* v)
+{
+    return batchNormal(v[0], v[1], v[2]);
+}
+
+static int batch_glNormal3d(GLdouble nx, GLdouble ny, GLdouble nz)
+{
+    return batchNormal((GLfloat)nx, (GLfloat)ny, (GLfloat)nz);
+}
+
+static int batch_glNormal3dv(const GLdouble* v)
+{
+    return batchNormal((GLfloat)v[0], (GLfloat)v[1], (GLfloat)v[2]);
+}
+
+static int batch_glColor3f(GLfloat red, GLfloat green, GLfloat blue)
+{
+    return batchColor(red, green, blue, 1.f);
+}
+
+static int batch_glColor3fv(const GLfloat* v)
+{
+    return batchColor(v[0], v[1], v[2], 1.f);
+}
+
+static int batch_glColor3d(GLdouble red, GLdouble green, GLdouble blue)
+{
+    return batchColor((GLfloat)red, (GLfloat)green, (GLfloat)blue, 1.f);
+}
+
+static int batch_glColor3dv(const GLdouble* v)
+{
+    return batchColor((GLfloat)v[0], (GLfloat)v[1], (GLfloat)v[2], 1.f);
+}
+
+static int batch_glColor3ub(GLubyte red, GLubyte green, GLubyte blue)
+{
+    return batchColor(red / 255.f, green / 255.f, blue / 255.f, 1.f);
+}
+
+static int batch_glColor3ubv(const GLubyte* v)
+{
+    return batchColor(v[0] / 255.f, v[1] / 255.f, v[2] / 255.f, 1.f);
+}
+
+static int batch_glColor3us(GLushort red, GLushort green, GLushort blue)
+{
+    return batchColor(red / 65535.f, green / 65535.f, blue / 65535.f, 1.f);
+}
+
+static int batch_glColor3usv(const GLushort* v)
+{
+    return batchColor(v[0] / 65535.f, v[1] / 65535.f, v[2] / 65535.f, 1.f);
+}
+
+static int batch_glColor3ui(GLuint red, GLuint green, GLuint blue)
+{
+    return batchColor((GLfloat)(red / 4294967295.0), (GLfloat)(green / 4294967295.0), (GLfloat)(blue / 4294967295.0), 1.f);
+}
+
+static int batch_glColor3uiv(const GLuint* v)
+{
+    return batchColor((GLfloat)(v[0] / 4294967295.0), (GLfloat)(v[1] / 4294967295.0), (GLfloat)(v[2] / 4294967295.0), 1.f);
+}
+
+static int batch_glColor4f(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha)
+{
+    return batchColor(red, green, blue, alpha);
+}
+
+static int batch_glColor4fv(const GLfloat* v)
+{
+    return batchColor(v[0], v[1], v[2], v[3]);
+}
+
+static int batch_glColor4d(GLdouble red, GLdouble green, GLdouble blue, GLdouble alpha)
+{
+    return batchColor((GLfloat)red, (GLfloat)green, (GLfloat)blue, (GLfloat)alpha);
+}
+
+static int batch_glColor4dv(const GLdouble* v)
+{
+    return batchColor((GLfloat)v[0], (GLfloat)v[1], (GLfloat)v[2], (GLfloat)v[3]);
+}
+
+static int batch_glColor4ub(GLubyte red, GLubyte green, GLubyte blue, GLubyte alpha)
+{
+    return batchColor(red / 255.f, green / 255.f, blue / 255.f, alpha / 255.f);
+}
+
+static int batch_glColor4ubv(const GLubyte* v)
+{
+    return batchColor(v[0] / 255.f, v[1] / 255.f, v[2] / 255.f, v[3] / 255.f);
+}
+
+static int batch_glColor4us(GLushort red, GLushort green, GLushort blue, GLushort alpha)
+{
+    return batchColor(red / 65535.f, green / 65535.f, blue / 65535.f, alpha / 65535.f);
+}
+
+static int batch_glColor4usv(const GLushort* v)
+{
+    return batchColor(v[0] / 65535.f, v[1] / 65535.f, v[2] / 65535.f, v[3] / 65535.f);
+}
+
+static int batch_glColor4ui(GLuint red, GLuint green, GLuint blue, GLuint alpha)
+{
+    return batchColor((GLfloat)(red / 4294967295.0), (GLfloat)(green / 4294967295.0), (GLfloat)(blue / 4294967295.0), (GLfloat)(alpha / 4294967295.0));
+}
+
+static int batch_glColor4uiv(const GLuint* v)
+{
+    return batchColor((GLfloat)(v[0] / 4294967295.0), (GLfloat)(v[1] / 4294967295.0), (GLfloat)(v[2] / 4294967295.0), (GLfloat)(v[3] / 4294967295.0));
+}
+
+#define GL_HOOK_FLUSH(name) \
+        if (_glfw.glbatch) \
+        { \
+            syncBatch(GL_##name); \
+        }
+#define GL_HOOK_FILTER_SKIP(name, args) \
+        if (_glfw.glshadow) \
+        { \
+            const int skip = skip_##name args; \
+            if (_glfw.glfilter) \
+            { \
+                filter_calls[GL_##name]++; \
+                if (skip) \
+                { \
+                    filter_dropped[GL_##name]++; \
+                    return; \
+                } \
+            } \
+        }
+#define GL_HOOK_FILTER_SYNC(name, args) \
+        if (_glfw.glshadow) \
+        { \
+            sync_##name args; \
+        }
+#define GL_HOOK_FILTER_FORGET(name, args) \
+        if (_glfw.glshadow) \
+        { \
+            forgetState(GL_##name); \
+        }
+#define GL_HOOK_NONE(name, args) \
+        GL_HOOK_FLUSH(name)
+#define GL_HOOK_SKIP(name, args) \
+        GL_HOOK_FILTER_SKIP(name, args) \
+        GL_HOOK_FLUSH(name)
+#define GL_HOOK_SYNC(name, args) \
+        GL_HOOK_FILTER_SYNC(name, args) \
+        GL_HOOK_FLUSH(name)
+#define GL_HOOK_FORGET(name, args) \
+        GL_HOOK_FILTER_FORGET(name, args) \
+        GL_HOOK_FLUSH(name)
+#define GL_HOOK_BATCH(name, args) \
+        if (_glfw.glbatch && batch_##name args) \
+        { \
+            return; \
+        }
+#define GL_HOOK_BATCH_SKIP(name, args) \
+        GL_HOOK_BATCH(name, args) \
+        GL_HOOK_FILTER_SKIP(name, args)
+#define GL_HOOK_BATCH_FORGET(name, args) \
+        GL_HOOK_BATCH(name, args) \
+        GL_HOOK_FILTER_FORGET(name, args)
+
+#define GL_THUNK_V(category, hook, name, params, args, bytes) \
+    GL_THUNK_LINKAGE void APIENTRY GL_THUNK(name) params \
+    { \
+        if (_glfw.glstats) \
+        { \
+            countCall(GL_##name, (bytes)); \
+        } \
+        GL_HOOK_##hook(name, args) \
+        GL_CALL(name) args; \
+    }
+#define GL_THUNK_R(category, type, name, params, args) \
+    GL_THUNK_LINKAGE type APIENTRY GL_THUNK(name) params \
+    { \
+        if (_glfw.glstats) \
+        { \
+            countCall(GL_##name, 0); \
+        } \
+        GL_HOOK_FLUSH(name) \
+        return GL_CALL(name) args; \
+    }
+GL_FUNCTIONS(GL_THUNK_V, GL_THUNK_R)
+#undef GL_THUNK_V
+#undef GL_THUNK_R
+#undef GL_HOOK_NONE
+#undef GL_HOOK_SKIP
+#undef GL_HOOK_SYNC
+#undef GL_HOOK_FORGET
+#undef GL_HOOK_BATCH
+#undef GL_HOOK_BATCH_SKIP
+#undef GL_HOOK_BATCH_FORGET
+#undef GL_HOOK_FILTER_SKIP
+#undef GL_HOOK_FILTER_SYNC
+#undef GL_HOOK_FILTER_FORGET
+#undef GL_HOOK_FLUSH
+
+static const struct
+{
+    const char* name;
+    int category;
+    void* thunk;
+} functions[GL_COUNT] = {
+#define GL_ENTRY_V(category, hook, name, params, args, bytes) \
+    { #name, CATEGORY_##category, (void*)GL_THUNK(name) },
+#define GL_ENTRY_R(category, type, name, params, args) \
+    { #name, CATEGORY_##category, (void*)GL_THUNK(name) },
+    GL_FUNCTIONS(GL_ENTRY_V, GL_ENTRY_R)
+#undef GL_ENTRY_V
+#undef GL_ENTRY_R
+};
+
+static const struct
+{
+    const char* name;
+    int function;
+} aliases[] = {
+#define GL_ALIAS_ENTRY(alias, name) { #alias, GL_##name },
+    GL_ALIASES(GL_ALIAS_ENTRY)
+#undef GL_ALIAS_ENTRY
+};
+
+#if defined(_GLFW_GL_INTERPOSE)
+#define GL_EXPORT_ALIAS(suffixed, name) \
+    GLFWAPI __typeof__(name) suffixed __attribute__((alias(#name)));
+GL_ALIASES(GL_EXPORT_ALIAS)
+#undef GL_EXPORT_ALIAS
+#endif
+
+static void* getProc(int function)
+{
+    void* proc = procs[function];
+    if (proc)
+    {
+        return proc;
+    }
+
+    const char* name = functions[function].name;
+    if (_glfw.window)
+    {
+        proc = _GLFW3(glfwGetProcAddress)(name);
+    }
+    if (!proc && _glfw.gl_handle)
+    {
+        proc = dlsym(_glfw.gl_handle, name);
+    }
+    // Our own export may be found first when interposing
+    if (!proc || proc == functions[function].thunk)
+    {
+        proc = dlsym(RTLD_NEXT, name);
+    }
+    if (!proc)
+    {
+        fprintf(stderr, "glfw2to3: %s not found\n", name);
+        abort();
+    }
+
+    procs[function] = proc;
+    return proc;
+}
+
+static void printGLStats(void)
+{
+    uint64_t frames = stats.frames ? stats.frames : 1;
+    int order[GL_COUNT];
+
+    fprintf(stderr, "glfw2to3 OpenGL statistics over %llu frames:\n", (unsigned long long)stats.frames);
+    fprintf(stderr, "%-28s %12s %12s %12s\n", "category", "calls", "per frame", "max/frame");
+    for (int i = 0; i < CATEGORY_COUNT; ++i)
+    {
+        fprintf(stderr, "%-28s %12llu %12.1f %12llu\n", category_names[i],
+                (unsigned long long)stats.categorycalls[i],
+                (double)stats.categorycalls[i] / (double)frames,
+                (unsigned long long)stats.categorymax[i]);
+    }
+
+    uint64_t bytes = 0;
+    for (int i = 0; i < GL_COUNT; ++i)
+    {
+        bytes += stats.bytes[i];
+    }
+    fprintf(stderr, "%-28s %12.1f %12.1f %12.1f\n", "uploaded KiB",
+            (double)bytes / 1024.0, (double)bytes / 1024.0 / (double)frames,
+            (double)stats.uploadmax / 1024.0);
+
+    // Most called functions first
+    for (int i = 0; i < GL_COUNT; ++i)
+    {
+        int j = i;
+        for (; j > 0 && stats.calls[order[j - 1]] < stats.calls[i]; --j)
+        {
+            order[j] = order[j - 1];
+        }
+        order[j] = i;
+    }
+
+    fprintf(stderr, "%-28s %12s %12s %12s %12s\n", "function", "calls", "per frame", "max/frame", "KiB");
+    for (int i = 0; i < GL_COUNT && i < top_functions; ++i)
+    {
+        int function = order[i];
+        if (!stats.calls[function])
+        {
+            break;
+        }
+        fprintf(stderr, "%-28s %12llu %12.1f %12llu %12.1f\n", functions[function].name,
+                (unsigned long long)stats.calls[function],
+                (double)stats.calls[function] / (double)frames,
+                (unsigned long long)stats.maxcalls[function],
+                (double)stats.bytes[function] / 1024.0);
+    }
+
+    // Each of these waits for the driver to catch up with the commands queued
+    // so far, so they are listed even when not among the most called
+    if (!stats.categorycalls[CATEGORY_GET])
+    {
+        return;
+    }
+    fprintf(stderr, "glGet calls, stalling the pipeline:\n");
+    for (int i = 0; i < GL_COUNT; ++i)
+    {
+        int function = order[i];
+        if (functions[function].category == CATEGORY_GET && stats.calls[function])
+        {
+            fprintf(stderr, "%-28s %12llu %12.1f %12llu\n", functions[function].name,
+                    (unsigned long long)stats.calls[function],
+                    (double)stats.calls[function] / (double)frames,
+                    (unsigned long long)stats.maxcalls[function]);
+        }
+    }
+}
+
+static void printFilterStats(void)
+{
+    fprintf(stderr, "glfw2to3 OpenGL state filter:\n");
+    fprintf(stderr, "%-28s %12s %12s %8s\n", "function", "calls", "dropped", "%");
+
+    uint64_t calls = 0, dropped = 0;
+    for (int i = 0; i < GL_COUNT; ++i)
+    {
+        if (!filter_calls[i])
+        {
+            continue;
+        }
+        fprintf(stderr, "%-28s %12llu %12llu %8.1f\n", functions[i].name,
+                (unsigned long long)filter_calls[i], (unsigned long long)filter_dropped[i],
+                100.0 * (double)filter_dropped[i] / (double)filter_calls[i]);
+        calls += filter_calls[i];
+        dropped += filter_dropped[i];
+    }
+    fprintf(stderr, "%-28s %12llu %12llu %8.1f\n", "total",
+            (unsigned long long)calls, (unsigned long long)dropped,
+            calls ? 100.0 * (double)dropped / (double)calls : 0.0);
+}
+
+static void printBatchStats(void)
+{
+    fprintf(stderr, "glfw2to3 OpenGL batching:\n");
+    fprintf(stderr, "%-28s %12llu\n", "primitives batched", (unsigned long long)batch.primitives);
+    fprintf(stderr, "%-28s %12llu\n", "draws", (unsigned long long)batch.draws);
+    fprintf(stderr, "%-28s %12.1f\n", "primitives per draw",
+            batch.draws ? (double)batch.primitives / (double)batch.draws : 0.0);
+    fprintf(stderr, "%-28s %12llu\n", "vertices", (unsigned long long)batch.drawnvertices);
+    fprintf(stderr, "%-28s %12llu\n", "primitives forwarded", (unsigned long long)batch.replays);
+}
+
+void* _glfwInterposeGLProc(const char* name, void* proc, int game)
+{
+    if (!proc || (!_glfw.glstats && !_glfw.glshadow && !_glfw.glbatch))
+    {
+        return proc;
+    }
+
+    int function = -1;
+    for (int i = 0; i < GL_COUNT && function < 0; ++i)
+    {
+        if (strcmp(functions[i].name, name) == 0)
+        {
+            function = i;
+        }
+    }
+    for (size_t i = 0; i < sizeof(aliases) / sizeof(aliases[0]) && function < 0; ++i)
+    {
+        if (strcmp(aliases[i].name, name) == 0)
+        {
+            function = aliases[i].function;
+        }
+    }
+    if (function < 0)
+    {
+        return proc;
+    }
+
+    if (proc != functions[function].thunk)
+    {
+        procs[function] = proc;
+    }
+    if (game)
+    {
+        resolved[function] = GL_TRUE;
+    }
+    return functions[function].thunk;
+}
+
+void _glfwFlushGLProcs(void)
+{
+    memset(procs, 0, sizeof(procs));
+    resetShadow();
+    resetBatch();
+}
+
+void _glfwFlushGLBatch(void)
+{
+    flushBatch();
+}
+
+// Whether the wrappers see every call to these functions, so that the state
+// they change can be told from the shadow.  Exported ones do, otherwise the
+// game must have looked them all up through glfwGetProcAddress(), as it may
+// as well call those of libGL directly
+static int seesCalls(const int* list, size_t count)
+{
+    if (!_glfw.glshadow)
+    {
+        return GL_FALSE;
+    }
+#if !defined(_GLFW_GL_INTERPOSE)
+    for (size_t i = 0; i < count; i++)
+    {
+        if (!resolved[list[i]])
+        {
+            return GL_FALSE;
+        }
+    }
+#else
+    (void)list;
+    (void)count;
+#endif
+    return GL_TRUE;
+}
+
+// Whether _glfw.unpack matches the context, otherwise it must be queried
+int _glfwIsGLPixelStoreKnown(void)
+{
+    static const int list[] = { GL_glPixelStorei };
+    return seesCalls(list, sizeof(list) / sizeof(list[0])) &&
+           (shadow.known & KNOWN_UNPACK);
+}
+
+// After _glfw.unpack was queried, it is known until the state is forgotten
+void _glfwSetGLPixelStoreKnown(void)
+{
+    shadow.known |= KNOWN_UNPACK;
+}
+
+// What glGetIntegerv() returns for the targets _glfwGetGLBinding() is used with
+static GLenum getBindingQuery(GLenum target)
+{
+    switch (target)
+    {
+    case GL_TEXTURE_2D:
+        return GL_TEXTURE_BINDING_2D;
+    case GL_TEXTURE_RECTANGLE:
+        return GL_TEXTURE_BINDING_RECTANGLE;
+    case GL_READ_FRAMEBUFFER:
+        return GL_READ_FRAMEBUFFER_BINDING;
+    case GL_DRAW_FRAMEBUFFER:
+        return GL_DRAW_FRAMEBUFFER_BINDING;
+    case GL_RENDERBUFFER:
+        return GL_RENDERBUFFER_BINDING;
+    default:
+        return 0;
+    }
+}
+
+// Whether the wrappers see every call which binds or deletes the objects of
+// a target, as _glfwGetGLBinding() is used with
+static int seesBindings(GLenum target)
+{
+    static const int textures[] = { GL_glBindTexture, GL_glDeleteTextures, GL_glActiveTexture };
+    static const int framebuffers[] = { GL_glBindFramebuffer, GL_glDeleteFramebuffers };
+    static const int renderbuffers[] = { GL_glBindRenderbuffer, GL_glDeleteRenderbuffers };
+    if (isTextureTarget(target))
+    {
+        return seesCalls(textures, sizeof(textures) / sizeof(textures[0]));
+    }
+    if (isFramebufferTarget(target))
+    {
+        return seesCalls(framebuffers, sizeof(framebuffers) / sizeof(framebuffers[0]));
+    }
+    if (isRenderbufferTarget(target))
+    {
+        return seesCalls(renderbuffers, sizeof(renderbuffers) / sizeof(renderbuffers[0]));
+    }
+    return GL_FALSE;
+}
+
+// Whether the wrappers see every call which binds, deletes or loads the
+// textures of the game, as streaming them needs
+int _glfwSeesGLTextureImages(void)
+{
+    static const int list[] = {
+        GL_glBindTexture, GL_glActiveTexture, GL_glDeleteTextures,
+        GL_glTexImage2D, GL_glCompressedTexImage2D
+    };
+    return seesCalls(list, sizeof(list) / sizeof(list[0]));
+}
+
+// Object bound to a target, on the active unit for textures.  Only queried
+// when the shadow doesn't know it, which it then does until it is forgotten
+// again, or when the wrappers may not see it change
+GLuint _glfwGetGLBinding(GLenum target)
+{
+    GLenum unit = 0;
+    const int known = seesBindings(target) &&
+        (!isTextureTarget(target) || getTextureUnit(KNOWN_ACTIVE_TEXTURE, &unit));
+    if (known)
+    {
+        for (int i = 0; i < shadow.bindingcount; i++)
+        {
+            const gl_binding* binding = &shadow.bindings[i];
+            if (binding->unit == unit && binding->target == target)
+            {
+                return binding->name;
+            }
+        }
+    }
+
+    GLint name = 0;
+    GL_CALL(glGetIntegerv)(getBindingQuery(target), &name);
+    if (known && !shadow.compiling)
+    {
+        skipBinding(unit, target, (GLuint)name);
+    }
+    return (GLuint)name;
+}
+
+// Whether a capability other than those of texture units is enabled, only
+// queried when the shadow doesn't know it either
+GLboolean _glfwIsGLEnabled(GLenum cap)
+{
+    static const int list[] = { GL_glEnable, GL_glDisable };
+    const int known = seesCalls(list, sizeof(list) / sizeof(list[0]));
+    if (known)
+    {
+        for (int i = 0; i < shadow.capcount; i++)
+        {
+            const gl_cap* entry = &shadow.caps[i];
+            if (!entry->client && entry->cap == cap)
+            {
+                return entry->enabled;
+            }
+        }
+    }
+
+    const GLboolean enabled = GL_CALL(glIsEnabled)(cap);
+    if (known)
+    {
+        skipCap(GL_FALSE, cap, enabled);
+    }
+    return enabled;
+}
+
+void _glfwEndGLFrame(void)
+{
+    uint64_t categories[CATEGORY_COUNT] = { 0 };
+    for (int i = 0; i < GL_COUNT; ++i)
+    {
+        uint64_t calls = stats.framecalls[i];
+        if (!calls)
+        {
+            continue;
+        }
+        stats.calls[i] += calls;
+        if (calls > stats.maxcalls[i])
+        {
+            stats.maxcalls[i] = calls;
+        }
+        categories[functions[i].category] += calls;
+        stats.framecalls[i] = 0;
+    }
+
+    for (int i = 0; i < CATEGORY_COUNT; ++i)
+    {
+        stats.categorycalls[i] += categories[i];
+        if (categories[i] > stats.categorymax[i])
+        {
+            stats.categorymax[i] = categories[i];
+        }
+    }
+
+    if (stats.framebytes > stats.uploadmax)
+    {
+        stats.uploadmax = stats.framebytes;
+    }
+    stats.framebytes = 0;
+    stats.frames++;
+}
+
+void _glfwInitGLCalls(void)
+{
+    const char* functions = getenv("GLFW2TO3_GL_STATS");
+    if (functions)
+    {
+        _glfw.glstats = GL_TRUE;
+        if (atoi(functions) > 0)
+        {
+            top_functions = atoi(functions);
+        }
+    }
+
+    // Exported wrappers see all the calls, the state they shadow is always
+    // worth following
+#if defined(_GLFW_GL_INTERPOSE)
+    _glfw.glshadow = GL_TRUE;
+#endif
+
+    if (getenv("GLFW2TO3_GL_FILTER"))
+    {
+        _glfw.glfilter = GL_TRUE;
+        _glfw.glshadow = GL_TRUE;
+    }
+
+    // Redundant binds between sprites would otherwise end every batch
+    if (getenv("GLFW2TO3_GL_BATCH"))
+    {
+        _glfw.glbatch = GL_TRUE;
+        _glfw.glfilter = GL_TRUE;
+        _glfw.glshadow = GL_TRUE;
+    }
+}
+
+void _glfwTerminateGLCalls(void)
+{
+    if (_glfw.glbatch)
+    {
+        printBatchStats();
+        _glfwFree(batch.vertices, GLFW_MEMORY_OTHER);
+        _glfwFree(batch.packed, GLFW_MEMORY_OTHER);
+        memset(&batch, 0, sizeof(batch));
+    }
+
+    if (_glfw.glfilter)
+    {
+        printFilterStats();
+        memset(filter_calls, 0, sizeof(filter_calls));
+        memset(filter_dropped, 0, sizeof(filter_dropped));
+    }
+
+    if (!_glfw.glstats)
+    {
+        return;
+    }
+
+    // The calls made since the last buffer swap make up a last frame
+    for (int i = 0; i < GL_COUNT; ++i)
+    {
+        if (stats.framecalls[i])
+        {
+            _glfwEndGLFrame();
+            break;
+        }
+    }
+
+    printGLStats();
+    memset(&stats, 0, sizeof(stats));
+}
+
+GLFWAPI void GLFWAPIENTRY glfwSyncGLState(void)
+{
+    _GLFW_COUNT_CALL(glfwSyncGLState);
+    if (_glfw.glbatch)
+    {
+        flushBatch();
+        batch.known = 0;
+    }
+    invalidateShadow();
+
+    // The active texture units may have been changed behind our back too
+    shadow.known &= ~(KNOWN_ACTIVE_TEXTURE | KNOWN_CLIENT_ACTIVE_TEXTURE);
+}
@@ -29,6 +29,7 @@
 
 #include "internal.h"
 
+#include <stdatomic.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -64,13 +65,22 @@
 //
 // TGA format image file loader. This module supports version 1 Targa
 // images, with these restrictions:
-//  - Pixel format may only be 8, 24 or 32 bits
+//  - Pixel format may only be 8, 24 or 32 bits, or 15 and 16 bits for
+//    true-color images (kept packed with GLFW_PACKED_PIXELS_BIT)
 //  - Colormaps must be no longer than 256 entries
 //
 //========================================================================
 
 //========================================================================
-// Opens a GLFW stream with a file
+// Description:
+//
+// PNG format image file loader, available when built with zlib. All the
+// color types, bit depths and interlacing are supported, with these
+// restrictions:
+//  - Samples are reduced to 8 bits
+//  - Gray+alpha images, and those with a transparent color, are expanded
+//    to RGBA
+//
 //========================================================================
 
 //------------------------------------------------------------------------
@@ -81,18 +91,142 @@ typedef struct {
     void*   data;
     long    position;
     long    size;
+
+    // Set when the file or memory block is compressed, positions are then
+    // counted in decompressed bytes
+    _GLFWdecoder* decoder;
+    long    decoded;
 } _GLFWstream;
 
+
+//========================================================================
+// Reads raw data from the file or memory block of a GLFW stream
+//========================================================================
+
+static long _glfwReadRawStream( void *user, void *data, long size )
+{
+    _GLFWstream *stream = (_GLFWstream*) user;
+
+    if( stream->file != NULL )
+    {
+        return (long) fread( data, 1, size, stream->file );
+    }
+
+    if( stream->data != NULL )
+    {
+        // Clamp read size to available data (none is left at EOF)
+        if( stream->position + size > stream->size )
+        {
+            size = stream->size - stream->position;
+        }
+
+        // Perform data read
+        memcpy( data, (unsigned char*) stream->data + stream->position, size );
+        stream->position += size;
+        return size;
+    }
+
+    return 0;
+}
+
+
+//========================================================================
+// Rewinds the file or memory block of a GLFW stream
+//========================================================================
+
+static int _glfwRewindRawStream( _GLFWstream *stream )
+{
+    if( stream->file != NULL )
+    {
+        return fseek( stream->file, 0, SEEK_SET ) == 0;
+    }
+
+    stream->position = 0;
+    return GL_TRUE;
+}
+
+
+//========================================================================
+// Looks for the magic number of a compressed format, and if found sets up
+// the decoder of a GLFW stream
+//========================================================================
+
+static int _glfwDetectStreamCompression( _GLFWstream *stream )
+{
+    unsigned char magic[4];
+    long size;
+    int codec;
+
+    size = _glfwReadRawStream( stream, magic, sizeof(magic) );
+    if( !_glfwRewindRawStream( stream ) )
+    {
+        return GL_FALSE;
+    }
+
+    codec = _glfwDetectCompression( magic, size );
+    if( codec != _GLFW_CODEC_NONE )
+    {
+        stream->decoder = _glfwCreateDecoder( codec );
+        if( stream->decoder == NULL )
+        {
+            return GL_FALSE;
+        }
+    }
+
+    return GL_TRUE;
+}
+
+
+//========================================================================
+// Opens a GLFW stream with a file
+//========================================================================
+
 static int _glfwOpenFileStream( _GLFWstream *stream, const char* name, const char* mode )
 {
+    const char *suffix;
+    char *compressed;
+    int codec;
+
     memset( stream, 0, sizeof(_GLFWstream) );
 
     stream->file = fopen( name, mode );
+
+    // Only the compressed variant of a file may be installed, for instance
+    // image.tga.zst instead of image.tga
+    if( stream->file == NULL && mode[0] == 'r' )
+    {
+        compressed = (char*) _glfwMalloc( strlen( name ) + 5, GLFW_MEMORY_OTHER );
+        if( compressed == NULL )
+        {
+            return GL_FALSE;
+        }
+
+        for( codec = 1; codec < _GLFW_CODEC_COUNT && stream->file == NULL; ++ codec )
+        {
+            suffix = _glfwGetCompressionSuffix( codec );
+            if( suffix != NULL )
+            {
+                strcpy( compressed, name );
+                strcat( compressed, suffix );
+                stream->file = fopen( compressed, mode );
+            }
+        }
+
+        _glfwFree( compressed, GLFW_MEMORY_OTHER );
+    }
+
     if( stream->file == NULL )
     {
         return GL_FALSE;
     }
 
+    if( mode[0] == 'r' && !_glfwDetectStreamCompression( stream ) )
+    {
+        fclose( stream->file );
+        stream->file = NULL;
+        return GL_FALSE;
+    }
+
     return GL_TRUE;
 }
 
@@ -111,38 +245,69 @@ static int _glfwOpenBufferStream( _GLFWstream *stream, void *data, long size )
 }
 
 
+//========================================================================
+// Opens a GLFW stream with a memory block to be read, which may be
+// compressed
+//========================================================================
+
+static int _glfwOpenReadBufferStream( _GLFWstream *stream, const void *data, long size )
+{
+    _glfwOpenBufferStream( stream, (void*) data, size );
+    return _glfwDetectStreamCompression( stream );
+}
+
+
 //========================================================================
 // Reads data from a GLFW stream
 //========================================================================
 
 static long _glfwReadStream( _GLFWstream *stream, void *data, long size )
 {
-    if( stream->file != NULL )
+    _GLFWstagetimer timer;
+
+    _GLFW_BEGIN_STAGE( timer );
+
+    if( stream->decoder != NULL )
     {
-        return (long) fread( data, 1, size, stream->file );
+        size = _glfwDecoderRead( stream->decoder, data, size,
+                                 _glfwReadRawStream, stream );
+        stream->decoded += size;
     }
-
-    if( stream->data != NULL )
+    else
     {
-        // Check for EOF
-        if( stream->position == stream->size )
-        {
-            return 0;
-        }
+        size = _glfwReadRawStream( stream, data, size );
+    }
 
-        // Clamp read size to available data
-        if( stream->position + size > stream->size )
-        {
-            size = stream->size - stream->position;
-        }
+    _GLFW_END_STAGE( timer, GLFW_STAGE_READ, size );
 
-        // Perform data read
-        memcpy( data, (unsigned char*) stream->data + stream->position, size );
-        stream->position += size;
-        return size;
+    return size;
+}
+
+
+//========================================================================
+// Writes data to a GLFW stream
+//========================================================================
+
+static long _glfwWriteStream( _GLFWstream *stream, const void *data, long size )
+{
+    long avail;
+
+    if( stream->file != NULL )
+    {
+        return (long) fwrite( data, 1, size, stream->file );
     }
 
-    return 0;
+    // Memory streams keep counting past their end (or without any memory
+    // block), so that the required size is known
+    if( stream->data != NULL && stream->position < stream->size )
+    {
+        avail = stream->size - stream->position;
+        memcpy( (unsigned char*) stream->data + stream->position, data,
+                size < avail ? size : avail );
+    }
+    stream->position += size;
+
+    return size;
 }
 
 
@@ -152,6 +317,11 @@ static long _glfwReadStream( _GLFWstream *stream, void *data, long size )
 
 static long _glfwTellStream( _GLFWstream *stream )
 {
+    if( stream->decoder != NULL )
+    {
+        return stream->decoded;
+    }
+
     if( stream->file != NULL )
     {
         return ftell( stream->file );
@@ -172,7 +342,50 @@ static long _glfwTellStream( _GLFWstream *stream )
 
 static int _glfwSeekStream( _GLFWstream *stream, long offset, int whence )
 {
-    long position;
+    unsigned char skip[4096];
+    long position, count;
+
+    // Compressed streams can only be decoded forward, so seeking backward
+    // restarts decoding from the beginning
+    if( stream->decoder != NULL )
+    {
+        if( whence == SEEK_CUR )
+        {
+            offset += stream->decoded;
+        }
+        else if( whence != SEEK_SET )
+        {
+            return GL_FALSE;
+        }
+
+        if( offset < stream->decoded )
+        {
+            if( !_glfwRewindRawStream( stream ) )
+            {
+                return GL_FALSE;
+            }
+            _glfwResetDecoder( stream->decoder );
+            stream->decoded = 0;
+        }
+
+        while( stream->decoded < offset )
+        {
+            count = offset - stream->decoded;
+            if( count > (long) sizeof(skip) )
+            {
+                count = (long) sizeof(skip);
+            }
+            count = _glfwDecoderRead( stream->decoder, skip, count,
+                                      _glfwReadRawStream, stream );
+            if( count <= 0 )
+            {
+                break;
+            }
+            stream->decoded += count;
+        }
+
+        return GL_TRUE;
+    }
 
     if( stream->file != NULL )
     {
@@ -236,6 +449,8 @@ static void _glfwCloseStream( _GLFWstream *stream )
 
     // Nothing to be done about (user allocated) memory blocks
 
+    _glfwDestroyDecoder( stream->decoder );
+
     memset( stream, 0, sizeof(_GLFWstream) );
 }
 
@@ -298,7 +513,11 @@ static int ReadTGAHeader( _GLFWstream *s, _tga_header_t *h )
 
     // Read TGA file header from file
     pos = _glfwTellStream( s );
-    _glfwReadStream( s, buf, 18 );
+    if( _glfwReadStream( s, buf, 18 ) != 18 )
+    {
+        _glfwSeekStream( s, pos, SEEK_SET );
+        return GL_FALSE;
+    }
 
     // Interpret header (endian independent parsing)
     h->idlen         = (int) buf[0];
@@ -320,12 +539,17 @@ static int ReadTGAHeader( _GLFWstream *s, _tga_header_t *h )
     h->_origin    = (int) (h->imageinfo & _TGA_IMAGEINFO_ORIGIN_MASK) >>
                      _TGA_IMAGEINFO_ORIGIN_SHIFT;
 
-    // Validate TGA header (is this a TGA file?)
-    if( (h->cmaptype == 0 || h->cmaptype == 1) &&
+    // Validate TGA header (is this a TGA file?), empty images are refused
+    // as there is nothing to decode into
+    if( h->width > 0 && h->height > 0 &&
+        (h->cmaptype == 0 || h->cmaptype == 1) &&
         ((h->imagetype >= 1 && h->imagetype <= 3) ||
          (h->imagetype >= 9 && h->imagetype <= 11)) &&
          (h->bitsperpixel == 8 || h->bitsperpixel == 24 ||
-          h->bitsperpixel == 32) )
+          h->bitsperpixel == 32 ||
+          ((h->bitsperpixel == 15 || h->bitsperpixel == 16) &&
+           (h->imagetype == _TGA_IMAGETYPE_TC ||
+            h->imagetype == _TGA_IMAGETYPE_TC_RLE))) )
     {
         // Skip the ID field
         _glfwSeekStream( s, h->idlen, SEEK_CUR );
@@ -343,89 +567,160 @@ static int ReadTGAHeader( _GLFWstream *s, _tga_header_t *h )
     }
 }
 
+//========================================================================
+// Size of the colormap of a TGA image, in bytes (0 if there is none)
+//========================================================================
+
+static int TGAColormapSize( const _tga_header_t *h )
+{
+    return (h->cmaptype == _TGA_CMAPTYPE_PRESENT ? 1 : 0) * h->cmaplen *
+           ((h->cmapentrysize+7) / 8);
+}
+
+
+//========================================================================
+// Bytes per pixel of a decoded TGA image (after colormap expansion)
+//========================================================================
+
+static int TGAPixelSize( const _tga_header_t *h )
+{
+    if( TGAColormapSize( h ) > 0 )
+    {
+        return (h->cmapentrysize + 7) / 8;
+    }
+
+    return (h->bitsperpixel + 7) / 8;
+}
+
+
+//========================================================================
+// OpenGL format of a 16-bit TGA image, kept packed (alpha is only present
+// in 16-bit images with an alpha bit)
+//========================================================================
+
+static int TGAPackedFormat( const _tga_header_t *h )
+{
+    return (h->bitsperpixel == 16 && h->_alphabits > 0) ? GL_RGB5_A1 :
+                                                          GL_RGB5;
+}
+
+
+//========================================================================
+// Bytes per pixel of a 16-bit image once unpacked to RGB/RGBA
+//========================================================================
+
+static int UnpackedPixelSize( int format )
+{
+    return format == GL_RGB5_A1 ? 4 : 3;
+}
+
+
 //========================================================================
 // Read Run-Length Encoded data
 //========================================================================
 
-static void ReadTGA_RLE( unsigned char *buf, int size, int bpp,
-                         _GLFWstream *s )
+static void ReadTGA_RLE( unsigned char *buf, int width, int height,
+                         int stride, int bpp, _GLFWstream *s )
 {
-    int repcount, bytes, k, n;
-    unsigned char pixel[ 4 ];
+    int repcount, count, k, n, x;
+    long left;
+    unsigned char pixel[ 4 ], *dst;
     char c;
 
     // Dummy check
-    if( bpp > 4 )
+    if( bpp > 4 || width <= 0 || height <= 0 )
     {
         return;
     }
 
-    while( size > 0 )
+    // Packets are clamped to the pixels left in the image, so that a
+    // corrupt file can't write past its end
+    x = 0;
+    left = (long) width * height;
+    dst = buf;
+    while( left > 0 )
     {
         // Get repetition count
-	_glfwReadStream( s, &c, 1 );
+        c = 0;
+        _glfwReadStream( s, &c, 1 );
         repcount = (unsigned int) c;
-        bytes = ((repcount & 127) + 1) * bpp;
-        if( size < bytes )
+        count = (repcount & 127) + 1;
+        if( count > left )
         {
-            bytes = size;
+            count = (int) left;
         }
+        left -= count;
 
         // Run-Length packet?
         if( repcount & 128 )
         {
             _glfwReadStream( s, pixel, bpp );
-            for( n = 0; n < (repcount & 127) + 1; n ++ )
+            for( ; count > 0; count -- )
             {
                 for( k = 0; k < bpp; k ++ )
                 {
-                    *buf ++ = pixel[ k ];
+                    *dst ++ = pixel[ k ];
+                }
+                if( ++ x == width )
+                {
+                    x = 0;
+                    buf += stride;
+                    dst = buf;
                 }
             }
         }
         else
         {
-            // It's a Raw packet
-            _glfwReadStream( s, buf, bytes );
-            buf += bytes;
+            // It's a Raw packet, which may span several rows
+            while( count > 0 )
+            {
+                n = count < width - x ? count : width - x;
+                _glfwReadStream( s, dst, n * bpp );
+                dst   += n * bpp;
+                x     += n;
+                count -= n;
+                if( x == width )
+                {
+                    x = 0;
+                    buf += stride;
+                    dst = buf;
+                }
+            }
         }
-
-        size -= bytes;
     }
 }
 
 
 //========================================================================
-// Read a TGA image from a file
+// Decode the pixels of a TGA image (the header has already been read)
+// into rows of stride bytes, starting at pix.  If alpha isn't NULL, how
+// RGBA images use their alpha channel is raised into it
 //========================================================================
 
-static int _glfwReadTGA( _GLFWstream *s, GLFWimage *img, int flags )
+static int DecodeTGA( _GLFWstream *s, const _tga_header_t *h,
+                      unsigned char *pix, int stride, int flags, int *alpha )
 {
-    _tga_header_t h;
-    unsigned char *cmap, *pix, tmp, *src, *dst;
-    int cmapsize, pixsize, pixsize2;
-    int bpp, bpp2, k, m, n, swapx, swapy;
+    _GLFWstagetimer timer;
+    unsigned char *cmap, *row, tmp, *src, *dst;
+    int cmapsize, rowsize, idx;
+    int bpp, bpp2, k, m, n, swapx, swapy, opaque;
+    uint16_t packed;
 
-    // Read TGA header
-    if( !ReadTGAHeader( s, &h ) )
-    {
-        return 0;
-    }
+    _GLFW_BEGIN_STAGE( timer );
 
     // Is there a colormap?
-    cmapsize = (h.cmaptype == _TGA_CMAPTYPE_PRESENT ? 1 : 0) * h.cmaplen *
-               ((h.cmapentrysize+7) / 8);
+    cmapsize = TGAColormapSize( h );
     if( cmapsize > 0 )
     {
         // Is it a colormap that we can handle?
-        if( (h.cmapentrysize != 24 && h.cmapentrysize != 32) ||
-            h.cmaplen == 0 || h.cmaplen > 256 )
+        if( (h->cmapentrysize != 24 && h->cmapentrysize != 32) ||
+            h->cmaplen == 0 || h->cmaplen > 256 )
         {
             return 0;
         }
 
         // Allocate memory for colormap
-        cmap = (unsigned char *) malloc( cmapsize );
+        cmap = (unsigned char *) _glfwMalloc( cmapsize, GLFW_MEMORY_COLORMAP );
         if( cmap == NULL )
         {
             return 0;
@@ -439,49 +734,36 @@ static int _glfwReadTGA( _GLFWstream *s, GLFWimage *img, int flags )
         cmap = NULL;
     }
 
-    // Size of pixel data
-    pixsize = h.width * h.height * ((h.bitsperpixel + 7) / 8);
-
     // Bytes per pixel (pixel data - unexpanded)
-    bpp = (h.bitsperpixel + 7) / 8;
+    bpp = (h->bitsperpixel + 7) / 8;
 
     // Bytes per pixel (expanded pixels - not colormap indeces)
-    if( cmap )
-    {
-        bpp2 = (h.cmapentrysize + 7) / 8;
-    }
-    else
-    {
-        bpp2 = bpp;
-    }
+    bpp2 = TGAPixelSize( h );
 
-    // For colormaped images, the RGB/RGBA image data may use more memory
-    // than the stored pixel data
-    pixsize2 = h.width * h.height * bpp2;
+    // Size of one row of pixel data
+    rowsize = h->width * bpp;
 
-    // Allocate memory for pixel data
-    pix = (unsigned char *) malloc( pixsize2 );
-    if( pix == NULL )
+    // Read pixel data from file, each row at the start of its stride (for
+    // colormaped images, the expanded row may use more memory than the
+    // stored pixel data)
+    if( h->imagetype >= _TGA_IMAGETYPE_CMAP_RLE )
     {
-        if( cmap )
-        {
-            free( cmap );
-        }
-        return 0;
+        ReadTGA_RLE( pix, h->width, h->height, stride, bpp, s );
     }
-
-    // Read pixel data from file
-    if( h.imagetype >= _TGA_IMAGETYPE_CMAP_RLE )
+    else if( stride == rowsize )
     {
-        ReadTGA_RLE( pix, pixsize, bpp, s );
+        _glfwReadStream( s, pix, rowsize * h->height );
     }
     else
     {
-        _glfwReadStream( s, pix, pixsize );
+        for( n = 0; n < h->height; n ++ )
+        {
+            _glfwReadStream( s, &pix[ n*stride ], rowsize );
+        }
     }
 
     // If the image origin is not what we want, re-arrange the pixels
-    switch( h._origin )
+    switch( h->_origin )
     {
     default:
     case _TGA_ORIGIN_UL:
@@ -508,39 +790,36 @@ static int _glfwReadTGA( _GLFWstream *s, GLFWimage *img, int flags )
         (!swapy && (flags & GLFW_ORIGIN_UL_BIT)) )
     {
         src = pix;
-        dst = &pix[ (h.height-1)*h.width*bpp ];
-        for( n = 0; n < h.height/2; n ++ )
+        dst = &pix[ (h->height-1)*stride ];
+        for( n = 0; n < h->height/2; n ++ )
         {
-            for( m = 0; m < h.width ; m ++ )
+            for( k = 0; k < rowsize; k ++ )
             {
-                for( k = 0; k < bpp; k ++ )
-                {
-                    tmp     = *src;
-                    *src ++ = *dst;
-                    *dst ++ = tmp;
-                }
+                tmp      = src[ k ];
+                src[ k ] = dst[ k ];
+                dst[ k ] = tmp;
             }
-            dst -= 2*h.width*bpp;
+            src += stride;
+            dst -= stride;
         }
     }
     if( swapx )
     {
-        src = pix;
-        dst = &pix[ (h.width-1)*bpp ];
-        for( n = 0; n < h.height; n ++ )
+        for( n = 0; n < h->height; n ++ )
         {
-            for( m = 0; m < h.width/2 ; m ++ )
+            src = &pix[ n*stride ];
+            dst = &src[ (h->width-1)*bpp ];
+            for( m = 0; m < h->width/2 ; m ++ )
             {
                 for( k = 0; k < bpp; k ++ )
                 {
-                    tmp     = *src;
-                    *src ++ = *dst;
-                    *dst ++ = tmp;
+                    tmp    = src[ k ];
+                    src[ k ] = dst[ k ];
+                    dst[ k ] = tmp;
                 }
-                dst -= 2*bpp;
+                src += bpp;
+                dst -= bpp;
             }
-            src += ((h.width+1)/2)*bpp;
-            dst += ((3*h.width+1)/2)*bpp;
         }
     }
 
@@ -551,7 +830,7 @@ static int _glfwReadTGA( _GLFWstream *s, GLFWimage *img, int flags )
         // Convert colormap pixel format (BGR -> RGB or BGRA -> RGBA)
         if( bpp2 == 3 || bpp2 == 4 )
         {
-            for( n = 0; n < h.cmaplen; n ++ )
+            for( n = 0; n < h->cmaplen; n ++ )
             {
                 tmp                = cmap[ n*bpp2 ];
                 cmap[ n*bpp2 ]     = cmap[ n*bpp2 + 2 ];
@@ -559,411 +838,2594 @@ static int _glfwReadTGA( _GLFWstream *s, GLFWimage *img, int flags )
             }
         }
 
-        // Convert pixel data to RGB/RGBA data
-        for( m = h.width * h.height - 1; m >= 0; m -- )
+        // Convert pixel data to RGB/RGBA data, backwards so that each row
+        // can be expanded in place
+        for( n = 0; n < h->height; n ++ )
         {
-            n = pix[ m ];
-            for( k = 0; k < bpp2; k ++ )
+            row = &pix[ n*stride ];
+            for( m = h->width - 1; m >= 0; m -- )
+            {
+                idx = row[ m ];
+                for( k = 0; k < bpp2; k ++ )
+                {
+                    row[ m*bpp2 + k ] = cmap[ idx*bpp2 + k ];
+                }
+            }
+            if( alpha && bpp2 == 4 )
             {
-                pix[ m*bpp2 + k ] = cmap[ n*bpp2 + k ];
+                *alpha = _glfwGetAlphaUsage( row, h->width, *alpha );
             }
         }
 
         // Free memory for colormap (it's not needed anymore)
-        free( cmap );
+        _glfwFree( cmap, GLFW_MEMORY_COLORMAP );
     }
     else
     {
         // Convert image pixel format (BGR -> RGB or BGRA -> RGBA)
         if( bpp2 == 3 || bpp2 == 4 )
         {
-            src = pix;
-            dst = &pix[ 2 ];
-            for( n = 0; n < h.height * h.width; n ++ )
+            for( n = 0; n < h->height; n ++ )
+            {
+                src = &pix[ n*stride ];
+                dst = &src[ 2 ];
+                for( m = 0; m < h->width; m ++ )
+                {
+                    tmp  = *src;
+                    *src = *dst;
+                    *dst = tmp;
+                    src += bpp2;
+                    dst += bpp2;
+                }
+                if( alpha && bpp2 == 4 )
+                {
+                    *alpha = _glfwGetAlphaUsage( &pix[ n*stride ], h->width,
+                                                 *alpha );
+                }
+            }
+        }
+
+        // Store 16-bit pixels as native GL_UNSIGNED_SHORT_1_5_5_5_REV
+        // ones, opaque when the image has no alpha bit
+        opaque = TGAPackedFormat( h ) == GL_RGB5;
+        if( bpp2 == 2 &&
+            (opaque || __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__) )
+        {
+            for( n = 0; n < h->height; n ++ )
             {
-                tmp  = *src;
-                *src = *dst;
-                *dst = tmp;
-                src += bpp2;
-                dst += bpp2;
+                src = &pix[ n*stride ];
+                for( m = 0; m < h->width; m ++ )
+                {
+                    packed = (uint16_t) (src[ 0 ] | (src[ 1 ] << 8) |
+                                         (opaque ? 0x8000 : 0));
+                    memcpy( src, &packed, 2 );
+                    src += 2;
+                }
             }
         }
     }
 
-    // Fill out GLFWimage struct (the Format field will be set by
-    // glfwReadImage)
-    img->Width         = h.width;
-    img->Height        = h.height;
-    img->BytesPerPixel = bpp2;
-    img->Data          = pix;
+    _GLFW_END_STAGE( timer, GLFW_STAGE_DECODE,
+                     (uint64_t) h->width * h->height * bpp2 );
 
     return 1;
 }
 
 
-
-// We want to support automatic mipmap generation
-#ifndef GL_SGIS_generate_mipmap
- #define GL_GENERATE_MIPMAP_SGIS       0x8191
- #define GL_GENERATE_MIPMAP_HINT_SGIS  0x8192
- #define GL_SGIS_generate_mipmap    1
-#endif // GL_SGIS_generate_mipmap
-
-
-//************************************************************************
-//****                  GLFW internal functions                       ****
-//************************************************************************
-
 //========================================================================
-// Upsample image, from size w1 x h1 to w2 x h2
+// Unpack a tightly packed 16-bit image to RGB/RGBA, into rows of dststride
+// bytes
 //========================================================================
 
-static void UpsampleImage( unsigned char *src, unsigned char *dst,
-    int w1, int h1, int w2, int h2, int bpp )
+static void UnpackImage( const unsigned char *src, unsigned char *dst,
+    int width, int height, int dststride, int dstbpp )
 {
-    int m, n, k, x, y, col8;
-    float dx, dy, xstep, ystep, col, col1, col2;
-    unsigned char *src1, *src2, *src3, *src4;
+    _GLFWstagetimer timer;
+    int n;
 
-    // Calculate scaling factor
-    xstep = (float)(w1-1) / (float)(w2-1);
-    ystep = (float)(h1-1) / (float)(h2-1);
+    _GLFW_BEGIN_STAGE( timer );
+
+    if( dststride == width * dstbpp )
+    {
+        _glfwUnpackPixels1555( src, dst, (long) width * height, dstbpp );
+    }
+    else
+    {
+        for( n = 0; n < height; n ++ )
+        {
+            _glfwUnpackPixels1555( &src[ n*width*2 ], &dst[ n*dststride ],
+                                   width, dstbpp );
+        }
+    }
+
+    _GLFW_END_STAGE( timer, GLFW_STAGE_CONVERT,
+                     (uint64_t) width * height * dstbpp );
+}
+
+
+//========================================================================
+// Header of an image file, in any of the supported formats
+//========================================================================
+
+typedef struct {
+    _tga_header_t tga;
+    _GLFWpng *png;             // PNG decoder, NULL for TGA images
+    int width;
+    int height;
+    int bpp;                   // Bytes per decoded pixel
+    int format;                // Format of packed 16-bit pixels, or 0
+} _image_header_t;
+
+// Destination of the rows of a PNG image
+typedef struct {
+    unsigned char *pix;
+    int stride;
+    int rowsize;
+    int height;
+    int flags;
+    int *alpha;                // Alpha usage of RGBA images, or NULL
+} _png_rows_t;
+
+
+//========================================================================
+// Reads data from a GLFW stream, for the PNG decoder
+//========================================================================
+
+static long ReadPNGStream( void *user, void *data, long size )
+{
+    return _glfwReadStream( (_GLFWstream*) user, data, size );
+}
+
+
+//========================================================================
+// Store a decoded PNG row (PNG images are stored top to bottom)
+//========================================================================
+
+static void StorePNGRow( void *user, int y, const unsigned char *row )
+{
+    _png_rows_t *rows = (_png_rows_t*) user;
+
+    if( !(rows->flags & GLFW_ORIGIN_UL_BIT) )
+    {
+        y = rows->height - 1 - y;
+    }
+
+    memcpy( &rows->pix[ y*rows->stride ], row, rows->rowsize );
+
+    if( rows->alpha )
+    {
+        *rows->alpha = _glfwGetAlphaUsage( row, rows->rowsize / 4,
+                                           *rows->alpha );
+    }
+}
+
+
+//========================================================================
+// Read the header of a PNG or TGA image (the format is detected from the
+// PNG signature, TGA files have none)
+//========================================================================
+
+static int ReadImageHeader( _GLFWstream *s, _image_header_t *h )
+{
+    unsigned char magic[ 8 ];
+    long pos;
+
+    h->png = NULL;
+
+    pos = _glfwTellStream( s );
+    if( _glfwReadStream( s, magic, 8 ) == 8 && _glfwIsPNG( magic, 8 ) )
+    {
+        h->png = _glfwReadPNGHeader( ReadPNGStream, s );
+        if( h->png == NULL )
+        {
+            return GL_FALSE;
+        }
+
+        _glfwGetPNGSize( h->png, &h->width, &h->height, &h->bpp );
+        h->format = 0;
+        return GL_TRUE;
+    }
+
+    if( !_glfwSeekStream( s, pos, SEEK_SET ) || !ReadTGAHeader( s, &h->tga ) )
+    {
+        return GL_FALSE;
+    }
+
+    h->width  = h->tga.width;
+    h->height = h->tga.height;
+    h->bpp    = TGAPixelSize( &h->tga );
+    h->format = h->bpp == 2 ? TGAPackedFormat( &h->tga ) : 0;
+    return GL_TRUE;
+}
+
+
+//========================================================================
+// Release what ReadImageHeader allocated, when the image isn't decoded
+//========================================================================
+
+static void FreeImageHeader( _image_header_t *h )
+{
+    _glfwDestroyPNG( h->png );
+    h->png = NULL;
+}
+
+
+//========================================================================
+// Decode the pixels of an image (the header has already been read) into
+// rows of stride bytes, starting at pix.  If alpha isn't NULL, it is set
+// to how the image uses its alpha channel
+//========================================================================
+
+static int DecodeImage( _GLFWstream *s, _image_header_t *h,
+                        unsigned char *pix, int stride, int flags, int *alpha )
+{
+    _GLFWstagetimer timer;
+    _png_rows_t rows;
+    int ok;
+
+    if( alpha )
+    {
+        *alpha = _GLFW_ALPHA_OPAQUE;
+    }
+
+    if( h->png == NULL )
+    {
+        return DecodeTGA( s, &h->tga, pix, stride, flags, alpha );
+    }
+
+    _GLFW_BEGIN_STAGE( timer );
+
+    rows.pix     = pix;
+    rows.stride  = stride;
+    rows.rowsize = h->width * h->bpp;
+    rows.height  = h->height;
+    rows.flags   = flags;
+    rows.alpha   = h->bpp == 4 ? alpha : NULL;
+    ok = _glfwDecodePNG( h->png, ReadPNGStream, s, StorePNGRow, &rows );
+    FreeImageHeader( h );
+
+    _GLFW_END_STAGE( timer, GLFW_STAGE_DECODE,
+                     (uint64_t) h->width * h->height * h->bpp );
+
+    return ok;
+}
+
+
+//========================================================================
+// Read an image from a stream, and optionally how it uses its alpha
+// channel
+//========================================================================
+
+static int ReadImage( _GLFWstream *s, GLFWimage *img, int flags, int *alpha )
+{
+    _image_header_t h;
+    unsigned char *pix, *unpacked;
+    int bpp2;
+
+    // Read image header
+    if( !ReadImageHeader( s, &h ) )
+    {
+        return 0;
+    }
+
+    // Allocate memory for pixel data
+    bpp2 = h.bpp;
+    pix = (unsigned char *) _glfwMalloc( h.width * h.height * bpp2,
+                                         GLFW_MEMORY_IMAGE );
+    if( pix == NULL )
+    {
+        FreeImageHeader( &h );
+        return 0;
+    }
+
+    if( !DecodeImage( s, &h, pix, h.width * bpp2, flags, alpha ) )
+    {
+        _glfwFree( pix, GLFW_MEMORY_IMAGE );
+        return 0;
+    }
+
+    // 16-bit images are unpacked unless asked otherwise
+    if( bpp2 == 2 )
+    {
+        img->Format = h.format;
+        if( !(flags & GLFW_PACKED_PIXELS_BIT) )
+        {
+            bpp2 = UnpackedPixelSize( img->Format );
+            unpacked = (unsigned char *) _glfwMalloc(
+                h.width * h.height * bpp2, GLFW_MEMORY_IMAGE );
+            if( unpacked == NULL )
+            {
+                _glfwFree( pix, GLFW_MEMORY_IMAGE );
+                return 0;
+            }
+            UnpackImage( pix, unpacked, h.width, h.height, h.width * bpp2,
+                         bpp2 );
+            _glfwFree( pix, GLFW_MEMORY_IMAGE );
+            pix = unpacked;
+        }
+    }
+
+    // Fill out GLFWimage struct (the Format field will be set by
+    // glfwReadImage, except for packed images)
+    img->Width         = h.width;
+    img->Height        = h.height;
+    img->BytesPerPixel = bpp2;
+    img->Data          = pix;
+
+    return 1;
+}
+
+
+
+//========================================================================
+// Length of the run of set bits starting at bit i (stopping at bit end)
+//========================================================================
+
+static int CountSetBits( const uint64_t *bits, int i, int end )
+{
+    uint64_t word;
+    int start = i, n;
+
+    while( i < end )
+    {
+        word = ~bits[ i >> 6 ] >> (i & 63);
+        n = word ? __builtin_ctzll( word ) : 64 - (i & 63);
+        i += n;
+        if( word )
+        {
+            break;
+        }
+    }
+
+    return (i < end ? i : end) - start;
+}
+
+
+//========================================================================
+// Index of the first set bit at or after bit i, or end if there is none
+//========================================================================
+
+static int FindSetBit( const uint64_t *bits, int i, int end )
+{
+    uint64_t word;
+
+    while( i < end )
+    {
+        word = bits[ i >> 6 ] >> (i & 63);
+        if( word )
+        {
+            i += __builtin_ctzll( word );
+            break;
+        }
+        i += 64 - (i & 63);
+    }
+
+    return i < end ? i : end;
+}
+
+
+//========================================================================
+// Run-Length Encode a row of pixels, returns the size of the packets
+//========================================================================
+
+static long WriteTGA_RLE( const unsigned char *row, int width, int bpp,
+                          uint64_t *bits, unsigned char *buf )
+{
+    unsigned char *dst = buf;
+    int i, n, next;
+
+    // Find identical neighbours in bulk, then only walk packet boundaries
+    _glfwFindEqualPixels( row, width, bpp, bits );
+
+    i = 0;
+    while( i < width )
+    {
+        n = CountSetBits( bits, i, width - 1 ) + 1;
+        if( n > 1 )
+        {
+            // Run-Length packet
+            if( n > 128 )
+            {
+                n = 128;
+            }
+            *dst ++ = (unsigned char) (128 | (n - 1));
+            memcpy( dst, &row[ i*bpp ], bpp );
+            dst += bpp;
+        }
+        else
+        {
+            // Raw packet, up to where the next run starts
+            next = FindSetBit( bits, i, width - 1 );
+            n = (next == width - 1 ? width : next) - i;
+            if( n > 128 )
+            {
+                n = 128;
+            }
+            *dst ++ = (unsigned char) (n - 1);
+            memcpy( dst, &row[ i*bpp ], n*bpp );
+            dst += n*bpp;
+        }
+        i += n;
+    }
+
+    return dst - buf;
+}
+
+
+//========================================================================
+// Write a TGA image to a file
+//========================================================================
+
+static int _glfwWriteTGA( _GLFWstream *s, const GLFWimage *img, int flags )
+{
+    static const signed char bgra[ 4 ] = { 2, 1, 0, 3 };
+    unsigned char buf[ 18 ], *src, *row, *packets;
+    uint64_t *bits;
+    uint16_t packed;
+    long rowsize, size;
+    int bpp, n, m, ok;
+
+    // Only 8 bit grayscale, RGB and RGBA images, and 16-bit packed ones,
+    // can be written
+    bpp = img->BytesPerPixel;
+    if( !img->Data || img->Width <= 0 || img->Height <= 0 ||
+        img->Width > 0xffff || img->Height > 0xffff ||
+        (bpp != 1 && bpp != 2 && bpp != 3 && bpp != 4) )
+    {
+        return GL_FALSE;
+    }
+
+    // Build TGA header (endian independent)
+    memset( buf, 0, sizeof(buf) );
+    buf[2]  = (unsigned char) (bpp == 1 ? _TGA_IMAGETYPE_GRAY :
+                                          _TGA_IMAGETYPE_TC);
+    if( flags & GLFW_RLE_BIT )
+    {
+        buf[2] += _TGA_IMAGETYPE_CMAP_RLE - _TGA_IMAGETYPE_CMAP;
+    }
+    buf[12] = (unsigned char) (img->Width & 0xff);
+    buf[13] = (unsigned char) (img->Width >> 8);
+    buf[14] = (unsigned char) (img->Height & 0xff);
+    buf[15] = (unsigned char) (img->Height >> 8);
+    buf[16] = (unsigned char) (bpp * 8);
+    buf[17] = (unsigned char) ((bpp == 4 ? 8 : 0) |
+              (img->Format == GL_RGB5_A1 ? 1 : 0) |
+              (((flags & GLFW_ORIGIN_UL_BIT) ? _TGA_ORIGIN_UL :
+                _TGA_ORIGIN_BL) << _TGA_IMAGEINFO_ORIGIN_SHIFT));
+    if( _glfwWriteStream( s, buf, 18 ) != 18 )
+    {
+        return GL_FALSE;
+    }
+
+    // Allocate memory for one converted row, and its RLE packets
+    rowsize = (long) img->Width * bpp;
+    row     = (unsigned char *) _glfwMalloc( rowsize, GLFW_MEMORY_OTHER );
+    packets = NULL;
+    bits    = NULL;
+    if( flags & GLFW_RLE_BIT )
+    {
+        packets = (unsigned char *) _glfwMalloc(
+            (long) img->Width * (bpp + 1), GLFW_MEMORY_OTHER );
+        bits    = (uint64_t *) _glfwMalloc(
+            ((img->Width + 63) / 64) * sizeof(uint64_t), GLFW_MEMORY_OTHER );
+    }
+    if( row == NULL || ((flags & GLFW_RLE_BIT) &&
+                        (packets == NULL || bits == NULL)) )
+    {
+        _glfwFree( row, GLFW_MEMORY_OTHER );
+        _glfwFree( packets, GLFW_MEMORY_OTHER );
+        _glfwFree( bits, GLFW_MEMORY_OTHER );
+        return GL_FALSE;
+    }
+
+    ok = GL_TRUE;
+    for( n = 0; n < img->Height && ok; n ++ )
+    {
+        src = &img->Data[ n*rowsize ];
+
+        // Convert RGB/RGBA to BGR/BGRA
+        if( bpp == 4 )
+        {
+            _glfwSwizzlePixels( src, row, img->Width, 4, bgra );
+        }
+        else if( bpp == 3 )
+        {
+            for( m = 0; m < img->Width; m ++ )
+            {
+                row[ m*3 ]     = src[ m*3 + 2 ];
+                row[ m*3 + 1 ] = src[ m*3 + 1 ];
+                row[ m*3 + 2 ] = src[ m*3 ];
+            }
+        }
+        else if( bpp == 2 )
+        {
+            // Packed pixels are stored little endian
+            for( m = 0; m < img->Width; m ++ )
+            {
+                memcpy( &packed, &src[ m*2 ], 2 );
+                row[ m*2 ]     = (unsigned char) (packed & 0xff);
+                row[ m*2 + 1 ] = (unsigned char) (packed >> 8);
+            }
+        }
+        else
+        {
+            memcpy( row, src, rowsize );
+        }
+
+        if( flags & GLFW_RLE_BIT )
+        {
+            size = WriteTGA_RLE( row, img->Width, bpp, bits, packets );
+            ok = _glfwWriteStream( s, packets, size ) == size;
+        }
+        else
+        {
+            ok = _glfwWriteStream( s, row, rowsize ) == rowsize;
+        }
+    }
+
+    _glfwFree( row, GLFW_MEMORY_OTHER );
+    _glfwFree( packets, GLFW_MEMORY_OTHER );
+    _glfwFree( bits, GLFW_MEMORY_OTHER );
+
+    return ok;
+}
+
+// We want to support automatic mipmap generation
+#ifndef GL_SGIS_generate_mipmap
+ #define GL_GENERATE_MIPMAP_SGIS       0x8191
+ #define GL_GENERATE_MIPMAP_HINT_SGIS  0x8192
+ #define GL_SGIS_generate_mipmap    1
+#endif // GL_SGIS_generate_mipmap
+
+// We want to ask the driver for its preferred upload layout
+#ifndef GL_TEXTURE_IMAGE_FORMAT
+ #define GL_TEXTURE_IMAGE_FORMAT       0x828F
+ #define GL_TEXTURE_IMAGE_TYPE         0x8290
+#endif // GL_TEXTURE_IMAGE_FORMAT
+
+// We want to rescale images with framebuffer blits
+#ifndef GL_READ_FRAMEBUFFER
+ #define GL_READ_FRAMEBUFFER           0x8CA8
+ #define GL_DRAW_FRAMEBUFFER           0x8CA9
+ #define GL_FRAMEBUFFER_COMPLETE       0x8CD5
+ #define GL_COLOR_ATTACHMENT0          0x8CE0
+ #define GL_RENDERBUFFER               0x8D41
+ #define GL_MAX_RENDERBUFFER_SIZE      0x84E8
+#endif // GL_READ_FRAMEBUFFER
+
+#ifndef GL_TEXTURE_RECTANGLE_ARB
+ #define GL_TEXTURE_RECTANGLE_ARB          0x84F5
+ #define GL_MAX_RECTANGLE_TEXTURE_SIZE_ARB 0x84F8
+#endif // GL_TEXTURE_RECTANGLE_ARB
+
+// We want to stream mipmap levels in, smallest first
+#ifndef GL_TEXTURE_BASE_LEVEL
+ #define GL_TEXTURE_BASE_LEVEL         0x813C
+#endif // GL_TEXTURE_BASE_LEVEL
+
+
+//************************************************************************
+//****                  GLFW internal functions                       ****
+//************************************************************************
+
+//========================================================================
+// Channels of a GL_UNSIGNED_SHORT_1_5_5_5_REV pixel (B, G, R, then A)
+//========================================================================
+
+static const int _glfwPackedShift[ 4 ] = { 0, 5, 10, 15 };
+static const int _glfwPackedMask[ 4 ]  = { 31, 31, 31, 1 };
+
+static unsigned LoadPacked( const unsigned char *p )
+{
+    uint16_t v;
+    memcpy( &v, p, 2 );
+    return v;
+}
+
+static void StorePacked( unsigned char *p, unsigned v )
+{
+    uint16_t u = (uint16_t) v;
+    memcpy( p, &u, 2 );
+}
+
+
+//========================================================================
+// Upsample a 16-bit packed image, interpolating each channel separately
+//========================================================================
+
+static void UpsamplePackedImage( unsigned char *src, unsigned char *dst,
+    int w1, int h1, int w2, int h2, int dststride )
+{
+    int m, n, k, x, x2, y, c1, c2, c3, c4;
+    unsigned p1, p2, p3, p4, out;
+    float dx, dy, xstep, ystep, col, col2;
+    unsigned char *row1, *row2;
+    _GLFWstagetimer timer;
+
+    _GLFW_BEGIN_STAGE( timer );
+
+    xstep = w2 > 1 ? (float)(w1-1) / (float)(w2-1) : 0.0f;
+    ystep = h2 > 1 ? (float)(h1-1) / (float)(h2-1) : 0.0f;
 
-    // Copy source data to destination data with bilinear interpolation
-    // Note: The rather strange look of this routine is a direct result of
-    // my attempts at optimizing it. Improvements are welcome!
     dy = 0.0f;
     y = 0;
     for( n = 0; n < h2; n ++ )
     {
-        dx = 0.0f;
-        src1 = &src[ y*w1*bpp ];
-        src3 = y < (h1-1) ? src1 + w1*bpp : src1;
-        src2 = src1 + bpp;
-        src4 = src3 + bpp;
-        x = 0;
-        for( m = 0; m < w2; m ++ )
+        row1 = &src[ y*w1*2 ];
+        row2 = y < (h1-1) ? row1 + w1*2 : row1;
+        dx = 0.0f;
+        x = 0;
+        for( m = 0; m < w2; m ++ )
+        {
+            x2 = x < (w1-1) ? x + 1 : x;
+            p1 = LoadPacked( &row1[ x*2 ] );
+            p2 = LoadPacked( &row1[ x2*2 ] );
+            p3 = LoadPacked( &row2[ x*2 ] );
+            p4 = LoadPacked( &row2[ x2*2 ] );
+            out = 0;
+            for( k = 0; k < 4; k ++ )
+            {
+                c1 = (p1 >> _glfwPackedShift[ k ]) & _glfwPackedMask[ k ];
+                c2 = (p2 >> _glfwPackedShift[ k ]) & _glfwPackedMask[ k ];
+                c3 = (p3 >> _glfwPackedShift[ k ]) & _glfwPackedMask[ k ];
+                c4 = (p4 >> _glfwPackedShift[ k ]) & _glfwPackedMask[ k ];
+                col  = c1 + (c2 - c1) * dx;
+                col2 = c3 + (c4 - c3) * dx;
+                col += (col2 - col) * dy;
+                out |= (unsigned) (col + 0.5f) << _glfwPackedShift[ k ];
+            }
+            StorePacked( &dst[ m*2 ], out );
+
+            dx += xstep;
+            if( dx >= 1.0f )
+            {
+                x ++;
+                dx -= 1.0f;
+            }
+        }
+        dst += dststride;
+        dy += ystep;
+        if( dy >= 1.0f )
+        {
+            y ++;
+            dy -= 1.0f;
+        }
+    }
+
+    _GLFW_END_STAGE( timer, GLFW_STAGE_RESCALE, (uint64_t) w2 * h2 * 2 );
+}
+
+
+//========================================================================
+// Average count 16-bit packed pixels, rounding each channel
+//========================================================================
+
+static unsigned AveragePacked( const unsigned *p, int count )
+{
+    unsigned out;
+    int k, n, sum;
+
+    out = 0;
+    for( k = 0; k < 4; k ++ )
+    {
+        sum = count / 2;
+        for( n = 0; n < count; n ++ )
+        {
+            sum += (p[ n ] >> _glfwPackedShift[ k ]) & _glfwPackedMask[ k ];
+        }
+        out |= (unsigned) (sum / count) << _glfwPackedShift[ k ];
+    }
+
+    return out;
+}
+
+
+//========================================================================
+// Build the next mip-map level of a 16-bit packed image (dst may be the
+// same buffer as src)
+//========================================================================
+
+static void HalvePackedImage( unsigned char *src, unsigned char *dst,
+    int width, int height, int halfwidth, int halfheight )
+{
+    unsigned p[ 4 ];
+    int m, n;
+
+    if( width == 1 || height == 1 )
+    {
+        // 1D case
+        for( m = 0; m < halfwidth+halfheight-1; m ++ )
+        {
+            p[ 0 ] = LoadPacked( &src[ m*4 ] );
+            p[ 1 ] = LoadPacked( &src[ m*4 + 2 ] );
+            StorePacked( &dst[ m*2 ], AveragePacked( p, 2 ) );
+        }
+    }
+    else
+    {
+        // 2D case
+        for( m = 0; m < halfheight; m ++ )
+        {
+            for( n = 0; n < halfwidth; n ++ )
+            {
+                p[ 0 ] = LoadPacked( &src[ (2*m*width + 2*n)*2 ] );
+                p[ 1 ] = LoadPacked( &src[ (2*m*width + 2*n + 1)*2 ] );
+                p[ 2 ] = LoadPacked( &src[ ((2*m+1)*width + 2*n)*2 ] );
+                p[ 3 ] = LoadPacked( &src[ ((2*m+1)*width + 2*n + 1)*2 ] );
+                StorePacked( &dst[ (m*halfwidth + n)*2 ],
+                             AveragePacked( p, 4 ) );
+            }
+        }
+    }
+}
+
+
+//========================================================================
+// Upsample image, from size w1 x h1 to w2 x h2 (with rows of dststride
+// bytes in the destination)
+//========================================================================
+
+static void UpsampleImage( unsigned char *src, unsigned char *dst,
+    int w1, int h1, int w2, int h2, int bpp, int dststride )
+{
+    int m, n, k, x, y, col8;
+    float dx, dy, xstep, ystep, col, col1, col2;
+    unsigned char *src1, *src2, *src3, *src4;
+    _GLFWstagetimer timer;
+
+    // 16-bit pixels are packed, not one byte per channel
+    if( bpp == 2 )
+    {
+        UpsamplePackedImage( src, dst, w1, h1, w2, h2, dststride );
+        return;
+    }
+
+    _GLFW_BEGIN_STAGE( timer );
+
+    // Calculate scaling factor (single pixel rows or columns don't step)
+    xstep = w2 > 1 ? (float)(w1-1) / (float)(w2-1) : 0.0f;
+    ystep = h2 > 1 ? (float)(h1-1) / (float)(h2-1) : 0.0f;
+
+    // Copy source data to destination data with bilinear interpolation
+    // Note: The rather strange look of this routine is a direct result of
+    // my attempts at optimizing it. Improvements are welcome!
+    dy = 0.0f;
+    y = 0;
+    for( n = 0; n < h2; n ++ )
+    {
+        dx = 0.0f;
+        src1 = &src[ y*w1*bpp ];
+        src3 = y < (h1-1) ? src1 + w1*bpp : src1;
+        src2 = w1 > 1 ? src1 + bpp : src1;
+        src4 = w1 > 1 ? src3 + bpp : src3;
+        x = 0;
+        for( m = 0; m < w2; m ++ )
+        {
+            for( k = 0; k < bpp; k ++ )
+            {
+                col1 = *src1 ++;
+                col2 = *src2 ++;
+                col = col1 + (col2 - col1) * dx;
+                col1 = *src3 ++;
+                col2 = *src4 ++;
+                col2 = col1 + (col2 - col1) * dx;
+                col += (col2 - col) * dy;
+                col8 = (int) (col + 0.5);
+                if( col8 >= 256 ) col8 = 255;
+                *dst++ = (unsigned char) col8;
+            }
+            dx += xstep;
+            if( dx >= 1.0f )
+            {
+                x ++;
+                dx -= 1.0f;
+                if( x >= (w1-1) )
+                {
+                    src2 = src1;
+                    src4 = src3;
+                }
+            }
+            else
+            {
+                src1 -= bpp;
+                src2 -= bpp;
+                src3 -= bpp;
+                src4 -= bpp;
+            }
+        }
+        dst += dststride - w2*bpp;
+        dy += ystep;
+        if( dy >= 1.0f )
+        {
+            y ++;
+            dy -= 1.0f;
+        }
+    }
+
+    _GLFW_END_STAGE( timer, GLFW_STAGE_RESCALE, (uint64_t) w2 * h2 * bpp );
+}
+
+
+//========================================================================
+// Build the next mip-map level (dst may be the same buffer as src)
+//========================================================================
+
+static int HalveImage( GLubyte *src, GLubyte *dst, int *width, int *height,
+    int components )
+{
+    _GLFWstagetimer timer;
+    int     halfwidth, halfheight, m, n, k, idx1, idx2;
+
+    // Last level?
+    if( *width <= 1 && *height <= 1 )
+    {
+        return GL_FALSE;
+    }
+
+    _GLFW_BEGIN_STAGE( timer );
+
+    // Calculate new width and height (handle 1D case)
+    halfwidth  = *width > 1 ? *width / 2 : 1;
+    halfheight = *height > 1 ? *height / 2 : 1;
+
+    // Downsample image with a simple box-filter
+    if( components == 2 )
+    {
+        // 16-bit packed pixels
+        HalvePackedImage( src, dst, *width, *height, halfwidth, halfheight );
+    }
+    else if( *width == 1 || *height == 1 )
+    {
+        // 1D case
+        for( m = 0; m < halfwidth+halfheight-1; m ++ )
+        {
+            for( k = 0; k < components; k ++ )
+            {
+                *dst ++ = (GLubyte) (((int)*src +
+                                      (int)src[components] + 1) >> 1);
+                src ++;
+            }
+            src += components;
+        }
+    }
+    else
+    {
+        // 2D case
+        idx1 = *width*components;
+        idx2 = (*width+1)*components;
+        for( m = 0; m < halfheight; m ++ )
+        {
+            for( n = 0; n < halfwidth; n ++ )
+            {
+                for( k = 0; k < components; k ++ )
+                {
+                    *dst ++ = (GLubyte) (((int)*src +
+                                          (int)src[components] +
+                                          (int)src[idx1] +
+                                          (int)src[idx2] + 2) >> 2);
+                    src ++;
+                }
+                src += components;
+            }
+            src += components * (*width + (*width & 1));
+        }
+    }
+
+    // Return new width and height
+    *width = halfwidth;
+    *height = halfheight;
+
+    _GLFW_END_STAGE( timer, GLFW_STAGE_MIPMAP,
+                     (uint64_t) halfwidth * halfheight * components );
+
+    return GL_TRUE;
+}
+
+
+//========================================================================
+// Returns the smallest power of two which is not less than size
+//========================================================================
+
+static int NextPowerOfTwo( int size )
+{
+    int log2, pot;
+
+    for( log2 = 0, pot = size; pot > 1; pot >>= 1, log2 ++ )
+      ;
+
+    pot = (int) 1 << log2;
+    if( pot < size )
+    {
+        pot <<= 1;
+    }
+
+    return pot;
+}
+
+
+//========================================================================
+// Rescales an image into power-of-two dimensions
+//========================================================================
+
+static int RescaleImage( GLFWimage* image )
+{
+    int     width, height, newsize;
+    unsigned char *data;
+
+    // Calculate next larger 2^N x 2^M size
+    width  = NextPowerOfTwo( image->Width );
+    height = NextPowerOfTwo( image->Height );
+
+    // Do we really need to rescale?
+    if( width != image->Width || height != image->Height )
+    {
+        // Allocate memory for new (upsampled) image data
+        newsize = width * height * image->BytesPerPixel;
+        data = (unsigned char *) _glfwMalloc( newsize, GLFW_MEMORY_IMAGE );
+        if( data == NULL )
+        {
+            _glfwFree( image->Data, GLFW_MEMORY_IMAGE );
+            return GL_FALSE;
+        }
+
+        // Copy old image data to new image data with interpolation
+        UpsampleImage( image->Data, data, image->Width, image->Height,
+                       width, height, image->BytesPerPixel,
+                       width * image->BytesPerPixel );
+
+        // Free memory for old image data (not needed anymore)
+        _glfwFree( image->Data, GLFW_MEMORY_IMAGE );
+
+        // Set pointer to new image data, and set new image dimensions
+        image->Data   = data;
+        image->Width  = width;
+        image->Height = height;
+    }
+
+    return GL_TRUE;
+}
+
+//========================================================================
+// Interpret the BytesPerPixel of an image as an OpenGL format
+//========================================================================
+
+static void SetImageFormat( GLFWimage *img, int flags )
+{
+    switch( img->BytesPerPixel )
+    {
+        case 2:
+            // Packed formats are set by the decoder
+            break;
+        default:
+        case 1:
+            if( flags & GLFW_ALPHA_MAP_BIT )
+            {
+                img->Format = GL_ALPHA;
+            }
+            else
+            {
+                img->Format = GL_LUMINANCE;
+            }
+            break;
+        case 3:
+            img->Format = GL_RGB;
+            break;
+        case 4:
+            img->Format = GL_RGBA;
+            break;
+    }
+}
+
+
+//========================================================================
+// Read an image from a stream into a caller-provided buffer, with rows of
+// stride bytes (0 meaning tightly packed). Returns the number of bytes
+// the image needs, or 0 on failure; nothing is decoded if that is larger
+// than size
+//========================================================================
+
+static long ReadImageInto( _GLFWstream *s, GLFWimage *img,
+    unsigned char *buffer, long size, int stride, int flags )
+{
+    _image_header_t h;
+    unsigned char *pix, *unpacked;
+    int  width, height, bpp, srcbpp, scratch;
+    long required;
+
+    // Read the image header, in any supported format
+    if( !ReadImageHeader( s, &h ) )
+    {
+        return 0;
+    }
+
+    // Compute the final image size, after unpacking and rescaling
+    width  = h.width;
+    height = h.height;
+    srcbpp = h.bpp;
+    bpp    = srcbpp;
+    if( srcbpp == 2 && !(flags & GLFW_PACKED_PIXELS_BIT) )
+    {
+        bpp = UnpackedPixelSize( h.format );
+    }
+    if( !(flags & GLFW_NO_RESCALE_BIT) )
+    {
+        width  = NextPowerOfTwo( width );
+        height = NextPowerOfTwo( height );
+    }
+
+    // Check that the stride can hold a row
+    if( stride == 0 )
+    {
+        stride = width * bpp;
+    }
+    else if( stride < width * bpp )
+    {
+        FreeImageHeader( &h );
+        return 0;
+    }
+    required = (long) stride * height;
+
+    // Let the caller know what to allocate, even when it is too small
+    img->Width         = width;
+    img->Height        = height;
+    img->BytesPerPixel = bpp;
+    if( bpp == 2 )
+    {
+        img->Format = h.format;
+    }
+    SetImageFormat( img, flags );
+
+    if( buffer == NULL || required > size )
+    {
+        FreeImageHeader( &h );
+        return required;
+    }
+
+    if( width == h.width && height == h.height && bpp == srcbpp )
+    {
+        // Decode straight into the caller's buffer
+        if( !DecodeImage( s, &h, buffer, stride, flags, NULL ) )
+        {
+            return 0;
+        }
+    }
+    else
+    {
+        // Unpacking and upsampling can't be done in place, so decode to a
+        // scratch buffer
+        scratch = width == h.width && height == h.height ?
+                  GLFW_MEMORY_CONVERT : GLFW_MEMORY_RESCALE;
+        pix = (unsigned char *) _glfwMalloc( h.width * h.height * srcbpp,
+                                             scratch );
+        if( pix == NULL )
+        {
+            FreeImageHeader( &h );
+            return 0;
+        }
+
+        if( !DecodeImage( s, &h, pix, h.width * srcbpp, flags, NULL ) )
+        {
+            _glfwFree( pix, scratch );
+            return 0;
+        }
+
+        if( bpp != srcbpp )
+        {
+            if( width == h.width && height == h.height )
+            {
+                UnpackImage( pix, buffer, width, height, stride, bpp );
+                _glfwFree( pix, scratch );
+                pix = NULL;
+            }
+            else
+            {
+                unpacked = (unsigned char *) _glfwMalloc(
+                    h.width * h.height * bpp, scratch );
+                if( unpacked == NULL )
+                {
+                    _glfwFree( pix, scratch );
+                    return 0;
+                }
+                UnpackImage( pix, unpacked, h.width, h.height,
+                             h.width * bpp, bpp );
+                _glfwFree( pix, scratch );
+                pix = unpacked;
+            }
+        }
+
+        if( pix != NULL )
+        {
+            UpsampleImage( pix, buffer, h.width, h.height, width, height,
+                           bpp, stride );
+            _glfwFree( pix, scratch );
+        }
+    }
+
+    // The buffer stays the caller's, glfwFreeImage must not free it
+    img->Data = buffer;
+    _glfwTrackImage( img, GL_TRUE );
+
+    return required;
+}
+
+
+//========================================================================
+// Index of an image format in the negotiated upload format table
+//========================================================================
+
+static int UploadFormatIndex( int format )
+{
+    switch( format )
+    {
+        case GL_LUMINANCE:
+            return 0;
+        case GL_ALPHA:
+            return 1;
+        case GL_RGB:
+            return 2;
+        case GL_RGBA:
+            return 3;
+        default:
+            return -1;
+    }
+}
+
+
+//========================================================================
+// Checks whether we know how to convert an image to an upload layout
+//========================================================================
+
+static int IsUploadFormatUsable( int srcformat, GLenum format, GLenum type )
+{
+    if( format != (GLenum) srcformat && format != GL_RGBA &&
+        format != GL_BGRA )
+    {
+        return GL_FALSE;
+    }
+
+    if( type == GL_UNSIGNED_BYTE )
+    {
+        return GL_TRUE;
+    }
+
+    // Packed 32-bit pixels have the same byte order on little endian
+    // machines
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    if( type == GL_UNSIGNED_INT_8_8_8_8_REV && format != (GLenum) srcformat )
+    {
+        return GL_TRUE;
+    }
+#endif
+
+    return GL_FALSE;
+}
+
+
+//========================================================================
+// Pick the pixel layout the driver prefers for uploading images of the
+// given format, using GL_ARB_internalformat_query2 when available and a
+// built-in table otherwise
+//========================================================================
+
+static void GetUploadFormat( int srcformat, int glMajor, int glMinor,
+    _GLFWuploadformat *upload )
+{
+    GLint format, type;
+    int   idx;
+
+    // 16-bit images are uploaded packed when OpenGL 1.2 packed pixels are
+    // available, and expanded to RGBA otherwise
+    if( srcformat == GL_RGB5_A1 || srcformat == GL_RGB5 )
+    {
+        if( glMajor > 1 || glMinor >= 2 )
+        {
+            upload->format = GL_BGRA;
+            upload->type   = GL_UNSIGNED_SHORT_1_5_5_5_REV;
+        }
+        else
+        {
+            upload->format = GL_RGBA;
+            upload->type   = GL_UNSIGNED_BYTE;
+        }
+        return;
+    }
+
+    // Already negotiated for this context?
+    idx = UploadFormatIndex( srcformat );
+    if( idx >= 0 && _glfw.uploadformats[ idx ].format != 0 )
+    {
+        *upload = _glfw.uploadformats[ idx ];
+        return;
+    }
+
+    upload->format = 0;
+    upload->type   = GL_UNSIGNED_BYTE;
+
+    if( _glfw.glGetInternalformativ && idx >= 0 )
+    {
+        format = 0;
+        type   = 0;
+        _glfw.glGetInternalformativ( GL_TEXTURE_2D, srcformat,
+            GL_TEXTURE_IMAGE_FORMAT, 1, &format );
+        _glfw.glGetInternalformativ( GL_TEXTURE_2D, srcformat,
+            GL_TEXTURE_IMAGE_TYPE, 1, &type );
+        if( IsUploadFormatUsable( srcformat, format, type ) )
+        {
+            upload->format = format;
+            upload->type   = type;
+        }
+    }
+
+    if( upload->format == 0 )
+    {
+        if( srcformat == GL_RGB ||
+            (glMajor == 1 && glMinor == 0 && srcformat == GL_ALPHA) )
+        {
+            // Most drivers store RGB textures as RGBX, and repack tightly
+            // packed RGB pixels on the CPU. OpenGL 1.0 has no alpha maps.
+            upload->format = GL_RGBA;
+        }
+        else
+        {
+            upload->format = srcformat;
+        }
+    }
+
+    if( idx >= 0 )
+    {
+        _glfw.uploadformats[ idx ] = *upload;
+    }
+}
+
+
+//========================================================================
+// Build the swizzle converting an image to a four channel upload layout,
+// returns GL_FALSE if the image can be uploaded as is
+//========================================================================
+
+static int GetUploadSwizzle( int srcformat, GLenum format,
+    signed char map[ 4 ] )
+{
+    signed char tmp;
+
+    if( format == (GLenum) srcformat )
+    {
+        return GL_FALSE;
+    }
+
+    switch( srcformat )
+    {
+        case GL_LUMINANCE:
+            map[ 0 ] = 0;
+            map[ 1 ] = 0;
+            map[ 2 ] = 0;
+            map[ 3 ] = _GLFW_SWIZZLE_ONE;
+            break;
+        case GL_ALPHA:
+            map[ 0 ] = _GLFW_SWIZZLE_ONE;
+            map[ 1 ] = _GLFW_SWIZZLE_ONE;
+            map[ 2 ] = _GLFW_SWIZZLE_ONE;
+            map[ 3 ] = 0;
+            break;
+        case GL_RGB:
+            map[ 0 ] = 0;
+            map[ 1 ] = 1;
+            map[ 2 ] = 2;
+            map[ 3 ] = _GLFW_SWIZZLE_ONE;
+            break;
+        default:
+            map[ 0 ] = 0;
+            map[ 1 ] = 1;
+            map[ 2 ] = 2;
+            map[ 3 ] = 3;
+            break;
+    }
+
+    if( format == GL_BGRA )
+    {
+        tmp      = map[ 0 ];
+        map[ 0 ] = map[ 2 ];
+        map[ 2 ] = tmp;
+    }
+
+    return GL_TRUE;
+}
+
+
+//========================================================================
+// Pick a 16-bit layout for an RGB or RGBA image, from how it uses its
+// alpha channel (scanned if unknown).  Returns the internal format, or 0
+// when reduced precision textures are disabled or don't apply
+//========================================================================
+
+static int GetPackedUpload( const GLFWimage *img, int alpha,
+    _GLFWuploadformat *upload )
+{
+    // Packed pixel types are from OpenGL 1.2
+    if( !_glfw.packedtextures ||
+        ( _glfw.glmajor == 1 && _glfw.glminor < 2 ) )
+    {
+        return 0;
+    }
+
+    if( img->Format == GL_RGB && img->BytesPerPixel == 3 )
+    {
+        alpha = _GLFW_ALPHA_OPAQUE;
+    }
+    else if( img->Format != GL_RGBA || img->BytesPerPixel != 4 )
+    {
+        return 0;
+    }
+    else if( alpha == _GLFW_ALPHA_UNKNOWN )
+    {
+        alpha = _glfwGetAlphaUsage( img->Data,
+            (long) img->Width * img->Height, _GLFW_ALPHA_OPAQUE );
+    }
+
+    switch( alpha )
+    {
+        case _GLFW_ALPHA_OPAQUE:
+            upload->format = GL_RGB;
+            upload->type   = GL_UNSIGNED_SHORT_5_6_5;
+            return GL_RGB5;
+        case _GLFW_ALPHA_BINARY:
+            upload->format = GL_RGBA;
+            upload->type   = GL_UNSIGNED_SHORT_5_5_5_1;
+            return GL_RGB5_A1;
+        default:
+            upload->format = GL_RGBA;
+            upload->type   = GL_UNSIGNED_SHORT_4_4_4_4;
+            return GL_RGBA4;
+    }
+}
+
+
+//========================================================================
+// Is this 8-bit image quantized to a 16-bit layout when uploaded?
+//========================================================================
+
+static int IsPackedUpload( const _GLFWuploadformat *upload, int bpp )
+{
+    return bpp > 2 && ( upload->type == GL_UNSIGNED_SHORT_5_6_5 ||
+                        upload->type == GL_UNSIGNED_SHORT_5_5_5_1 ||
+                        upload->type == GL_UNSIGNED_SHORT_4_4_4_4 );
+}
+
+
+//========================================================================
+// A batch of images read concurrently
+//========================================================================
+
+typedef struct {
+    const char  **names;
+    const void  **data;
+    const long  *sizes;
+    GLFWimage   *imgs;
+    int         *results;
+    int         flags;
+    atomic_int  loaded;
+} _GLFWimagebatch;
+
+static void ReadBatchImage( int i, void *arg )
+{
+    _GLFWimagebatch *batch = (_GLFWimagebatch *) arg;
+    int result;
+
+    if( batch->names )
+    {
+        result = glfwReadImage( batch->names[ i ], &batch->imgs[ i ],
+                                batch->flags );
+    }
+    else
+    {
+        result = glfwReadMemoryImage( batch->data[ i ], batch->sizes[ i ],
+                                      &batch->imgs[ i ], batch->flags );
+    }
+
+    if( batch->results )
+    {
+        batch->results[ i ] = result;
+    }
+    if( result )
+    {
+        atomic_fetch_add_explicit( &batch->loaded, 1, memory_order_relaxed );
+    }
+}
+
+
+//========================================================================
+// Read an image from an open stream, which is closed, rescaling it unless
+// asked otherwise, and optionally how it uses its alpha channel
+//========================================================================
+
+static int ReadStreamImage( _GLFWstream *s, GLFWimage *img, int flags,
+    int *alpha )
+{
+    // Read the image, in any supported format
+    if( !ReadImage( s, img, flags, alpha ) )
+    {
+        _glfwCloseStream( s );
+        return GL_FALSE;
+    }
+
+    // Close stream
+    _glfwCloseStream( s );
+
+    // Should we rescale the image to closest 2^N x 2^M resolution?
+    if( !(flags & GLFW_NO_RESCALE_BIT) )
+    {
+        if( !RescaleImage( img ) )
+        {
+            return GL_FALSE;
+        }
+    }
+
+    // Interpret BytesPerPixel as an OpenGL format
+    SetImageFormat( img, flags );
+
+    // Remember the image until it is freed
+    _glfwTrackImage( img, GL_FALSE );
+
+    return GL_TRUE;
+}
+
+
+//========================================================================
+// Read an image from a named file
+//========================================================================
+
+static int ReadImageFile( const char *name, GLFWimage *img, int flags,
+    int *alpha )
+{
+    _GLFWstream stream;
+
+    // Start with an empty image descriptor
+    img->Width         = 0;
+    img->Height        = 0;
+    img->BytesPerPixel = 0;
+    img->Data          = NULL;
+
+    // Open file
+    if( !_glfwOpenFileStream( &stream, name, "rb" ) )
+    {
+        return GL_FALSE;
+    }
+
+    return ReadStreamImage( &stream, img, flags, alpha );
+}
+
+
+//========================================================================
+// Read an image file from a memory buffer
+//========================================================================
+
+static int ReadMemoryImage( const void *data, long size, GLFWimage *img,
+    int flags, int *alpha )
+{
+    _GLFWstream stream;
+
+    // Start with an empty image descriptor
+    img->Width         = 0;
+    img->Height        = 0;
+    img->BytesPerPixel = 0;
+    img->Data          = NULL;
+
+    // Open buffer
+    if( !_glfwOpenReadBufferStream( &stream, data, size ) )
+    {
+        return GL_FALSE;
+    }
+
+    return ReadStreamImage( &stream, img, flags, alpha );
+}
+
+
+//************************************************************************
+//****                    GLFW user functions                         ****
+//************************************************************************
+
+//========================================================================
+// Read an image from a named file
+//========================================================================
+
+GLFWAPI int GLFWAPIENTRY glfwReadImage( const char *name, GLFWimage *img,
+    int flags )
+{
+    _GLFW_COUNT_CALL( glfwReadImage );
+    return ReadImageFile( name, img, flags, NULL );
+}
+
+
+//========================================================================
+// Read an image file from a memory buffer
+//========================================================================
+
+GLFWAPI int GLFWAPIENTRY glfwReadMemoryImage( const void *data, long size, GLFWimage *img, int flags )
+{
+    _GLFW_COUNT_CALL( glfwReadMemoryImage );
+    return ReadMemoryImage( data, size, img, flags, NULL );
+}
+
+
+//========================================================================
+// Read an image from a named file into a caller-provided buffer
+//========================================================================
+
+GLFWAPI long GLFWAPIENTRY glfwReadImageInto( const char *name, GLFWimage *img,
+    void *buffer, long size, int stride, int flags )
+{
+    _GLFW_COUNT_CALL( glfwReadImageInto );
+    _GLFWstream stream;
+    long required;
+
+    // Start with an empty image descriptor
+    img->Width         = 0;
+    img->Height        = 0;
+    img->BytesPerPixel = 0;
+    img->Data          = NULL;
+
+    // Open file
+    if( !_glfwOpenFileStream( &stream, name, "rb" ) )
+    {
+        return 0;
+    }
+
+    required = ReadImageInto( &stream, img, buffer, size, stride, flags );
+
+    // Close stream
+    _glfwCloseStream( &stream );
+
+    return required;
+}
+
+
+//========================================================================
+// Read an image file from a memory buffer into a caller-provided buffer
+//========================================================================
+
+GLFWAPI long GLFWAPIENTRY glfwReadMemoryImageInto( const void *data, long datasize, GLFWimage *img, void *buffer, long size, int stride, int flags )
+{
+    _GLFW_COUNT_CALL( glfwReadMemoryImageInto );
+    _GLFWstream stream;
+    long required;
+
+    // Start with an empty image descriptor
+    img->Width         = 0;
+    img->Height        = 0;
+    img->BytesPerPixel = 0;
+    img->Data          = NULL;
+
+    // Open buffer
+    if( !_glfwOpenReadBufferStream( &stream, data, datasize ) )
+    {
+        return 0;
+    }
+
+    required = ReadImageInto( &stream, img, buffer, size, stride, flags );
+
+    // Close stream
+    _glfwCloseStream( &stream );
+
+    return required;
+}
+
+
+//========================================================================
+// Read several images from named files concurrently
+//========================================================================
+
+GLFWAPI int  GLFWAPIENTRY glfwReadImages( const char **names, GLFWimage *imgs,
+    int *results, int count, int flags )
+{
+    _GLFW_COUNT_CALL( glfwReadImages );
+    _GLFWimagebatch batch = { names, NULL, NULL, imgs, results, flags, 0 };
+
+    _glfwParallelFor( count, ReadBatchImage, &batch );
+
+    return atomic_load( &batch.loaded );
+}
+
+
+//========================================================================
+// Read several image files from memory buffers concurrently
+//========================================================================
+
+GLFWAPI int  GLFWAPIENTRY glfwReadMemoryImages( const void **data,
+    const long *sizes, GLFWimage *imgs, int *results, int count, int flags )
+{
+    _GLFW_COUNT_CALL( glfwReadMemoryImages );
+    _GLFWimagebatch batch = { NULL, data, sizes, imgs, results, flags, 0 };
+
+    _glfwParallelFor( count, ReadBatchImage, &batch );
+
+    return atomic_load( &batch.loaded );
+}
+
+
+//========================================================================
+// Free allocated memory for an image
+//========================================================================
+
+GLFWAPI void GLFWAPIENTRY glfwFreeImage( GLFWimage *img )
+{
+    _GLFW_COUNT_CALL( glfwFreeImage );
+    // Free memory
+    if( img->Data != NULL )
+    {
+        switch( _glfwUntrackImage( img->Data ) )
+        {
+        case _GLFW_IMAGE_OWNED:
+            _glfwFree( img->Data, GLFW_MEMORY_IMAGE );
+            break;
+
+        case _GLFW_IMAGE_BORROWED:
+            // Read into a buffer of the caller's, which still owns it
+            break;
+
+        default:
+            // Not allocated by us
+            free( img->Data );
+            break;
+        }
+        img->Data = NULL;
+    }
+
+    // Clear all fields
+    img->Width         = 0;
+    img->Height        = 0;
+    img->Format        = 0;
+    img->BytesPerPixel = 0;
+}
+
+
+//========================================================================
+// Write an image to a named file, as a TGA image
+//========================================================================
+
+GLFWAPI int  GLFWAPIENTRY glfwWriteImage( const char *name,
+    const GLFWimage *img, int flags )
+{
+    _GLFW_COUNT_CALL( glfwWriteImage );
+    _GLFWstream stream;
+    int ok;
+
+    // Open file
+    if( !_glfwOpenFileStream( &stream, name, "wb" ) )
+    {
+        return GL_FALSE;
+    }
+
+    ok = _glfwWriteTGA( &stream, img, flags );
+
+    // Close stream, which also flushes it
+    if( fclose( stream.file ) != 0 )
+    {
+        ok = GL_FALSE;
+    }
+
+    return ok;
+}
+
+
+//========================================================================
+// Write an image to a memory buffer, as a TGA image. Returns the size of
+// the file, which is only complete if it is not larger than size
+//========================================================================
+
+GLFWAPI long GLFWAPIENTRY glfwWriteMemoryImage( const GLFWimage *img,
+    void *data, long size, int flags )
+{
+    _GLFW_COUNT_CALL( glfwWriteMemoryImage );
+    _GLFWstream stream;
+    long written;
+
+    // Open buffer
+    if( !_glfwOpenBufferStream( &stream, data, size ) )
+    {
+        return 0;
+    }
+
+    written = _glfwWriteTGA( &stream, img, flags ) ? stream.position : 0;
+
+    // Close stream
+    _glfwCloseStream( &stream );
+
+    return written;
+}
+
+
+//========================================================================
+// Set how many of the top mipmap levels of textures are dropped at load
+// time, to save memory and upload time
+//========================================================================
+
+GLFWAPI void GLFWAPIENTRY glfwSetTextureLodBias( int levels )
+{
+    _GLFW_COUNT_CALL( glfwSetTextureLodBias );
+    _glfw.texturelodbias = levels > 0 ? levels : 0;
+}
+
+
+//========================================================================
+// Set how many bytes of mipmap levels may be uploaded per frame, the
+// largest levels of mipmapped textures being uploaded over the next frames
+// instead of at load time.  Zero disables texture streaming
+//========================================================================
+
+GLFWAPI void GLFWAPIENTRY glfwSetTextureStreamBudget( long bytes )
+{
+    _GLFW_COUNT_CALL( glfwSetTextureStreamBudget );
+    _glfw.texturestreambudget = bytes > 0 ? bytes : 0;
+}
+
+
+//========================================================================
+// Read the unpack pixel-store state back from the context
+//========================================================================
+
+static void QueryUnpackState( void )
+{
+    _glfw.glGetIntegerv( GL_UNPACK_ALIGNMENT, &_glfw.unpack.alignment );
+    _glfw.glGetIntegerv( GL_UNPACK_ROW_LENGTH, &_glfw.unpack.rowlength );
+    _glfw.glGetIntegerv( GL_UNPACK_SKIP_ROWS, &_glfw.unpack.skiprows );
+    _glfw.glGetIntegerv( GL_UNPACK_SKIP_PIXELS, &_glfw.unpack.skippixels );
+    _glfw.glGetIntegerv( GL_UNPACK_SWAP_BYTES, &_glfw.unpack.swapbytes );
+    _glfwSetGLPixelStoreKnown();
+}
+
+
+//========================================================================
+// Re-read the unpack pixel-store state, for applications that change it
+// with glPixelStorei() behind our back
+//========================================================================
+
+GLFWAPI void GLFWAPIENTRY glfwSyncPixelStore( void )
+{
+    _GLFW_COUNT_CALL( glfwSyncPixelStore );
+    // Is GLFW initialized?
+    if( !_glfw.window )
+    {
+        return;
+    }
+
+    QueryUnpackState();
+}
+
+
+//========================================================================
+// Set an unpack pixel-store parameter, unless the context already has it
+//========================================================================
+
+static void SetPixelStore( GLenum pname, GLint *shadow, GLint value )
+{
+    if( *shadow != value )
+    {
+        _glfw.glPixelStorei( pname, value );
+        *shadow = value;
+    }
+}
+
+
+//========================================================================
+// Make our rows tightly packed, from the first pixel of the image, saving
+// the caller's unpack state
+//========================================================================
+
+static void SaveUnpackState( _GLFWpixelstore *saved )
+{
+    // Unless the OpenGL wrappers saw every pixel-store call of the game, the
+    // shadow may be stale, and neither what we set nor what we put back
+    // could be trusted
+    if( !_glfwIsGLPixelStoreKnown() )
+    {
+        QueryUnpackState();
+    }
+
+    *saved = _glfw.unpack;
+    SetPixelStore( GL_UNPACK_ROW_LENGTH, &_glfw.unpack.rowlength, 0 );
+    SetPixelStore( GL_UNPACK_SKIP_ROWS, &_glfw.unpack.skiprows, 0 );
+    SetPixelStore( GL_UNPACK_SKIP_PIXELS, &_glfw.unpack.skippixels, 0 );
+    SetPixelStore( GL_UNPACK_SWAP_BYTES, &_glfw.unpack.swapbytes, 0 );
+}
+
+
+//========================================================================
+// Restore the caller's unpack state
+//========================================================================
+
+static void RestoreUnpackState( const _GLFWpixelstore *saved )
+{
+    SetPixelStore( GL_UNPACK_ALIGNMENT, &_glfw.unpack.alignment,
+                   saved->alignment );
+    SetPixelStore( GL_UNPACK_ROW_LENGTH, &_glfw.unpack.rowlength,
+                   saved->rowlength );
+    SetPixelStore( GL_UNPACK_SKIP_ROWS, &_glfw.unpack.skiprows,
+                   saved->skiprows );
+    SetPixelStore( GL_UNPACK_SKIP_PIXELS, &_glfw.unpack.skippixels,
+                   saved->skippixels );
+    SetPixelStore( GL_UNPACK_SWAP_BYTES, &_glfw.unpack.swapbytes,
+                   saved->swapbytes );
+}
+
+
+//========================================================================
+// Have the driver generate the mipmaps of the bound texture, returning
+// whether we turned it on, as games may have done so themselves
+//========================================================================
+
+static int EnableAutoMipmaps( void )
+{
+    GLint   enabled;
+
+    _glfw.glGetTexParameteriv( GL_TEXTURE_2D, GL_GENERATE_MIPMAP_SGIS,
+                               &enabled );
+    if( enabled )
+    {
+        return GL_FALSE;
+    }
+
+    _glfw.glTexParameteri( GL_TEXTURE_2D, GL_GENERATE_MIPMAP_SGIS, GL_TRUE );
+    return GL_TRUE;
+}
+
+
+//========================================================================
+// Upload one mipmap level of the bound texture
+//========================================================================
+
+static int UploadMipmap( int level, int format, int width, int height,
+    int bpp, const _GLFWuploadformat *upload, const unsigned char *data )
+{
+    _GLFWstagetimer timer;
+    unsigned char *packed;
+    int     n;
+
+    // Reduced precision is applied to each level once it has been built
+    packed = NULL;
+    if( IsPackedUpload( upload, bpp ) )
+    {
+        packed = (unsigned char *) _glfwMalloc( width * height * 2,
+                                                GLFW_MEMORY_CONVERT );
+        if( packed == NULL )
+        {
+            return GL_FALSE;
+        }
+
+        _GLFW_BEGIN_STAGE( timer );
+        for( n = 0; n < height; n ++ )
+        {
+            _glfwQuantizePixels( data + (long) n * width * bpp,
+                (uint16_t *) packed + (long) n * width, width, 0, n, bpp,
+                upload->type );
+        }
+        _GLFW_END_STAGE( timer, GLFW_STAGE_CONVERT,
+                         (uint64_t) width * height * 2 );
+
+        data = packed;
+        bpp  = 2;
+    }
+
+    // Only drop the unpack alignment when this level's rows need it
+    if( ( width * bpp ) % _glfw.unpack.alignment )
+    {
+        SetPixelStore( GL_UNPACK_ALIGNMENT, &_glfw.unpack.alignment, 1 );
+    }
+
+    _GLFW_BEGIN_STAGE( timer );
+    _glfw.glTexImage2D( GL_TEXTURE_2D, level, format, width, height, 0,
+        upload->format, upload->type, (void*) data );
+    _GLFW_END_STAGE( timer, GLFW_STAGE_UPLOAD,
+                     (uint64_t) width * height * bpp );
+
+    _glfwFree( packed, GLFW_MEMORY_CONVERT );
+
+    return GL_TRUE;
+}
+
+
+//========================================================================
+// Mipmap levels of a texture still to be uploaded: levels 0 to base - 1,
+// stored one after the other from the largest one
+//========================================================================
+
+struct _GLFWtexturestream
+{
+    GLuint              texture;
+    int                 width, height, bpp, format;
+    _GLFWuploadformat   upload;
+    int                 base;
+    unsigned char      *data;
+    _GLFWtexturestream *next;
+};
+
+
+//========================================================================
+// Find a mipmap level of a streamed texture, and its size
+//========================================================================
+
+static unsigned char *GetStreamLevel( _GLFWtexturestream *s, int level,
+    int *width, int *height )
+{
+    unsigned char *data = s->data;
+    int     w = s->width, h = s->height;
+
+    for( ; level > 0; level -- )
+    {
+        data += (long) w * h * s->bpp;
+        w = w > 1 ? w / 2 : 1;
+        h = h > 1 ? h / 2 : 1;
+    }
+
+    *width  = w;
+    *height = h;
+    return data;
+}
+
+
+//========================================================================
+// Upload the next levels of a streamed texture, which must be bound, as
+// long as they fit in the per-frame budget.  At least one level is
+// uploaded per frame, and the texture stays complete from its base level
+//========================================================================
+
+static void UploadStreamLevels( _GLFWtexturestream *s, long *spent )
+{
+    unsigned char *data;
+    int     width, height;
+    long    size;
+
+    _glfw.texturestreamupload = GL_TRUE;
+    while( s->base > 0 )
+    {
+        data = GetStreamLevel( s, s->base - 1, &width, &height );
+        size = (long) width * height * s->bpp;
+        if( *spent > 0 && *spent + size > _glfw.texturestreambudget )
         {
-            for( k = 0; k < bpp; k ++ )
-            {
-                col1 = *src1 ++;
-                col2 = *src2 ++;
-                col = col1 + (col2 - col1) * dx;
-                col1 = *src3 ++;
-                col2 = *src4 ++;
-                col2 = col1 + (col2 - col1) * dx;
-                col += (col2 - col) * dy;
-                col8 = (int) (col + 0.5);
-                if( col8 >= 256 ) col8 = 255;
-                *dst++ = (unsigned char) col8;
-            }
-            dx += xstep;
-            if( dx >= 1.0f )
-            {
-                x ++;
-                dx -= 1.0f;
-                if( x >= (w1-1) )
-                {
-                    src2 = src1;
-                    src4 = src3;
-                }
-            }
-            else
-            {
-                src1 -= bpp;
-                src2 -= bpp;
-                src3 -= bpp;
-                src4 -= bpp;
-            }
+            break;
         }
-        dy += ystep;
-        if( dy >= 1.0f )
+
+        if( !UploadMipmap( s->base - 1, s->format, width, height, s->bpp,
+                           &s->upload, data ) )
         {
-            y ++;
-            dy -= 1.0f;
+            break;
         }
+        *spent += size;
+        s->base --;
     }
+    _glfw.texturestreamupload = GL_FALSE;
+
+    _glfw.glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, s->base );
 }
 
 
 //========================================================================
-// Build the next mip-map level
+// Free a streamed texture record
 //========================================================================
 
-static int HalveImage( GLubyte *src, int *width, int *height,
-    int components )
+static void FreeTextureStream( _GLFWtexturestream *s )
 {
-    int     halfwidth, halfheight, m, n, k, idx1, idx2;
-    GLubyte *dst;
+    _glfwFree( s->data, GLFW_MEMORY_RESCALE );
+    _glfwFree( s, GLFW_MEMORY_OTHER );
+}
 
-    // Last level?
-    if( *width <= 1 && *height <= 1 )
+
+//========================================================================
+// Stop streaming the bound texture, which is about to be replaced
+//========================================================================
+
+void _glfwForgetTextureStream( GLuint texture )
+{
+    _GLFWtexturestream **link, *s;
+
+    for( link = &_glfw.texturestreams; ( s = *link ) != NULL;
+         link = &s->next )
     {
-        return GL_FALSE;
+        if( s->texture == texture )
+        {
+            *link = s->next;
+            FreeTextureStream( s );
+            _glfw.glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0 );
+            return;
+        }
     }
+}
 
-    // Calculate new width and height (handle 1D case)
-    halfwidth  = *width > 1 ? *width / 2 : 1;
-    halfheight = *height > 1 ? *height / 2 : 1;
 
-    // Downsample image with a simple box-filter
-    dst = src;
-    if( *width == 1 || *height == 1 )
+//========================================================================
+// Upload all the remaining levels of the bound texture, if it is being
+// streamed in
+//========================================================================
+
+static void FinishTextureStream( GLuint texture )
+{
+    _GLFWtexturestream **link, *s;
+    int     base;
+    long    spent;
+
+    for( link = &_glfw.texturestreams; ( s = *link ) != NULL;
+         link = &s->next )
     {
-        // 1D case
-        for( m = 0; m < halfwidth+halfheight-1; m ++ )
+        if( s->texture == texture )
         {
-            for( k = 0; k < components; k ++ )
+            // As long as levels can still be uploaded
+            do
             {
-                *dst ++ = (GLubyte) (((int)*src +
-                                      (int)src[components] + 1) >> 1);
-                src ++;
+                base  = s->base;
+                spent = 0;
+                UploadStreamLevels( s, &spent );
             }
-            src += components;
+            while( s->base > 0 && s->base < base );
+
+            *link = s->next;
+            FreeTextureStream( s );
+            return;
         }
     }
-    else
+}
+
+
+//========================================================================
+// Upload the smallest mipmap levels of an image to the bound texture, and
+// queue the others to be uploaded over the next frames
+//========================================================================
+
+static int StreamTextureImage( GLuint texture, const unsigned char *data,
+    int width, int height, int bpp, int format,
+    const _GLFWuploadformat *upload )
+{
+    _GLFWtexturestream *s, **link;
+    unsigned char *level, *next, *shrunk;
+    int     w, h, n, levels;
+    long    size, spent;
+
+    // Size of the whole mipmap chain
+    size   = 0;
+    levels = 0;
+    w      = width;
+    h      = height;
+    for( ;; )
     {
-        // 2D case
-        idx1 = *width*components;
-        idx2 = (*width+1)*components;
-        for( m = 0; m < halfheight; m ++ )
+        size += (long) w * h * bpp;
+        levels ++;
+        if( w <= 1 && h <= 1 )
         {
-            for( n = 0; n < halfwidth; n ++ )
-            {
-                for( k = 0; k < components; k ++ )
-                {
-                    *dst ++ = (GLubyte) (((int)*src +
-                                          (int)src[components] +
-                                          (int)src[idx1] +
-                                          (int)src[idx2] + 2) >> 2);
-                    src ++;
-                }
-                src += components;
-            }
-            src += components * (*width);
+            break;
         }
+        w = w > 1 ? w / 2 : 1;
+        h = h > 1 ? h / 2 : 1;
     }
 
-    // Return new width and height
-    *width = halfwidth;
-    *height = halfheight;
+    s = (_GLFWtexturestream *) _glfwCalloc( 1, sizeof( *s ),
+                                            GLFW_MEMORY_OTHER );
+    if( s == NULL )
+    {
+        return GL_FALSE;
+    }
+    s->data = (unsigned char *) _glfwMalloc( size, GLFW_MEMORY_RESCALE );
+    if( s->data == NULL )
+    {
+        _glfwFree( s, GLFW_MEMORY_OTHER );
+        return GL_FALSE;
+    }
+    s->texture = texture;
+    s->width   = width;
+    s->height  = height;
+    s->bpp     = bpp;
+    s->format  = format;
+    s->upload  = *upload;
+    s->base    = levels;
+
+    // Build the whole mipmap chain up front
+    memcpy( s->data, data, (size_t) width * height * bpp );
+    level = s->data;
+    w     = width;
+    h     = height;
+    for( n = 1; n < levels; n ++ )
+    {
+        next = level + (long) w * h * bpp;
+        HalveImage( level, next, &w, &h, bpp );
+        level = next;
+    }
+
+    // Drivers size the texture storage from the first level they see, so
+    // let them see the largest one, without uploading it yet
+    _glfw.glTexImage2D( GL_TEXTURE_2D, 0, format, width, height, 0,
+        upload->format, upload->type, NULL );
+
+    // Upload the smallest levels right away
+    spent = 0;
+    UploadStreamLevels( s, &spent );
+    if( s->base == 0 )
+    {
+        FreeTextureStream( s );
+        return GL_TRUE;
+    }
+
+    // Only keep the levels still to be uploaded, and queue them after the
+    // textures loaded before this one
+    shrunk = (unsigned char *) _glfwRealloc( s->data,
+        GetStreamLevel( s, s->base, &w, &h ) - s->data, GLFW_MEMORY_RESCALE );
+    if( shrunk != NULL )
+    {
+        s->data = shrunk;
+    }
+
+    for( link = &_glfw.texturestreams; *link != NULL; link = &(*link)->next )
+    {
+    }
+    *link = s;
 
     return GL_TRUE;
 }
 
 
 //========================================================================
-// Rescales an image into power-of-two dimensions
+// Resample an image to the given size on the GPU, into level 0 of the
+// bound texture: the original image is uploaded to a scratch rectangle
+// texture, blitted with linear filtering into a scratch renderbuffer, and
+// copied from there.  The scratch objects are kept for the next images
 //========================================================================
 
-static int RescaleImage( GLFWimage* image )
+static int BlitRescaledImage( const unsigned char *data, int width,
+    int height, const _GLFWuploadformat *upload, int format, int dstwidth,
+    int dstheight, int mipmaps )
 {
-    int     width, height, log2, newsize;
-    unsigned char *data;
+    GLuint  readfbo, drawfbo, renderbuffer, rectangle;
+    GLint   maxtexture;
+    GLboolean scissor;
+    int     complete;
+
+    // Limits of the scratch objects, queried once per context
+    if( _glfw.blitmaxsource == 0 )
+    {
+        _glfw.glGetIntegerv( GL_MAX_RECTANGLE_TEXTURE_SIZE_ARB,
+                             &_glfw.blitmaxsource );
+        _glfw.glGetIntegerv( GL_MAX_RENDERBUFFER_SIZE, &_glfw.blitmaxsize );
+        _glfw.glGetIntegerv( GL_MAX_TEXTURE_SIZE, &maxtexture );
+        if( maxtexture < _glfw.blitmaxsize )
+        {
+            _glfw.blitmaxsize = maxtexture;
+        }
+    }
+
+    // Larger images are rescaled on the CPU, which says nothing about
+    // whether the others can be blitted
+    if( width > _glfw.blitmaxsource || height > _glfw.blitmaxsource ||
+        dstwidth > _glfw.blitmaxsize || dstheight > _glfw.blitmaxsize )
+    {
+        return GL_FALSE;
+    }
+
+    // Save the bindings we are about to change, which are only queried when
+    // the OpenGL wrappers may have missed them changing
+    readfbo      = _glfwGetGLBinding( GL_READ_FRAMEBUFFER );
+    drawfbo      = _glfwGetGLBinding( GL_DRAW_FRAMEBUFFER );
+    renderbuffer = _glfwGetGLBinding( GL_RENDERBUFFER );
+    rectangle    = _glfwGetGLBinding( GL_TEXTURE_RECTANGLE_ARB );
+    scissor      = _glfwIsGLEnabled( GL_SCISSOR_TEST );
+
+    // The scratch objects are created by the first blit of the context
+    complete = _glfw.blitfbo[ 0 ] != 0;
+    if( !complete )
+    {
+        _glfw.glGenTextures( 1, &_glfw.blittexture );
+        _glfw.glGenRenderbuffers( 1, &_glfw.blitrenderbuffer );
+        _glfw.glGenFramebuffers( 2, _glfw.blitfbo );
+    }
+
+    // Upload the original image once
+    _glfw.glBindTexture( GL_TEXTURE_RECTANGLE_ARB, _glfw.blittexture );
+    _glfw.glTexImage2D( GL_TEXTURE_RECTANGLE_ARB, 0, GL_RGBA8, width, height,
+        0, upload->format, upload->type, (void*) data );
+
+    _glfw.glBindRenderbuffer( GL_RENDERBUFFER, _glfw.blitrenderbuffer );
+    _glfw.glRenderbufferStorage( GL_RENDERBUFFER, GL_RGBA8, dstwidth,
+        dstheight );
+
+    _glfw.glBindFramebuffer( GL_READ_FRAMEBUFFER, _glfw.blitfbo[ 0 ] );
+    _glfw.glBindFramebuffer( GL_DRAW_FRAMEBUFFER, _glfw.blitfbo[ 1 ] );
+    if( !complete )
+    {
+        _glfw.glFramebufferTexture2D( GL_READ_FRAMEBUFFER,
+            GL_COLOR_ATTACHMENT0, GL_TEXTURE_RECTANGLE_ARB,
+            _glfw.blittexture, 0 );
+        _glfw.glFramebufferRenderbuffer( GL_DRAW_FRAMEBUFFER,
+            GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, _glfw.blitrenderbuffer );
+
+        // Resizing the attachments keeps their formats, so they are only
+        // checked once
+        complete = _glfw.glCheckFramebufferStatus( GL_READ_FRAMEBUFFER ) ==
+                   GL_FRAMEBUFFER_COMPLETE &&
+                   _glfw.glCheckFramebufferStatus( GL_DRAW_FRAMEBUFFER ) ==
+                   GL_FRAMEBUFFER_COMPLETE;
+    }
+
+    if( complete )
+    {
+        // Blits are clipped by the scissor test
+        if( scissor )
+        {
+            _glfw.glDisable( GL_SCISSOR_TEST );
+        }
+
+        _glfw.glBlitFramebuffer( 0, 0, width, height, 0, 0, dstwidth,
+            dstheight, GL_COLOR_BUFFER_BIT, GL_LINEAR );
+
+        // Copy the result into the bound texture, converting it to the
+        // internal format of the image on the way
+        _glfw.glBindFramebuffer( GL_READ_FRAMEBUFFER, _glfw.blitfbo[ 1 ] );
+        _glfw.glCopyTexImage2D( GL_TEXTURE_2D, 0, format, 0, 0, dstwidth,
+            dstheight, 0 );
+
+        if( mipmaps )
+        {
+            _glfw.glGenerateMipmap( GL_TEXTURE_2D );
+        }
+
+        if( scissor )
+        {
+            _glfw.glEnable( GL_SCISSOR_TEST );
+        }
+    }
+
+    // Restore the bindings
+    _glfw.glBindFramebuffer( GL_READ_FRAMEBUFFER, readfbo );
+    _glfw.glBindFramebuffer( GL_DRAW_FRAMEBUFFER, drawfbo );
+    _glfw.glBindRenderbuffer( GL_RENDERBUFFER, renderbuffer );
+    _glfw.glBindTexture( GL_TEXTURE_RECTANGLE_ARB, rectangle );
+
+    // Don't try again with a driver which can't do it
+    if( !complete )
+    {
+        _glfw.glDeleteFramebuffers( 2, _glfw.blitfbo );
+        _glfw.glDeleteRenderbuffers( 1, &_glfw.blitrenderbuffer );
+        _glfw.glDeleteTextures( 1, &_glfw.blittexture );
+        _glfw.blitfbo[ 0 ] = _glfw.blitfbo[ 1 ] = 0;
+        _glfw.blitrenderbuffer = _glfw.blittexture = 0;
+        _glfw.fboblit = GL_FALSE;
+    }
+
+    return complete;
+}
+
+
+//========================================================================
+// Upload an image object to texture memory, resampling it to power-of-two
+// dimensions first if asked to.  alpha is how the image uses its alpha
+// channel, if known
+//========================================================================
+
+static int LoadTextureImage( GLFWimage *img, int flags, int rescale,
+    int alpha )
+{
+    _GLFWpixelstore saved;
+    int     level, format, AutoGen, AutoGenSet, width, height, bpp, n;
+    int     potwidth, potheight, blitted, stream, packed, ok, category;
+    GLuint  texture;
+    _GLFWuploadformat upload;
+    _GLFWstagetimer timer;
+    signed char map[ 4 ];
+    unsigned char *data, *rescaled;
+
+    // TODO: Use GL_MAX_TEXTURE_SIZE or GL_PROXY_TEXTURE_2D to determine
+    //       whether the image size is valid.
+    // NOTE: May require box filter downsampling routine.
+
+    // Which pixel layout does the driver want for this image?
+    int glMajor = _glfw.glmajor, glMinor = _glfw.glminor;
+    GetUploadFormat( img->Format, glMajor, glMinor, &upload );
+
+    // Or reduced precision, if enabled
+    packed = GetPackedUpload( img, alpha, &upload );
+
+    // Convert the image to that layout if needed (this includes the alpha
+    // map to RGBA conversion of OpenGL 1.0)
+    width  = img->Width;
+    height = img->Height;
+    bpp    = img->BytesPerPixel;
+    data   = img->Data;
+    category = GLFW_MEMORY_CONVERT;
+    if( bpp == 2 && upload.type == GL_UNSIGNED_BYTE )
+    {
+        data = (unsigned char *) _glfwMalloc( width * height * 4, category );
+        if( data == NULL )
+        {
+            return GL_FALSE;
+        }
+
+        UnpackImage( img->Data, data, width, height, width * 4, 4 );
+        bpp = 4;
+    }
+    else if( !packed && bpp != 2 &&
+             GetUploadSwizzle( img->Format, upload.format, map ) )
+    {
+        data = (unsigned char *) _glfwMalloc( width * height * 4, category );
+        if( data == NULL )
+        {
+            return GL_FALSE;
+        }
+
+        _GLFW_BEGIN_STAGE( timer );
+        _glfwSwizzlePixels( img->Data, data, (long) width * height, bpp,
+                            map );
+        bpp = 4;
+        _GLFW_END_STAGE( timer, GLFW_STAGE_CONVERT,
+                         (uint64_t) width * height * bpp );
+    }
+
+    // Drop the top mipmap levels when a texture LOD bias is set
+    for( n = 0; n < _glfw.texturelodbias; n ++ )
+    {
+        if( width <= 1 && height <= 1 )
+        {
+            break;
+        }
+
+        if( data == img->Data )
+        {
+            // Leave the caller's image alone
+            category = GLFW_MEMORY_RESCALE;
+            data = (unsigned char *) _glfwMalloc( (width > 1 ? width / 2 : 1) *
+                (height > 1 ? height / 2 : 1) * bpp, category );
+            if( data == NULL )
+            {
+                return GL_FALSE;
+            }
+            HalveImage( img->Data, data, &width, &height, bpp );
+        }
+        else
+        {
+            HalveImage( data, data, &width, &height, bpp );
+        }
+    }
+
+    // Power-of-two size of the image, minus the dropped levels
+    potwidth  = NextPowerOfTwo( img->Width ) >> n;
+    potheight = NextPowerOfTwo( img->Height ) >> n;
+    potwidth  = potwidth > 0 ? potwidth : 1;
+    potheight = potheight > 0 ? potheight : 1;
+
+    SaveUnpackState( &saved );
+
+    // A texture still being streamed in is replaced by this image
+    texture = 0;
+    stream  = ( flags & GLFW_BUILD_MIPMAPS_BIT ) && _glfw.texturestreaming &&
+              _glfw.texturestreambudget > 0 && _glfwSeesGLTextureImages();
+    if( stream || _glfw.texturestreams )
+    {
+        texture = _glfwGetGLBinding( GL_TEXTURE_2D );
+        _glfwForgetTextureStream( texture );
+    }
+
+    // The default texture can't be told apart from a deleted one, so it is
+    // never streamed
+    stream = stream && texture != 0;
+
+    // Should we use automatic mipmap generation?
+    AutoGen = ( flags & GLFW_BUILD_MIPMAPS_BIT ) && _glfw.autogenmipmap &&
+              !stream;
+
+    // Enable automatic mipmap generation
+    AutoGenSet = AutoGen && EnableAutoMipmaps();
+
+    // Format specification is different for OpenGL 1.0
+    if( packed )
+    {
+        format = packed;
+    }
+    else if( glMajor == 1 && glMinor == 0 )
+    {
+        format = bpp;
+    }
+    else
+    {
+        format = img->Format;
+    }
+
+    // Resample the image to power-of-two dimensions, on the GPU if the
+    // driver lets us, otherwise on the CPU
+    blitted = GL_FALSE;
+    ok = GL_TRUE;
+    if( rescale && ( width != potwidth || height != potheight ) )
+    {
+        // Blits can't dither, reduced precision images are resampled here
+        if( _glfw.fboblit && !packed )
+        {
+            if( ( width * bpp ) % _glfw.unpack.alignment )
+            {
+                SetPixelStore( GL_UNPACK_ALIGNMENT, &_glfw.unpack.alignment,
+                               1 );
+            }
 
-    // Calculate next larger 2^N width
-    for( log2 = 0, width = image->Width; width > 1; width >>= 1, log2 ++ )
-      ;
+            _GLFW_BEGIN_STAGE( timer );
+            blitted = BlitRescaledImage( data, width, height, &upload, format,
+                potwidth, potheight,
+                ( flags & GLFW_BUILD_MIPMAPS_BIT ) && !AutoGen );
+            _GLFW_END_STAGE( timer, GLFW_STAGE_UPLOAD,
+                             (uint64_t) width * height * bpp );
+        }
 
-    width  = (int) 1 << log2;
-    if( width < image->Width )
-    {
-        width <<= 1;
+        if( !blitted )
+        {
+            rescaled = (unsigned char *) _glfwMalloc( potwidth * potheight *
+                bpp, GLFW_MEMORY_RESCALE );
+            if( rescaled != NULL )
+            {
+                UpsampleImage( data, rescaled, width, height, potwidth,
+                               potheight, bpp, potwidth * bpp );
+                if( data != img->Data )
+                {
+                    _glfwFree( data, category );
+                }
+                data     = rescaled;
+                category = GLFW_MEMORY_RESCALE;
+                width    = potwidth;
+                height   = potheight;
+            }
+            else
+            {
+                ok = GL_FALSE;
+            }
+        }
     }
 
-    // Calculate next larger 2^M height
-    for( log2 = 0, height = image->Height; height > 1; height >>= 1, log2 ++ )
-      ;
-
-    height = (int) 1 << log2;
-    if( height < image->Height )
+    // Upload to texture memeory, unless the blit already did
+    if( ok && !blitted && stream )
     {
-        height <<= 1;
+        ok = StreamTextureImage( texture, data, width, height, bpp, format,
+                                 &upload );
     }
-
-    // Do we really need to rescale?
-    if( width != image->Width || height != image->Height )
+    else if( ok && !blitted )
     {
-        // Allocate memory for new (upsampled) image data
-        newsize = width * height * image->BytesPerPixel;
-        data = (unsigned char *) malloc( newsize );
-        if( data == NULL )
+        level = 0;
+        do
         {
-            free( image->Data );
-            return GL_FALSE;
+            // Upload this mipmap level
+            ok = UploadMipmap( level, format, width, height, bpp, &upload,
+                               data );
+            if( !ok )
+            {
+                break;
+            }
+
+            // Build next mipmap level manually, if required
+            if( ( flags & GLFW_BUILD_MIPMAPS_BIT ) && !AutoGen )
+            {
+                level = HalveImage( data, data, &width, &height, bpp ) ?
+                        level + 1 : 0;
+            }
         }
+        while( level != 0 );
+    }
 
-        // Copy old image data to new image data with interpolation
-        UpsampleImage( image->Data, data, image->Width, image->Height,
-                       width, height, image->BytesPerPixel );
+    // Automatic mipmap generation is texture state, only turn off what we
+    // turned on
+    if( AutoGenSet )
+    {
+        _glfw.glTexParameteri( GL_TEXTURE_2D, GL_GENERATE_MIPMAP_SGIS,
+            GL_FALSE );
+    }
 
-        // Free memory for old image data (not needed anymore)
-        free( image->Data );
+    RestoreUnpackState( &saved );
 
-        // Set pointer to new image data, and set new image dimensions
-        image->Data   = data;
-        image->Width  = width;
-        image->Height = height;
+    if( data != img->Data )
+    {
+        // Free the converted image data
+        _glfwFree( data, category );
+    }
+    else
+    {
+        // The image data was halved in place, keep its size in sync
+        img->Width  = width;
+        img->Height = height;
     }
 
-    return GL_TRUE;
+    return ok;
 }
 
 
-//************************************************************************
-//****                    GLFW user functions                         ****
-//************************************************************************
-
 //========================================================================
-// Read an image from a named file
+// Upload the next mipmap levels of streamed textures, within the per-frame
+// budget.  Textures which the game deleted or loaded again were already
+// dropped by the OpenGL wrappers, so nothing needs to be queried
 //========================================================================
 
-GLFWAPI int GLFWAPIENTRY glfwReadImage( const char *name, GLFWimage *img,
-    int flags )
+void _glfwUpdateTextureStreams( void )
 {
-    _GLFWstream stream;
-
-    // Start with an empty image descriptor
-    img->Width         = 0;
-    img->Height        = 0;
-    img->BytesPerPixel = 0;
-    img->Data          = NULL;
-
-    // Open file
-    if( !_glfwOpenFileStream( &stream, name, "rb" ) )
-    {
-        return GL_FALSE;
-    }
+    _GLFWtexturestream **link, *s;
+    _GLFWpixelstore saved;
+    GLuint  bound;
+    long    spent;
 
-    // We only support TGA files at the moment
-    if( !_glfwReadTGA( &stream, img, flags ) )
+    if( !_glfw.texturestreams )
     {
-        _glfwCloseStream( &stream );
-        return GL_FALSE;
+        return;
     }
 
-    // Close stream
-    _glfwCloseStream( &stream );
+    bound = _glfwGetGLBinding( GL_TEXTURE_2D );
+    SaveUnpackState( &saved );
 
-    // Should we rescale the image to closest 2^N x 2^M resolution?
-    if( !(flags & GLFW_NO_RESCALE_BIT) )
+    spent = 0;
+    link  = &_glfw.texturestreams;
+    while( ( s = *link ) != NULL &&
+           ( spent == 0 || spent < _glfw.texturestreambudget ) )
     {
-        if( !RescaleImage( img ) )
+        _glfw.glBindTexture( GL_TEXTURE_2D, s->texture );
+        UploadStreamLevels( s, &spent );
+
+        if( s->base == 0 )
         {
-            return GL_FALSE;
+            *link = s->next;
+            FreeTextureStream( s );
+        }
+        else
+        {
+            link = &s->next;
         }
     }
 
-    // Interpret BytesPerPixel as an OpenGL format
-    switch( img->BytesPerPixel )
-    {
-        default:
-        case 1:
-            if( flags & GLFW_ALPHA_MAP_BIT )
-            {
-                img->Format = GL_ALPHA;
-            }
-            else
-            {
-                img->Format = GL_LUMINANCE;
-            }
-            break;
-        case 3:
-            img->Format = GL_RGB;
-            break;
-        case 4:
-            img->Format = GL_RGBA;
-            break;
-    }
-
-    return GL_TRUE;
+    RestoreUnpackState( &saved );
+    _glfw.glBindTexture( GL_TEXTURE_2D, bound );
 }
 
 
 //========================================================================
-// Read an image file from a memory buffer
+// Forget about all streamed textures, when their context goes away
 //========================================================================
 
-GLFWAPI int GLFWAPIENTRY glfwReadMemoryImage( const void *data, long size, GLFWimage *img, int flags )
+void _glfwDestroyTextureStreams( void )
 {
-    _GLFWstream stream;
-
-    // Start with an empty image descriptor
-    img->Width         = 0;
-    img->Height        = 0;
-    img->BytesPerPixel = 0;
-    img->Data          = NULL;
+    _GLFWtexturestream *s;
 
-    // Open buffer
-    if( !_glfwOpenBufferStream( &stream, (void*) data, size ) )
+    while( ( s = _glfw.texturestreams ) != NULL )
     {
-        return GL_FALSE;
+        _glfw.texturestreams = s->next;
+        FreeTextureStream( s );
     }
+}
 
-    // We only support TGA files at the moment
-    if( !_glfwReadTGA( &stream, img, flags ) )
-    {
-        _glfwCloseStream( &stream );
-        return GL_FALSE;
-    }
 
-    // Close stream
-    _glfwCloseStream( &stream );
+//========================================================================
+// Forget about streamed textures deleted by the game.  Their names are gone,
+// so no OpenGL state is touched
+//========================================================================
 
-    // Should we rescale the image to closest 2^N x 2^M resolution?
-    if( !(flags & GLFW_NO_RESCALE_BIT) )
-    {
-        if( !RescaleImage( img ) )
-        {
-            return GL_FALSE;
-        }
-    }
+void _glfwDeleteTextureStreams( GLsizei n, const GLuint *textures )
+{
+    _GLFWtexturestream **link, *s;
+    GLsizei i;
 
-    // Interpret BytesPerPixel as an OpenGL format
-    switch( img->BytesPerPixel )
+    for( i = 0; i < n && _glfw.texturestreams; i ++ )
     {
-        default:
-        case 1:
-            if( flags & GLFW_ALPHA_MAP_BIT )
-            {
-                img->Format = GL_ALPHA;
-            }
-            else
+        for( link = &_glfw.texturestreams; ( s = *link ) != NULL;
+             link = &s->next )
+        {
+            if( s->texture == textures[ i ] )
             {
-                img->Format = GL_LUMINANCE;
+                *link = s->next;
+                FreeTextureStream( s );
+                break;
             }
-            break;
-        case 3:
-            img->Format = GL_RGB;
-            break;
-        case 4:
-            img->Format = GL_RGBA;
-            break;
+        }
     }
-
-    return GL_TRUE;
 }
 
 
 //========================================================================
-// Free allocated memory for an image
+// Upload an image object to texture memory
 //========================================================================
 
-GLFWAPI void GLFWAPIENTRY glfwFreeImage( GLFWimage *img )
+GLFWAPI int  GLFWAPIENTRY glfwLoadTextureImage2D( GLFWimage *img, int flags )
 {
-    // Free memory
-    if( img->Data != NULL )
+    _GLFW_COUNT_CALL( glfwLoadTextureImage2D );
+    _GLFW_TRACE_SCOPE( "glfwLoadTextureImage2D" );
+    // Is GLFW initialized?
+    if( !_glfw.window )
     {
-        free( img->Data );
-        img->Data = NULL;
+        return GL_FALSE;
     }
 
-    // Clear all fields
-    img->Width         = 0;
-    img->Height        = 0;
-    img->Format        = 0;
-    img->BytesPerPixel = 0;
+    return LoadTextureImage( img, flags, GL_FALSE, _GLFW_ALPHA_UNKNOWN );
 }
 
 
@@ -973,7 +3435,10 @@ GLFWAPI void GLFWAPIENTRY glfwFreeImage( GLFWimage *img )
 
 GLFWAPI int GLFWAPIENTRY glfwLoadTexture2D( const char *name, int flags )
 {
+    _GLFW_COUNT_CALL( glfwLoadTexture2D );
+    _GLFW_TRACE_SCOPE( "glfwLoadTexture2D" );
     GLFWimage img;
+    int rescale, readflags, alpha;
 
     // Is GLFW initialized?
     if( !_glfw.window )
@@ -981,19 +3446,31 @@ GLFWAPI int GLFWAPIENTRY glfwLoadTexture2D( const char *name, int flags )
         return GL_FALSE;
     }
 
-    // Force rescaling if necessary
-    if( glfwExtensionSupported("GL_ARB_texture_non_power_of_two") )
+    // Force rescaling if necessary, which is done on the GPU if possible
+    rescale = !_glfw.npottextures;
+    if( rescale )
     {
         flags &= (~GLFW_NO_RESCALE_BIT);
     }
+    rescale = rescale && _glfw.fboblit;
+
+    // 16-bit images may stay packed
+    readflags = flags | GLFW_PACKED_PIXELS_BIT;
+    if( rescale )
+    {
+        readflags |= GLFW_NO_RESCALE_BIT;
+    }
 
-    // Read image from file
-    if( !glfwReadImage( name, &img, flags ) )
+    // Read image from file, finding out how it uses its alpha channel
+    // while decoding it if that matters
+    alpha = _GLFW_ALPHA_UNKNOWN;
+    if( !ReadImageFile( name, &img, readflags,
+                        _glfw.packedtextures ? &alpha : NULL ) )
     {
         return GL_FALSE;
     }
 
-    if( !glfwLoadTextureImage2D( &img, flags ) )
+    if( !LoadTextureImage( &img, flags, rescale, alpha ) )
     {
         return GL_FALSE;
     }
@@ -1011,7 +3488,10 @@ GLFWAPI int GLFWAPIENTRY glfwLoadTexture2D( const char *name, int flags )
 
 GLFWAPI int  GLFWAPIENTRY glfwLoadMemoryTexture2D( const void *data, long size, int flags )
 {
+    _GLFW_COUNT_CALL( glfwLoadMemoryTexture2D );
+    _GLFW_TRACE_SCOPE( "glfwLoadMemoryTexture2D" );
     GLFWimage img;
+    int rescale, readflags, alpha;
 
     // Is GLFW initialized?
     if( !_glfw.window )
@@ -1019,19 +3499,30 @@ GLFWAPI int  GLFWAPIENTRY glfwLoadMemoryTexture2D( const void *data, long size,
         return GL_FALSE;
     }
 
-    // Force rescaling if necessary
-    if( glfwExtensionSupported("GL_ARB_texture_non_power_of_two") )
+    // Force rescaling if necessary, which is done on the GPU if possible
+    rescale = !_glfw.npottextures;
+    if( rescale )
     {
         flags &= (~GLFW_NO_RESCALE_BIT);
     }
+    rescale = rescale && _glfw.fboblit;
+
+    // 16-bit images may stay packed
+    readflags = flags | GLFW_PACKED_PIXELS_BIT;
+    if( rescale )
+    {
+        readflags |= GLFW_NO_RESCALE_BIT;
+    }
 
-    // Read image from file
-    if( !glfwReadMemoryImage( data, size, &img, flags ) )
+    // Read image from buffer
+    alpha = _GLFW_ALPHA_UNKNOWN;
+    if( !ReadMemoryImage( data, size, &img, readflags,
+                          _glfw.packedtextures ? &alpha : NULL ) )
     {
         return GL_FALSE;
     }
 
-    if( !glfwLoadTextureImage2D( &img, flags ) )
+    if( !LoadTextureImage( &img, flags, rescale, alpha ) )
     {
         return GL_FALSE;
     }
@@ -1044,116 +3535,283 @@ GLFWAPI int  GLFWAPIENTRY glfwLoadMemoryTexture2D( const void *data, long size,
 
 
 //========================================================================
-// Upload an image object to texture memory
+// Upload a rectangle of an image to a mipmap level of the bound texture,
+// at the same position.  stride is the width of the image, the rectangle
+// is picked with the unpack pixel-store state unless it has to be
+// converted to the layout the driver wants
 //========================================================================
 
-GLFWAPI int  GLFWAPIENTRY glfwLoadTextureImage2D( GLFWimage *img, int flags )
+static int UploadSubImage( int level, int x, int y, int width, int height,
+    const unsigned char *data, int stride, int bpp,
+    const _GLFWuploadformat *upload, const signed char *map )
 {
-    GLint   UnpackAlignment, GenMipMap;
-    int     level, format, AutoGen, newsize, n;
-    unsigned char *data, *dataptr;
-
-    // Is GLFW initialized?
-    if( !_glfw.window )
+    _GLFWstagetimer timer;
+    unsigned char *converted;
+    const unsigned char *src;
+    int     n, rowlength, skippixels, skiprows;
+
+    rowlength  = stride;
+    skippixels = x;
+    skiprows   = y;
+    converted  = NULL;
+    if( IsPackedUpload( upload, bpp ) )
     {
-        return GL_FALSE;
-    }
-
-    // TODO: Use GL_MAX_TEXTURE_SIZE or GL_PROXY_TEXTURE_2D to determine
-    //       whether the image size is valid.
-    // NOTE: May require box filter downsampling routine.
+        // Quantize the rectangle with the dither pattern of the texture
+        converted = (unsigned char *) _glfwMalloc( width * height * 2,
+                                                   GLFW_MEMORY_CONVERT );
+        if( converted == NULL )
+        {
+            return GL_FALSE;
+        }
 
-    // Do we need to convert the alpha map to RGBA format (OpenGL 1.0)?
-    int glMajor, glMinor;
-    glfwGetGLVersion(&glMajor, &glMinor, NULL);
-    if( (glMajor == 1) && (glMinor == 0) &&
-        (img->Format == GL_ALPHA) )
+        _GLFW_BEGIN_STAGE( timer );
+        for( n = 0; n < height; n ++ )
+        {
+            src = data + ( (long) ( y + n ) * stride + x ) * bpp;
+            _glfwQuantizePixels( src, (uint16_t *) converted + n * width,
+                                 width, x, y + n, bpp, upload->type );
+        }
+        _GLFW_END_STAGE( timer, GLFW_STAGE_CONVERT,
+                         (uint64_t) width * height * 2 );
+
+        data       = converted;
+        bpp        = 2;
+        rowlength  = width;
+        skippixels = 0;
+        skiprows   = 0;
+    }
+    else if( ( bpp == 2 && upload->type == GL_UNSIGNED_BYTE ) || map )
     {
-        // We go to RGBA representation instead
-        img->BytesPerPixel = 4;
-
-        // Allocate memory for new RGBA image data
-        newsize = img->Width * img->Height * img->BytesPerPixel;
-        data = (unsigned char *) malloc( newsize );
-        if( data == NULL )
+        // Only convert the rectangle
+        converted = (unsigned char *) _glfwMalloc( width * height * 4,
+                                                   GLFW_MEMORY_CONVERT );
+        if( converted == NULL )
         {
-            free( img->Data );
             return GL_FALSE;
         }
 
-        // Convert Alpha map to RGBA
-        dataptr = data;
-        for( n = 0; n < (img->Width*img->Height); ++ n )
+        for( n = 0; n < height; n ++ )
         {
-            *dataptr ++ = 255;
-            *dataptr ++ = 255;
-            *dataptr ++ = 255;
-            *dataptr ++ = img->Data[n];
+            src = data + ( (long) ( y + n ) * stride + x ) * bpp;
+            if( bpp == 2 )
+            {
+                UnpackImage( src, converted + n * width * 4, width, 1,
+                             width * 4, 4 );
+            }
+            else
+            {
+                _GLFW_BEGIN_STAGE( timer );
+                _glfwSwizzlePixels( src, converted + n * width * 4, width,
+                                    bpp, map );
+                _GLFW_END_STAGE( timer, GLFW_STAGE_CONVERT,
+                                 (uint64_t) width * 4 );
+            }
         }
 
-        // Free memory for old image data (not needed anymore)
-        free( img->Data );
+        data       = converted;
+        bpp        = 4;
+        rowlength  = width;
+        skippixels = 0;
+        skiprows   = 0;
+    }
 
-        // Set pointer to new image data
-        img->Data = data;
+    SetPixelStore( GL_UNPACK_ROW_LENGTH, &_glfw.unpack.rowlength,
+                   rowlength );
+    SetPixelStore( GL_UNPACK_SKIP_PIXELS, &_glfw.unpack.skippixels,
+                   skippixels );
+    SetPixelStore( GL_UNPACK_SKIP_ROWS, &_glfw.unpack.skiprows, skiprows );
+    if( ( rowlength * bpp ) % _glfw.unpack.alignment )
+    {
+        SetPixelStore( GL_UNPACK_ALIGNMENT, &_glfw.unpack.alignment, 1 );
     }
 
-    // Set unpack alignment to one byte
-    _glfw.glGetIntegerv( GL_UNPACK_ALIGNMENT, &UnpackAlignment );
-    _glfw.glPixelStorei( GL_UNPACK_ALIGNMENT, 1 );
+    _GLFW_BEGIN_STAGE( timer );
+    _glfw.glTexSubImage2D( GL_TEXTURE_2D, level, x, y, width, height,
+        upload->format, upload->type, (void*) data );
+    _GLFW_END_STAGE( timer, GLFW_STAGE_UPLOAD,
+                     (uint64_t) width * height * bpp );
 
-    // Should we use automatic mipmap generation?
-    AutoGen = ( flags & GLFW_BUILD_MIPMAPS_BIT ) &&
-              glfwExtensionSupported("GL_SGIS_generate_mipmap");
+    _glfwFree( converted, GLFW_MEMORY_CONVERT );
 
-    // Enable automatic mipmap generation
-    if( AutoGen )
+    return GL_TRUE;
+}
+
+
+//========================================================================
+// Upload a changed rectangle of an image to the bound texture, which was
+// loaded from that image with the same flags.  Only the mipmap tiles
+// covering the rectangle are uploaded
+//========================================================================
+
+GLFWAPI int  GLFWAPIENTRY glfwUpdateTextureImage2D( const GLFWimage *img,
+    int x, int y, int width, int height, int flags )
+{
+    _GLFW_COUNT_CALL( glfwUpdateTextureImage2D );
+    _GLFW_TRACE_SCOPE( "glfwUpdateTextureImage2D" );
+    _GLFWpixelstore saved;
+    _GLFWuploadformat upload;
+    _GLFWstagetimer timer;
+    signed char map[ 4 ], *swizzle;
+    unsigned char *data, *level0, *scratch;
+    int     w, h, bpp, n, bias, x0, y0, x1, y1, mipmaps, ok;
+    int     AutoGen, AutoGenSet;
+
+    // Is GLFW initialized?
+    if( !_glfw.window )
     {
-        _glfw.glGetTexParameteriv( GL_TEXTURE_2D, GL_GENERATE_MIPMAP_SGIS,
-            &GenMipMap );
-        _glfw.glTexParameteri( GL_TEXTURE_2D, GL_GENERATE_MIPMAP_SGIS,
-            GL_TRUE );
+        return GL_FALSE;
     }
 
-    // Format specification is different for OpenGL 1.0
-    if( glMajor == 1 && glMinor == 0 )
+    // Clip the rectangle to the image
+    if( x < 0 )
     {
-        format = img->BytesPerPixel;
+        width += x;
+        x = 0;
     }
-    else
+    if( y < 0 )
     {
-        format = img->Format;
+        height += y;
+        y = 0;
+    }
+    width  = x + width > img->Width ? img->Width - x : width;
+    height = y + height > img->Height ? img->Height - y : height;
+    if( width <= 0 || height <= 0 )
+    {
+        return GL_TRUE;
+    }
+
+    // Without GL_ARB_texture_non_power_of_two, such an image was rescaled
+    // when it was loaded
+    if( !_glfw.npottextures &&
+        ( NextPowerOfTwo( img->Width ) != img->Width ||
+          NextPowerOfTwo( img->Height ) != img->Height ) )
+    {
+        return GL_FALSE;
+    }
+
+    // Same pixel layout as when the texture was loaded
+    GetUploadFormat( img->Format, _glfw.glmajor, _glfw.glminor, &upload );
+    bpp = img->BytesPerPixel;
+    swizzle = NULL;
+    if( !GetPackedUpload( img, _GLFW_ALPHA_UNKNOWN, &upload ) && bpp != 2 &&
+        GetUploadSwizzle( img->Format, upload.format, map ) )
+    {
+        swizzle = map;
+    }
+
+    SaveUnpackState( &saved );
+
+    // A texture still being streamed in gets its remaining levels first
+    if( _glfw.texturestreams )
+    {
+        FinishTextureStream( _glfwGetGLBinding( GL_TEXTURE_2D ) );
+    }
+
+    // Levels dropped by the texture LOD bias
+    w = img->Width;
+    h = img->Height;
+    for( bias = 0; bias < _glfw.texturelodbias && ( w > 1 || h > 1 );
+         bias ++ )
+    {
+        w = w > 1 ? w / 2 : 1;
+        h = h > 1 ? h / 2 : 1;
     }
 
-    // Upload to texture memeory
-    level = 0;
-    do
+    // Mipmaps are either generated by the driver, or by us
+    AutoGen = ( flags & GLFW_BUILD_MIPMAPS_BIT ) && _glfw.autogenmipmap;
+    mipmaps = ( flags & GLFW_BUILD_MIPMAPS_BIT ) && !AutoGen;
+    AutoGenSet = AutoGen && EnableAutoMipmaps();
+
+    level0  = NULL;
+    scratch = NULL;
+    if( bias == 0 && !mipmaps )
+    {
+        // Only level 0 changed, upload it from the caller's image
+        ok = UploadSubImage( 0, x, y, width, height, img->Data, img->Width,
+                             bpp, &upload, swizzle );
+    }
+    else
     {
-        // Upload this mipmap level
-        _glfw.glTexImage2D( GL_TEXTURE_2D, level, format,
-            img->Width, img->Height, 0, format,
-            GL_UNSIGNED_BYTE, (void*) img->Data );
+        // Each pixel of the smaller levels is built from a block of the
+        // image as large as the level is small, so they are halved again
+        // from the whole image, and only their dirty tiles are uploaded.
+        // Conversion happens first, as when the texture was loaded
+        w    = img->Width;
+        h    = img->Height;
+        data = img->Data;
+        ok   = GL_TRUE;
+        if( ( bpp == 2 && upload.type == GL_UNSIGNED_BYTE ) || swizzle )
+        {
+            level0 = (unsigned char *) _glfwMalloc( w * h * 4,
+                                                    GLFW_MEMORY_CONVERT );
+            if( level0 == NULL )
+            {
+                ok = GL_FALSE;
+            }
+            else if( bpp == 2 )
+            {
+                UnpackImage( data, level0, w, h, w * 4, 4 );
+            }
+            else
+            {
+                _GLFW_BEGIN_STAGE( timer );
+                _glfwSwizzlePixels( data, level0, (long) w * h, bpp,
+                                    swizzle );
+                _GLFW_END_STAGE( timer, GLFW_STAGE_CONVERT,
+                                 (uint64_t) w * h * 4 );
+            }
+            data    = level0;
+            bpp     = 4;
+            swizzle = NULL;
+        }
+
+        if( ok )
+        {
+            scratch = (unsigned char *) _glfwMalloc( (w > 1 ? w / 2 : 1) *
+                (h > 1 ? h / 2 : 1) * bpp, GLFW_MEMORY_RESCALE );
+            ok = scratch != NULL;
+        }
 
-        // Build next mipmap level manually, if required
-        if( ( flags & GLFW_BUILD_MIPMAPS_BIT ) && !AutoGen )
+        x0 = x;
+        y0 = y;
+        x1 = x + width - 1;
+        y1 = y + height - 1;
+        for( n = 0; ok; n ++ )
         {
-            level = HalveImage( img->Data, &img->Width,
-                        &img->Height, img->BytesPerPixel ) ?
-                    level + 1 : 0;
+            // Odd rows and columns are dropped when halving, which may
+            // leave nothing of the rectangle in this level
+            x1 = x1 < w ? x1 : w - 1;
+            y1 = y1 < h ? y1 : h - 1;
+            if( n >= bias && x0 <= x1 && y0 <= y1 )
+            {
+                ok = UploadSubImage( n - bias, x0, y0, x1 - x0 + 1,
+                                     y1 - y0 + 1, data, w, bpp, &upload,
+                                     NULL );
+            }
+
+            if( ( n >= bias && !mipmaps ) ||
+                !HalveImage( data, scratch, &w, &h, bpp ) )
+            {
+                break;
+            }
+            data = scratch;
+            x0 >>= 1;
+            y0 >>= 1;
+            x1 >>= 1;
+            y1 >>= 1;
         }
     }
-    while( level != 0 );
 
-    // Restore old automatic mipmap generation state
-    if( AutoGen )
+    if( AutoGenSet )
     {
         _glfw.glTexParameteri( GL_TEXTURE_2D, GL_GENERATE_MIPMAP_SGIS,
-            GenMipMap );
+            GL_FALSE );
     }
 
-    // Restore old unpack alignment
-    _glfw.glPixelStorei( GL_UNPACK_ALIGNMENT, UnpackAlignment );
+    RestoreUnpackState( &saved );
 
-    return GL_TRUE;
-}
+    _glfwFree( scratch, GLFW_MEMORY_RESCALE );
+    _glfwFree( level0, GLFW_MEMORY_CONVERT );
 
+    return ok;
+}
@@ -28,6 +28,7 @@
 #include "internal.h"
 
 #include <dlfcn.h>
+#include <stdlib.h>
 
 _GLFWlibrary _glfw = { 0 };
 
@@ -35,16 +36,31 @@ _GLFWlibrary _glfw = { 0 };
 
 GLFWAPI int  GLFWAPIENTRY glfwInit(void)
 {
+#if !defined(_GLFW_DIRECT)
     if (!_glfw.handle)
     {
-        _glfw.handle = dlopen("libglfw.so.3", RTLD_LAZY);
+        const char* name = getenv("GLFW2TO3_GLFW3_LIBRARY");
+        if (!name)
+        {
+            name = "libglfw.so.3";
+        }
+
+        // Kept loaded by glfwTerminate(), games may have bound functions
+        // forwarded straight to it
+        _glfw.handle = dlopen(name, RTLD_LAZY | RTLD_NODELETE);
         if (!_glfw.handle)
         {
             return GL_FALSE;
         }
     }
+#endif
 
-    if (!_glfw.gl_handle)
+    const char* gl_name = getenv("GLFW2TO3_GL_LIBRARY");
+    if (!_glfw.gl_handle && gl_name)
+    {
+        _glfw.gl_handle = dlopen(gl_name, RTLD_LAZY);
+    }
+    else if (!_glfw.gl_handle)
     {
         _glfw.gl_handle = dlopen("libOpenGL.so.0", RTLD_LAZY);
         if (!_glfw.gl_handle)
@@ -53,6 +69,7 @@ GLFWAPI int  GLFWAPIENTRY glfwInit(void)
         }
     }
 
+#if !defined(_GLFW_DIRECT)
 #define DLSYM(sym) do { \
     _glfw.sym = (PFN_##sym)dlsym(_glfw.handle, #sym); \
     if (!_glfw.sym) \
@@ -101,12 +118,40 @@ GLFWAPI int  GLFWAPIENTRY glfwInit(void)
     DLSYM(glfwGetJoystickButtons);
 
 #undef DLSYM
+#endif
+
+    _glfwInitStats();
+    _glfwInitTrace();
+    _glfwInitGLCalls();
+
+    const char* lodbias = getenv("GLFW2TO3_TEXTURE_LOD_BIAS");
+    if (lodbias)
+    {
+        glfwSetTextureLodBias(atoi(lodbias));
+    }
+
+    if (getenv("GLFW2TO3_PACKED_TEXTURES"))
+    {
+        glfwEnable(GLFW_PACKED_TEXTURES);
+    }
 
-    return _glfw.glfwInit();
+    const char* streaming = getenv("GLFW2TO3_TEXTURE_STREAMING");
+    if (streaming)
+    {
+        glfwSetTextureStreamBudget(atol(streaming));
+    }
+
+    return _GLFW3(glfwInit)();
 }
 
 GLFWAPI void GLFWAPIENTRY glfwTerminate(void)
 {
+    _glfwDestroyTextureStreams();
+    _glfwFlushProcCache();
+    _glfwTerminateStats();
+    _glfwTerminateTrace();
+    _glfwTerminateGLCalls();
+
     if (_glfw.handle)
     {
         dlclose(_glfw.handle);
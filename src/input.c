@@ -31,42 +31,53 @@
 
 /* Input handling */
 
-GLFWAPI void GLFWAPIENTRY glfwPollEvents(void)
+static void pollEvents(void)
 {
-    _glfw.glfwPollEvents();
+    _GLFW_COUNT_CALL(glfwPollEvents);
+    _GLFW_TRACE_SCOPE("glfwPollEvents");
+    _GLFW3(glfwPollEvents)();
 }
 
-GLFWAPI void GLFWAPIENTRY glfwWaitEvents(void)
+_GLFW_FORWARD(glfwPollEvents, pollEvents);
+
+static void waitEvents(void)
 {
-    _glfw.glfwWaitEvents();
+    _GLFW_COUNT_CALL(glfwWaitEvents);
+    _GLFW_TRACE_SCOPE("glfwWaitEvents");
+    _GLFW3(glfwWaitEvents)();
 }
 
+_GLFW_FORWARD(glfwWaitEvents, waitEvents);
+
 GLFWAPI int  GLFWAPIENTRY glfwGetKey(int key)
 {
+    _GLFW_COUNT_CALL(glfwGetKey);
     if (!_glfw.window)
     {
         return GLFW_RELEASE;
     }
-    return _glfw.glfwGetKey(_glfw.window, key);
+    return _GLFW3(glfwGetKey)(_glfw.window, key);
 }
 
 GLFWAPI int  GLFWAPIENTRY glfwGetMouseButton(int button)
 {
+    _GLFW_COUNT_CALL(glfwGetMouseButton);
     if (!_glfw.window)
     {
         return GLFW_RELEASE;
     }
-    return _glfw.glfwGetMouseButton(_glfw.window, button);
+    return _GLFW3(glfwGetMouseButton)(_glfw.window, button);
 }
 
 GLFWAPI void GLFWAPIENTRY glfwGetMousePos(int *xpos, int *ypos)
 {
+    _GLFW_COUNT_CALL(glfwGetMousePos);
     if (!_glfw.window)
     {
         return;
     }
     double xpos_double, ypos_double;
-    _glfw.glfwGetCursorPos(_glfw.window, &xpos_double, &ypos_double);
+    _GLFW3(glfwGetCursorPos)(_glfw.window, &xpos_double, &ypos_double);
     if (xpos)
     {
         *xpos = (int)xpos_double;
@@ -79,25 +90,29 @@ GLFWAPI void GLFWAPIENTRY glfwGetMousePos(int *xpos, int *ypos)
 
 GLFWAPI void GLFWAPIENTRY glfwSetMousePos(int xpos, int ypos)
 {
+    _GLFW_COUNT_CALL(glfwSetMousePos);
     if (_glfw.window)
     {
-        _glfw.glfwSetCursorPos(_glfw.window, (double)xpos, (double)ypos);
+        _GLFW3(glfwSetCursorPos)(_glfw.window, (double)xpos, (double)ypos);
     }
 }
 
 GLFWAPI int  GLFWAPIENTRY glfwGetMouseWheel(void)
 {
+    _GLFW_COUNT_CALL(glfwGetMouseWheel);
     // TODO: implement.
     return 0;
 }
 
 GLFWAPI void GLFWAPIENTRY glfwSetMouseWheel(int pos)
 {
+    _GLFW_COUNT_CALL(glfwSetMouseWheel);
     fprintf(stderr, "Unimplemented glfwSetMouseWheel(%d)\n", pos);
 }
 
 static void key_cbfun3(GLFWwindow* window, int key, int scancode, int action, int mods)
 {
+    _GLFW_TRACE_SCOPE("key_cbfun3");
     (void)window;
     (void)scancode;
     (void)mods;
@@ -134,12 +149,14 @@ static void key_cbfun3(GLFWwindow* window, int key, int scancode, int action, in
 
 static void char_cbfun3(GLFWwindow* window, unsigned int codepoint)
 {
+    _GLFW_TRACE_SCOPE("char_cbfun3");
     (void)window;
     _glfw.charfun((int)codepoint, GLFW_PRESS);
 }
 
 static void mousebutton_cbfun3(GLFWwindow* window, int button, int action, int mods)
 {
+    _GLFW_TRACE_SCOPE("mousebutton_cbfun3");
     (void)window;
     (void)mods;
     _glfw.mousebuttonfun(button, action);
@@ -147,12 +164,14 @@ static void mousebutton_cbfun3(GLFWwindow* window, int button, int action, int m
 
 static void cursorpos_cbfun3(GLFWwindow* window, double xpos, double ypos)
 {
+    _GLFW_TRACE_SCOPE("cursorpos_cbfun3");
     (void)window;
     _glfw.mouseposfun((int)xpos, (int)ypos);
 }
 
 static void scroll_cbfun3(GLFWwindow* window, double xoffset, double yoffset)
 {
+    _GLFW_TRACE_SCOPE("scroll_cbfun3");
     (void)window;
     (void)xoffset;
     _glfw.mousewheelfun((int)yoffset);
@@ -160,45 +179,50 @@ static void scroll_cbfun3(GLFWwindow* window, double xoffset, double yoffset)
 
 GLFWAPI void GLFWAPIENTRY glfwSetKeyCallback(GLFWkeyfun cbfun)
 {
+    _GLFW_COUNT_CALL(glfwSetKeyCallback);
     if (_glfw.window)
     {
         _glfw.keyfun = cbfun;
-        _glfw.glfwSetKeyCallback(_glfw.window, key_cbfun3);
+        _GLFW3(glfwSetKeyCallback)(_glfw.window, key_cbfun3);
     }
 }
 
 GLFWAPI void GLFWAPIENTRY glfwSetCharCallback(GLFWcharfun cbfun)
 {
+    _GLFW_COUNT_CALL(glfwSetCharCallback);
     if (_glfw.window)
     {
         _glfw.charfun = cbfun;
-        _glfw.glfwSetCharCallback(_glfw.window, char_cbfun3);
+        _GLFW3(glfwSetCharCallback)(_glfw.window, char_cbfun3);
     }
 }
 
 GLFWAPI void GLFWAPIENTRY glfwSetMouseButtonCallback(GLFWmousebuttonfun cbfun)
 {
+    _GLFW_COUNT_CALL(glfwSetMouseButtonCallback);
     if (_glfw.window)
     {
         _glfw.mousebuttonfun = cbfun;
-        _glfw.glfwSetMouseButtonCallback(_glfw.window, mousebutton_cbfun3);
+        _GLFW3(glfwSetMouseButtonCallback)(_glfw.window, mousebutton_cbfun3);
     }
 }
 
 GLFWAPI void GLFWAPIENTRY glfwSetMousePosCallback(GLFWmouseposfun cbfun)
 {
+    _GLFW_COUNT_CALL(glfwSetMousePosCallback);
     if (_glfw.window)
     {
         _glfw.mouseposfun = cbfun;
-        _glfw.glfwSetCursorPosCallback(_glfw.window, cursorpos_cbfun3);
+        _GLFW3(glfwSetCursorPosCallback)(_glfw.window, cursorpos_cbfun3);
     }
 }
 
 GLFWAPI void GLFWAPIENTRY glfwSetMouseWheelCallback(GLFWmousewheelfun cbfun)
 {
+    _GLFW_COUNT_CALL(glfwSetMouseWheelCallback);
     if (_glfw.window)
     {
         _glfw.mousewheelfun = cbfun;
-        _glfw.glfwSetScrollCallback(_glfw.window, scroll_cbfun3);
+        _GLFW3(glfwSetScrollCallback)(_glfw.window, scroll_cbfun3);
     }
 }
@@ -27,6 +27,9 @@
 
 #include "GL/glfw.h"
 
+#include <stddef.h>
+#include <stdint.h>
+
 typedef struct GLFWwindow GLFWwindow;
 typedef struct GLFWmonitor GLFWmonitor;
 
@@ -76,14 +79,59 @@ typedef const unsigned char* (* PFN_glfwGetJoystickButtons)(int, int* count);
 
 typedef const GLubyte* (* PFN_glGetString)(GLenum);
 typedef void (* PFN_glPixelStorei)(GLenum, GLint);
-typedef void (* PFN_glGetTexParameteriv)(GLenum, GLenum, GLint*);
 typedef void (* PFN_glGetIntegerv)(GLenum, GLint*);
 typedef void (* PFN_glTexParameteri)(GLenum, GLenum, GLint);
+typedef void (* PFN_glGetTexParameteriv)(GLenum, GLenum, GLint*);
 typedef void (* PFN_glTexImage2D)(GLenum, GLint, GLint, GLsizei, GLsizei, GLint, GLenum, GLenum, const GLvoid*);
+typedef void (* PFN_glTexSubImage2D)(GLenum, GLint, GLint, GLint, GLsizei, GLsizei, GLenum, GLenum, const GLvoid*);
+typedef void (* PFN_glGetInternalformativ)(GLenum, GLenum, GLenum, GLsizei, GLint*);
+typedef GLboolean (* PFN_glIsEnabled)(GLenum);
+typedef void (* PFN_glEnable)(GLenum);
+typedef void (* PFN_glDisable)(GLenum);
+typedef void (* PFN_glGenTextures)(GLsizei, GLuint*);
+typedef void (* PFN_glDeleteTextures)(GLsizei, const GLuint*);
+typedef void (* PFN_glBindTexture)(GLenum, GLuint);
+typedef void (* PFN_glCopyTexImage2D)(GLenum, GLint, GLenum, GLint, GLint, GLsizei, GLsizei, GLint);
+typedef void (* PFN_glGenFramebuffers)(GLsizei, GLuint*);
+typedef void (* PFN_glDeleteFramebuffers)(GLsizei, const GLuint*);
+typedef void (* PFN_glBindFramebuffer)(GLenum, GLuint);
+typedef void (* PFN_glFramebufferTexture2D)(GLenum, GLenum, GLenum, GLuint, GLint);
+typedef void (* PFN_glFramebufferRenderbuffer)(GLenum, GLenum, GLenum, GLuint);
+typedef GLenum (* PFN_glCheckFramebufferStatus)(GLenum);
+typedef void (* PFN_glGenRenderbuffers)(GLsizei, GLuint*);
+typedef void (* PFN_glDeleteRenderbuffers)(GLsizei, const GLuint*);
+typedef void (* PFN_glBindRenderbuffer)(GLenum, GLuint);
+typedef void (* PFN_glRenderbufferStorage)(GLenum, GLenum, GLsizei, GLsizei);
+typedef void (* PFN_glBlitFramebuffer)(GLint, GLint, GLint, GLint, GLint, GLint, GLint, GLint, GLbitfield, GLenum);
+typedef void (* PFN_glGenerateMipmap)(GLenum);
 
 #define GL_FALSE 0
 #define GL_TRUE 1
 
+// Swizzle map entry filling the channel with 255 instead of a source channel
+#define _GLFW_SWIZZLE_ONE -1
+
+// Pixel layout used to upload images with a given base format
+typedef struct _GLFWuploadformat {
+    GLenum format;
+    GLenum type;
+} _GLFWuploadformat;
+
+// Mipmap levels of a texture still to be uploaded
+typedef struct _GLFWtexturestream _GLFWtexturestream;
+
+// Entry point returned by glfwGetProcAddress() for the current context
+typedef struct _GLFWprocentry _GLFWprocentry;
+
+// Unpack state used by image uploads
+typedef struct _GLFWpixelstore {
+    GLint alignment;
+    GLint rowlength;
+    GLint skiprows;
+    GLint skippixels;
+    GLint swapbytes;
+} _GLFWpixelstore;
+
 typedef struct _GLFWlibrary {
     void* handle;
     void* gl_handle;
@@ -139,12 +187,399 @@ typedef struct _GLFWlibrary {
 
     PFN_glGetString         glGetString;
     PFN_glPixelStorei       glPixelStorei;
-    PFN_glGetTexParameteriv glGetTexParameteriv;
     PFN_glGetIntegerv       glGetIntegerv;
     PFN_glTexParameteri     glTexParameteri;
+    PFN_glGetTexParameteriv glGetTexParameteriv;
     PFN_glTexImage2D        glTexImage2D;
+    PFN_glTexSubImage2D     glTexSubImage2D;
+    PFN_glGetInternalformativ glGetInternalformativ;
+
+    // Used to rescale images on the GPU, only loaded when fboblit is set
+    PFN_glIsEnabled         glIsEnabled;
+    PFN_glEnable            glEnable;
+    PFN_glDisable           glDisable;
+    PFN_glGenTextures       glGenTextures;
+    PFN_glDeleteTextures    glDeleteTextures;
+    PFN_glBindTexture       glBindTexture;
+    PFN_glCopyTexImage2D    glCopyTexImage2D;
+    PFN_glGenFramebuffers   glGenFramebuffers;
+    PFN_glDeleteFramebuffers glDeleteFramebuffers;
+    PFN_glBindFramebuffer   glBindFramebuffer;
+    PFN_glFramebufferTexture2D glFramebufferTexture2D;
+    PFN_glFramebufferRenderbuffer glFramebufferRenderbuffer;
+    PFN_glCheckFramebufferStatus glCheckFramebufferStatus;
+    PFN_glGenRenderbuffers  glGenRenderbuffers;
+    PFN_glDeleteRenderbuffers glDeleteRenderbuffers;
+    PFN_glBindRenderbuffer  glBindRenderbuffer;
+    PFN_glRenderbufferStorage glRenderbufferStorage;
+    PFN_glBlitFramebuffer   glBlitFramebuffer;
+    PFN_glGenerateMipmap    glGenerateMipmap;
+
+    // For GL_LUMINANCE, GL_ALPHA, GL_RGB and GL_RGBA images, negotiated
+    // lazily and reset whenever a new context is created
+    _GLFWuploadformat uploadformats[4];
+
+    // Shadow of the unpack state of the context: set to the OpenGL defaults
+    // when a context is created, updated on every change we make or the
+    // wrappers see, and read back from the driver by uploads when they
+    // don't see them all, or by glfwSyncPixelStore
+    _GLFWpixelstore unpack;
+
+    // Capabilities of the context, queried once when it is created
+    int glmajor, glminor;
+    int autogenmipmap;
+    int npottextures;
+    int fboblit;
+    // Scratch objects images are rescaled through, created by the first
+    // blit, and the largest images they take
+    GLuint blittexture, blitrenderbuffer, blitfbo[2];
+    GLint blitmaxsource, blitmaxsize;
+    int texturestreaming;
 
     uint64_t timer_base;
+
+    int imagestats;
+    int callstats;
+    int memorystats;
+    int tracing;
+    int glstats;
+    int glfilter;
+    int glbatch;
+    // Whether the OpenGL wrappers shadow the state, for the filter or for
+    // texture streaming to know the bound texture without querying it
+    int glshadow;
+    int texturelodbias;
+
+    // Quantize RGB and RGBA textures to 16-bit layouts when uploading them
+    int packedtextures;
+
+    // Textures whose largest mipmap levels are uploaded over the next
+    // frames, within a per-frame budget in bytes
+    long texturestreambudget;
+    _GLFWtexturestream* texturestreams;
+    // Set while their levels are uploaded, which the wrappers then don't
+    // take for the game loading them again
+    int texturestreamupload;
+
+    // Open addressing hash table of the entry points already looked up
+    _GLFWprocentry* procs;
+    int procsize;
+    int proccount;
+    long prochits;
+    long procmisses;
 } _GLFWlibrary;
 
 extern _GLFWlibrary _glfw;
+
+// Calls into GLFW 3, through the pointers resolved by glfwInit(), or
+// directly when a static GLFW 3 is linked in with its symbols renamed
+#if defined(_GLFW_DIRECT)
+#define _GLFW3(sym) _glfw3_##sym
+#define _GLFW3_EXTERN(sym) extern __typeof__(*(PFN_##sym) 0) _glfw3_##sym
+_GLFW3_EXTERN(glfwInit);
+_GLFW3_EXTERN(glfwTerminate);
+_GLFW3_EXTERN(glfwCreateWindow);
+_GLFW3_EXTERN(glfwDestroyWindow);
+_GLFW3_EXTERN(glfwIconifyWindow);
+_GLFW3_EXTERN(glfwRestoreWindow);
+_GLFW3_EXTERN(glfwMakeContextCurrent);
+_GLFW3_EXTERN(glfwWindowHint);
+_GLFW3_EXTERN(glfwSetWindowTitle);
+_GLFW3_EXTERN(glfwSetWindowSizeCallback);
+_GLFW3_EXTERN(glfwSetWindowCloseCallback);
+_GLFW3_EXTERN(glfwSetWindowRefreshCallback);
+_GLFW3_EXTERN(glfwSetKeyCallback);
+_GLFW3_EXTERN(glfwSetCharCallback);
+_GLFW3_EXTERN(glfwGetMouseButton);
+_GLFW3_EXTERN(glfwSetMouseButtonCallback);
+_GLFW3_EXTERN(glfwSetCursorPosCallback);
+_GLFW3_EXTERN(glfwSetScrollCallback);
+_GLFW3_EXTERN(glfwGetFramebufferSize);
+_GLFW3_EXTERN(glfwGetWindowContentScale);
+_GLFW3_EXTERN(glfwSetWindowSize);
+_GLFW3_EXTERN(glfwGetWindowAttrib);
+_GLFW3_EXTERN(glfwSetWindowPos);
+_GLFW3_EXTERN(glfwSwapBuffers);
+_GLFW3_EXTERN(glfwSwapInterval);
+_GLFW3_EXTERN(glfwExtensionSupported);
+_GLFW3_EXTERN(glfwGetProcAddress);
+_GLFW3_EXTERN(glfwGetPrimaryMonitor);
+_GLFW3_EXTERN(glfwGetVideoModes);
+_GLFW3_EXTERN(glfwGetVideoMode);
+_GLFW3_EXTERN(glfwPollEvents);
+_GLFW3_EXTERN(glfwWaitEvents);
+_GLFW3_EXTERN(glfwGetKey);
+_GLFW3_EXTERN(glfwGetCursorPos);
+_GLFW3_EXTERN(glfwSetCursorPos);
+_GLFW3_EXTERN(glfwJoystickPresent);
+_GLFW3_EXTERN(glfwGetJoystickAxes);
+_GLFW3_EXTERN(glfwGetJoystickButtons);
+#undef _GLFW3_EXTERN
+#else
+#define _GLFW3(sym) _glfw.sym
+#endif
+
+// Exports a GLFW 2 function which only forwards to its GLFW 3 counterpart,
+// given a static thunk doing so.  It is an IFUNC in the dlopen mode, so that
+// games binding it once GLFW 3 is loaded call straight into it unless calls
+// are counted or traced, and an alias of the thunk otherwise.  Resolvers can
+// run before the sanitizers are set up
+#if !defined(_GLFW_DIRECT) && defined(__ELF__) && defined(__GNUC__)
+#define _GLFW_FORWARD(sym, thunk) \
+    __attribute__((no_sanitize_address)) \
+    static PFN_##sym resolve_##sym(void) \
+    { \
+        return _glfw.handle && !_glfw.callstats && !_glfw.tracing ? \
+               _glfw.sym : (PFN_##sym) thunk; \
+    } \
+    extern __typeof__(sym) sym __attribute__((ifunc("resolve_" #sym)))
+#else
+#define _GLFW_FORWARD(sym, thunk) \
+    extern __typeof__(sym) sym __attribute__((alias(#thunk)))
+#endif
+
+// Timing of one run of an image pipeline stage
+typedef struct _GLFWstagetimer {
+    uint64_t start;
+    uint64_t io;
+} _GLFWstagetimer;
+
+// These only cost a branch when image statistics are disabled
+#define _GLFW_BEGIN_STAGE(timer) do { \
+    (timer).start = 0; \
+    if (_glfw.imagestats) \
+    { \
+        _glfwBeginStage(&(timer)); \
+    } \
+} while (0)
+
+#define _GLFW_END_STAGE(timer, stage, bytes) do { \
+    if ((timer).start) \
+    { \
+        _glfwEndStage(&(timer), (stage), (bytes)); \
+    } \
+} while (0)
+
+// Exported functions whose calls are counted with GLFW2TO3_STATS
+#define _GLFW_ENTRY_POINTS(F) \
+    F(glfwOpenWindow) \
+    F(glfwOpenWindowHint) \
+    F(glfwCloseWindow) \
+    F(glfwSetWindowTitle) \
+    F(glfwGetWindowSize) \
+    F(glfwSetWindowSize) \
+    F(glfwSetWindowPos) \
+    F(glfwIconifyWindow) \
+    F(glfwRestoreWindow) \
+    F(glfwSwapBuffers) \
+    F(glfwSwapInterval) \
+    F(glfwGetWindowParam) \
+    F(glfwSetWindowSizeCallback) \
+    F(glfwSetWindowCloseCallback) \
+    F(glfwSetWindowRefreshCallback) \
+    F(glfwPollEvents) \
+    F(glfwWaitEvents) \
+    F(glfwGetKey) \
+    F(glfwGetMouseButton) \
+    F(glfwGetMousePos) \
+    F(glfwSetMousePos) \
+    F(glfwGetMouseWheel) \
+    F(glfwSetMouseWheel) \
+    F(glfwSetKeyCallback) \
+    F(glfwSetCharCallback) \
+    F(glfwSetMouseButtonCallback) \
+    F(glfwSetMousePosCallback) \
+    F(glfwSetMouseWheelCallback) \
+    F(glfwGetJoystickParam) \
+    F(glfwGetJoystickPos) \
+    F(glfwGetJoystickButtons) \
+    F(glfwGetTime) \
+    F(glfwSetTime) \
+    F(glfwSleep) \
+    F(glfwCreateThread) \
+    F(glfwDestroyThread) \
+    F(glfwWaitThread) \
+    F(glfwGetThreadID) \
+    F(glfwCreateMutex) \
+    F(glfwDestroyMutex) \
+    F(glfwLockMutex) \
+    F(glfwUnlockMutex) \
+    F(glfwCreateCond) \
+    F(glfwDestroyCond) \
+    F(glfwWaitCond) \
+    F(glfwSignalCond) \
+    F(glfwBroadcastCond) \
+    F(glfwGetNumberOfProcessors) \
+    F(glfwReadImage) \
+    F(glfwReadMemoryImage) \
+    F(glfwReadImageInto) \
+    F(glfwReadMemoryImageInto) \
+    F(glfwReadImages) \
+    F(glfwReadMemoryImages) \
+    F(glfwFreeImage) \
+    F(glfwWriteImage) \
+    F(glfwWriteMemoryImage) \
+    F(glfwSetTextureLodBias) \
+    F(glfwSetTextureStreamBudget) \
+    F(glfwSyncPixelStore) \
+    F(glfwLoadTextureImage2D) \
+    F(glfwLoadTexture2D) \
+    F(glfwLoadMemoryTexture2D) \
+    F(glfwUpdateTextureImage2D) \
+    F(glfwExtensionSupported) \
+    F(glfwGetProcAddress) \
+    F(glfwGetProcAddressStats) \
+    F(glfwSyncGLState) \
+    F(glfwGetGLVersion)
+
+enum {
+#define _GLFW_CALL_ID(name) _GLFW_CALL_##name,
+    _GLFW_ENTRY_POINTS(_GLFW_CALL_ID)
+#undef _GLFW_CALL_ID
+    _GLFW_CALL_COUNT
+};
+
+// Number of (log2 of nanoseconds) buckets in call latency histograms
+#define _GLFW_CALL_BUCKETS 32
+
+typedef struct _GLFWcalltimer {
+    uint64_t start;
+    int call;
+} _GLFWcalltimer;
+
+void _glfwEndCall(const _GLFWcalltimer* timer);
+
+static inline void _glfwEndCallTimer(const _GLFWcalltimer* timer)
+{
+    if (timer->start)
+    {
+        _glfwEndCall(timer);
+    }
+}
+
+// Times the rest of the calling function, which costs a branch on entry and
+// one on return when call statistics are disabled
+#define _GLFW_COUNT_CALL(name) \
+    _GLFWcalltimer _glfwCallTimer __attribute__((cleanup(_glfwEndCallTimer))) = { \
+        __builtin_expect(_glfw.callstats, 0) ? _glfwGetTimerValue() : 0, \
+        _GLFW_CALL_##name \
+    }
+
+// Span of the frame timeline, recorded with GLFW2TO3_TRACE
+typedef struct _GLFWtracespan {
+    uint64_t start;
+    const char* name;
+} _GLFWtracespan;
+
+void _glfwEndTraceSpan(const _GLFWtracespan* span);
+
+static inline void _glfwEndTraceScope(const _GLFWtracespan* span)
+{
+    if (span->start)
+    {
+        _glfwEndTraceSpan(span);
+    }
+}
+
+// Records the rest of the calling scope in the trace, name must be static
+#define _GLFW_TRACE_SCOPE(name) \
+    _GLFWtracespan _glfwTraceSpan __attribute__((cleanup(_glfwEndTraceScope))) = { \
+        __builtin_expect(_glfw.tracing, 0) ? _glfwGetTimerValue() : 0, \
+        (name) \
+    }
+
+void _glfwInitTrace(void);
+void _glfwTerminateTrace(void);
+
+uint64_t _glfwGetTimerValue(void);
+
+void _glfwInitStats(void);
+void _glfwTerminateStats(void);
+void _glfwBeginStage(_GLFWstagetimer* timer);
+void _glfwEndStage(_GLFWstagetimer* timer, int stage, uint64_t bytes);
+
+// Accounted allocations, category being one of GLFW_MEMORY_*
+void* _glfwMalloc(size_t size, int category);
+void* _glfwCalloc(size_t count, size_t size, int category);
+void* _glfwRealloc(void* ptr, size_t size, int category);
+void _glfwFree(void* ptr, int category);
+
+// Image data returned to the caller, until passed to glfwFreeImage, borrowed
+// being set for buffers the caller owns.  Untracking tells who owns the data
+#define _GLFW_IMAGE_UNTRACKED 0
+#define _GLFW_IMAGE_OWNED     1
+#define _GLFW_IMAGE_BORROWED  2
+void _glfwTrackImage(const GLFWimage* img, int borrowed);
+int _glfwUntrackImage(const void* data);
+
+// Decompression of image streams, the codecs are only detected when built in
+#define _GLFW_CODEC_NONE  0
+#define _GLFW_CODEC_GZIP  1
+#define _GLFW_CODEC_ZSTD  2
+#define _GLFW_CODEC_LZ4   3
+#define _GLFW_CODEC_COUNT 4
+
+typedef struct _GLFWdecoder _GLFWdecoder;
+
+// Reads compressed bytes from the underlying file or memory block
+typedef long (*_GLFWrawreadfun)(void* user, void* data, long size);
+
+int _glfwDetectCompression(const unsigned char* magic, long size);
+const char* _glfwGetCompressionSuffix(int codec);
+_GLFWdecoder* _glfwCreateDecoder(int codec);
+long _glfwDecoderRead(_GLFWdecoder* decoder, void* data, long size,
+                      _GLFWrawreadfun read, void* user);
+void _glfwResetDecoder(_GLFWdecoder* decoder);
+void _glfwDestroyDecoder(_GLFWdecoder* decoder);
+
+// PNG decoding, the decoder is only available when built with zlib
+typedef struct _GLFWpng _GLFWpng;
+
+// Receives each decoded row, from the top of the image
+typedef void (*_GLFWpngrowfun)(void* user, int y, const unsigned char* row);
+
+int _glfwIsPNG(const unsigned char* magic, long size);
+_GLFWpng* _glfwReadPNGHeader(_GLFWrawreadfun read, void* user);
+void _glfwGetPNGSize(const _GLFWpng* png, int* width, int* height, int* bpp);
+int _glfwDecodePNG(_GLFWpng* png, _GLFWrawreadfun read, void* user,
+                   _GLFWpngrowfun emit, void* emituser);
+void _glfwDestroyPNG(_GLFWpng* png);
+
+void _glfwUpdateTextureStreams(void);
+void _glfwForgetTextureStream(GLuint texture);
+void _glfwDeleteTextureStreams(GLsizei n, const GLuint* textures);
+void _glfwDestroyTextureStreams(void);
+
+void _glfwFlushProcCache(void);
+
+// Wrapping of the OpenGL entry points counted with GLFW2TO3_GL_STATS, or
+// filtered with GLFW2TO3_GL_FILTER
+void* _glfwInterposeGLProc(const char* name, void* proc, int game);
+void _glfwFlushGLProcs(void);
+void _glfwFlushGLBatch(void);
+int _glfwIsGLPixelStoreKnown(void);
+void _glfwSetGLPixelStoreKnown(void);
+int _glfwSeesGLTextureImages(void);
+GLuint _glfwGetGLBinding(GLenum target);
+GLboolean _glfwIsGLEnabled(GLenum cap);
+void _glfwEndGLFrame(void);
+void _glfwInitGLCalls(void);
+void _glfwTerminateGLCalls(void);
+
+void _glfwParallelFor(int count, void (*fun)(int, void*), void* arg);
+
+void _glfwSwizzlePixels(const unsigned char* src, unsigned char* dst,
+                        long count, int srcbpp, const signed char map[4]);
+void _glfwUnpackPixels1555(const unsigned char* src, unsigned char* dst,
+                           long count, int dstbpp);
+void _glfwFindEqualPixels(const unsigned char* row, int width, int bpp, uint64_t* bits);
+
+// How an image uses its alpha channel, from the least demanding
+#define _GLFW_ALPHA_UNKNOWN -1
+#define _GLFW_ALPHA_OPAQUE   0
+#define _GLFW_ALPHA_BINARY   1
+#define _GLFW_ALPHA_BLENDED  2
+
+int _glfwGetAlphaUsage(const unsigned char* pixels, long count, int usage);
+void _glfwQuantizePixels(const unsigned char* src, uint16_t* dst, long count,
+                         int x, int y, int srcbpp, GLenum type);
@@ -33,16 +33,17 @@
 
 GLFWAPI int GLFWAPIENTRY glfwGetJoystickParam(int joy, int param)
 {
+    _GLFW_COUNT_CALL(glfwGetJoystickParam);
     int count;
     switch (param)
     {
     case GLFW_PRESENT:
-        return _glfw.glfwJoystickPresent(joy);
+        return _GLFW3(glfwJoystickPresent)(joy);
     case GLFW_AXES:
-        _glfw.glfwGetJoystickAxes(joy, &count);
+        _GLFW3(glfwGetJoystickAxes)(joy, &count);
         return count;
     case GLFW_BUTTONS:
-        _glfw.glfwGetJoystickButtons(joy, &count);
+        _GLFW3(glfwGetJoystickButtons)(joy, &count);
         return count;
     default:
         return 0;
@@ -51,8 +52,9 @@ GLFWAPI int GLFWAPIENTRY glfwGetJoystickParam(int joy, int param)
 
 GLFWAPI int GLFWAPIENTRY glfwGetJoystickPos(int joy, float *pos, int numaxes)
 {
+    _GLFW_COUNT_CALL(glfwGetJoystickPos);
     int count;
-    const float* joystick_axes = _glfw.glfwGetJoystickAxes(joy, &count);
+    const float* joystick_axes = _GLFW3(glfwGetJoystickAxes)(joy, &count);
     if (!joystick_axes)
     {
         return 0;
@@ -67,8 +69,9 @@ GLFWAPI int GLFWAPIENTRY glfwGetJoystickPos(int joy, float *pos, int numaxes)
 
 GLFWAPI int GLFWAPIENTRY glfwGetJoystickButtons(int joy, unsigned char *buttons, int numbuttons)
 {
+    _GLFW_COUNT_CALL(glfwGetJoystickButtons);
     int count;
-    const unsigned char* joystick_buttons = _glfw.glfwGetJoystickButtons(joy, &count);
+    const unsigned char* joystick_buttons = _GLFW3(glfwGetJoystickButtons)(joy, &count);
     if (!joystick_buttons)
     {
         return 0;
@@ -0,0 +1,294 @@
+/*************************************************************************
+ * GLFW 2to3 - www.glfw.org
+ * A library easing porting from GLFW 2 to GLFW 3.x
+ *------------------------------------------------------------------------
+ * Copyright © 2020 Emmanuel Gil Peyrot <linkmauve@linkmauve.fr>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would
+ *    be appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not
+ *    be misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source
+ *    distribution.
+ *
+ *************************************************************************/
+
+#include "internal.h"
+
+#include <malloc.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <threads.h>
+
+/* Memory accounting */
+
+typedef struct memory_stats
+{
+    atomic_ullong bytes;
+    atomic_ullong peak;
+    atomic_ullong blocks;
+    atomic_ullong total;
+} memory_stats;
+
+static memory_stats categories[GLFW_MEMORY_COUNT];
+
+static const char* category_names[GLFW_MEMORY_COUNT] = {
+    "image",
+    "colormap",
+    "rescale",
+    "convert",
+    "sync",
+    "threads",
+    "other",
+    "total",
+};
+
+// Images handed out by glfwReadImage and not yet freed, so that they can be
+// told apart from caller allocated ones and reported as leaks.  Images read
+// into a caller's buffer are tracked too, as borrowed, so that freeing them
+// leaves that buffer alone.
+typedef struct tracked_image
+{
+    struct tracked_image* next;
+    const void* data;
+    int width, height, bpp;
+    int borrowed;
+} tracked_image;
+
+#define TRACKED_BUCKETS 256
+
+static tracked_image* tracked[TRACKED_BUCKETS];
+static mtx_t tracked_lock;
+static once_flag tracked_once = ONCE_FLAG_INIT;
+
+static void init_tracked_lock(void)
+{
+    mtx_init(&tracked_lock, mtx_plain);
+}
+
+static tracked_image** get_bucket(const void* data)
+{
+    return &tracked[((uintptr_t)data >> 4) % TRACKED_BUCKETS];
+}
+
+static void add(memory_stats* stats, unsigned long long size)
+{
+    unsigned long long bytes = atomic_fetch_add_explicit(&stats->bytes, size, memory_order_relaxed) + size;
+    unsigned long long peak = atomic_load_explicit(&stats->peak, memory_order_relaxed);
+    while (bytes > peak &&
+           !atomic_compare_exchange_weak_explicit(&stats->peak, &peak, bytes,
+                                                  memory_order_relaxed, memory_order_relaxed))
+        ;
+    atomic_fetch_add_explicit(&stats->blocks, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&stats->total, 1, memory_order_relaxed);
+}
+
+static void sub(memory_stats* stats, unsigned long long size)
+{
+    atomic_fetch_sub_explicit(&stats->bytes, size, memory_order_relaxed);
+    atomic_fetch_sub_explicit(&stats->blocks, 1, memory_order_relaxed);
+}
+
+// Blocks are accounted with their usable size, which is what they really
+// cost and needs no header in front of them: image data must stay a plain
+// malloc() block, as games may free() it themselves.
+static void account(void* ptr, int category)
+{
+    if (ptr)
+    {
+        size_t size = malloc_usable_size(ptr);
+        add(&categories[category], size);
+        add(&categories[GLFW_MEMORY_TOTAL], size);
+    }
+}
+
+static void unaccount(void* ptr, int category)
+{
+    if (ptr)
+    {
+        size_t size = malloc_usable_size(ptr);
+        sub(&categories[category], size);
+        sub(&categories[GLFW_MEMORY_TOTAL], size);
+    }
+}
+
+void* _glfwMalloc(size_t size, int category)
+{
+    void* ptr = malloc(size);
+    account(ptr, category);
+    return ptr;
+}
+
+void* _glfwCalloc(size_t count, size_t size, int category)
+{
+    void* ptr = calloc(count, size);
+    account(ptr, category);
+    return ptr;
+}
+
+void* _glfwRealloc(void* ptr, size_t size, int category)
+{
+    size_t old = ptr ? malloc_usable_size(ptr) : 0;
+    void* ret = realloc(ptr, size);
+    if (ret)
+    {
+        if (ptr)
+        {
+            sub(&categories[category], old);
+            sub(&categories[GLFW_MEMORY_TOTAL], old);
+        }
+        account(ret, category);
+    }
+    return ret;
+}
+
+void _glfwFree(void* ptr, int category)
+{
+    unaccount(ptr, category);
+    free(ptr);
+}
+
+// Must be called with tracked_lock held
+static tracked_image* unlink_image(const void* data)
+{
+    for (tracked_image** it = get_bucket(data); *it; it = &(*it)->next)
+    {
+        if ((*it)->data == data)
+        {
+            tracked_image* image = *it;
+            *it = image->next;
+            return image;
+        }
+    }
+    return NULL;
+}
+
+void _glfwTrackImage(const GLFWimage* img, int borrowed)
+{
+    // Images of our own are only tracked to report the leaked ones.
+    // Otherwise they are the game's from now on, and stop being accounted
+    // as they may be passed to free()
+    if (!borrowed && !_glfw.memorystats)
+    {
+        unaccount(img->Data, GLFW_MEMORY_IMAGE);
+        return;
+    }
+
+    tracked_image* image = malloc(sizeof(tracked_image));
+    if (!image)
+    {
+        return;
+    }
+
+    image->data = img->Data;
+    image->width = img->Width;
+    image->height = img->Height;
+    image->bpp = img->BytesPerPixel;
+    image->borrowed = borrowed;
+
+    // A buffer read into again, or a borrowed one its owner freed before
+    // malloc() handed its address out again, replaces the stale entry
+    call_once(&tracked_once, init_tracked_lock);
+    mtx_lock(&tracked_lock);
+    tracked_image* stale = unlink_image(img->Data);
+    tracked_image** bucket = get_bucket(img->Data);
+    image->next = *bucket;
+    *bucket = image;
+    mtx_unlock(&tracked_lock);
+
+    free(stale);
+}
+
+int _glfwUntrackImage(const void* data)
+{
+    call_once(&tracked_once, init_tracked_lock);
+    mtx_lock(&tracked_lock);
+    tracked_image* image = unlink_image(data);
+    mtx_unlock(&tracked_lock);
+
+    int owner = _GLFW_IMAGE_UNTRACKED;
+    if (image)
+    {
+        owner = image->borrowed ? _GLFW_IMAGE_BORROWED : _GLFW_IMAGE_OWNED;
+    }
+    free(image);
+    return owner;
+}
+
+// Known from the start, as images may be read before glfwInit().
+__attribute__((constructor))
+static void init_memory_stats(void)
+{
+    if (getenv("GLFW2TO3_MEMORY_STATS"))
+    {
+        _glfw.memorystats = GL_TRUE;
+    }
+}
+
+// Printed when the library is unloaded, so that images freed after
+// glfwTerminate() aren't reported as leaks.
+__attribute__((destructor))
+static void print_summary(void)
+{
+    if (!_glfw.memorystats)
+    {
+        return;
+    }
+
+    fprintf(stderr, "glfw2to3 memory statistics:\n");
+    fprintf(stderr, "%-8s %14s %14s %10s %10s\n", "category", "live bytes", "peak bytes", "blocks", "total");
+    for (int i = 0; i < GLFW_MEMORY_COUNT; ++i)
+    {
+        GLFWmemorystats stats;
+        glfwGetMemoryStats(i, &stats);
+        fprintf(stderr, "%-8s %14llu %14llu %10llu %10llu\n", category_names[i], stats.Bytes, stats.PeakBytes, stats.Blocks, stats.TotalBlocks);
+    }
+
+    int leaks = 0;
+    for (int i = 0; i < TRACKED_BUCKETS; ++i)
+    {
+        for (tracked_image* image = tracked[i]; image; image = image->next)
+        {
+            if (image->borrowed)
+            {
+                continue;
+            }
+            if (leaks++ < 32)
+            {
+                fprintf(stderr, "leaked image %p: %dx%d, %d bytes per pixel\n", image->data, image->width, image->height, image->bpp);
+            }
+        }
+    }
+    if (leaks > 32)
+    {
+        fprintf(stderr, "... and %d more leaked images\n", leaks - 32);
+    }
+}
+
+GLFWAPI int  GLFWAPIENTRY glfwGetMemoryStats(int category, GLFWmemorystats *stats)
+{
+    if (category < 0 || category >= GLFW_MEMORY_COUNT || !stats)
+    {
+        return GL_FALSE;
+    }
+
+    memory_stats* src = &categories[category];
+    stats->Bytes = atomic_load_explicit(&src->bytes, memory_order_relaxed);
+    stats->PeakBytes = atomic_load_explicit(&src->peak, memory_order_relaxed);
+    stats->Blocks = atomic_load_explicit(&src->blocks, memory_order_relaxed);
+    stats->TotalBlocks = atomic_load_explicit(&src->total, memory_order_relaxed);
+    return GL_TRUE;
+}
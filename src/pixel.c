@@ -0,0 +1,429 @@
+/*************************************************************************
+ * GLFW 2to3 - www.glfw.org
+ * A library easing porting from GLFW 2 to GLFW 3.x
+ *------------------------------------------------------------------------
+ * Copyright © 2020 Emmanuel Gil Peyrot <linkmauve@linkmauve.fr>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would
+ *    be appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not
+ *    be misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source
+ *    distribution.
+ *
+ *************************************************************************/
+
+#include "internal.h"
+
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <tmmintrin.h>
+#define _GLFW_HAVE_SSSE3 1
+#endif
+
+/* Pixel format conversion */
+
+static void swizzleScalar(const unsigned char* src, unsigned char* dst,
+                          long count, int srcbpp, const signed char map[4])
+{
+    for (long i = 0; i < count; ++i)
+    {
+        for (int c = 0; c < 4; ++c)
+        {
+            dst[c] = map[c] == _GLFW_SWIZZLE_ONE ? 255 : src[map[c]];
+        }
+        src += srcbpp;
+        dst += 4;
+    }
+}
+
+#if _GLFW_HAVE_SSSE3
+// Converts four pixels per iteration with a single byte shuffle, as long as
+// sixteen source bytes can be loaded.  Returns the number of pixels done.
+__attribute__((target("ssse3")))
+static long swizzleSSSE3(const unsigned char* src, unsigned char* dst,
+                         long count, int srcbpp, const signed char map[4])
+{
+    signed char shuffle[16], fill[16];
+    for (int p = 0; p < 4; ++p)
+    {
+        for (int c = 0; c < 4; ++c)
+        {
+            if (map[c] == _GLFW_SWIZZLE_ONE)
+            {
+                shuffle[p * 4 + c] = (signed char)0x80;
+                fill[p * 4 + c] = (signed char)0xff;
+            }
+            else
+            {
+                shuffle[p * 4 + c] = (signed char)(p * srcbpp + map[c]);
+                fill[p * 4 + c] = 0;
+            }
+        }
+    }
+
+    const __m128i mask = _mm_loadu_si128((const __m128i*)shuffle);
+    const __m128i ones = _mm_loadu_si128((const __m128i*)fill);
+
+    long i = 0;
+    for (; (count - i) * srcbpp >= 16; i += 4)
+    {
+        __m128i pixels = _mm_loadu_si128((const __m128i*)(src + i * srcbpp));
+        pixels = _mm_or_si128(_mm_shuffle_epi8(pixels, mask), ones);
+        _mm_storeu_si128((__m128i*)(dst + i * 4), pixels);
+    }
+    return i;
+}
+#endif
+
+void _glfwSwizzlePixels(const unsigned char* src, unsigned char* dst,
+                        long count, int srcbpp, const signed char map[4])
+{
+    long done = 0;
+#if _GLFW_HAVE_SSSE3
+    if (__builtin_cpu_supports("ssse3"))
+    {
+        done = swizzleSSSE3(src, dst, count, srcbpp, map);
+    }
+#endif
+    swizzleScalar(src + done * srcbpp, dst + done * 4, count - done, srcbpp, map);
+}
+
+static void unpack1555Scalar(const unsigned char* src, unsigned char* dst,
+                             long count, int dstbpp)
+{
+    for (long i = 0; i < count; ++i)
+    {
+        uint16_t p;
+        memcpy(&p, src + i * 2, sizeof(p));
+
+        const unsigned r = (p >> 10) & 31, g = (p >> 5) & 31, b = p & 31;
+        dst[0] = (unsigned char)((r << 3) | (r >> 2));
+        dst[1] = (unsigned char)((g << 3) | (g >> 2));
+        dst[2] = (unsigned char)((b << 3) | (b >> 2));
+        if (dstbpp == 4)
+        {
+            dst[3] = (p & 0x8000) ? 255 : 0;
+        }
+        dst += dstbpp;
+    }
+}
+
+#if defined(__SSE2__)
+// Expands eight pixels per iteration, each channel being widened from five
+// to eight bits by replicating its top bits.  Returns the number of pixels
+// done.
+static long unpack1555SSE2(const unsigned char* src, unsigned char* dst, long count)
+{
+    const __m128i mask5 = _mm_set1_epi16(0xf8);
+    const __m128i mask3 = _mm_set1_epi16(0x07);
+
+    long i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        const __m128i p = _mm_loadu_si128((const __m128i*)(src + i * 2));
+        const __m128i r = _mm_or_si128(_mm_and_si128(_mm_srli_epi16(p, 7), mask5),
+                                       _mm_and_si128(_mm_srli_epi16(p, 12), mask3));
+        const __m128i g = _mm_or_si128(_mm_and_si128(_mm_srli_epi16(p, 2), mask5),
+                                       _mm_and_si128(_mm_srli_epi16(p, 7), mask3));
+        const __m128i b = _mm_or_si128(_mm_and_si128(_mm_slli_epi16(p, 3), mask5),
+                                       _mm_and_si128(_mm_srli_epi16(p, 2), mask3));
+        const __m128i a = _mm_srai_epi16(p, 15);
+
+        const __m128i rg = _mm_or_si128(r, _mm_slli_epi16(g, 8));
+        const __m128i ba = _mm_or_si128(b, _mm_slli_epi16(a, 8));
+        _mm_storeu_si128((__m128i*)(dst + i * 4), _mm_unpacklo_epi16(rg, ba));
+        _mm_storeu_si128((__m128i*)(dst + i * 4 + 16), _mm_unpackhi_epi16(rg, ba));
+    }
+    return i;
+}
+#endif
+
+void _glfwUnpackPixels1555(const unsigned char* src, unsigned char* dst,
+                           long count, int dstbpp)
+{
+    long done = 0;
+#if defined(__SSE2__)
+    if (dstbpp == 4)
+    {
+        done = unpack1555SSE2(src, dst, count);
+    }
+#endif
+    unpack1555Scalar(src + done * 2, dst + done * dstbpp, count - done, dstbpp);
+}
+
+// Sets bit i of bits when pixel i of the row is identical to pixel i + 1.
+void _glfwFindEqualPixels(const unsigned char* row, int width, int bpp, uint64_t* bits)
+{
+    memset(bits, 0, ((width + 63) / 64) * sizeof(uint64_t));
+
+    int i = 0;
+#if defined(__SSE2__)
+    if (bpp == 4)
+    {
+        for (; i + 4 < width; i += 4)
+        {
+            __m128i a = _mm_loadu_si128((const __m128i*)(row + i * 4));
+            __m128i b = _mm_loadu_si128((const __m128i*)(row + i * 4 + 4));
+            uint64_t mask = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(a, b)));
+            bits[i >> 6] |= mask << (i & 63);
+        }
+    }
+    else if (bpp == 1)
+    {
+        for (; i + 16 < width; i += 16)
+        {
+            __m128i a = _mm_loadu_si128((const __m128i*)(row + i));
+            __m128i b = _mm_loadu_si128((const __m128i*)(row + i + 1));
+            uint64_t mask = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(a, b));
+            bits[i >> 6] |= mask << (i & 63);
+        }
+    }
+    else if (bpp == 3)
+    {
+        // Five pixels per load, a pixel is equal when its three bytes are.
+        for (; i + 6 < width; i += 5)
+        {
+            __m128i a = _mm_loadu_si128((const __m128i*)(row + i * 3));
+            __m128i b = _mm_loadu_si128((const __m128i*)(row + i * 3 + 3));
+            int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(a, b));
+            for (int p = 0; p < 5; ++p)
+            {
+                if (((mask >> (p * 3)) & 7) == 7)
+                {
+                    bits[(i + p) >> 6] |= (uint64_t)1 << ((i + p) & 63);
+                }
+            }
+        }
+    }
+#endif
+    for (; i < width - 1; ++i)
+    {
+        if (!memcmp(row + i * bpp, row + (i + 1) * bpp, bpp))
+        {
+            bits[i >> 6] |= (uint64_t)1 << (i & 63);
+        }
+    }
+}
+
+/* Alpha usage */
+
+// Returns usage, raised to what the alpha channel of these RGBA pixels
+// needs.
+int _glfwGetAlphaUsage(const unsigned char* pixels, long count, int usage)
+{
+    long i = 0;
+#if defined(__SSE2__)
+    const __m128i mask = _mm_set1_epi32((int)0xff000000);
+    for (; i + 4 <= count && usage != _GLFW_ALPHA_BLENDED; i += 4)
+    {
+        const __m128i a = _mm_and_si128(_mm_loadu_si128((const __m128i*)(pixels + i * 4)), mask);
+        const int opaque = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(a, mask)));
+        const int clear = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(a, _mm_setzero_si128())));
+        if ((opaque | clear) != 15)
+        {
+            usage = _GLFW_ALPHA_BLENDED;
+        }
+        else if (clear)
+        {
+            usage = _GLFW_ALPHA_BINARY;
+        }
+    }
+#endif
+    for (; i < count && usage != _GLFW_ALPHA_BLENDED; ++i)
+    {
+        const unsigned char a = pixels[i * 4 + 3];
+        if (a == 0)
+        {
+            usage = _GLFW_ALPHA_BINARY;
+        }
+        else if (a != 255)
+        {
+            usage = _GLFW_ALPHA_BLENDED;
+        }
+    }
+    return usage;
+}
+
+/* Reduced precision */
+
+// 4x4 ordered dither, as offsets in [0, 255) added to value * levels before
+// dividing by 255.
+static const uint8_t ditherOffsets[4][4] = {
+    {   7, 135,  39, 167 },
+    { 199,  71, 231, 103 },
+    {  55, 183,  23, 151 },
+    { 247, 119, 215,  87 },
+};
+
+// Levels and bit positions of the R, G, B and A channels of a packed
+// 16-bit type, a channel with no levels being left out.
+static void getPackedLayout(GLenum type, int levels[4], int shifts[4])
+{
+    static const int layouts[3][8] = {
+        { 31, 63, 31,  0, 11, 5, 0, 0 },  // GL_UNSIGNED_SHORT_5_6_5
+        { 15, 15, 15, 15, 12, 8, 4, 0 },  // GL_UNSIGNED_SHORT_4_4_4_4
+        { 31, 31, 31,  1, 11, 6, 1, 0 },  // GL_UNSIGNED_SHORT_5_5_5_1
+    };
+    const int* layout = layouts[type == GL_UNSIGNED_SHORT_5_6_5 ? 0 :
+                                type == GL_UNSIGNED_SHORT_4_4_4_4 ? 1 : 2];
+    for (int c = 0; c < 4; ++c)
+    {
+        levels[c] = layout[c];
+        shifts[c] = layout[4 + c];
+    }
+}
+
+static void quantizeScalar(const unsigned char* src, uint16_t* dst, long count,
+                           int x, int y, int srcbpp,
+                           const int levels[4], const int shifts[4])
+{
+    const uint8_t* offsets = ditherOffsets[y & 3];
+    for (long i = 0; i < count; ++i)
+    {
+        const unsigned d = offsets[(x + i) & 3];
+        unsigned p = 0;
+        for (int c = 0; c < 4; ++c)
+        {
+            const unsigned v = c < srcbpp ? src[c] : 255;
+            p |= ((v * levels[c] + d) / 255) << shifts[c];
+        }
+        dst[i] = (uint16_t)p;
+        src += srcbpp;
+    }
+}
+
+#if defined(__SSE2__)
+typedef struct quantizeConsts {
+    __m128i levels, weights, offsets[2];
+} quantizeConsts;
+
+static void initQuantizeConsts(quantizeConsts* k, int x, int y,
+                               const int levels[4], const int shifts[4])
+{
+    short o[4];
+    for (int p = 0; p < 4; ++p)
+    {
+        o[p] = ditherOffsets[y & 3][(x + p) & 3];
+    }
+
+    k->levels = _mm_setr_epi16(levels[0], levels[1], levels[2], levels[3],
+                               levels[0], levels[1], levels[2], levels[3]);
+    k->weights = _mm_setr_epi16(1 << shifts[0], 1 << shifts[1], 1 << shifts[2], 1 << shifts[3],
+                                1 << shifts[0], 1 << shifts[1], 1 << shifts[2], 1 << shifts[3]);
+    k->offsets[0] = _mm_setr_epi16(o[0], o[0], o[0], o[0], o[1], o[1], o[1], o[1]);
+    k->offsets[1] = _mm_setr_epi16(o[2], o[2], o[2], o[2], o[3], o[3], o[3], o[3]);
+}
+
+// Quantizes two RGBA pixels widened to 16-bit channels, and shifts each
+// channel to its place, (x + 1 + (x >> 8)) >> 8 being x / 255 for any
+// 16-bit x.
+static inline __m128i quantize2(__m128i channels, __m128i levels, __m128i offsets,
+                                __m128i weights)
+{
+    __m128i x = _mm_add_epi16(_mm_mullo_epi16(channels, levels), offsets);
+    x = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(x, _mm_set1_epi16(1)),
+                                     _mm_srli_epi16(x, 8)), 8);
+    x = _mm_madd_epi16(x, weights);
+
+    // Each pixel is now the sum of two neighbouring 32-bit lanes
+    return _mm_add_epi32(x, _mm_srli_epi64(x, 32));
+}
+
+// Quantizes four RGBA pixels, returned in the low half.
+static inline __m128i quantize4(__m128i pixels, const quantizeConsts* k)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i lo = quantize2(_mm_unpacklo_epi8(pixels, zero), k->levels,
+                                 k->offsets[0], k->weights);
+    const __m128i hi = quantize2(_mm_unpackhi_epi8(pixels, zero), k->levels,
+                                 k->offsets[1], k->weights);
+    __m128i p = _mm_unpacklo_epi64(_mm_shuffle_epi32(lo, _MM_SHUFFLE(3, 3, 2, 0)),
+                                   _mm_shuffle_epi32(hi, _MM_SHUFFLE(3, 3, 2, 0)));
+
+    // Signed saturation would clamp the top bit away
+    p = _mm_packs_epi32(_mm_sub_epi32(p, _mm_set1_epi32(0x8000)), zero);
+    return _mm_xor_si128(p, _mm_set1_epi16((short)0x8000));
+}
+
+// Quantizes four RGBA pixels per iteration, the dither pattern repeating
+// every four pixels.  Returns the number of pixels done.
+static long quantizeSSE2(const unsigned char* src, uint16_t* dst, long count,
+                         int x, int y, const int levels[4], const int shifts[4])
+{
+    quantizeConsts k;
+    initQuantizeConsts(&k, x, y, levels, shifts);
+
+    long i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        const __m128i pixels = _mm_loadu_si128((const __m128i*)(src + i * 4));
+        _mm_storel_epi64((__m128i*)(dst + i), quantize4(pixels, &k));
+    }
+    return i;
+}
+
+#if _GLFW_HAVE_SSSE3
+// Same for RGB pixels, expanded to RGBA with a byte shuffle, as long as
+// sixteen source bytes can be loaded.
+__attribute__((target("ssse3")))
+static long quantizeSSSE3(const unsigned char* src, uint16_t* dst, long count,
+                          int x, int y, const int levels[4], const int shifts[4])
+{
+    quantizeConsts k;
+    initQuantizeConsts(&k, x, y, levels, shifts);
+
+    const __m128i mask = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1,
+                                       6, 7, 8, -1, 9, 10, 11, -1);
+    const __m128i alpha = _mm_set1_epi32((int)0xff000000);
+
+    long i = 0;
+    for (; (count - i) * 3 >= 16; i += 4)
+    {
+        __m128i pixels = _mm_loadu_si128((const __m128i*)(src + i * 3));
+        pixels = _mm_or_si128(_mm_shuffle_epi8(pixels, mask), alpha);
+        _mm_storel_epi64((__m128i*)(dst + i), quantize4(pixels, &k));
+    }
+    return i;
+}
+#endif
+#endif
+
+// Quantizes a row of RGB or RGBA pixels to a packed 16-bit type, with an
+// ordered dither.  x and y are the position of the first pixel in the
+// image, so that the dither pattern doesn't depend on how it is split.
+void _glfwQuantizePixels(const unsigned char* src, uint16_t* dst, long count,
+                         int x, int y, int srcbpp, GLenum type)
+{
+    int levels[4], shifts[4];
+    getPackedLayout(type, levels, shifts);
+
+    long done = 0;
+#if defined(__SSE2__)
+    if (srcbpp == 4)
+    {
+        done = quantizeSSE2(src, dst, count, x, y, levels, shifts);
+    }
+#if _GLFW_HAVE_SSSE3
+    else if (__builtin_cpu_supports("ssse3"))
+    {
+        done = quantizeSSSE3(src, dst, count, x, y, levels, shifts);
+    }
+#endif
+#endif
+    quantizeScalar(src + done * srcbpp, dst + done, count - done, x + (int)done, y,
+                   srcbpp, levels, shifts);
+}
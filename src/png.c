@@ -0,0 +1,765 @@
+/*************************************************************************
+ * GLFW 2to3 - www.glfw.org
+ * A library easing porting from GLFW 2 to GLFW 3.x
+ *------------------------------------------------------------------------
+ * Copyright © 2020 Emmanuel Gil Peyrot <linkmauve@linkmauve.fr>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would
+ *    be appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not
+ *    be misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source
+ *    distribution.
+ *
+ *************************************************************************/
+
+#include "internal.h"
+
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+// PNG decoding needs zlib, enabled by the build system when it is found
+#ifndef _GLFW_HAVE_ZLIB
+#define _GLFW_HAVE_ZLIB 0
+#endif
+
+#if _GLFW_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/* PNG image decoding */
+
+static const unsigned char signature[8] = { 137, 'P', 'N', 'G', '\r', '\n', 26, '\n' };
+
+int _glfwIsPNG(const unsigned char* magic, long size)
+{
+    return size >= (long)sizeof(signature) && !memcmp(magic, signature, sizeof(signature));
+}
+
+#if _GLFW_HAVE_ZLIB
+
+#define _GLFW_PNG_GRAY       0
+#define _GLFW_PNG_RGB        2
+#define _GLFW_PNG_PALETTE    3
+#define _GLFW_PNG_GRAY_ALPHA 4
+#define _GLFW_PNG_RGBA       6
+
+// Size of the window of compressed bytes fed to zlib
+#define _GLFW_PNG_WINDOW 32768
+
+struct _GLFWpng
+{
+    int width, height;
+    int depth, colortype, interlace;
+    int channels;   // samples per pixel in the file
+    int filterbpp;  // distance in bytes between the pixels filters compare
+    int bpp;        // bytes per decoded pixel, 1, 3 or 4
+
+    unsigned char palette[256][4];
+    int palettesize;
+    int hasalpha;   // palette entries with transparency
+    int haskey;     // transparent colour of gray and RGB images
+    unsigned key[3];
+
+    // Bytes left in the current IDAT chunk
+    uint32_t chunkleft;
+
+    z_stream zlib;
+    int zlibinit;
+    unsigned char in[_GLFW_PNG_WINDOW];
+};
+
+static uint32_t readU32(const unsigned char* p)
+{
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+static int readExactly(_GLFWrawreadfun read, void* user, void* data, long size)
+{
+    return read(user, data, size) == size;
+}
+
+static int skipBytes(_GLFWrawreadfun read, void* user, uint32_t size)
+{
+    unsigned char buffer[512];
+    while (size > 0)
+    {
+        const long count = size < sizeof(buffer) ? (long)size : (long)sizeof(buffer);
+        if (!readExactly(read, user, buffer, count))
+        {
+            return 0;
+        }
+        size -= count;
+    }
+    return 1;
+}
+
+static int parseIHDR(_GLFWpng* png, const unsigned char* data)
+{
+    const uint32_t width = readU32(data), height = readU32(data + 4);
+    png->depth = data[8];
+    png->colortype = data[9];
+    png->interlace = data[12];
+
+    // Decoded images are addressed with ints
+    if (width == 0 || height == 0 || width > INT_MAX / 4 ||
+        (uint64_t)width * height * 4 > INT_MAX)
+    {
+        return 0;
+    }
+    png->width = (int)width;
+    png->height = (int)height;
+
+    // Only the compression and filter methods 0 exist
+    if (data[10] != 0 || data[11] != 0 || png->interlace > 1)
+    {
+        return 0;
+    }
+
+    const int d = png->depth;
+    switch (png->colortype)
+    {
+    case _GLFW_PNG_GRAY:
+        png->channels = 1;
+        return d == 1 || d == 2 || d == 4 || d == 8 || d == 16;
+    case _GLFW_PNG_PALETTE:
+        png->channels = 1;
+        return d == 1 || d == 2 || d == 4 || d == 8;
+    case _GLFW_PNG_RGB:
+        png->channels = 3;
+        return d == 8 || d == 16;
+    case _GLFW_PNG_GRAY_ALPHA:
+        png->channels = 2;
+        return d == 8 || d == 16;
+    case _GLFW_PNG_RGBA:
+        png->channels = 4;
+        return d == 8 || d == 16;
+    default:
+        return 0;
+    }
+}
+
+static int parseTRNS(_GLFWpng* png, const unsigned char* data, uint32_t size)
+{
+    const unsigned mask = (1u << png->depth) - 1;
+
+    switch (png->colortype)
+    {
+    case _GLFW_PNG_PALETTE:
+        if (size > 256)
+        {
+            return 0;
+        }
+        for (uint32_t i = 0; i < size; ++i)
+        {
+            png->palette[i][3] = data[i];
+        }
+        png->hasalpha = size > 0;
+        return 1;
+    case _GLFW_PNG_GRAY:
+        if (size != 2)
+        {
+            return 0;
+        }
+        png->key[0] = ((data[0] << 8) | data[1]) & mask;
+        png->haskey = 1;
+        return 1;
+    case _GLFW_PNG_RGB:
+        if (size != 6)
+        {
+            return 0;
+        }
+        for (int c = 0; c < 3; ++c)
+        {
+            png->key[c] = ((data[c * 2] << 8) | data[c * 2 + 1]) & mask;
+        }
+        png->haskey = 1;
+        return 1;
+    default:
+        // Images with an alpha channel can't have a tRNS chunk
+        return 0;
+    }
+}
+
+// Reads every chunk up to the image data, which is left at the start of
+// the first IDAT chunk.
+static int readHeader(_GLFWpng* png, _GLFWrawreadfun read, void* user)
+{
+    unsigned char head[8], data[768];
+    int seenihdr = 0;
+
+    for (;;)
+    {
+        if (!readExactly(read, user, head, sizeof(head)))
+        {
+            return 0;
+        }
+
+        const uint32_t size = readU32(head);
+        const unsigned char* type = head + 4;
+        if (size > INT32_MAX)
+        {
+            return 0;
+        }
+
+        if (!seenihdr)
+        {
+            // The header must come first
+            if (memcmp(type, "IHDR", 4) || size != 13 ||
+                !readExactly(read, user, data, size) || !parseIHDR(png, data))
+            {
+                return 0;
+            }
+            seenihdr = 1;
+        }
+        else if (!memcmp(type, "IDAT", 4))
+        {
+            png->chunkleft = size;
+            return png->colortype != _GLFW_PNG_PALETTE || png->palettesize > 0;
+        }
+        else if (!memcmp(type, "PLTE", 4))
+        {
+            if (size == 0 || size % 3 || size > sizeof(data) ||
+                !readExactly(read, user, data, size))
+            {
+                return 0;
+            }
+            png->palettesize = (int)(size / 3);
+            for (int i = 0; i < png->palettesize; ++i)
+            {
+                memcpy(png->palette[i], data + i * 3, 3);
+            }
+        }
+        else if (!memcmp(type, "tRNS", 4))
+        {
+            if (size > sizeof(data) || !readExactly(read, user, data, size) ||
+                !parseTRNS(png, data, size))
+            {
+                return 0;
+            }
+        }
+        else if (!(type[0] & 0x20))
+        {
+            // An unknown critical chunk, or IEND before any image data
+            return 0;
+        }
+        else if (!skipBytes(read, user, size))
+        {
+            return 0;
+        }
+
+        // Skip the CRC, the image data is already checked by zlib
+        if (!skipBytes(read, user, 4))
+        {
+            return 0;
+        }
+    }
+}
+
+_GLFWpng* _glfwReadPNGHeader(_GLFWrawreadfun read, void* user)
+{
+    _GLFWpng* png = _glfwCalloc(1, sizeof(_GLFWpng), GLFW_MEMORY_OTHER);
+    if (!png)
+    {
+        return NULL;
+    }
+
+    // Palette entries are opaque unless a tRNS chunk says otherwise
+    for (int i = 0; i < 256; ++i)
+    {
+        png->palette[i][3] = 255;
+    }
+
+    if (!readHeader(png, read, user) || inflateInit(&png->zlib) != Z_OK)
+    {
+        _glfwFree(png, GLFW_MEMORY_OTHER);
+        return NULL;
+    }
+    png->zlibinit = 1;
+
+    png->filterbpp = (png->channels * png->depth + 7) / 8;
+
+    // Gray+alpha, and colour keyed images, are expanded to RGBA
+    if (png->colortype == _GLFW_PNG_GRAY)
+    {
+        png->bpp = png->haskey ? 4 : 1;
+    }
+    else if (png->colortype == _GLFW_PNG_PALETTE)
+    {
+        png->bpp = png->hasalpha ? 4 : 3;
+    }
+    else if (png->colortype == _GLFW_PNG_RGB)
+    {
+        png->bpp = png->haskey ? 4 : 3;
+    }
+    else
+    {
+        png->bpp = 4;
+    }
+
+    return png;
+}
+
+void _glfwGetPNGSize(const _GLFWpng* png, int* width, int* height, int* bpp)
+{
+    *width = png->width;
+    *height = png->height;
+    *bpp = png->bpp;
+}
+
+// Inflates exactly size bytes of filtered image data, moving on to the next
+// IDAT chunks as needed.
+static int inflateBytes(_GLFWpng* png, unsigned char* data, size_t size,
+                        _GLFWrawreadfun read, void* user)
+{
+    png->zlib.next_out = data;
+    png->zlib.avail_out = (uInt)size;
+
+    while (png->zlib.avail_out > 0)
+    {
+        if (png->zlib.avail_in == 0)
+        {
+            while (png->chunkleft == 0)
+            {
+                // CRC of the previous chunk, then the next chunk header
+                unsigned char head[12];
+                if (!readExactly(read, user, head, sizeof(head)) ||
+                    memcmp(head + 8, "IDAT", 4))
+                {
+                    return 0;
+                }
+                png->chunkleft = readU32(head + 4);
+            }
+
+            const long count = png->chunkleft < _GLFW_PNG_WINDOW ? (long)png->chunkleft : _GLFW_PNG_WINDOW;
+            if (!readExactly(read, user, png->in, count))
+            {
+                return 0;
+            }
+            png->chunkleft -= count;
+            png->zlib.next_in = png->in;
+            png->zlib.avail_in = (uInt)count;
+        }
+
+        const int ret = inflate(&png->zlib, Z_NO_FLUSH);
+        if (ret == Z_STREAM_END)
+        {
+            return png->zlib.avail_out == 0;
+        }
+        if (ret != Z_OK)
+        {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+static void unfilterSub(unsigned char* row, size_t size, int bpp)
+{
+    size_t i = bpp;
+#if defined(__SSE2__)
+    // One pixel at a time, all of its bytes at once
+    if (bpp == 3 || bpp == 4)
+    {
+        __m128i a = _mm_setzero_si128();
+        for (i = 0; i + 4 <= size; i += bpp)
+        {
+            int32_t v;
+            memcpy(&v, row + i, 4);
+            a = _mm_add_epi8(a, _mm_cvtsi32_si128(v));
+            v = _mm_cvtsi128_si32(a);
+            memcpy(row + i, &v, bpp);
+        }
+        if (i == 0)
+        {
+            i = bpp;
+        }
+    }
+#endif
+    for (; i < size; ++i)
+    {
+        row[i] += row[i - bpp];
+    }
+}
+
+static void unfilterUp(unsigned char* row, const unsigned char* prev, size_t size)
+{
+    size_t i = 0;
+#if defined(__SSE2__)
+    for (; i + 16 <= size; i += 16)
+    {
+        const __m128i a = _mm_loadu_si128((const __m128i*)(row + i));
+        const __m128i b = _mm_loadu_si128((const __m128i*)(prev + i));
+        _mm_storeu_si128((__m128i*)(row + i), _mm_add_epi8(a, b));
+    }
+#endif
+    for (; i < size; ++i)
+    {
+        row[i] += prev[i];
+    }
+}
+
+static void unfilterAverage(unsigned char* row, const unsigned char* prev, size_t size, int bpp)
+{
+    size_t i = 0;
+#if defined(__SSE2__)
+    if (bpp == 3 || bpp == 4)
+    {
+        // _mm_avg_epu8 rounds up, PNG rounds down
+        const __m128i one = _mm_set1_epi8(1);
+        __m128i a = _mm_setzero_si128();
+        for (; i + 4 <= size; i += bpp)
+        {
+            int32_t v, u;
+            memcpy(&v, row + i, 4);
+            memcpy(&u, prev + i, 4);
+            const __m128i b = _mm_cvtsi32_si128(u);
+            __m128i avg = _mm_avg_epu8(a, b);
+            avg = _mm_sub_epi8(avg, _mm_and_si128(_mm_xor_si128(a, b), one));
+            a = _mm_add_epi8(_mm_cvtsi32_si128(v), avg);
+            v = _mm_cvtsi128_si32(a);
+            memcpy(row + i, &v, bpp);
+        }
+    }
+#endif
+    for (; i < (size_t)bpp && i < size; ++i)
+    {
+        row[i] += prev[i] >> 1;
+    }
+    for (; i < size; ++i)
+    {
+        row[i] += (row[i - bpp] + prev[i]) >> 1;
+    }
+}
+
+static unsigned char paeth(int a, int b, int c)
+{
+    const int pa = abs(b - c), pb = abs(a - c), pc = abs(a + b - 2 * c);
+    if (pa <= pb && pa <= pc)
+    {
+        return (unsigned char)a;
+    }
+    return (unsigned char)(pb <= pc ? b : c);
+}
+
+#if defined(__SSE2__)
+static __m128i abs16(__m128i x)
+{
+    return _mm_max_epi16(x, _mm_sub_epi16(_mm_setzero_si128(), x));
+}
+
+static __m128i select16(__m128i mask, __m128i a, __m128i b)
+{
+    return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+#endif
+
+static void unfilterPaeth(unsigned char* row, const unsigned char* prev, size_t size, int bpp)
+{
+    size_t i = 0;
+#if defined(__SSE2__)
+    if (bpp == 3 || bpp == 4)
+    {
+        // The predictor is computed on 16-bit lanes, to keep the signs
+        const __m128i zero = _mm_setzero_si128();
+        __m128i a = zero, c = zero;
+        for (; i + 4 <= size; i += bpp)
+        {
+            int32_t v, u;
+            memcpy(&v, row + i, 4);
+            memcpy(&u, prev + i, 4);
+            const __m128i b = _mm_unpacklo_epi8(_mm_cvtsi32_si128(u), zero);
+            const __m128i d = _mm_unpacklo_epi8(_mm_cvtsi32_si128(v), zero);
+
+            __m128i pa = _mm_sub_epi16(b, c);
+            __m128i pb = _mm_sub_epi16(a, c);
+            __m128i pc = abs16(_mm_add_epi16(pa, pb));
+            pa = abs16(pa);
+            pb = abs16(pb);
+            const __m128i smallest = _mm_min_epi16(pc, _mm_min_epi16(pa, pb));
+            const __m128i predicted =
+                select16(_mm_cmpeq_epi16(smallest, pa), a,
+                         select16(_mm_cmpeq_epi16(smallest, pb), b, c));
+
+            a = _mm_and_si128(_mm_add_epi16(d, predicted), _mm_set1_epi16(0xff));
+            c = b;
+            v = _mm_cvtsi128_si32(_mm_packus_epi16(a, a));
+            memcpy(row + i, &v, bpp);
+        }
+    }
+#endif
+    for (; i < (size_t)bpp && i < size; ++i)
+    {
+        row[i] += prev[i];
+    }
+    for (; i < size; ++i)
+    {
+        row[i] += paeth(row[i - bpp], prev[i], prev[i - bpp]);
+    }
+}
+
+static int unfilterRow(unsigned char* row, const unsigned char* prev, size_t size,
+                       int bpp, int filter)
+{
+    switch (filter)
+    {
+    case 0:
+        return 1;
+    case 1:
+        unfilterSub(row, size, bpp);
+        return 1;
+    case 2:
+        unfilterUp(row, prev, size);
+        return 1;
+    case 3:
+        unfilterAverage(row, prev, size, bpp);
+        return 1;
+    case 4:
+        unfilterPaeth(row, prev, size, bpp);
+        return 1;
+    default:
+        return 0;
+    }
+}
+
+static unsigned getSample(const unsigned char* row, long index, int depth)
+{
+    switch (depth)
+    {
+    case 16:
+        return (row[index * 2] << 8) | row[index * 2 + 1];
+    case 8:
+        return row[index];
+    default:
+    {
+        const long bit = index * depth;
+        return (row[bit >> 3] >> (8 - depth - (bit & 7))) & ((1u << depth) - 1);
+    }
+    }
+}
+
+// Converts count pixels of an unfiltered row to 8-bit L, RGB or RGBA, step
+// bytes apart in dst.
+static void expandRow(const _GLFWpng* png, const unsigned char* src,
+                      unsigned char* dst, int count, int step)
+{
+    const int depth = png->depth, bpp = png->bpp;
+
+    // 8-bit samples are already laid out like the decoded pixels
+    if (depth == 8 && png->channels == bpp && step == bpp)
+    {
+        memcpy(dst, src, (size_t)count * bpp);
+        return;
+    }
+
+    // Gray levels are scaled to the full 8-bit range
+    const unsigned maxgray = (1u << depth) - 1;
+
+    for (int x = 0; x < count; ++x, dst += step)
+    {
+        unsigned s[4];
+        for (int c = 0; c < png->channels; ++c)
+        {
+            s[c] = getSample(src, (long)x * png->channels + c, depth);
+        }
+
+        switch (png->colortype)
+        {
+        case _GLFW_PNG_PALETTE:
+            memcpy(dst, png->palette[s[0]], bpp);
+            break;
+        case _GLFW_PNG_GRAY:
+        {
+            const unsigned char l = (unsigned char)(depth == 16 ? s[0] >> 8 : s[0] * 255 / maxgray);
+            dst[0] = l;
+            if (bpp == 4)
+            {
+                dst[1] = dst[2] = l;
+                dst[3] = s[0] == png->key[0] ? 0 : 255;
+            }
+            break;
+        }
+        case _GLFW_PNG_GRAY_ALPHA:
+        {
+            const int shift = depth == 16 ? 8 : 0;
+            dst[0] = dst[1] = dst[2] = (unsigned char)(s[0] >> shift);
+            dst[3] = (unsigned char)(s[1] >> shift);
+            break;
+        }
+        default:
+        {
+            const int shift = depth == 16 ? 8 : 0;
+            for (int c = 0; c < png->channels; ++c)
+            {
+                dst[c] = (unsigned char)(s[c] >> shift);
+            }
+            if (png->colortype == _GLFW_PNG_RGB && bpp == 4)
+            {
+                dst[3] = s[0] == png->key[0] && s[1] == png->key[1] &&
+                         s[2] == png->key[2] ? 0 : 255;
+            }
+            break;
+        }
+        }
+    }
+}
+
+// Inflates, unfilters and expands height rows of width pixels, the first
+// one being stored at dst and the next ones rowstep bytes apart.
+static int decodePass(_GLFWpng* png, unsigned char* rows, int width, int height,
+                      unsigned char* dst, long rowstep, int step,
+                      _GLFWrawreadfun read, void* user,
+                      _GLFWpngrowfun emit, void* emituser)
+{
+    const size_t size = ((size_t)width * png->channels * png->depth + 7) / 8;
+    unsigned char* cur = rows;
+    unsigned char* prev = rows + size + 1;
+
+    // The row above the first one is all zeroes
+    memset(prev, 0, size + 1);
+
+    for (int y = 0; y < height; ++y)
+    {
+        if (!inflateBytes(png, cur, size + 1, read, user) ||
+            !unfilterRow(cur + 1, prev + 1, size, png->filterbpp, cur[0]))
+        {
+            return 0;
+        }
+
+        expandRow(png, cur + 1, dst + y * rowstep, width, step);
+        if (emit)
+        {
+            emit(emituser, y, dst);
+        }
+
+        unsigned char* tmp = cur;
+        cur = prev;
+        prev = tmp;
+    }
+
+    return 1;
+}
+
+int _glfwDecodePNG(_GLFWpng* png, _GLFWrawreadfun read, void* user,
+                   _GLFWpngrowfun emit, void* emituser)
+{
+    const long rowsize = (long)png->width * png->bpp;
+    const size_t filtered = ((size_t)png->width * png->channels * png->depth + 7) / 8 + 1;
+    int ok = 1;
+
+    // Two filtered rows, the current one and the one above it
+    unsigned char* rows = _glfwMalloc(filtered * 2, GLFW_MEMORY_OTHER);
+    if (!rows)
+    {
+        return 0;
+    }
+
+    if (!png->interlace)
+    {
+        // Each row is handed over as soon as it is decoded
+        unsigned char* row = _glfwMalloc(rowsize, GLFW_MEMORY_OTHER);
+        ok = row && decodePass(png, rows, png->width, png->height, row, 0,
+                               png->bpp, read, user, emit, emituser);
+        _glfwFree(row, GLFW_MEMORY_OTHER);
+    }
+    else
+    {
+        // Adam7 passes each fill a sparse subset of the image, which is
+        // only complete after the last one
+        static const int x0[7] = { 0, 4, 0, 2, 0, 1, 0 };
+        static const int y0[7] = { 0, 0, 4, 0, 2, 0, 1 };
+        static const int dx[7] = { 8, 8, 4, 4, 2, 2, 1 };
+        static const int dy[7] = { 8, 8, 8, 4, 4, 2, 2 };
+
+        unsigned char* image = _glfwMalloc((size_t)rowsize * png->height, GLFW_MEMORY_OTHER);
+        ok = image != NULL;
+
+        for (int pass = 0; ok && pass < 7; ++pass)
+        {
+            const int width = (png->width - x0[pass] + dx[pass] - 1) / dx[pass];
+            const int height = (png->height - y0[pass] + dy[pass] - 1) / dy[pass];
+            if (width > 0 && height > 0)
+            {
+                ok = decodePass(png, rows, width, height,
+                                image + (long)y0[pass] * rowsize + (long)x0[pass] * png->bpp,
+                                (long)dy[pass] * rowsize, dx[pass] * png->bpp,
+                                read, user, NULL, NULL);
+            }
+        }
+
+        for (int y = 0; ok && emit && y < png->height; ++y)
+        {
+            emit(emituser, y, image + (long)y * rowsize);
+        }
+
+        _glfwFree(image, GLFW_MEMORY_OTHER);
+    }
+
+    _glfwFree(rows, GLFW_MEMORY_OTHER);
+    return ok;
+}
+
+void _glfwDestroyPNG(_GLFWpng* png)
+{
+    if (!png)
+    {
+        return;
+    }
+
+    if (png->zlibinit)
+    {
+        inflateEnd(&png->zlib);
+    }
+    _glfwFree(png, GLFW_MEMORY_OTHER);
+}
+
+#else
+
+_GLFWpng* _glfwReadPNGHeader(_GLFWrawreadfun read, void* user)
+{
+    (void)read;
+    (void)user;
+    return NULL;
+}
+
+void _glfwGetPNGSize(const _GLFWpng* png, int* width, int* height, int* bpp)
+{
+    (void)png;
+    *width = *height = *bpp = 0;
+}
+
+int _glfwDecodePNG(_GLFWpng* png, _GLFWrawreadfun read, void* user,
+                   _GLFWpngrowfun emit, void* emituser)
+{
+    (void)png;
+    (void)read;
+    (void)user;
+    (void)emit;
+    (void)emituser;
+    return 0;
+}
+
+void _glfwDestroyPNG(_GLFWpng* png)
+{
+    (void)png;
+}
+
+#endif
@@ -0,0 +1,328 @@
+/*************************************************************************
+ * GLFW 2to3 - www.glfw.org
+ * A library easing porting from GLFW 2 to GLFW 3.x
+ *------------------------------------------------------------------------
+ * Copyright © 2020 Emmanuel Gil Peyrot <linkmauve@linkmauve.fr>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would
+ *    be appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not
+ *    be misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source
+ *    distribution.
+ *
+ *************************************************************************/
+
+#include "internal.h"
+
+#include <signal.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/* Image pipeline statistics */
+
+typedef struct stage_stats
+{
+    atomic_ullong calls;
+    atomic_ullong ns;
+    atomic_ullong bytes;
+    atomic_ullong histogram[GLFW_STATS_BUCKETS];
+} stage_stats;
+
+static stage_stats stages[GLFW_STAGE_COUNT];
+
+static const char* stage_names[GLFW_STAGE_COUNT] = {
+    "read",
+    "decode",
+    "rescale",
+    "convert",
+    "mipmap",
+    "upload",
+};
+
+// Time this thread spent reading streams, excluded from the other stages.
+static _Thread_local uint64_t io_time = 0;
+
+static int getBucket(uint64_t ns)
+{
+    uint64_t us = ns / 1000;
+    int bucket = 0;
+    while (us > 1 && bucket < GLFW_STATS_BUCKETS - 1)
+    {
+        us >>= 1;
+        ++bucket;
+    }
+    return bucket;
+}
+
+/* Entry point statistics */
+
+typedef struct call_stats
+{
+    atomic_ullong calls;
+    atomic_ullong ns;
+    atomic_ullong histogram[_GLFW_CALL_BUCKETS];
+} call_stats;
+
+// Counters of one thread, only ever written by it
+typedef struct thread_calls
+{
+    call_stats calls[_GLFW_CALL_COUNT];
+    struct thread_calls* next;
+} thread_calls;
+
+static _Atomic(thread_calls*) all_threads = NULL;
+static _Thread_local thread_calls* this_thread = NULL;
+
+// Set by SIGUSR1, and handled by the next counted call
+static atomic_int report_requested = 0;
+
+static const char* call_names[_GLFW_CALL_COUNT] = {
+#define _GLFW_CALL_NAME(name) #name,
+    _GLFW_ENTRY_POINTS(_GLFW_CALL_NAME)
+#undef _GLFW_CALL_NAME
+};
+
+static void addCount(atomic_ullong* counter, uint64_t value)
+{
+    // No other thread writes it, so no need for a locked add
+    atomic_store_explicit(counter, atomic_load_explicit(counter, memory_order_relaxed) + value, memory_order_relaxed);
+}
+
+static int getCallBucket(uint64_t ns)
+{
+    int bucket = 63 - __builtin_clzll(ns | 1);
+    return bucket < _GLFW_CALL_BUCKETS ? bucket : _GLFW_CALL_BUCKETS - 1;
+}
+
+static thread_calls* getThreadCalls(void)
+{
+    if (!this_thread)
+    {
+        // Never freed, the counts of finished threads are still reported,
+        // and other threads may keep calling in after glfwTerminate()
+        thread_calls* calls = calloc(1, sizeof(thread_calls));
+        if (!calls)
+        {
+            return NULL;
+        }
+
+        calls->next = atomic_load_explicit(&all_threads, memory_order_relaxed);
+        while (!atomic_compare_exchange_weak_explicit(&all_threads, &calls->next, calls,
+                                                      memory_order_release, memory_order_relaxed))
+        {
+        }
+        this_thread = calls;
+    }
+    return this_thread;
+}
+
+// Upper bound of the bucket holding the given fraction of the calls
+static uint64_t getPercentile(const uint64_t* histogram, uint64_t calls, double fraction)
+{
+    uint64_t seen = 0;
+    for (int i = 0; i < _GLFW_CALL_BUCKETS; ++i)
+    {
+        seen += histogram[i];
+        if (seen && seen >= (uint64_t)(fraction * (double)calls))
+        {
+            return (uint64_t)2 << i;
+        }
+    }
+    return (uint64_t)2 << (_GLFW_CALL_BUCKETS - 1);
+}
+
+static void printCallStats(void)
+{
+    uint64_t calls[_GLFW_CALL_COUNT] = { 0 };
+    uint64_t ns[_GLFW_CALL_COUNT] = { 0 };
+    uint64_t histograms[_GLFW_CALL_COUNT][_GLFW_CALL_BUCKETS] = { { 0 } };
+    int order[_GLFW_CALL_COUNT];
+
+    thread_calls* thread = atomic_load_explicit(&all_threads, memory_order_acquire);
+    for (; thread; thread = thread->next)
+    {
+        for (int i = 0; i < _GLFW_CALL_COUNT; ++i)
+        {
+            const call_stats* stats = &thread->calls[i];
+            calls[i] += atomic_load_explicit(&stats->calls, memory_order_relaxed);
+            ns[i] += atomic_load_explicit(&stats->ns, memory_order_relaxed);
+            for (int j = 0; j < _GLFW_CALL_BUCKETS; ++j)
+            {
+                histograms[i][j] += atomic_load_explicit(&stats->histogram[j], memory_order_relaxed);
+            }
+        }
+    }
+
+    // Most expensive entry points first
+    for (int i = 0; i < _GLFW_CALL_COUNT; ++i)
+    {
+        int j = i;
+        for (; j > 0 && ns[order[j - 1]] < ns[i]; --j)
+        {
+            order[j] = order[j - 1];
+        }
+        order[j] = i;
+    }
+
+    fprintf(stderr, "glfw2to3 call statistics:\n");
+    fprintf(stderr, "%-28s %10s %12s %10s %10s %10s\n", "function", "calls", "total ms", "mean ns", "p50 ns", "p99 ns");
+    for (int i = 0; i < _GLFW_CALL_COUNT; ++i)
+    {
+        int call = order[i];
+        if (!calls[call])
+        {
+            continue;
+        }
+        fprintf(stderr, "%-28s %10llu %12.3f %10llu %10llu %10llu\n", call_names[call],
+                (unsigned long long)calls[call], (double)ns[call] * 1e-6,
+                (unsigned long long)(ns[call] / calls[call]),
+                (unsigned long long)getPercentile(histograms[call], calls[call], 0.5),
+                (unsigned long long)getPercentile(histograms[call], calls[call], 0.99));
+    }
+}
+
+static void requestReport(int signal)
+{
+    (void)signal;
+    atomic_store_explicit(&report_requested, 1, memory_order_relaxed);
+}
+
+void _glfwEndCall(const _GLFWcalltimer* timer)
+{
+    uint64_t ns = _glfwGetTimerValue() - timer->start;
+
+    thread_calls* calls = getThreadCalls();
+    if (calls)
+    {
+        call_stats* stats = &calls->calls[timer->call];
+        addCount(&stats->calls, 1);
+        addCount(&stats->ns, ns);
+        addCount(&stats->histogram[getCallBucket(ns)], 1);
+    }
+
+    // Printing isn't safe from the signal handler itself
+    if (atomic_load_explicit(&report_requested, memory_order_relaxed) &&
+        atomic_exchange_explicit(&report_requested, 0, memory_order_relaxed))
+    {
+        printCallStats();
+    }
+}
+
+void _glfwInitStats(void)
+{
+    if (getenv("GLFW2TO3_IMAGE_STATS"))
+    {
+        _glfw.imagestats = GL_TRUE;
+    }
+
+    if (getenv("GLFW2TO3_STATS"))
+    {
+        _glfw.callstats = GL_TRUE;
+
+        // Unless the game handles it already
+        struct sigaction action;
+        if (sigaction(SIGUSR1, NULL, &action) == 0 && action.sa_handler == SIG_DFL)
+        {
+            action.sa_handler = requestReport;
+            sigemptyset(&action.sa_mask);
+            action.sa_flags = SA_RESTART;
+            sigaction(SIGUSR1, &action, NULL);
+        }
+    }
+}
+
+void _glfwTerminateStats(void)
+{
+    if (_glfw.callstats)
+    {
+        printCallStats();
+    }
+
+    if (!getenv("GLFW2TO3_IMAGE_STATS"))
+    {
+        return;
+    }
+
+    fprintf(stderr, "glfw2to3 image statistics:\n");
+    fprintf(stderr, "%-8s %10s %14s %14s %12s\n", "stage", "calls", "total ms", "bytes", "MiB/s");
+    for (int i = 0; i < GLFW_STAGE_COUNT; ++i)
+    {
+        GLFWstagestats stats;
+        glfwGetImageStats(i, &stats);
+        double ms = (double)stats.Nanoseconds * 1e-6;
+        double rate = stats.Nanoseconds ? (double)stats.Bytes / (1024.0 * 1024.0) / ((double)stats.Nanoseconds * 1e-9) : 0.0;
+        fprintf(stderr, "%-8s %10llu %14.3f %14llu %12.1f\n", stage_names[i], stats.Calls, ms, stats.Bytes, rate);
+    }
+}
+
+void _glfwBeginStage(_GLFWstagetimer* timer)
+{
+    timer->io = io_time;
+    timer->start = _glfwGetTimerValue();
+}
+
+void _glfwEndStage(_GLFWstagetimer* timer, int stage, uint64_t bytes)
+{
+    uint64_t ns = _glfwGetTimerValue() - timer->start;
+    if (stage == GLFW_STAGE_READ)
+    {
+        io_time += ns;
+    }
+    else
+    {
+        ns -= io_time - timer->io;
+    }
+
+    stage_stats* stats = &stages[stage];
+    atomic_fetch_add_explicit(&stats->calls, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&stats->ns, ns, memory_order_relaxed);
+    atomic_fetch_add_explicit(&stats->bytes, bytes, memory_order_relaxed);
+    atomic_fetch_add_explicit(&stats->histogram[getBucket(ns)], 1, memory_order_relaxed);
+}
+
+GLFWAPI int  GLFWAPIENTRY glfwGetImageStats(int stage, GLFWstagestats *stats)
+{
+    if (stage < 0 || stage >= GLFW_STAGE_COUNT || !stats)
+    {
+        return GL_FALSE;
+    }
+
+    stage_stats* src = &stages[stage];
+    stats->Calls = atomic_load_explicit(&src->calls, memory_order_relaxed);
+    stats->Nanoseconds = atomic_load_explicit(&src->ns, memory_order_relaxed);
+    stats->Bytes = atomic_load_explicit(&src->bytes, memory_order_relaxed);
+    for (int i = 0; i < GLFW_STATS_BUCKETS; ++i)
+    {
+        stats->Histogram[i] = atomic_load_explicit(&src->histogram[i], memory_order_relaxed);
+    }
+    return GL_TRUE;
+}
+
+GLFWAPI void GLFWAPIENTRY glfwResetImageStats(void)
+{
+    for (int stage = 0; stage < GLFW_STAGE_COUNT; ++stage)
+    {
+        stage_stats* stats = &stages[stage];
+        atomic_store_explicit(&stats->calls, 0, memory_order_relaxed);
+        atomic_store_explicit(&stats->ns, 0, memory_order_relaxed);
+        atomic_store_explicit(&stats->bytes, 0, memory_order_relaxed);
+        for (int i = 0; i < GLFW_STATS_BUCKETS; ++i)
+        {
+            atomic_store_explicit(&stats->histogram[i], 0, memory_order_relaxed);
+        }
+    }
+}
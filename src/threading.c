@@ -28,6 +28,7 @@
 #include "internal.h"
 
 #include <threads.h>
+#include <stdatomic.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <math.h>
@@ -35,10 +36,17 @@
 
 /* Threading support */
 
-// TODO: use a mutex to protect this variable!
+// Threads by ID, from 1 on as 0 is the main thread
 static thrd_t* threads = NULL;
 static int allocated = 0;
 static int size = 0;
+static mtx_t threads_lock;
+static once_flag threads_once = ONCE_FLAG_INIT;
+
+static void init_threads_lock(void)
+{
+    mtx_init(&threads_lock, mtx_plain);
+}
 
 typedef struct fat_arg
 {
@@ -49,55 +57,87 @@ typedef struct fat_arg
 static int start_thread(void* arg)
 {
     fat_arg* fat_arg = arg;
-    fat_arg->fun(fat_arg->arg);
+    GLFWthreadfun fun = fat_arg->fun;
+    void* user = fat_arg->arg;
+    _glfwFree(fat_arg, GLFW_MEMORY_THREADS);
+    fun(user);
     return 0;
 }
 
 GLFWAPI GLFWthread GLFWAPIENTRY glfwCreateThread(GLFWthreadfun fun, void *arg)
 {
-    if (allocated == 0)
+    _GLFW_COUNT_CALL(glfwCreateThread);
+    // Freed by the thread, as this function may return before it starts
+    fat_arg* fat_arg = _glfwMalloc(sizeof(*fat_arg), GLFW_MEMORY_THREADS);
+    if (!fat_arg)
     {
-        threads = malloc(sizeof(thrd_t));
-        allocated = 1;
+        return -1;
     }
-    else if (size + 1 > allocated)
+    fat_arg->fun = fun;
+    fat_arg->arg = arg;
+
+    call_once(&threads_once, init_threads_lock);
+    mtx_lock(&threads_lock);
+    if (size + 2 > allocated)
     {
-        threads = realloc(threads, 2 * allocated * sizeof(thrd_t));
-        for (int i = 0; i < allocated; ++i)
+        int count = allocated ? 2 * allocated : 8;
+        thrd_t* grown = _glfwRealloc(threads, count * sizeof(thrd_t), GLFW_MEMORY_THREADS);
+        if (!grown)
         {
-            threads[allocated + i] = ~0UL;
+            mtx_unlock(&threads_lock);
+            _glfwFree(fat_arg, GLFW_MEMORY_THREADS);
+            return -1;
         }
-        allocated *= 2;
+        for (int i = allocated; i < count; ++i)
+        {
+            grown[i] = ~0UL;
+        }
+        threads = grown;
+        allocated = count;
     }
-    // TODO: can this be put on the stack?
-    fat_arg fat_arg = {
-        fun,
-        arg,
-    };
     // TODO: be smarter with reuse of IDs.
-    if (thrd_create(&threads[size + 1], start_thread, &fat_arg) != thrd_success)
+    if (thrd_create(&threads[size + 1], start_thread, fat_arg) != thrd_success)
     {
+        mtx_unlock(&threads_lock);
+        _glfwFree(fat_arg, GLFW_MEMORY_THREADS);
         return -1;
     }
-    return ++size;
+    GLFWthread ID = ++size;
+    mtx_unlock(&threads_lock);
+    return ID;
 }
 
 GLFWAPI void GLFWAPIENTRY glfwDestroyThread(GLFWthread ID)
 {
+    _GLFW_COUNT_CALL(glfwDestroyThread);
     // TODO: figure out how and whether to implement.
     fprintf(stderr, "glfwDestroyThread(%d), dangerous function left unimplemented.\n", ID);
+    call_once(&threads_once, init_threads_lock);
+    mtx_lock(&threads_lock);
     threads[ID] = ~0UL;
+    mtx_unlock(&threads_lock);
 }
 
 GLFWAPI int  GLFWAPIENTRY glfwWaitThread(GLFWthread ID, int waitmode)
 {
-    if (threads[ID] == ~0UL)
+    _GLFW_COUNT_CALL(glfwWaitThread);
+    call_once(&threads_once, init_threads_lock);
+    mtx_lock(&threads_lock);
+    thrd_t thrd = threads[ID];
+    mtx_unlock(&threads_lock);
+
+    if (thrd == ~0UL)
     {
         return GL_TRUE;
     }
     if (waitmode == GLFW_WAIT)
     {
-        thrd_join(threads[ID], NULL);
+        thrd_join(thrd, NULL);
+
+        // A thread can only be joined once
+        mtx_lock(&threads_lock);
+        threads[ID] = ~0UL;
+        mtx_unlock(&threads_lock);
         return GL_TRUE;
     }
     else // if (waitmore == GLFW_NOWAIT)
@@ -109,22 +149,34 @@ GLFWAPI int  GLFWAPIENTRY glfwWaitThread(GLFWthread ID, int waitmode)
 
 GLFWAPI GLFWthread GLFWAPIENTRY glfwGetThreadID(void)
 {
+    _GLFW_COUNT_CALL(glfwGetThreadID);
     thrd_t thrd = thrd_current();
-    for (int i = 0; i < size; ++i)
+    GLFWthread ID = -1;
+    call_once(&threads_once, init_threads_lock);
+    mtx_lock(&threads_lock);
+    for (int i = 1; i <= size; ++i)
     {
         if (threads[i] == thrd)
         {
-            return i;
+            ID = i;
+            break;
         }
     }
-    return -1;
+    mtx_unlock(&threads_lock);
+    return ID;
 }
 
 GLFWAPI GLFWmutex GLFWAPIENTRY glfwCreateMutex(void)
 {
-    mtx_t* mutex = malloc(sizeof(mtx_t));
+    _GLFW_COUNT_CALL(glfwCreateMutex);
+    mtx_t* mutex = _glfwMalloc(sizeof(mtx_t), GLFW_MEMORY_SYNC);
+    if (!mutex)
+    {
+        return NULL;
+    }
     if (mtx_init(mutex, mtx_plain) != thrd_success)
     {
+        _glfwFree(mutex, GLFW_MEMORY_SYNC);
         return NULL;
     }
     return mutex;
@@ -132,25 +184,45 @@ GLFWAPI GLFWmutex GLFWAPIENTRY glfwCreateMutex(void)
 
 GLFWAPI void GLFWAPIENTRY glfwDestroyMutex(GLFWmutex mutex)
 {
+    _GLFW_COUNT_CALL(glfwDestroyMutex);
     mtx_destroy(mutex);
-    free(mutex);
+    _glfwFree(mutex, GLFW_MEMORY_SYNC);
 }
 
 GLFWAPI void GLFWAPIENTRY glfwLockMutex(GLFWmutex mutex)
 {
+    _GLFW_COUNT_CALL(glfwLockMutex);
+    if (_glfw.tracing)
+    {
+        // Only the locks which have to wait show up in the trace
+        if (mtx_trylock(mutex) == thrd_success)
+        {
+            return;
+        }
+        _GLFW_TRACE_SCOPE("glfwLockMutex wait");
+        mtx_lock(mutex);
+        return;
+    }
     mtx_lock(mutex);
 }
 
 GLFWAPI void GLFWAPIENTRY glfwUnlockMutex(GLFWmutex mutex)
 {
+    _GLFW_COUNT_CALL(glfwUnlockMutex);
     mtx_unlock(mutex);
 }
 
 GLFWAPI GLFWcond GLFWAPIENTRY glfwCreateCond(void)
 {
-    cnd_t* cond = malloc(sizeof(cnd_t));
+    _GLFW_COUNT_CALL(glfwCreateCond);
+    cnd_t* cond = _glfwMalloc(sizeof(cnd_t), GLFW_MEMORY_SYNC);
+    if (!cond)
+    {
+        return NULL;
+    }
     if (cnd_init(cond) != thrd_success)
     {
+        _glfwFree(cond, GLFW_MEMORY_SYNC);
         return NULL;
     }
     return cond;
@@ -158,32 +230,153 @@ GLFWAPI GLFWcond GLFWAPIENTRY glfwCreateCond(void)
 
 GLFWAPI void GLFWAPIENTRY glfwDestroyCond(GLFWcond cond)
 {
+    _GLFW_COUNT_CALL(glfwDestroyCond);
     cnd_destroy(cond);
-    free(cond);
+    _glfwFree(cond, GLFW_MEMORY_SYNC);
 }
 
 GLFWAPI void GLFWAPIENTRY glfwWaitCond(GLFWcond cond, GLFWmutex mutex, double timeout)
 {
+    _GLFW_COUNT_CALL(glfwWaitCond);
+    _GLFW_TRACE_SCOPE("glfwWaitCond");
+    if (timeout >= GLFW_INFINITY)
+    {
+        cnd_wait(cond, mutex);
+        return;
+    }
+
+    // The timeout is relative, cnd_timedwait() wants an absolute time
     struct timespec tp;
+    timespec_get(&tp, TIME_UTC);
     double sec;
     double nsec = modf(timeout, &sec) * 1000000000.0;
-    tp.tv_sec = (time_t)sec;
-    tp.tv_nsec = (long)nsec;
+    tp.tv_sec += (time_t)sec;
+    tp.tv_nsec += (long)nsec;
+    if (tp.tv_nsec >= 1000000000L)
+    {
+        tp.tv_sec++;
+        tp.tv_nsec -= 1000000000L;
+    }
     cnd_timedwait(cond, mutex, &tp);
 }
 
 GLFWAPI void GLFWAPIENTRY glfwSignalCond(GLFWcond cond)
 {
+    _GLFW_COUNT_CALL(glfwSignalCond);
     cnd_signal(cond);
 }
 
 GLFWAPI void GLFWAPIENTRY glfwBroadcastCond(GLFWcond cond)
 {
+    _GLFW_COUNT_CALL(glfwBroadcastCond);
     cnd_broadcast(cond);
 }
 
 GLFWAPI int  GLFWAPIENTRY glfwGetNumberOfProcessors(void)
 {
+    _GLFW_COUNT_CALL(glfwGetNumberOfProcessors);
     // TODO: make this more portable.
     return sysconf(_SC_NPROCESSORS_ONLN);
 }
+
+typedef struct parallel_range
+{
+    atomic_int next;
+    int end;
+} parallel_range;
+
+typedef struct parallel_job
+{
+    void (*fun)(int, void*);
+    void* arg;
+    parallel_range* ranges;
+    int workers;
+} parallel_job;
+
+typedef struct parallel_worker
+{
+    parallel_job* job;
+    int index;
+    int started;
+} parallel_worker;
+
+static int run_parallel_worker(void* arg)
+{
+    parallel_worker* worker = arg;
+    parallel_job* job = worker->job;
+
+    // Drain our own range first, then steal items from the other workers.
+    for (int i = 0; i < job->workers; ++i)
+    {
+        parallel_range* range = &job->ranges[(worker->index + i) % job->workers];
+        int item;
+        while ((item = atomic_fetch_add_explicit(&range->next, 1, memory_order_relaxed)) < range->end)
+        {
+            job->fun(item, job->arg);
+        }
+    }
+    return 0;
+}
+
+void _glfwParallelFor(int count, void (*fun)(int, void*), void* arg)
+{
+    int workers = glfwGetNumberOfProcessors();
+    if (workers > count)
+    {
+        workers = count;
+    }
+
+    parallel_range* ranges = NULL;
+    parallel_worker* args = NULL;
+    thrd_t* thrds = NULL;
+    if (workers > 1)
+    {
+        ranges = _glfwMalloc(workers * sizeof(parallel_range), GLFW_MEMORY_THREADS);
+        args = _glfwMalloc(workers * sizeof(parallel_worker), GLFW_MEMORY_THREADS);
+        thrds = _glfwMalloc(workers * sizeof(thrd_t), GLFW_MEMORY_THREADS);
+    }
+    if (!ranges || !args || !thrds)
+    {
+        _glfwFree(ranges, GLFW_MEMORY_THREADS);
+        _glfwFree(args, GLFW_MEMORY_THREADS);
+        _glfwFree(thrds, GLFW_MEMORY_THREADS);
+        for (int i = 0; i < count; ++i)
+        {
+            fun(i, arg);
+        }
+        return;
+    }
+
+    parallel_job job = {
+        fun,
+        arg,
+        ranges,
+        workers,
+    };
+    for (int i = 0; i < workers; ++i)
+    {
+        atomic_init(&ranges[i].next, (int)((long)count * i / workers));
+        ranges[i].end = (int)((long)count * (i + 1) / workers);
+        args[i].job = &job;
+        args[i].index = i;
+    }
+
+    // The calling thread is the first worker, the items of a worker which
+    // failed to start get stolen by the others.
+    for (int i = 1; i < workers; ++i)
+    {
+        args[i].started = thrd_create(&thrds[i], run_parallel_worker, &args[i]) == thrd_success;
+    }
+    run_parallel_worker(&args[0]);
+    for (int i = 1; i < workers; ++i)
+    {
+        if (args[i].started)
+        {
+            thrd_join(thrds[i], NULL);
+        }
+    }
+
+    _glfwFree(ranges, GLFW_MEMORY_THREADS);
+    _glfwFree(args, GLFW_MEMORY_THREADS);
+    _glfwFree(thrds, GLFW_MEMORY_THREADS);
+}
@@ -30,7 +30,7 @@
 #include <threads.h>
 #include <math.h>
 
-static uint64_t getTime(void)
+uint64_t _glfwGetTimerValue(void)
 {
     struct timespec ts;
     clock_gettime(CLOCK_MONOTONIC, &ts);
@@ -39,21 +39,25 @@ static uint64_t getTime(void)
 
 void _glfwInitTimer(void)
 {
-    _glfw.timer_base = getTime();
+    _glfw.timer_base = _glfwGetTimerValue();
 }
 
 GLFWAPI double GLFWAPIENTRY glfwGetTime(void)
 {
-    return (double) (getTime() - _glfw.timer_base) * 1e-9;
+    _GLFW_COUNT_CALL(glfwGetTime);
+    return (double) (_glfwGetTimerValue() - _glfw.timer_base) * 1e-9;
 }
 
 GLFWAPI void   GLFWAPIENTRY glfwSetTime(double time)
 {
-    _glfw.timer_base = getTime() - (uint64_t) (time / 1e-9);
+    _GLFW_COUNT_CALL(glfwSetTime);
+    _glfw.timer_base = _glfwGetTimerValue() - (uint64_t) (time / 1e-9);
 }
 
 GLFWAPI void   GLFWAPIENTRY glfwSleep(double time)
 {
+    _GLFW_COUNT_CALL(glfwSleep);
+    _GLFW_TRACE_SCOPE("glfwSleep");
     if (time > 0.0)
     {
         struct timespec dur;
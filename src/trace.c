@@ -0,0 +1,218 @@
+/*************************************************************************
+ * GLFW 2to3 - www.glfw.org
+ * A library easing porting from GLFW 2 to GLFW 3.x
+ *------------------------------------------------------------------------
+ * Copyright © 2020 Emmanuel Gil Peyrot <linkmauve@linkmauve.fr>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would
+ *    be appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not
+ *    be misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source
+ *    distribution.
+ *
+ *************************************************************************/
+
+
+#include "internal.h"
+
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+/* Frame timeline tracing */
+
+// Spans kept per thread, older ones get overwritten
+#define TRACE_EVENTS 32768
+
+// Nesting of glfwTraceBegin() spans per thread
+#define TRACE_DEPTH 64
+
+typedef struct trace_event
+{
+    const char* name;
+    uint64_t start;
+    uint64_t duration;
+} trace_event;
+
+typedef struct thread_trace
+{
+    trace_event events[TRACE_EVENTS];
+    atomic_uint head;
+    long tid;
+    _GLFWtracespan stack[TRACE_DEPTH];
+    int depth;
+    struct thread_trace* next;
+} thread_trace;
+
+static _Atomic(thread_trace*) all_threads = NULL;
+static _Thread_local thread_trace* this_thread = NULL;
+
+static thread_trace* getThreadTrace(void)
+{
+    if (!this_thread)
+    {
+        // Never freed, other threads may keep running after glfwTerminate()
+        thread_trace* trace = calloc(1, sizeof(thread_trace));
+        if (!trace)
+        {
+            return NULL;
+        }
+
+        trace->tid = (long)syscall(SYS_gettid);
+        trace->next = atomic_load_explicit(&all_threads, memory_order_relaxed);
+        while (!atomic_compare_exchange_weak_explicit(&all_threads, &trace->next, trace,
+                                                      memory_order_release, memory_order_relaxed))
+        {
+        }
+        this_thread = trace;
+    }
+    return this_thread;
+}
+
+static void recordSpan(const char* name, uint64_t start, uint64_t end)
+{
+    thread_trace* trace = getThreadTrace();
+    if (!trace)
+    {
+        return;
+    }
+
+    unsigned int head = atomic_load_explicit(&trace->head, memory_order_relaxed);
+    trace_event* event = &trace->events[head % TRACE_EVENTS];
+    event->name = name;
+    event->start = start;
+    event->duration = end - start;
+    atomic_store_explicit(&trace->head, head + 1, memory_order_release);
+}
+
+static void writeString(FILE* file, const char* string)
+{
+    fputc('"', file);
+    for (; *string; ++string)
+    {
+        unsigned char c = (unsigned char)*string;
+        if (c == '"' || c == '\\')
+        {
+            fprintf(file, "\\%c", c);
+        }
+        else if (c < 0x20)
+        {
+            fprintf(file, "\\u%04x", c);
+        }
+        else
+        {
+            fputc(c, file);
+        }
+    }
+    fputc('"', file);
+}
+
+// Chrome trace event format, which Perfetto also opens
+static void writeTrace(const char* path)
+{
+    FILE* file = fopen(path, "w");
+    if (!file)
+    {
+        fprintf(stderr, "glfw2to3: can't write trace to %s\n", path);
+        return;
+    }
+
+    long pid = (long)getpid();
+    int first = GL_TRUE;
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+
+    thread_trace* trace = atomic_load_explicit(&all_threads, memory_order_acquire);
+    for (; trace; trace = trace->next)
+    {
+        unsigned int head = atomic_load_explicit(&trace->head, memory_order_acquire);
+        unsigned int count = head < TRACE_EVENTS ? head : TRACE_EVENTS;
+        for (unsigned int i = head - count; i != head; ++i)
+        {
+            const trace_event* event = &trace->events[i % TRACE_EVENTS];
+            fprintf(file, "%s\n{\"ph\":\"X\",\"pid\":%ld,\"tid\":%ld,\"ts\":%.3f,\"dur\":%.3f,\"name\":",
+                    first ? "" : ",", pid, trace->tid,
+                    (double)event->start * 1e-3, (double)event->duration * 1e-3);
+            writeString(file, event->name);
+            fputc('}', file);
+            first = GL_FALSE;
+        }
+    }
+
+    fprintf(file, "\n]}\n");
+    fclose(file);
+}
+
+void _glfwInitTrace(void)
+{
+    _glfw.tracing = getenv("GLFW2TO3_TRACE") != NULL;
+}
+
+void _glfwTerminateTrace(void)
+{
+    const char* path = getenv("GLFW2TO3_TRACE");
+    if (_glfw.tracing && path)
+    {
+        writeTrace(path);
+    }
+}
+
+void _glfwEndTraceSpan(const _GLFWtracespan* span)
+{
+    recordSpan(span->name, span->start, _glfwGetTimerValue());
+}
+
+GLFWAPI void GLFWAPIENTRY glfwTraceBegin(const char *name)
+{
+    if (!_glfw.tracing)
+    {
+        return;
+    }
+
+    thread_trace* trace = getThreadTrace();
+    if (trace && trace->depth < TRACE_DEPTH)
+    {
+        trace->stack[trace->depth].start = _glfwGetTimerValue();
+        trace->stack[trace->depth].name = name;
+    }
+    if (trace)
+    {
+        // Deeper spans are dropped, but still have to be ended
+        trace->depth++;
+    }
+}
+
+GLFWAPI void GLFWAPIENTRY glfwTraceEnd(void)
+{
+    if (!_glfw.tracing)
+    {
+        return;
+    }
+
+    thread_trace* trace = this_thread;
+    if (!trace || trace->depth == 0)
+    {
+        return;
+    }
+
+    trace->depth--;
+    if (trace->depth < TRACE_DEPTH)
+    {
+        const _GLFWtracespan* span = &trace->stack[trace->depth];
+        recordSpan(span->name, span->start, _glfwGetTimerValue());
+    }
+}
@@ -33,9 +33,9 @@
 
 GLFWAPI int  GLFWAPIENTRY glfwGetVideoModes(GLFWvidmode *list, int maxcount)
 {
-    GLFWmonitor* monitor = _glfw.glfwGetPrimaryMonitor();
+    GLFWmonitor* monitor = _GLFW3(glfwGetPrimaryMonitor)();
     int count;
-    const vidmode3* modes = _glfw.glfwGetVideoModes(monitor, &count);
+    const vidmode3* modes = _GLFW3(glfwGetVideoModes)(monitor, &count);
     if (count > maxcount)
     {
         count = maxcount;
@@ -49,7 +49,7 @@ GLFWAPI int  GLFWAPIENTRY glfwGetVideoModes(GLFWvidmode *list, int maxcount)
 
 GLFWAPI void GLFWAPIENTRY glfwGetDesktopMode(GLFWvidmode *mode)
 {
-    GLFWmonitor* monitor = _glfw.glfwGetPrimaryMonitor();
-    const vidmode3* vidmode3 = _glfw.glfwGetVideoMode(monitor);
+    GLFWmonitor* monitor = _GLFW3(glfwGetPrimaryMonitor)();
+    const vidmode3* vidmode3 = _GLFW3(glfwGetVideoMode)(monitor);
     memcpy(mode, vidmode3, sizeof(GLFWvidmode));
 }
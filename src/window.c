@@ -28,18 +28,20 @@
 #include "internal.h"
 
 #include <stdio.h>
+#include <string.h>
 #include <dlfcn.h>
 
 /* Window handling */
 
 GLFWAPI int  GLFWAPIENTRY glfwOpenWindow(int width, int height, int redbits, int greenbits, int bluebits, int alphabits, int depthbits, int stencilbits, int mode)
 {
-    _glfw.glfwWindowHint(GLFW_RED_BITS, redbits);
-    _glfw.glfwWindowHint(GLFW_GREEN_BITS, greenbits);
-    _glfw.glfwWindowHint(GLFW_BLUE_BITS, bluebits);
-    _glfw.glfwWindowHint(GLFW_ALPHA_BITS, alphabits);
-    _glfw.glfwWindowHint(GLFW_DEPTH_BITS, depthbits);
-    _glfw.glfwWindowHint(GLFW_STENCIL_BITS, stencilbits);
+    _GLFW_COUNT_CALL(glfwOpenWindow);
+    _GLFW3(glfwWindowHint)(GLFW_RED_BITS, redbits);
+    _GLFW3(glfwWindowHint)(GLFW_GREEN_BITS, greenbits);
+    _GLFW3(glfwWindowHint)(GLFW_BLUE_BITS, bluebits);
+    _GLFW3(glfwWindowHint)(GLFW_ALPHA_BITS, alphabits);
+    _GLFW3(glfwWindowHint)(GLFW_DEPTH_BITS, depthbits);
+    _GLFW3(glfwWindowHint)(GLFW_STENCIL_BITS, stencilbits);
 
     GLFWmonitor* monitor;
     if (mode == GLFW_WINDOW)
@@ -48,22 +50,24 @@ GLFWAPI int  GLFWAPIENTRY glfwOpenWindow(int width, int height, int redbits, int
     }
     else
     {
-        monitor = _glfw.glfwGetPrimaryMonitor();
+        monitor = _GLFW3(glfwGetPrimaryMonitor)();
     }
 
-    _glfw.window = _glfw.glfwCreateWindow(width, height, "GLFW2to3", monitor, NULL);
+    _glfw.window = _GLFW3(glfwCreateWindow)(width, height, "GLFW2to3", monitor, NULL);
     if (!_glfw.window)
     {
         return GL_FALSE;
     }
 
+    // Not through glfwGetProcAddress(), which tells the wrappers that the
+    // game calls them
 #define GETPROCADDRESS(sym) do { \
-    _glfw.sym = (PFN_##sym)glfwGetProcAddress(#sym); \
+    _glfw.sym = (PFN_##sym)_glfwInterposeGLProc(#sym, _GLFW3(glfwGetProcAddress)(#sym), GL_FALSE); \
     if (!_glfw.sym) \
     { \
         if (_glfw.gl_handle) \
         { \
-            _glfw.sym = dlsym(_glfw.gl_handle, #sym); \
+            _glfw.sym = _glfwInterposeGLProc(#sym, dlsym(_glfw.gl_handle, #sym), GL_FALSE); \
         } \
         if (!_glfw.sym) \
         { \
@@ -74,24 +78,86 @@ GLFWAPI int  GLFWAPIENTRY glfwOpenWindow(int width, int height, int redbits, int
 
     GETPROCADDRESS(glGetString);
     GETPROCADDRESS(glPixelStorei);
-    GETPROCADDRESS(glGetTexParameteriv);
     GETPROCADDRESS(glGetIntegerv);
     GETPROCADDRESS(glTexParameteri);
+    GETPROCADDRESS(glGetTexParameteriv);
     GETPROCADDRESS(glTexImage2D);
+    GETPROCADDRESS(glTexSubImage2D);
 
 #undef GETPROCADDRESS
 
-    _glfw.glfwMakeContextCurrent(_glfw.window);
+    _GLFW3(glfwMakeContextCurrent)(_glfw.window);
+
+    // Entry points cached for a previous context, or looked up above before
+    // this one was current, may not be valid for it
+    _glfwFlushProcCache();
+
+    // Optional entry points, they need a current context to be queried.
+    _glfw.glGetInternalformativ = NULL;
+    if (glfwExtensionSupported("GL_ARB_internalformat_query2"))
+    {
+        _glfw.glGetInternalformativ = (PFN_glGetInternalformativ)_GLFW3(glfwGetProcAddress)("glGetInternalformativ");
+    }
+    memset(_glfw.uploadformats, 0, sizeof(_glfw.uploadformats));
+
+    _glfw.unpack = (_GLFWpixelstore){ .alignment = 4 };
+    glfwGetGLVersion(&_glfw.glmajor, &_glfw.glminor, NULL);
+    _glfw.autogenmipmap = glfwExtensionSupported("GL_SGIS_generate_mipmap");
+    _glfw.npottextures = glfwExtensionSupported("GL_ARB_texture_non_power_of_two");
+
+    // Looked up through the OpenGL wrappers, so that the state they shadow
+    // also sees our own calls
+#define GETOPTIONALPROC(sym) \
+    ((_glfw.sym = (PFN_##sym)_glfwInterposeGLProc(#sym, _GLFW3(glfwGetProcAddress)(#sym), GL_FALSE)) || \
+     (_glfw.gl_handle && (_glfw.sym = (PFN_##sym)_glfwInterposeGLProc(#sym, dlsym(_glfw.gl_handle, #sym), GL_FALSE))))
+
+    // Rescaling images on the GPU needs framebuffer blits, and rectangle
+    // textures to hold the original image.
+    _glfw.fboblit = GL_FALSE;
+    _glfw.blittexture = _glfw.blitrenderbuffer = 0;
+    _glfw.blitfbo[0] = _glfw.blitfbo[1] = 0;
+    _glfw.blitmaxsource = _glfw.blitmaxsize = 0;
+    if ((_glfw.glmajor >= 3 || glfwExtensionSupported("GL_ARB_framebuffer_object")) &&
+        (_glfw.glmajor > 3 || (_glfw.glmajor == 3 && _glfw.glminor >= 1) ||
+         glfwExtensionSupported("GL_ARB_texture_rectangle")))
+    {
+        _glfw.fboblit = GETOPTIONALPROC(glIsEnabled) &&
+                        GETOPTIONALPROC(glEnable) &&
+                        GETOPTIONALPROC(glDisable) &&
+                        GETOPTIONALPROC(glGenTextures) &&
+                        GETOPTIONALPROC(glDeleteTextures) &&
+                        GETOPTIONALPROC(glBindTexture) &&
+                        GETOPTIONALPROC(glCopyTexImage2D) &&
+                        GETOPTIONALPROC(glGenFramebuffers) &&
+                        GETOPTIONALPROC(glDeleteFramebuffers) &&
+                        GETOPTIONALPROC(glBindFramebuffer) &&
+                        GETOPTIONALPROC(glFramebufferTexture2D) &&
+                        GETOPTIONALPROC(glFramebufferRenderbuffer) &&
+                        GETOPTIONALPROC(glCheckFramebufferStatus) &&
+                        GETOPTIONALPROC(glGenRenderbuffers) &&
+                        GETOPTIONALPROC(glDeleteRenderbuffers) &&
+                        GETOPTIONALPROC(glBindRenderbuffer) &&
+                        GETOPTIONALPROC(glRenderbufferStorage) &&
+                        GETOPTIONALPROC(glBlitFramebuffer) &&
+                        GETOPTIONALPROC(glGenerateMipmap);
+    }
+
+    // Streaming mipmaps needs GL_TEXTURE_BASE_LEVEL, from OpenGL 1.2.
+    _glfw.texturestreaming = (_glfw.glmajor > 1 || _glfw.glminor >= 2) &&
+                             GETOPTIONALPROC(glBindTexture);
+
+#undef GETOPTIONALPROC
 
     return GL_TRUE;
 }
 
 GLFWAPI void GLFWAPIENTRY glfwOpenWindowHint(int target, int hint)
 {
+    _GLFW_COUNT_CALL(glfwOpenWindowHint);
     switch (target)
     {
     case GLFW_WINDOW_NO_RESIZE:
-        _glfw.glfwWindowHint(0x00020003, !hint);
+        _GLFW3(glfwWindowHint)(0x00020003, !hint);
         break;
     default:
         fprintf(stderr, "Unsupported glfwOpenWindowHint(0x%x, 0x%x)\n", target, hint);
@@ -101,78 +167,103 @@ GLFWAPI void GLFWAPIENTRY glfwOpenWindowHint(int target, int hint)
 
 GLFWAPI void GLFWAPIENTRY glfwCloseWindow(void)
 {
+    _GLFW_COUNT_CALL(glfwCloseWindow);
+    _glfwDestroyTextureStreams();
+    _glfwFlushProcCache();
+
     if (_glfw.window)
     {
-        _glfw.glfwDestroyWindow(_glfw.window);
+        _GLFW3(glfwDestroyWindow)(_glfw.window);
         _glfw.window = NULL;
     }
 }
 
 GLFWAPI void GLFWAPIENTRY glfwSetWindowTitle(const char *title)
 {
+    _GLFW_COUNT_CALL(glfwSetWindowTitle);
     if (_glfw.window)
     {
-        _glfw.glfwSetWindowTitle(_glfw.window, title);
+        _GLFW3(glfwSetWindowTitle)(_glfw.window, title);
     }
 }
 
 GLFWAPI void GLFWAPIENTRY glfwGetWindowSize(int *width, int *height)
 {
+    _GLFW_COUNT_CALL(glfwGetWindowSize);
     if (_glfw.window)
     {
-        _glfw.glfwGetFramebufferSize(_glfw.window, width, height);
+        _GLFW3(glfwGetFramebufferSize)(_glfw.window, width, height);
     }
 }
 
 GLFWAPI void GLFWAPIENTRY glfwSetWindowSize(int width, int height)
 {
+    _GLFW_COUNT_CALL(glfwSetWindowSize);
     if (_glfw.window)
     {
         float xscale, yscale;
-        _glfw.glfwGetWindowContentScale(_glfw.window, &xscale, &yscale);
-        _glfw.glfwSetWindowSize(_glfw.window, width * xscale, height * yscale);
+        _GLFW3(glfwGetWindowContentScale)(_glfw.window, &xscale, &yscale);
+        _GLFW3(glfwSetWindowSize)(_glfw.window, width * xscale, height * yscale);
     }
 }
 
 GLFWAPI void GLFWAPIENTRY glfwSetWindowPos(int x, int y)
 {
+    _GLFW_COUNT_CALL(glfwSetWindowPos);
     if (_glfw.window)
     {
-        _glfw.glfwSetWindowPos(_glfw.window, x, y);
+        _GLFW3(glfwSetWindowPos)(_glfw.window, x, y);
     }
 }
 
 GLFWAPI void GLFWAPIENTRY glfwIconifyWindow(void)
 {
+    _GLFW_COUNT_CALL(glfwIconifyWindow);
     if (_glfw.window)
     {
-        _glfw.glfwIconifyWindow(_glfw.window);
+        _GLFW3(glfwIconifyWindow)(_glfw.window);
     }
 }
 
 GLFWAPI void GLFWAPIENTRY glfwRestoreWindow(void)
 {
+    _GLFW_COUNT_CALL(glfwRestoreWindow);
     if (_glfw.window)
     {
-        _glfw.glfwRestoreWindow(_glfw.window);
+        _GLFW3(glfwRestoreWindow)(_glfw.window);
     }
 }
 
 GLFWAPI void GLFWAPIENTRY glfwSwapBuffers(void)
 {
+    _GLFW_COUNT_CALL(glfwSwapBuffers);
+    _GLFW_TRACE_SCOPE("glfwSwapBuffers");
     if (_glfw.window)
     {
-        _glfw.glfwSwapBuffers(_glfw.window);
+        if (_glfw.glbatch)
+        {
+            _glfwFlushGLBatch();
+        }
+        _GLFW3(glfwSwapBuffers)(_glfw.window);
+        if (_glfw.glstats)
+        {
+            _glfwEndGLFrame();
+        }
+        _glfwUpdateTextureStreams();
     }
 }
 
-GLFWAPI void GLFWAPIENTRY glfwSwapInterval(int interval)
+static void swapInterval(int interval)
 {
-    _glfw.glfwSwapInterval(interval);
+    _GLFW_COUNT_CALL(glfwSwapInterval);
+    _GLFW3(glfwSwapInterval)(interval);
 }
 
+_GLFW_FORWARD(glfwSwapInterval, swapInterval);
+
 GLFWAPI int  GLFWAPIENTRY glfwGetWindowParam(int param)
 {
+    _GLFW_COUNT_CALL(glfwGetWindowParam);
     if (!_glfw.window)
     {
         return GL_FALSE;
@@ -182,9 +273,9 @@ GLFWAPI int  GLFWAPIENTRY glfwGetWindowParam(int param)
     case GLFW_OPENED:
         return !!_glfw.window;
     case GLFW_ACTIVE:
-        return _glfw.glfwGetWindowAttrib(_glfw.window, 0x00020001);
+        return _GLFW3(glfwGetWindowAttrib)(_glfw.window, 0x00020001);
     case GLFW_ICONIFIED:
-        return _glfw.glfwGetWindowAttrib(_glfw.window, 0x00020002);
+        return _GLFW3(glfwGetWindowAttrib)(_glfw.window, 0x00020002);
     default:
         fprintf(stderr, "Unsupported glfwGetWindowParam(0x%x)\n", param);
         return GL_FALSE;
@@ -193,45 +284,51 @@ GLFWAPI int  GLFWAPIENTRY glfwGetWindowParam(int param)
 
 static void size_cbfun3(GLFWwindow* window, int width, int height)
 {
+    _GLFW_TRACE_SCOPE("size_cbfun3");
     (void)window;
     _glfw.windowsizefun(width, height);
 }
 
 static int close_cbfun3(GLFWwindow* window)
 {
+    _GLFW_TRACE_SCOPE("close_cbfun3");
     (void)window;
     return _glfw.closefun();
 }
 
 static void refresh_cbfun3(GLFWwindow* window)
 {
+    _GLFW_TRACE_SCOPE("refresh_cbfun3");
     (void)window;
     _glfw.refreshfun();
 }
 
 GLFWAPI void GLFWAPIENTRY glfwSetWindowSizeCallback(GLFWwindowsizefun cbfun)
 {
+    _GLFW_COUNT_CALL(glfwSetWindowSizeCallback);
     if (_glfw.window)
     {
         _glfw.windowsizefun = cbfun;
-        _glfw.glfwSetWindowSizeCallback(_glfw.window, size_cbfun3);
+        _GLFW3(glfwSetWindowSizeCallback)(_glfw.window, size_cbfun3);
     }
 }
 
 GLFWAPI void GLFWAPIENTRY glfwSetWindowCloseCallback(GLFWwindowclosefun cbfun)
 {
+    _GLFW_COUNT_CALL(glfwSetWindowCloseCallback);
     if (_glfw.window)
     {
         _glfw.closefun = cbfun;
-        _glfw.glfwSetWindowCloseCallback(_glfw.window, close_cbfun3);
+        _GLFW3(glfwSetWindowCloseCallback)(_glfw.window, close_cbfun3);
     }
 }
 
 GLFWAPI void GLFWAPIENTRY glfwSetWindowRefreshCallback(GLFWwindowrefreshfun cbfun)
 {
+    _GLFW_COUNT_CALL(glfwSetWindowRefreshCallback);
     if (_glfw.window)
     {
         _glfw.refreshfun = cbfun;
-        _glfw.glfwSetWindowRefreshCallback(_glfw.window, refresh_cbfun3);
+        _GLFW3(glfwSetWindowRefreshCallback)(_glfw.window, refresh_cbfun3);
     }
 }
@@ -0,0 +1,476 @@
+/*************************************************************************
+ * GLFW 2to3 - www.glfw.org
+ * A library easing porting from GLFW 2 to GLFW 3.x
+ *------------------------------------------------------------------------
+ * Copyright © 2020 Emmanuel Gil Peyrot <linkmauve@linkmauve.fr>
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would
+ *    be appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not
+ *    be misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source
+ *    distribution.
+ *
+ *************************************************************************/
+
+// Draws the same immediate mode primitives with and without
+// GLFW2TO3_GL_BATCH, on top of the mock libraries, and checks that the mock
+// OpenGL drew the same vertices with the same attributes and textures.  Run
+// through `meson test`, with the directory to write the logs to.
+
+#include <GL/glfw.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#define FRAMES 3
+
+// Resolved through glfwGetProcAddress(), so that they are wrapped
+#define TEST_GL_FUNCTIONS(F) \
+    F(glBegin) \
+    F(glEnd) \
+    F(glVertex2f) \
+    F(glVertex2i) \
+    F(glVertex2sv) \
+    F(glVertex3f) \
+    F(glVertex3fv) \
+    F(glVertex3d) \
+    F(glVertex4f) \
+    F(glColor3f) \
+    F(glColor4f) \
+    F(glColor4fv) \
+    F(glColor4ub) \
+    F(glColor3us) \
+    F(glColor4dv) \
+    F(glColor3b) \
+    F(glTexCoord1f) \
+    F(glTexCoord2f) \
+    F(glTexCoord2i) \
+    F(glTexCoord3fv) \
+    F(glTexCoord4f) \
+    F(glMultiTexCoord2f) \
+    F(glNormal3f) \
+    F(glNormal3fv) \
+    F(glNormal3b) \
+    F(glEdgeFlag) \
+    F(glEvalCoord1f) \
+    F(glArrayElement) \
+    F(glVertexPointer) \
+    F(glEnableClientState) \
+    F(glEnable) \
+    F(glGenTextures) \
+    F(glBindTexture)
+
+static struct {
+#define F(name) __typeof__(&name) name;
+    TEST_GL_FUNCTIONS(F)
+#undef F
+} gl;
+
+typedef struct run
+{
+    const char* name;
+    const char* batch;
+    const char* version;
+} run;
+
+// The first one is the reference the others are compared to
+static const run runs[] = {
+    { "direct", NULL, NULL },
+    { "batched", "1", NULL },
+    { "batched-gl14", "1", "1.4 glfw2to3 mock" },
+};
+
+static int loadFunctions(void)
+{
+#define F(name) \
+    gl.name = (__typeof__(&name))glfwGetProcAddress(#name); \
+    if (!gl.name) \
+    { \
+        fprintf(stderr, "%s not found\n", #name); \
+        return 0; \
+    }
+    TEST_GL_FUNCTIONS(F)
+#undef F
+    return 1;
+}
+
+/* Drawing */
+
+static const GLfloat elements[] = { 5.f, 6.f, 7.f, 8.f };
+
+// Textured quads in a few textures, as games draw sprites
+static void drawSprites(const GLuint* textures)
+{
+    gl.glEnable(GL_TEXTURE_2D);
+    for (int i = 0; i < 40; i++)
+    {
+        const GLshort corner[2] = { (GLshort)(i * 16 + 16), (GLshort)(i + 16) };
+        gl.glBindTexture(GL_TEXTURE_2D, textures[i / 10]);
+        if (i % 3 == 0)
+        {
+            gl.glColor4ub(255, (GLubyte)(i * 6), 128, 200);
+        }
+
+        gl.glBegin(GL_QUADS);
+        gl.glTexCoord2f(0.f, 0.f);
+        gl.glVertex2f(i * 16.f, (GLfloat)i);
+        gl.glTexCoord2i(1, 0);
+        gl.glVertex2i(i * 16 + 16, i);
+        gl.glTexCoord2f(1.f, 1.f);
+        gl.glVertex2sv(corner);
+        gl.glTexCoord2i(0, 1);
+        gl.glVertex3d(i * 16.0, i + 16.0, (i % 2) * 0.5);
+        if (i % 7 == 0)
+        {
+            // Incomplete, which OpenGL ignores
+            gl.glVertex2f(0.f, 0.f);
+        }
+        gl.glEnd();
+    }
+}
+
+// Triangles with every attribute varying, set through various functions
+static void drawShaded(int frame)
+{
+    gl.glBegin(GL_TRIANGLES);
+    for (int i = 0; i < 12; i++)
+    {
+        const GLdouble color[4] = { 0.25, 0.5, i / 12.0, 1.0 };
+        const GLfloat red[4] = { 1.f, 0.f, 0.f, 0.5f };
+        const GLfloat value[3] = { i * 0.125f, 0.5f, 0.75f };
+
+        switch (i % 4)
+        {
+        case 0:
+            gl.glColor3us((GLushort)(i * 4000), 65535, (GLushort)(frame * 1000));
+            break;
+        case 1:
+            gl.glColor4dv(color);
+            break;
+        case 2:
+            gl.glColor3f(0.5f, 0.5f, 0.5f);
+            break;
+        default:
+            gl.glColor4fv(red);
+            break;
+        }
+
+        if (i % 2)
+        {
+            gl.glNormal3fv(value);
+        }
+        else
+        {
+            gl.glNormal3f(0.f, 1.f, 0.f);
+        }
+
+        switch (i % 3)
+        {
+        case 0:
+            gl.glTexCoord1f(i * 0.5f);
+            break;
+        case 1:
+            gl.glTexCoord3fv(value);
+            break;
+        default:
+            gl.glTexCoord4f(0.f, 1.f, 0.f, 2.f);
+            break;
+        }
+
+        gl.glVertex3f((GLfloat)i, (GLfloat)(i * i), (GLfloat)frame);
+    }
+    gl.glEnd();
+}
+
+// Functions which aren't recorded, called in and between primitives
+static void drawUnrecorded(void)
+{
+    gl.glBegin(GL_TRIANGLES);
+    gl.glColor3f(0.f, 1.f, 0.f);
+    gl.glVertex2f(1.f, 2.f);
+    gl.glColor3b(10, 20, 30);
+    gl.glVertex2f(3.f, 4.f);
+    gl.glNormal3b(-128, 0, 127);
+    gl.glVertex4f(5.f, 6.f, 0.f, 2.f);
+    gl.glMultiTexCoord2f(GL_TEXTURE1, 0.25f, 0.75f);
+    gl.glVertex2f(7.f, 8.f);
+    gl.glEdgeFlag(GL_FALSE);
+    gl.glVertex2f(9.f, 10.f);
+    gl.glEdgeFlag(GL_TRUE);
+    gl.glEvalCoord1f(0.5f);
+    gl.glArrayElement(0);
+    gl.glArrayElement(1);
+    gl.glVertex2f(11.f, 12.f);
+    gl.glEnd();
+
+    // Attributes set again to what they were before an unrecorded change
+    gl.glColor4f(1.f, 0.f, 0.f, 1.f);
+    gl.glBegin(GL_QUADS);
+    gl.glVertex2f(0.f, 0.f);
+    gl.glVertex2f(1.f, 0.f);
+    gl.glVertex2f(1.f, 1.f);
+    gl.glVertex2f(0.f, 1.f);
+    gl.glEnd();
+    gl.glColor3b(10, 20, 30);
+    gl.glColor4f(1.f, 0.f, 0.f, 1.f);
+    gl.glBegin(GL_QUADS);
+    gl.glVertex2f(2.f, 0.f);
+    gl.glVertex2f(3.f, 0.f);
+    gl.glVertex2f(3.f, 1.f);
+    gl.glVertex2f(2.f, 1.f);
+    gl.glEnd();
+
+    gl.glTexCoord2f(0.5f, 0.5f);
+    gl.glNormal3f(1.f, 0.f, 0.f);
+    gl.glBegin(GL_POINTS);
+    gl.glVertex2f(1.f, 1.f);
+    gl.glEnd();
+    gl.glMultiTexCoord2f(GL_TEXTURE0, 0.f, 0.f);
+    gl.glNormal3b(0, 0, 0);
+    gl.glTexCoord2f(0.5f, 0.5f);
+    gl.glNormal3f(1.f, 0.f, 0.f);
+    gl.glBegin(GL_POINTS);
+    gl.glVertex2f(2.f, 2.f);
+    gl.glEnd();
+}
+
+// Primitives which can't be appended to each other
+static void drawStrips(void)
+{
+    for (int i = 0; i < 3; i++)
+    {
+        gl.glBegin(i == 2 ? GL_TRIANGLE_FAN : GL_LINE_STRIP);
+        for (int j = 0; j < 5; j++)
+        {
+            const GLfloat position[3] = { (GLfloat)i, (GLfloat)j, (GLfloat)(i * j) };
+            gl.glColor3f(j * 0.25f, 0.f, 1.f);
+            gl.glVertex3fv(position);
+        }
+        gl.glEnd();
+    }
+
+    gl.glBegin(GL_LINE_LOOP);
+    gl.glEnd();
+}
+
+static int draw(void)
+{
+    if (!glfwInit())
+    {
+        fprintf(stderr, "glfwInit() failed\n");
+        return EXIT_FAILURE;
+    }
+    if (!glfwOpenWindow(640, 480, 8, 8, 8, 8, 24, 0, GLFW_WINDOW) ||
+        !loadFunctions())
+    {
+        glfwTerminate();
+        return EXIT_FAILURE;
+    }
+
+    GLuint textures[4];
+    gl.glGenTextures(4, textures);
+    gl.glVertexPointer(2, GL_FLOAT, 0, elements);
+    gl.glEnableClientState(GL_VERTEX_ARRAY);
+
+    for (int frame = 0; frame < FRAMES; frame++)
+    {
+        drawSprites(textures);
+        drawShaded(frame);
+        drawUnrecorded();
+        drawStrips();
+        glfwSwapBuffers();
+    }
+
+    glfwTerminate();
+    return EXIT_SUCCESS;
+}
+
+/* Comparison of the logs */
+
+typedef struct log_lines
+{
+    char** lines;
+    int count;
+    // Calls to glBegin(), which batching should have saved
+    int begins;
+} log_lines;
+
+// Keeps what was drawn, dropping the calls which drew it
+static int readLog(const char* path, log_lines* log)
+{
+    static const char* kept[] = { "Vertex(", "Primitive(", "Current(", "SwapBuffers" };
+
+    FILE* file = fopen(path, "r");
+    if (!file)
+    {
+        perror(path);
+        return 0;
+    }
+
+    char line[1024];
+    int capacity = 0;
+    memset(log, 0, sizeof(*log));
+    while (fgets(line, sizeof(line), file))
+    {
+        const char* text = strchr(line, ' ');
+        if (!text)
+        {
+            continue;
+        }
+        text++;
+        if (strncmp(text, "glBegin(", 8) == 0)
+        {
+            log->begins++;
+        }
+
+        for (size_t i = 0; i < sizeof(kept) / sizeof(kept[0]); i++)
+        {
+            if (strncmp(text, kept[i], strlen(kept[i])) != 0)
+            {
+                continue;
+            }
+            if (log->count == capacity)
+            {
+                capacity = capacity ? capacity * 2 : 1024;
+                log->lines = realloc(log->lines, capacity * sizeof(char*));
+                if (!log->lines)
+                {
+                    abort();
+                }
+            }
+            log->lines[log->count++] = strdup(line);
+            break;
+        }
+    }
+
+    fclose(file);
+    return 1;
+}
+
+static void freeLog(log_lines* log)
+{
+    for (int i = 0; i < log->count; i++)
+    {
+        free(log->lines[i]);
+    }
+    free(log->lines);
+}
+
+static int compareLogs(const char* name, const log_lines* expected, const log_lines* actual)
+{
+    for (int i = 0; i < expected->count && i < actual->count; i++)
+    {
+        if (strcmp(expected->lines[i], actual->lines[i]) != 0)
+        {
+            fprintf(stderr, "%s: drawn item %d differs\nexpected: %sactual:   %s",
+                    name, i, expected->lines[i], actual->lines[i]);
+            return 0;
+        }
+    }
+    if (expected->count != actual->count)
+    {
+        fprintf(stderr, "%s: %d items drawn instead of %d\n",
+                name, actual->count, expected->count);
+        return 0;
+    }
+    if (actual->begins >= expected->begins)
+    {
+        fprintf(stderr, "%s: %d calls to glBegin(), nothing was batched\n",
+                name, actual->begins);
+        return 0;
+    }
+
+    printf("%s: %d items drawn, %d calls to glBegin() instead of %d\n",
+           name, actual->count, actual->begins, expected->begins);
+    return 1;
+}
+
+// Draws in a child process, as the mock OpenGL reads the environment when
+// loaded by glfwInit()
+static int drawRun(const run* run, const char* path)
+{
+    // The child exits normally, for the mock to write its whole log
+    fflush(NULL);
+    pid_t pid = fork();
+    if (pid < 0)
+    {
+        perror("fork");
+        return 0;
+    }
+    if (pid == 0)
+    {
+        setenv("GLFW2TO3_MOCK_GL_LOG", path, 1);
+        if (run->batch)
+        {
+            setenv("GLFW2TO3_GL_BATCH", run->batch, 1);
+        }
+        else
+        {
+            unsetenv("GLFW2TO3_GL_BATCH");
+        }
+        if (run->version)
+        {
+            setenv("GLFW2TO3_MOCK_GL_VERSION", run->version, 1);
+        }
+        exit(draw());
+    }
+
+    int status;
+    if (waitpid(pid, &status, 0) < 0 || !WIFEXITED(status) ||
+        WEXITSTATUS(status) != EXIT_SUCCESS)
+    {
+        fprintf(stderr, "%s: drawing failed\n", run->name);
+        return 0;
+    }
+    return 1;
+}
+
+int main(int argc, char** argv)
+{
+    const char* dir = argc > 1 ? argv[1] : ".";
+    const int count = sizeof(runs) / sizeof(runs[0]);
+    log_lines reference = { 0 };
+    int success = 1;
+
+    for (int i = 0; i < count && success; i++)
+    {
+        char path[4096];
+        snprintf(path, sizeof(path), "%s/batch-%s.log", dir, runs[i].name);
+        if (!drawRun(&runs[i], path))
+        {
+            success = 0;
+            break;
+        }
+
+        log_lines log;
+        if (!readLog(path, i ? &log : &reference))
+        {
+            success = 0;
+            break;
+        }
+        if (i)
+        {
+            success = compareLogs(runs[i].name, &reference, &log);
+            freeLog(&log);
+        }
+    }
+
+    freeLog(&reference);
+    return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}